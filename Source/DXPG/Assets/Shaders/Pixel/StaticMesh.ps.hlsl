@@ -3,11 +3,27 @@ struct Material
     float4 Diffuse;
     int UseDiffuseTexture;
     int UseAlphaMask;
+    int UseVirtualTexture;
+    uint VirtualTextureId;
+    uint2 TextureSize;
+    uint2 TileSize;
+    uint StandardLevels;
 };
 ConstantBuffer<Material> MaterialCB : register(b1);
 
+struct Feedback
+{
+    uint Width;
+    // Pixel of every 8x8 block that writes the block's entry this frame
+    uint2 Pixel;
+};
+ConstantBuffer<Feedback> FeedbackCB : register(b3);
+
 Texture2D Diffuse : register(t3);
 Texture2D Alpha : register(t4);
+// Finest resident level of a virtual texture per level 0 tile
+Texture2D<uint> ResidencyMap : register(t5);
+RWStructuredBuffer<uint> TileFeedback : register(u0);
 
 SamplerState Sampler : register(s0);
 
@@ -24,9 +40,34 @@ struct PSOut
     float4 Normal : SV_TARGET1;
 };
 
+float4 SampleVirtualDiffuse(float2 texCoord, uint2 pixel)
+{
+    float lod = Diffuse.CalculateLevelOfDetailUnclamped(Sampler, texCoord);
+    float2 wrapped = frac(texCoord);
+    if (all((pixel & 7) == FeedbackCB.Pixel))
+    {
+        uint level = uint(clamp(lod, 0.0, 15.0));
+        // Packed levels are always resident
+        if (level < MaterialCB.StandardLevels)
+        {
+            uint2 tile = uint2(wrapped * max(MaterialCB.TextureSize >> level, 1)) / MaterialCB.TileSize;
+            TileFeedback[(pixel.y >> 3) * FeedbackCB.Width + (pixel.x >> 3)] = (MaterialCB.VirtualTextureId << 20) | (level << 16) | (tile.y << 8) | tile.x;
+        }
+    }
+
+    uint2 residencySize;
+    ResidencyMap.GetDimensions(residencySize.x, residencySize.y);
+    uint residentLevel = ResidencyMap.Load(int3(min(uint2(wrapped * residencySize), residencySize - 1), 0));
+    return Diffuse.Sample(Sampler, texCoord, int2(0, 0), float(residentLevel));
+}
+
 PSOut main(PSIn IN)
 {
-    float4 diffuseCol = MaterialCB.UseDiffuseTexture ? Diffuse.Sample(Sampler, IN.TexCoord): MaterialCB.Diffuse;
+    float4 diffuseCol = MaterialCB.Diffuse;
+    if (MaterialCB.UseVirtualTexture)
+        diffuseCol = SampleVirtualDiffuse(IN.TexCoord, uint2(IN.Pos.xy));
+    else if (MaterialCB.UseDiffuseTexture)
+        diffuseCol = Diffuse.Sample(Sampler, IN.TexCoord);
         
     if(diffuseCol.a < 0.5)
         discard;
@@ -1,17 +1,28 @@
-struct ModelViewProjection
+struct ViewProjectionData
 {
-    matrix MVP;
+    matrix ViewProjection;
 };
 
-ConstantBuffer<ModelViewProjection> ModelViewProjectionCB : register(b0);
+struct InstanceOffsetData
+{
+    uint Offset;
+};
+
+struct InstanceData
+{
+    matrix Model;
+    matrix Normal;
+};
+
+ConstantBuffer<ViewProjectionData> ViewProjectionCB : register(b0);
+ConstantBuffer<InstanceOffsetData> InstanceOffsetCB : register(b1);
 
-StructuredBuffer<float3> Positions : register(t0);
+StructuredBuffer<InstanceData> Instances : register(t0);
 
 struct VSIn
 {
-    uint PosIndex : POSINDEX;
-    uint NormalIndex : NORMALINDEX;
-    uint TexCoordIndex : TEXCOORDINDEX;
+    float3 Position : POSITION;
+    uint InstanceID : SV_InstanceID;
 };
 
 struct VSOut
@@ -21,7 +32,8 @@ struct VSOut
 
 VSOut main(VSIn IN)
 {
+    matrix model = Instances[InstanceOffsetCB.Offset + IN.InstanceID].Model;
     VSOut output;
-    output.Pos = mul(ModelViewProjectionCB.MVP, float4(Positions[IN.PosIndex] / 100, 1.0));
+    output.Pos = mul(ViewProjectionCB.ViewProjection, mul(model, float4(IN.Position, 1.0)));
     return output;
 }
\ No newline at end of file
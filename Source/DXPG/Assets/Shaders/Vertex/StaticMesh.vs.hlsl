@@ -1,20 +1,46 @@
-struct ModelViewProjection
+struct ViewProjectionData
 {
-    matrix MVP;
+    matrix ViewProjection;
+};
+
+struct InstanceOffsetData
+{
+    uint Offset;
+};
+
+struct InstanceData
+{
+    matrix Model;
     matrix Normal;
 };
 
-ConstantBuffer<ModelViewProjection> ModelViewProjectionCB : register(b0);
+ConstantBuffer<ViewProjectionData> ViewProjectionCB : register(b0);
+ConstantBuffer<InstanceOffsetData> InstanceOffsetCB : register(b2);
+
+StructuredBuffer<InstanceData> Instances : register(t0);
 
-StructuredBuffer<float3> Positions : register(t0);
-StructuredBuffer<float3> Normals : register(t1);
-StructuredBuffer<float2> TexCoords : register(t2);
+#ifdef QUANTIZED_VERTICES
+// Inverse of OctahedralEncode in VertexQuantization.cpp
+float3 OctahedralDecode(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
 
 struct VSIn
 {
-    uint PosIndex : POSINDEX;
-    uint NormalIndex : NORMALINDEX;
-    uint TexCoordIndex : TEXCOORDINDEX;
+    float3 Position : POSITION;
+#ifdef QUANTIZED_VERTICES
+    float2 Normal : NORMAL;
+#else
+    float3 Normal : NORMAL;
+#endif
+    float2 TexCoord : TEXCOORD;
+    uint InstanceID : SV_InstanceID;
 };
 
 struct VSOut
@@ -26,9 +52,16 @@ struct VSOut
 
 VSOut main(VSIn IN)
 {
+    InstanceData instance = Instances[InstanceOffsetCB.Offset + IN.InstanceID];
     VSOut output;
-    output.Pos = mul(ModelViewProjectionCB.MVP, float4(Positions[IN.PosIndex]/100, 1.0));
-    output.Normal = mul(ModelViewProjectionCB.Normal, float4(Normals[IN.NormalIndex], 0.0)).xyz;
-    output.TexCoord = TexCoords[IN.TexCoordIndex];
+    float4 worldPos = mul(instance.Model, float4(IN.Position, 1.0));
+    output.Pos = mul(ViewProjectionCB.ViewProjection, worldPos);
+#ifdef QUANTIZED_VERTICES
+    float3 normal = OctahedralDecode(IN.Normal);
+#else
+    float3 normal = IN.Normal;
+#endif
+    output.Normal = mul(instance.Normal, float4(normal, 0.0)).xyz;
+    output.TexCoord = IN.TexCoord;
     return output;
 }
\ No newline at end of file
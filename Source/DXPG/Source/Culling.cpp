@@ -0,0 +1,136 @@
+#include "Culling.h"
+
+#include <cassert>
+
+namespace dxpg
+{
+
+namespace
+{
+// Bit i is set when lane i has its sign bit set
+uint32_t LaneMask(Vector4 v)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+	return static_cast<uint32_t>(_mm_movemask_ps(v));
+#else
+	XMUINT4 lanes;
+	XMStoreUInt4(&lanes, v);
+	return (lanes.x >> 31) | ((lanes.y >> 31) << 1) | ((lanes.z >> 31) << 2) | ((lanes.w >> 31) << 3);
+#endif
+}
+
+Vector4 LoadLanes(std::vector<float> const& values, size_t base)
+{
+	return XMLoadFloat4(reinterpret_cast<XMFLOAT4 const*>(values.data() + base));
+}
+}
+
+Frustum Frustum::FromViewProjection(Matrix4x4 const& viewProjection)
+{
+	// Row vector convention, clip = p * M, so the clip space axes are the columns of M
+	Matrix4x4 columns = XMMatrixTranspose(viewProjection);
+	Frustum frustum;
+	frustum.Planes[Left] = XMVectorAdd(columns.r[3], columns.r[0]);
+	frustum.Planes[Right] = XMVectorSubtract(columns.r[3], columns.r[0]);
+	frustum.Planes[Bottom] = XMVectorAdd(columns.r[3], columns.r[1]);
+	frustum.Planes[Top] = XMVectorSubtract(columns.r[3], columns.r[1]);
+	// D3D clip space depth is [0, w]
+	frustum.Planes[Near] = columns.r[2];
+	frustum.Planes[Far] = XMVectorSubtract(columns.r[3], columns.r[2]);
+	for (auto& plane : frustum.Planes)
+		plane = XMPlaneNormalize(plane);
+	return frustum;
+}
+
+void BoundsSoA::Resize(size_t count)
+{
+	Count = count;
+	size_t padded = (count + 3) & ~size_t(3);
+	for (auto* values : { &CenterX, &CenterY, &CenterZ, &ExtentX, &ExtentY, &ExtentZ })
+		values->resize(padded, 0.0f);
+}
+
+void BoundsSoA::Set(size_t index, DirectX::BoundingBox const& box)
+{
+	assert(index < Count);
+	CenterX[index] = box.Center.x;
+	CenterY[index] = box.Center.y;
+	CenterZ[index] = box.Center.z;
+	ExtentX[index] = box.Extents.x;
+	ExtentY[index] = box.Extents.y;
+	ExtentZ[index] = box.Extents.z;
+}
+
+DirectX::BoundingBox BoundsSoA::Get(size_t index) const
+{
+	assert(index < Count);
+	return DirectX::BoundingBox(Vector3(CenterX[index], CenterY[index], CenterZ[index]), Vector3(ExtentX[index], ExtentY[index], ExtentZ[index]));
+}
+
+CullingStats CullBoxes(Frustum const& frustum, BoundsSoA const& bounds, std::vector<uint32_t>& outVisible, uint32_t planeMask)
+{
+	struct SplatPlane
+	{
+		Vector4 X, Y, Z, W;
+		Vector4 AbsX, AbsY, AbsZ;
+	};
+	std::array<SplatPlane, Frustum::PlaneCount> planes;
+	uint32_t planeCount = 0;
+	for (uint32_t i = 0; i < Frustum::PlaneCount; ++i)
+	{
+		if (!(planeMask & (1u << i)))
+			continue;
+		Vector4 plane = frustum.Planes[i];
+		auto& splat = planes[planeCount++];
+		splat.X = XMVectorSplatX(plane);
+		splat.Y = XMVectorSplatY(plane);
+		splat.Z = XMVectorSplatZ(plane);
+		splat.W = XMVectorSplatW(plane);
+		splat.AbsX = XMVectorAbs(splat.X);
+		splat.AbsY = XMVectorAbs(splat.Y);
+		splat.AbsZ = XMVectorAbs(splat.Z);
+	}
+
+	CullingStats stats{};
+	size_t const count = bounds.Count;
+	for (size_t base = 0; base < count; base += 4)
+	{
+		Vector4 centerX = LoadLanes(bounds.CenterX, base);
+		Vector4 centerY = LoadLanes(bounds.CenterY, base);
+		Vector4 centerZ = LoadLanes(bounds.CenterZ, base);
+		Vector4 extentX = LoadLanes(bounds.ExtentX, base);
+		Vector4 extentY = LoadLanes(bounds.ExtentY, base);
+		Vector4 extentZ = LoadLanes(bounds.ExtentZ, base);
+
+		// A box is outside when its projected radius can't reach the positive side of some plane
+		Vector4 outside = XMVectorFalseInt();
+		for (uint32_t i = 0; i < planeCount; ++i)
+		{
+			auto& plane = planes[i];
+			Vector4 distance = XMVectorMultiplyAdd(plane.X, centerX, XMVectorMultiplyAdd(plane.Y, centerY, XMVectorMultiplyAdd(plane.Z, centerZ, plane.W)));
+			Vector4 radius = XMVectorMultiplyAdd(plane.AbsX, extentX, XMVectorMultiplyAdd(plane.AbsY, extentY, XMVectorMultiply(plane.AbsZ, extentZ)));
+			outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(distance, radius), XMVectorZero()));
+		}
+
+		uint32_t visibleMask = ~LaneMask(outside) & 0xF;
+		size_t laneCount = count - base < 4 ? count - base : 4;
+		for (size_t lane = 0; lane < laneCount; ++lane)
+		{
+			if (visibleMask & (1u << lane))
+			{
+				outVisible.push_back(static_cast<uint32_t>(base + lane));
+				stats.Visible++;
+			}
+			else
+				stats.Culled++;
+		}
+	}
+	return stats;
+}
+
+CullingStats CullShadowCasters(Matrix4x4 const& lightViewProjection, BoundsSoA const& bounds, std::vector<uint32_t>& outCasters)
+{
+	return CullBoxes(Frustum::FromViewProjection(lightViewProjection), bounds, outCasters, Frustum::AllPlanes & ~(1u << Frustum::Near));
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "MathTypes.h"
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace dxpg
+{
+
+struct Frustum
+{
+	enum PlaneIndex : uint32_t
+	{
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		PlaneCount
+	};
+	static constexpr uint32_t AllPlanes = (1u << PlaneCount) - 1;
+
+	// Inward facing planes, a point p is inside a plane when dot(p.xyz, plane.xyz) + plane.w >= 0
+	std::array<Vector4, PlaneCount> Planes;
+
+	static Frustum FromViewProjection(Matrix4x4 const& viewProjection);
+};
+
+// World space boxes in structure-of-arrays layout, padded to a multiple of 4 so they can be tested 4 at a time
+struct BoundsSoA
+{
+	std::vector<float> CenterX, CenterY, CenterZ;
+	std::vector<float> ExtentX, ExtentY, ExtentZ;
+	size_t Count = 0;
+
+	// Keeps the boxes below count, new ones are empty
+	void Resize(size_t count);
+	void Set(size_t index, DirectX::BoundingBox const& box);
+	DirectX::BoundingBox Get(size_t index) const;
+};
+
+struct CullingStats
+{
+	uint32_t Visible = 0;
+	uint32_t Culled = 0;
+};
+
+// Appends the indices of the boxes intersecting the frustum to outVisible.
+// Only the planes selected by planeMask are tested.
+CullingStats CullBoxes(Frustum const& frustum, BoundsSoA const& bounds, std::vector<uint32_t>& outVisible, uint32_t planeMask = Frustum::AllPlanes);
+
+// Shadow casters of a directional light. The light volume is extended towards the light by skipping its near plane,
+// so occluders outside the volume still cast; the shadow pass has to clamp their depth instead of clipping it.
+CullingStats CullShadowCasters(Matrix4x4 const& lightViewProjection, BoundsSoA const& bounds, std::vector<uint32_t>& outCasters);
+
+}
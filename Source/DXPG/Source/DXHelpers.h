@@ -18,12 +18,7 @@
 #include <wrl.h>
 using Microsoft::WRL::ComPtr;
 
-#include "DirectXMath.h"
-using namespace DirectX;
-using Matrix4x4 = DirectX::XMMATRIX;
-using Vector4 = DirectX::XMVECTOR;
-using Vector3 = DirectX::XMFLOAT3;
-using Vector2 = DirectX::XMFLOAT2;
+#include "MathTypes.h"
 #include <directx/d3dx12.h>
 #include <d3dcompiler.h>
 
@@ -314,4 +309,19 @@ struct TransitionVec : std::vector<D3D12_RESOURCE_BARRIER>
 	void Execute(ID3D12GraphicsCommandList* cmdList);
 };
 
+// View format that decodes sRGB, formats without one are returned as they are
+inline DXGI_FORMAT ToSrgbFormat(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    case DXGI_FORMAT_B8G8R8A8_UNORM: return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+    case DXGI_FORMAT_BC1_UNORM: return DXGI_FORMAT_BC1_UNORM_SRGB;
+    case DXGI_FORMAT_BC2_UNORM: return DXGI_FORMAT_BC2_UNORM_SRGB;
+    case DXGI_FORMAT_BC3_UNORM: return DXGI_FORMAT_BC3_UNORM_SRGB;
+    case DXGI_FORMAT_BC7_UNORM: return DXGI_FORMAT_BC7_UNORM_SRGB;
+    default: return format;
+    }
+}
+
 }
\ No newline at end of file
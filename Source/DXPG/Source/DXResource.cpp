@@ -1,4 +1,5 @@
 #include "DXResource.h"
+#include "StagingRing.h"
 
 namespace dxpg
 {
@@ -62,23 +63,23 @@ DXBuffer DXBuffer::Create(ID3D12Device* device, std::wstring name, size_t size,
 	return DXBuffer(name, resource, state, device, size);
 }
 
-DXBuffer DXBuffer::CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, ComPtr<ID3D12Resource>& outUploadBuf, std::span<const std::byte> data, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_FLAGS flags)
+DXBuffer DXBuffer::CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, std::span<const std::byte> data, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_FLAGS flags)
 {
-	auto buffer = Create(device, name, data.size(), D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, flags);
-	outUploadBuf = buffer.Upload(cmdList, data);
-	TransitionVec(buffer, state).Execute(cmdList);
+	// Copy queues leave the buffer in the common state, the graphics queue promotes it when it reads it
+	bool copyQueue = cmdList->GetType() == D3D12_COMMAND_LIST_TYPE_COPY;
+	auto buffer = Create(device, name, data.size(), D3D12_HEAP_TYPE_DEFAULT, copyQueue ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_COPY_DEST, flags);
+	buffer.Upload(cmdList, frameCtx, data);
+	if (!copyQueue)
+		TransitionVec(buffer, state).Execute(cmdList);
 	return buffer;
 }
 
 
-ComPtr<ID3D12Resource> DXBuffer::Upload(ID3D12GraphicsCommandList* cmdList, std::span<const std::byte> data, size_t offset)
+void DXBuffer::Upload(ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, std::span<const std::byte> data, size_t offset)
 {
-	auto uploadResource = Create(Device, Name + L"UploadBuffer", data.size(), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
-	CD3DX12_RANGE readRange(0, 0);
-	memcpy(uploadResource.Map(), data.data(), data.size());
-	uploadResource.Unmap();
-	cmdList->CopyBufferRegion(Resource.Get(), offset, uploadResource.Resource.Get(), 0, data.size());
-	return uploadResource.Resource;
+	auto staging = AllocateStaging(Device, frameCtx, data.size(), 16);
+	memcpy(staging.Data, data.data(), data.size());
+	cmdList->CopyBufferRegion(Resource.Get(), offset, staging.Resource, staging.Offset, data.size());
 }
 
 ShaderResourceView DXBuffer::CreateSRV(size_t numElements, size_t stride, size_t offset, D3D12_BUFFER_SRV_FLAGS flags)
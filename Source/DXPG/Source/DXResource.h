@@ -5,6 +5,7 @@
 namespace dxpg
 {
 
+struct FrameContext;
 
 struct DXResource
 {
@@ -76,20 +77,21 @@ struct DXBuffer : DXResource
 	static DXBuffer Create(ID3D12Device* device, std::wstring name, size_t size, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
 
 	template<typename T>
-	static DXBuffer CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, ComPtr<ID3D12Resource>& outUploadBuf, std::span<const T> data, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE)
+	static DXBuffer CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, std::span<const T> data, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE)
 	{
-		return CreateAndUpload(device, name, cmdList, outUploadBuf, std::span<const std::byte>((std::byte const*)data.data(), data.size_bytes()), state, flags);
+		return CreateAndUpload(device, name, cmdList, frameCtx, std::span<const std::byte>((std::byte const*)data.data(), data.size_bytes()), state, flags);
 	}
 
-	static DXBuffer CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, ComPtr<ID3D12Resource>& outUploadBuf, std::span<const std::byte> data, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+	static DXBuffer CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, std::span<const std::byte> data, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
 
+	// Stages data in the context's upload memory, the buffer has to be in the copy destination state
 	template<typename T>
-	ComPtr<ID3D12Resource> Upload(ID3D12GraphicsCommandList* cmdList, std::span<const T> data, size_t offset = 0)
+	void Upload(ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, std::span<const T> data, size_t offset = 0)
 	{
-		return Upload(cmdList, std::span<const std::byte>((std::byte const*)data.data(), data.size_bytes()), offset);
+		Upload(cmdList, frameCtx, std::span<const std::byte>((std::byte const*)data.data(), data.size_bytes()), offset);
 	}
 
-	ComPtr<ID3D12Resource> Upload(ID3D12GraphicsCommandList* cmdList, std::span<const std::byte> data, size_t offset = 0);
+	void Upload(ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, std::span<const std::byte> data, size_t offset = 0);
 
 	ShaderResourceView CreateSRV(size_t numElements = 0, size_t stride = 0, size_t offset = 0, D3D12_BUFFER_SRV_FLAGS flags = D3D12_BUFFER_SRV_FLAG_NONE);
 
@@ -148,9 +150,9 @@ struct DXTypedBuffer : DXBuffer
 		return DXTypedBuffer(DXBuffer::Create(device, name, numElements * sizeof(T), heapType, state, flags));
 	}
 
-	static DXTypedBuffer CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, ComPtr<ID3D12Resource>& outUploadBuf, std::span<const T> data, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE)
+	static DXTypedBuffer CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, std::span<const T> data, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE)
 	{
-		return DXTypedBuffer(DXBuffer::CreateAndUpload(device, name, cmdList, outUploadBuf, std::span<const std::byte>((std::byte const*)data.data(), data.size_bytes()), state, flags));
+		return DXTypedBuffer(DXBuffer::CreateAndUpload(device, name, cmdList, frameCtx, std::span<const std::byte>((std::byte const*)data.data(), data.size_bytes()), state, flags));
 	}
 
 	UnorderedAccessView CreateTypedUAV(size_t firstElement = 0, D3D12_BUFFER_UAV_FLAGS flags = D3D12_BUFFER_UAV_FLAG_NONE)
@@ -175,9 +177,9 @@ struct DXTypedSingularBuffer : DXTypedBuffer<T>
 		return static_cast<DXTypedSingularBuffer<T>>(DXTypedBuffer<T>::Create(device, name, 1, D3D12_HEAP_TYPE_DEFAULT, state, flags));
 	}
 
-	static DXTypedSingularBuffer<T> CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, ComPtr<ID3D12Resource>& outUploadResource, T const& data, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE)
+	static DXTypedSingularBuffer<T> CreateAndUpload(ID3D12Device* device, std::wstring name, ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, T const& data, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE)
 	{
-		return static_cast<DXTypedSingularBuffer<T>>(DXTypedBuffer<T>::CreateAndUpload(device, name, cmdList, outUploadResource, std::span{ &data, 1 }, state, flags));
+		return static_cast<DXTypedSingularBuffer<T>>(DXTypedBuffer<T>::CreateAndUpload(device, name, cmdList, frameCtx, std::span{ &data, 1 }, state, flags));
 	}
 
 	using DXTypedBuffer<T>::DXTypedBuffer;
@@ -0,0 +1,103 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+
+namespace dxpg
+{
+
+void GeometryBufferPool::Init(ID3D12Device* device, std::wstring name, uint32_t stride, uint32_t blockElements, D3D12_RESOURCE_STATES readState)
+{
+	Device = device;
+	Name = std::move(name);
+	Stride = stride;
+	BlockElements = blockElements;
+	ReadState = readState;
+	Blocks.clear();
+}
+
+GeometryAllocation GeometryBufferPool::Allocate(uint32_t elements)
+{
+	if (elements == 0)
+		return {};
+	for (uint32_t block = 0; block < Blocks.size(); ++block)
+	{
+		auto range = Blocks[block].Allocator.Allocate(elements);
+		if (range.IsValid())
+			return { block, range };
+	}
+
+	uint32_t blockElements = std::max(BlockElements, elements);
+	auto& block = Blocks.emplace_back();
+	block.Buffer = DXBuffer::Create(Device, Name + L"_Block" + std::to_wstring(Blocks.size() - 1), size_t(blockElements) * Stride, D3D12_HEAP_TYPE_DEFAULT, ReadState);
+	block.Allocator.Reset(blockElements);
+	auto range = block.Allocator.Allocate(elements);
+	assert(range.IsValid());
+	return { static_cast<uint32_t>(Blocks.size() - 1), range };
+}
+
+void GeometryBufferPool::Free(GeometryAllocation& allocation)
+{
+	if (!allocation.IsValid())
+		return;
+	Blocks[allocation.Block].Allocator.Free(allocation.Range);
+	allocation = {};
+}
+
+void GeometryBufferPool::Upload(ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, GeometryAllocation const& allocation, std::span<std::byte const> data)
+{
+	assert(allocation.IsValid());
+	auto& block = Blocks[allocation.Block];
+	assert(data.size() <= size_t(block.Allocator.AllocationSize(allocation.Range)) * Stride);
+	// Buffers are read by earlier commands on the same queue, the barriers order the copy after them.
+	// A copy queue writes ranges no frame reads yet, the buffer decays to the common state between command lists
+	bool copyQueue = cmdList->GetType() == D3D12_COMMAND_LIST_TYPE_COPY;
+	if (!copyQueue)
+		TransitionVec(block.Buffer, D3D12_RESOURCE_STATE_COPY_DEST).Execute(cmdList);
+	block.Buffer.Upload(cmdList, frameCtx, data, size_t(allocation.Offset()) * Stride);
+	if (!copyQueue)
+		TransitionVec(block.Buffer, ReadState).Execute(cmdList);
+}
+
+D3D12_VERTEX_BUFFER_VIEW GeometryBufferPool::VertexBufferView(GeometryAllocation const& allocation)
+{
+	auto& buffer = GetBuffer(allocation);
+	D3D12_VERTEX_BUFFER_VIEW view{};
+	view.BufferLocation = buffer.GPUAddress();
+	view.SizeInBytes = static_cast<UINT>(buffer.Size);
+	view.StrideInBytes = Stride;
+	return view;
+}
+
+D3D12_INDEX_BUFFER_VIEW GeometryBufferPool::IndexBufferView(GeometryAllocation const& allocation, DXGI_FORMAT format)
+{
+	auto& buffer = GetBuffer(allocation);
+	D3D12_INDEX_BUFFER_VIEW view{};
+	view.BufferLocation = buffer.GPUAddress();
+	view.SizeInBytes = static_cast<UINT>(buffer.Size);
+	view.Format = format;
+	return view;
+}
+
+TlsfAllocator::Stats GeometryBufferPool::GetStats() const
+{
+	TlsfAllocator::Stats stats;
+	for (auto& block : Blocks)
+	{
+		auto blockStats = block.Allocator.GetStats();
+		stats.Size += blockStats.Size;
+		stats.FreeUnits += blockStats.FreeUnits;
+		stats.FreeRegions += blockStats.FreeRegions;
+		stats.Allocations += blockStats.Allocations;
+		stats.LargestFreeRegion = std::max(stats.LargestFreeRegion, blockStats.LargestFreeRegion);
+	}
+	return stats;
+}
+
+void GeometryPool::Init(ID3D12Device* device)
+{
+	VertexPools[size_t(VertexFormat::Full)].Init(device, L"GeometryPool_FullVertices", sizeof(MeshVertex), BlockBytes / sizeof(MeshVertex), D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+	VertexPools[size_t(VertexFormat::Quantized)].Init(device, L"GeometryPool_QuantizedVertices", sizeof(QuantizedMeshVertex), BlockBytes / sizeof(QuantizedMeshVertex), D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+	Indices.Init(device, L"GeometryPool_Indices", sizeof(uint32_t), BlockBytes / sizeof(uint32_t), D3D12_RESOURCE_STATE_INDEX_BUFFER);
+}
+
+}
\ No newline at end of file
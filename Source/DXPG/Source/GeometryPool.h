@@ -0,0 +1,77 @@
+#pragma once
+
+#include "DXPGCommon.h"
+#include "DXResource.h"
+#include "TlsfAllocator.h"
+#include "VertexQuantization.h"
+
+#include <array>
+
+namespace dxpg
+{
+
+// A range of one block of a GeometryBufferPool, offsets and sizes are in elements of the pool's stride
+struct GeometryAllocation
+{
+	static constexpr uint32_t InvalidBlock = UINT32_MAX;
+
+	uint32_t Block = InvalidBlock;
+	TlsfAllocator::Allocation Range;
+
+	bool IsValid() const { return Block != InvalidBlock; }
+	uint32_t Offset() const { return Range.Offset; }
+};
+
+// Large default heap buffers shared by many meshes. Every block is one committed resource carved up by a
+// TlsfAllocator, so meshes in the same block share one vertex or index buffer binding and only differ in offsets.
+// A block is created when no existing one has room, allocations larger than a block get a block of their own
+struct GeometryBufferPool
+{
+	void Init(ID3D12Device* device, std::wstring name, uint32_t stride, uint32_t blockElements, D3D12_RESOURCE_STATES readState);
+
+	// Returns an invalid allocation for 0 elements
+	GeometryAllocation Allocate(uint32_t elements);
+	// The range must no longer be in use by the GPU
+	void Free(GeometryAllocation& allocation);
+	// Copies data to the start of the allocation, the block is back in its read state afterwards
+	void Upload(ID3D12GraphicsCommandList* cmdList, FrameContext& frameCtx, GeometryAllocation const& allocation, std::span<std::byte const> data);
+
+	DXBuffer& GetBuffer(GeometryAllocation const& allocation) { return Blocks[allocation.Block].Buffer; }
+	// Views of the whole block, the allocation's offset goes into BaseVertex or the first index of a draw
+	D3D12_VERTEX_BUFFER_VIEW VertexBufferView(GeometryAllocation const& allocation);
+	D3D12_INDEX_BUFFER_VIEW IndexBufferView(GeometryAllocation const& allocation, DXGI_FORMAT format);
+
+	// Summed over all blocks, LargestFreeRegion is the largest of any block
+	TlsfAllocator::Stats GetStats() const;
+	size_t BlockCount() const { return Blocks.size(); }
+	uint32_t Stride = 0;
+
+private:
+	struct Block
+	{
+		DXBuffer Buffer;
+		TlsfAllocator Allocator;
+	};
+
+	ID3D12Device* Device = nullptr;
+	std::wstring Name;
+	uint32_t BlockElements = 0;
+	D3D12_RESOURCE_STATES ReadState = D3D12_RESOURCE_STATE_COMMON;
+	std::vector<Block> Blocks;
+};
+
+// Vertex pools per vertex format, so a whole block can be bound with the format's stride, and one index pool
+struct GeometryPool
+{
+	static constexpr size_t BlockBytes = 64 << 20;
+
+	void Init(ID3D12Device* device);
+
+	GeometryBufferPool& Vertices(VertexFormat format) { return VertexPools[size_t(format)]; }
+
+	std::array<GeometryBufferPool, size_t(VertexFormat::Count)> VertexPools;
+	// 4 byte elements, 16 bit index lists are rounded up to an even count
+	GeometryBufferPool Indices;
+};
+
+}
\ No newline at end of file
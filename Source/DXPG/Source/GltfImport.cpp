@@ -0,0 +1,379 @@
+#include "GltfImport.h"
+
+#include <chrono>
+#include <map>
+#include <tuple>
+#include <unordered_set>
+#include "Parallel.h"
+
+namespace dxpg
+{
+
+namespace
+{
+
+// Primitives that use the same attribute accessors share their vertices
+struct VertexRange
+{
+	int32_t Position;
+	int32_t Normal;
+	int32_t TexCoord;
+	uint32_t Count = 0;
+	uint32_t BaseVertex = 0;
+	std::vector<MeshVertex> Vertices;
+	DirectX::BoundingBox Bounds{};
+	DirectX::BoundingSphere BoundingSphere{};
+};
+
+std::string UniqueName(std::unordered_set<std::string>& usedNames, std::string name)
+{
+	std::string unique = name;
+	for (uint32_t suffix = 2; !usedNames.insert(unique).second; ++suffix)
+		unique = name + "_" + std::to_string(suffix);
+	return unique;
+}
+
+// URIs are percent encoded
+std::string DecodeUri(std::string_view uri)
+{
+	std::string decoded;
+	decoded.reserve(uri.size());
+	for (size_t i = 0; i < uri.size(); ++i)
+	{
+		auto hex = [](char c) -> int
+		{
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F')
+				return c - 'A' + 10;
+			return -1;
+		};
+		if (uri[i] == '%' && i + 2 < uri.size() && hex(uri[i + 1]) >= 0 && hex(uri[i + 2]) >= 0)
+		{
+			decoded += char(hex(uri[i + 1]) * 16 + hex(uri[i + 2]));
+			i += 2;
+		}
+		else
+			decoded += uri[i];
+	}
+	return decoded;
+}
+
+struct PrimitiveRef
+{
+	uint32_t Mesh;
+	uint32_t Primitive;
+	uint32_t Range;
+};
+
+// Area weighted sum of the face normals around each vertex, over every primitive sharing the stream.
+// Triangles with indices past the stream are left out, their primitive is skipped later anyway
+void GenerateNormals(GltfDocument const& document, std::span<PrimitiveRef const> primitives, uint32_t rangeIndex, VertexRange& range)
+{
+	std::vector<Vector3> normals(range.Count, Vector3(0.0f, 0.0f, 0.0f));
+	for (auto& ref : primitives)
+	{
+		if (ref.Range != rangeIndex)
+			continue;
+		auto& primitive = document.Meshes[ref.Mesh].Primitives[ref.Primitive];
+		uint32_t indexCount = primitive.Indices >= 0 ? document.Accessors[primitive.Indices].Count : range.Count;
+		for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			uint32_t corners[3];
+			for (uint32_t c = 0; c < 3; ++c)
+				corners[c] = primitive.Indices >= 0 ? document.Accessors[primitive.Indices].ReadIndex(i + c) : i + c;
+			if (corners[0] >= range.Count || corners[1] >= range.Count || corners[2] >= range.Count)
+				continue;
+			Vector4 p0 = XMLoadFloat3(&range.Vertices[corners[0]].Position);
+			Vector4 faceNormal = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&range.Vertices[corners[1]].Position), p0),
+				XMVectorSubtract(XMLoadFloat3(&range.Vertices[corners[2]].Position), p0));
+			for (uint32_t corner : corners)
+				XMStoreFloat3(&normals[corner], XMVectorAdd(XMLoadFloat3(&normals[corner]), faceNormal));
+		}
+	}
+	for (uint32_t i = 0; i < range.Count; ++i)
+	{
+		Vector4 normal = XMLoadFloat3(&normals[i]);
+		// Unreferenced vertices and degenerate fans still need a unit vector for quantization
+		if (XMVectorGetX(XMVector3LengthSq(normal)) < 1e-20f)
+			range.Vertices[i].Normal = Vector3(0.0f, 1.0f, 0.0f);
+		else
+			XMStoreFloat3(&range.Vertices[i].Normal, XMVector3Normalize(normal));
+	}
+}
+
+void ReadVertices(GltfDocument const& document, std::span<PrimitiveRef const> primitives, uint32_t rangeIndex, float positionScale, VertexRange& range)
+{
+	auto& positions = document.Accessors[range.Position];
+	range.Vertices.resize(range.Count);
+	for (uint32_t i = 0; i < range.Count; ++i)
+	{
+		auto& vertex = range.Vertices[i];
+		float position[3] = {};
+		positions.Read(i, position);
+		vertex.Position = Vector3(position[0] * positionScale, position[1] * positionScale, position[2] * positionScale);
+		if (range.Normal >= 0)
+		{
+			float normal[3] = {};
+			document.Accessors[range.Normal].Read(i, normal);
+			vertex.Normal = Vector3(normal);
+		}
+		float texCoord[2] = {};
+		if (range.TexCoord >= 0)
+			document.Accessors[range.TexCoord].Read(i, texCoord);
+		// glTF puts the origin at the top left, the renderer uses the bottom left origin of OBJ files and loads images flipped
+		vertex.TexCoord = Vector2(texCoord[0], 1.0f - texCoord[1]);
+	}
+	if (range.Normal < 0)
+		GenerateNormals(document, primitives, rangeIndex, range);
+	ComputeMeshBounds(range.Vertices, range.Bounds, range.BoundingSphere);
+}
+
+}
+
+bool CookGlbModel(std::filesystem::path const& path, VertexFormat format, float positionScale, CookedGlb& outCooked, std::string& outError)
+{
+	auto importStart = std::chrono::high_resolution_clock::now();
+	if (!outCooked.File.Open(path))
+	{
+		outError = "Failed to map the file";
+		return false;
+	}
+	auto& document = outCooked.Document;
+	if (!ParseGlb(outCooked.File.Data(), document, outError))
+		return false;
+
+	auto& cooked = outCooked.Model;
+	auto& stats = cooked.Stats;
+	cooked.Format = format;
+	cooked.VertexStride = format == VertexFormat::Quantized ? sizeof(QuantizedMeshVertex) : sizeof(MeshVertex);
+
+	// Find the primitives worth drawing and the distinct vertex streams they use
+	std::vector<PrimitiveRef> primitives;
+	std::vector<VertexRange> ranges;
+	std::map<std::tuple<int32_t, int32_t, int32_t>, uint32_t> rangeLookup;
+	std::vector<uint32_t> meshFirstPrimitive(document.Meshes.size() + 1, 0);
+	for (uint32_t meshIndex = 0; meshIndex < document.Meshes.size(); ++meshIndex)
+	{
+		meshFirstPrimitive[meshIndex] = static_cast<uint32_t>(primitives.size());
+		auto& mesh = document.Meshes[meshIndex];
+		for (uint32_t primitiveIndex = 0; primitiveIndex < mesh.Primitives.size(); ++primitiveIndex)
+		{
+			auto& primitive = mesh.Primitives[primitiveIndex];
+			if (primitive.Mode != 4 || primitive.Position < 0)
+			{
+				outCooked.SkippedPrimitives++;
+				continue;
+			}
+			uint32_t vertexCount = document.Accessors[primitive.Position].Count;
+			auto attributeFits = [&](int32_t accessor)
+			{
+				return accessor < 0 || document.Accessors[accessor].Count >= vertexCount;
+			};
+			if (vertexCount == 0 || !attributeFits(primitive.Normal) || !attributeFits(primitive.TexCoord))
+			{
+				outCooked.SkippedPrimitives++;
+				continue;
+			}
+			auto [it, inserted] = rangeLookup.try_emplace({ primitive.Position, primitive.Normal, primitive.TexCoord }, static_cast<uint32_t>(ranges.size()));
+			if (inserted)
+				ranges.push_back({ .Position = primitive.Position, .Normal = primitive.Normal, .TexCoord = primitive.TexCoord, .Count = vertexCount });
+			primitives.push_back({ meshIndex, primitiveIndex, it->second });
+		}
+	}
+	meshFirstPrimitive[document.Meshes.size()] = static_cast<uint32_t>(primitives.size());
+
+	// Vertex streams are independent, decode them in parallel and pack them into the vertex buffer in order
+	ParallelFor(ranges.size(), [&](size_t rangeIndex)
+	{
+		ReadVertices(document, primitives, static_cast<uint32_t>(rangeIndex), positionScale, ranges[rangeIndex]);
+	});
+	std::vector<MeshVertex> vertices;
+	std::vector<QuantizedMeshVertex> quantizedVertices;
+	QuantizationError quantizationError;
+	for (auto& range : ranges)
+	{
+		range.BaseVertex = static_cast<uint32_t>(vertices.size() + quantizedVertices.size());
+		if (format == VertexFormat::Quantized)
+			QuantizeVertices(range.Vertices, range.Bounds, quantizedVertices, quantizationError);
+		else
+			vertices.insert(vertices.end(), range.Vertices.begin(), range.Vertices.end());
+		stats.SourceVertices += range.Count;
+		stats.UniqueVertices += range.Count;
+		if (range.Normal < 0)
+			outCooked.GeneratedNormals++;
+		range.Vertices = {};
+	}
+	auto vertexBytes = format == VertexFormat::Quantized ? std::as_bytes(std::span(quantizedVertices)) : std::as_bytes(std::span(vertices));
+	outCooked.Vertices.assign(vertexBytes.begin(), vertexBytes.end());
+	cooked.Vertices = outCooked.Vertices;
+	stats.VertexBufferBytes = static_cast<uint32_t>(outCooked.Vertices.size());
+
+	// Materials, primitives without one get the white default material of the spec
+	std::unordered_set<std::string> usedNames;
+	for (size_t materialIndex = 0; materialIndex < document.Materials.size(); ++materialIndex)
+	{
+		auto& material = document.Materials[materialIndex];
+		auto& name = outCooked.MaterialNames.emplace_back(UniqueName(usedNames, material.Name.empty() ? "Material" + std::to_string(materialIndex) : material.Name));
+		CookedMaterial cookedMaterial{ .Name = name, .DiffuseColor = Vector3(material.BaseColorFactor[0], material.BaseColorFactor[1], material.BaseColorFactor[2]) };
+		if (material.BaseColorImage >= 0)
+		{
+			auto& image = document.Images[material.BaseColorImage];
+			// Embedded images are named after their index, they are keyed by the model path when loaded
+			if (!image.Data.empty())
+			{
+				cookedMaterial.DiffuseTexture = outCooked.TexturePaths.emplace_back("image" + std::to_string(material.BaseColorImage));
+				cookedMaterial.DiffuseTextureData = image.Data;
+			}
+			else if (!image.Uri.empty() && !image.Uri.starts_with("data:"))
+				cookedMaterial.DiffuseTexture = outCooked.TexturePaths.emplace_back(DecodeUri(image.Uri));
+		}
+		cooked.Materials.push_back(cookedMaterial);
+	}
+	int32_t defaultMaterial = -1;
+
+	// One shape per primitive, named after its mesh
+	usedNames.clear();
+	outCooked.Shapes.resize(primitives.size());
+	std::vector<uint8_t> shapeValid(primitives.size(), 1);
+	ParallelFor(primitives.size(), [&](size_t shapeIndex)
+	{
+		auto& ref = primitives[shapeIndex];
+		auto& primitive = document.Meshes[ref.Mesh].Primitives[ref.Primitive];
+		auto& range = ranges[ref.Range];
+		auto& shape = outCooked.Shapes[shapeIndex];
+		shape.Bounds = range.Bounds;
+		shape.BoundingSphere = range.BoundingSphere;
+		if (primitive.Indices < 0)
+		{
+			shape.Indices32.resize(range.Count - range.Count % 3);
+			for (uint32_t i = 0; i < shape.Indices32.size(); ++i)
+				shape.Indices32[i] = i;
+			return;
+		}
+		// Indices past the vertex stream would read the neighbours in the geometry pool
+		auto& indices = document.Accessors[primitive.Indices];
+		uint32_t maxIndex = 0;
+		for (uint32_t i = 0; i < indices.Count; ++i)
+			maxIndex = std::max(maxIndex, indices.ReadIndex(i));
+		if (maxIndex >= range.Count || (indices.ComponentType != GltfComponentType::UnsignedByte && indices.ComponentType != GltfComponentType::UnsignedShort
+			&& indices.ComponentType != GltfComponentType::UnsignedInt))
+		{
+			shapeValid[shapeIndex] = 0;
+			return;
+		}
+		bool inPlace = indices.IsTightlyPacked() && indices.ComponentType != GltfComponentType::UnsignedByte;
+		if (!inPlace)
+		{
+			uint32_t count = indices.Count - indices.Count % 3;
+			if (FitsIndex16(range.Count))
+			{
+				shape.Indices16.resize(count);
+				for (uint32_t i = 0; i < count; ++i)
+					shape.Indices16[i] = static_cast<uint16_t>(indices.ReadIndex(i));
+			}
+			else
+			{
+				shape.Indices32.resize(count);
+				for (uint32_t i = 0; i < count; ++i)
+					shape.Indices32[i] = indices.ReadIndex(i);
+			}
+		}
+	});
+
+	std::vector<uint32_t> primitiveToShape(primitives.size(), UINT32_MAX);
+	for (size_t shapeIndex = 0; shapeIndex < primitives.size(); ++shapeIndex)
+	{
+		if (!shapeValid[shapeIndex])
+		{
+			outCooked.SkippedPrimitives++;
+			continue;
+		}
+		auto& ref = primitives[shapeIndex];
+		auto& mesh = document.Meshes[ref.Mesh];
+		auto& primitive = mesh.Primitives[ref.Primitive];
+		auto& range = ranges[ref.Range];
+		auto& shape = outCooked.Shapes[shapeIndex];
+		std::string meshName = mesh.Name.empty() ? "Mesh" + std::to_string(ref.Mesh) : mesh.Name;
+		shape.Name = UniqueName(usedNames, mesh.Primitives.size() > 1 ? meshName + "_" + std::to_string(ref.Primitive) : meshName);
+
+		CookedShape cookedShape{ .Name = shape.Name, .MaterialIndex = primitive.Material, .BaseVertex = range.BaseVertex, .VertexCount = range.Count, .Bounds = shape.Bounds, .BoundingSphere = shape.BoundingSphere };
+		if (!shape.Indices16.empty())
+		{
+			cookedShape.IndexStride = sizeof(uint16_t);
+			cookedShape.Indices = std::as_bytes(std::span(shape.Indices16));
+		}
+		else if (!shape.Indices32.empty() || primitive.Indices < 0)
+		{
+			cookedShape.IndexStride = sizeof(uint32_t);
+			cookedShape.Indices = std::as_bytes(std::span(shape.Indices32));
+		}
+		else
+		{
+			auto& indices = document.Accessors[primitive.Indices];
+			cookedShape.IndexStride = indices.ElementSize();
+			cookedShape.Indices = indices.Data.first(size_t(indices.Count - indices.Count % 3) * indices.ElementSize());
+		}
+		if (cookedShape.MaterialIndex < 0)
+		{
+			if (defaultMaterial < 0)
+			{
+				defaultMaterial = static_cast<int32_t>(cooked.Materials.size());
+				auto& name = outCooked.MaterialNames.emplace_back(UniqueName(usedNames, "Default"));
+				cooked.Materials.push_back({ .Name = name, .DiffuseColor = Vector3(1.0f, 1.0f, 1.0f) });
+			}
+			cookedShape.MaterialIndex = defaultMaterial;
+		}
+		uint32_t indexCount = static_cast<uint32_t>(cookedShape.Indices.size() / cookedShape.IndexStride);
+		shape.Lod = { .FirstIndex = 0, .IndexCount = indexCount, .Error = 0.0f };
+		cookedShape.Lods = std::span(&shape.Lod, 1);
+		stats.Triangles += indexCount / 3;
+		if (cookedShape.IndexStride == sizeof(uint16_t))
+			stats.Index16Shapes++;
+		else
+			stats.Index32Shapes++;
+		primitiveToShape[shapeIndex] = static_cast<uint32_t>(cooked.Shapes.size());
+		cooked.Shapes.push_back(cookedShape);
+	}
+
+	// Nodes reachable from the scene roots, parents first. Skipped primitives keep the shapes of a mesh contiguous
+	std::vector<std::pair<uint32_t, int32_t>> nodeStack;
+	for (auto it = document.SceneRoots.rbegin(); it != document.SceneRoots.rend(); ++it)
+		nodeStack.push_back({ *it, -1 });
+	while (!nodeStack.empty())
+	{
+		auto [nodeIndex, parent] = nodeStack.back();
+		nodeStack.pop_back();
+		auto& node = document.Nodes[nodeIndex];
+		CookedNode cookedNode{
+			.Name = outCooked.NodeNames.emplace_back(node.Name.empty() ? "Node" + std::to_string(nodeIndex) : node.Name),
+			.Parent = parent,
+			.Translation = Vector3(node.Translation[0] * positionScale, node.Translation[1] * positionScale, node.Translation[2] * positionScale),
+			.Rotation = XMVectorSet(node.Rotation[0], node.Rotation[1], node.Rotation[2], node.Rotation[3]),
+			.Scale = Vector3(node.Scale[0], node.Scale[1], node.Scale[2]),
+			.FirstShape = 0,
+			.ShapeCount = 0 };
+		if (node.Mesh >= 0)
+		{
+			for (uint32_t p = meshFirstPrimitive[node.Mesh]; p < meshFirstPrimitive[node.Mesh + 1]; ++p)
+			{
+				if (primitiveToShape[p] == UINT32_MAX)
+					continue;
+				if (cookedNode.ShapeCount == 0)
+					cookedNode.FirstShape = primitiveToShape[p];
+				cookedNode.ShapeCount++;
+			}
+		}
+		int32_t cookedIndex = static_cast<int32_t>(cooked.Nodes.size());
+		cooked.Nodes.push_back(cookedNode);
+		for (auto child = node.Children.rbegin(); child != node.Children.rend(); ++child)
+			nodeStack.push_back({ *child, cookedIndex });
+	}
+
+	stats.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - importStart).count();
+	return true;
+}
+
+}
\ No newline at end of file
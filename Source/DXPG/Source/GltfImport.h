@@ -0,0 +1,55 @@
+#pragma once
+
+#include "GltfParser.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace dxpg
+{
+
+// Owns everything a CookedModel imported from a GLB file points to. Tightly packed 16 and 32 bit index
+// accessors and embedded images are not copied, the cooked spans point into the mapped file
+struct CookedGlb
+{
+	struct Shape
+	{
+		std::string Name;
+		// Only used when the accessor could not be referenced in place
+		std::vector<uint16_t> Indices16;
+		std::vector<uint32_t> Indices32;
+		MeshLod Lod;
+		DirectX::BoundingBox Bounds;
+		DirectX::BoundingSphere BoundingSphere;
+	};
+
+	MappedFile File;
+	GltfDocument Document;
+	std::vector<std::byte> Vertices;
+	// The cooked model keeps views of these strings, a deque never moves them when it grows
+	std::deque<std::string> MaterialNames;
+	std::deque<std::string> TexturePaths;
+	std::vector<Shape> Shapes;
+	std::deque<std::string> NodeNames;
+	// Primitives that are not triangle lists or reference vertices out of range
+	uint32_t SkippedPrimitives = 0;
+	// Vertex streams without normals, they get smooth normals from the triangles that use them
+	uint32_t GeneratedNormals = 0;
+	CookedModel Model;
+};
+
+// Maps and parses the file and builds the vertex buffer in the requested format, texture coordinates are flipped
+// from the top left origin of glTF to the bottom left origin of OBJ files and the texture loader. Shapes are single LOD and without meshlets, the file is
+// expected to be optimized by whatever exported it. Positions and node translations are multiplied by positionScale
+bool CookGlbModel(std::filesystem::path const& path, VertexFormat format, float positionScale, CookedGlb& outCooked, std::string& outError);
+
+inline bool IsGlbPath(std::filesystem::path const& path)
+{
+	return path.extension() == ".glb" || path.extension() == ".GLB";
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,509 @@
+#include "GltfParser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace dxpg
+{
+
+static uint32_t ComponentSize(GltfComponentType type)
+{
+	switch (type)
+	{
+	case GltfComponentType::Byte:
+	case GltfComponentType::UnsignedByte:
+		return 1;
+	case GltfComponentType::Short:
+	case GltfComponentType::UnsignedShort:
+		return 2;
+	case GltfComponentType::UnsignedInt:
+	case GltfComponentType::Float:
+		return 4;
+	}
+	return 0;
+}
+
+uint32_t GltfAccessor::ElementSize() const
+{
+	return ComponentSize(ComponentType) * ComponentCount;
+}
+
+template<typename T>
+static T ReadUnaligned(std::byte const* data)
+{
+	T value;
+	memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+void GltfAccessor::Read(uint32_t index, std::span<float> outValues) const
+{
+	std::byte const* element = Data.data() + size_t(index) * ByteStride;
+	uint32_t componentSize = ComponentSize(ComponentType);
+	uint32_t count = std::min<uint32_t>(ComponentCount, static_cast<uint32_t>(outValues.size()));
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		std::byte const* component = element + i * componentSize;
+		float value = 0.0f;
+		switch (ComponentType)
+		{
+		case GltfComponentType::Float:
+			value = ReadUnaligned<float>(component);
+			break;
+		case GltfComponentType::UnsignedByte:
+			value = ReadUnaligned<uint8_t>(component);
+			value = Normalized ? value / 255.0f : value;
+			break;
+		case GltfComponentType::UnsignedShort:
+			value = ReadUnaligned<uint16_t>(component);
+			value = Normalized ? value / 65535.0f : value;
+			break;
+		case GltfComponentType::Byte:
+			value = ReadUnaligned<int8_t>(component);
+			value = Normalized ? std::max(value / 127.0f, -1.0f) : value;
+			break;
+		case GltfComponentType::Short:
+			value = ReadUnaligned<int16_t>(component);
+			value = Normalized ? std::max(value / 32767.0f, -1.0f) : value;
+			break;
+		case GltfComponentType::UnsignedInt:
+			value = static_cast<float>(ReadUnaligned<uint32_t>(component));
+			break;
+		}
+		outValues[i] = value;
+	}
+}
+
+uint32_t GltfAccessor::ReadIndex(uint32_t index) const
+{
+	std::byte const* element = Data.data() + size_t(index) * ByteStride;
+	switch (ComponentType)
+	{
+	case GltfComponentType::UnsignedByte:
+		return ReadUnaligned<uint8_t>(element);
+	case GltfComponentType::UnsignedShort:
+		return ReadUnaligned<uint16_t>(element);
+	case GltfComponentType::UnsignedInt:
+		return ReadUnaligned<uint32_t>(element);
+	default:
+		return 0;
+	}
+}
+
+namespace
+{
+
+constexpr uint32_t GlbMagic = 0x46546C67;
+constexpr uint32_t GlbChunkJson = 0x4E4F534A;
+constexpr uint32_t GlbChunkBin = 0x004E4942;
+
+struct BufferView
+{
+	std::span<std::byte const> Data;
+	uint32_t ByteStride = 0;
+};
+
+uint32_t TypeComponentCount(std::string_view type)
+{
+	if (type == "SCALAR")
+		return 1;
+	if (type == "VEC2")
+		return 2;
+	if (type == "VEC3")
+		return 3;
+	if (type == "VEC4" || type == "MAT2")
+		return 4;
+	if (type == "MAT3")
+		return 9;
+	if (type == "MAT4")
+		return 16;
+	return 0;
+}
+
+template<size_t N>
+void ReadFloats(JsonValue const& array, std::array<float, N>& outValues)
+{
+	if (array.Size() != N)
+		return;
+	for (size_t i = 0; i < N; ++i)
+		outValues[i] = static_cast<float>(array[i].AsNumber());
+}
+
+// Splits a column major affine matrix into translation, rotation and scale, shear is dropped
+void DecomposeMatrix(std::array<float, 16> const& m, GltfNode& outNode)
+{
+	outNode.Translation = { m[12], m[13], m[14] };
+	float columns[3][3] = { { m[0], m[1], m[2] }, { m[4], m[5], m[6] }, { m[8], m[9], m[10] } };
+	for (int c = 0; c < 3; ++c)
+	{
+		outNode.Scale[c] = std::sqrt(columns[c][0] * columns[c][0] + columns[c][1] * columns[c][1] + columns[c][2] * columns[c][2]);
+		if (outNode.Scale[c] > 0.0f)
+			for (int r = 0; r < 3; ++r)
+				columns[c][r] /= outNode.Scale[c];
+	}
+	// A mirroring matrix keeps a proper rotation by flipping one axis
+	float det = columns[0][0] * (columns[1][1] * columns[2][2] - columns[2][1] * columns[1][2])
+		- columns[1][0] * (columns[0][1] * columns[2][2] - columns[2][1] * columns[0][2])
+		+ columns[2][0] * (columns[0][1] * columns[1][2] - columns[1][1] * columns[0][2]);
+	if (det < 0.0f)
+	{
+		outNode.Scale[0] = -outNode.Scale[0];
+		for (int r = 0; r < 3; ++r)
+			columns[0][r] = -columns[0][r];
+	}
+
+	// R(row, col) is columns[col][row]
+	auto r = [&](int row, int col) { return columns[col][row]; };
+	float trace = r(0, 0) + r(1, 1) + r(2, 2);
+	float x, y, z, w;
+	if (trace > 0.0f)
+	{
+		float s = std::sqrt(trace + 1.0f) * 2.0f;
+		w = 0.25f * s;
+		x = (r(2, 1) - r(1, 2)) / s;
+		y = (r(0, 2) - r(2, 0)) / s;
+		z = (r(1, 0) - r(0, 1)) / s;
+	}
+	else if (r(0, 0) > r(1, 1) && r(0, 0) > r(2, 2))
+	{
+		float s = std::sqrt(1.0f + r(0, 0) - r(1, 1) - r(2, 2)) * 2.0f;
+		w = (r(2, 1) - r(1, 2)) / s;
+		x = 0.25f * s;
+		y = (r(0, 1) + r(1, 0)) / s;
+		z = (r(0, 2) + r(2, 0)) / s;
+	}
+	else if (r(1, 1) > r(2, 2))
+	{
+		float s = std::sqrt(1.0f + r(1, 1) - r(0, 0) - r(2, 2)) * 2.0f;
+		w = (r(0, 2) - r(2, 0)) / s;
+		x = (r(0, 1) + r(1, 0)) / s;
+		y = 0.25f * s;
+		z = (r(1, 2) + r(2, 1)) / s;
+	}
+	else
+	{
+		float s = std::sqrt(1.0f + r(2, 2) - r(0, 0) - r(1, 1)) * 2.0f;
+		w = (r(1, 0) - r(0, 1)) / s;
+		x = (r(0, 2) + r(2, 0)) / s;
+		y = (r(1, 2) + r(2, 1)) / s;
+		z = 0.25f * s;
+	}
+	outNode.Rotation = { x, y, z, w };
+}
+
+struct GlbReader
+{
+	std::span<std::byte const> Bin;
+	std::vector<BufferView> BufferViews;
+	std::string Error;
+
+	bool Fail(std::string message)
+	{
+		if (Error.empty())
+			Error = std::move(message);
+		return false;
+	}
+
+	// Index members must name an existing element, returns false for absent ones too
+	static bool ValidIndex(JsonValue const& value, size_t count)
+	{
+		int64_t index = value.AsInt();
+		return index >= 0 && uint64_t(index) < count;
+	}
+
+	bool ReadBuffers(JsonValue const& json)
+	{
+		auto& buffers = json["buffers"];
+		for (size_t i = 0; i < buffers.Size(); ++i)
+		{
+			if (!buffers[i]["uri"].IsNull())
+				return Fail("Buffer " + std::to_string(i) + " is external, only the binary chunk is supported");
+			if (uint64_t(buffers[i]["byteLength"].AsInt(0)) > Bin.size())
+				return Fail("Buffer " + std::to_string(i) + " is larger than the binary chunk");
+		}
+
+		auto& views = json["bufferViews"];
+		BufferViews.resize(views.Size());
+		for (size_t i = 0; i < views.Size(); ++i)
+		{
+			auto& view = views[i];
+			if (!ValidIndex(view["buffer"], buffers.Size()))
+				return Fail("Buffer view " + std::to_string(i) + " has no valid buffer");
+			int64_t offset = view["byteOffset"].AsInt(0);
+			int64_t length = view["byteLength"].AsInt(0);
+			if (offset < 0 || length < 0 || uint64_t(offset) + uint64_t(length) > Bin.size())
+				return Fail("Buffer view " + std::to_string(i) + " is out of bounds");
+			BufferViews[i].Data = Bin.subspan(size_t(offset), size_t(length));
+			BufferViews[i].ByteStride = static_cast<uint32_t>(view["byteStride"].AsInt(0));
+		}
+		return true;
+	}
+
+	bool ReadAccessors(JsonValue const& json, GltfDocument& outDocument)
+	{
+		auto& accessors = json["accessors"];
+		outDocument.Accessors.resize(accessors.Size());
+		for (size_t i = 0; i < accessors.Size(); ++i)
+		{
+			auto& source = accessors[i];
+			auto& accessor = outDocument.Accessors[i];
+			std::string name = "Accessor " + std::to_string(i);
+			if (!source["sparse"].IsNull())
+				return Fail(name + " is sparse");
+			if (!ValidIndex(source["bufferView"], BufferViews.size()))
+				return Fail(name + " has no valid buffer view");
+			accessor.ComponentType = static_cast<GltfComponentType>(source["componentType"].AsInt(0));
+			accessor.ComponentCount = TypeComponentCount(source["type"].AsString());
+			if (ComponentSize(accessor.ComponentType) == 0 || accessor.ComponentCount == 0)
+				return Fail(name + " has an unknown type");
+			accessor.Normalized = source["normalized"].AsBool();
+			int64_t count = source["count"].AsInt(0);
+			int64_t offset = source["byteOffset"].AsInt(0);
+			if (count < 0 || count > UINT32_MAX || offset < 0)
+				return Fail(name + " has an invalid count or offset");
+			accessor.Count = static_cast<uint32_t>(count);
+
+			auto& view = BufferViews[size_t(source["bufferView"].AsInt())];
+			accessor.ByteStride = view.ByteStride ? view.ByteStride : accessor.ElementSize();
+			uint64_t byteLength = accessor.Count ? uint64_t(accessor.Count - 1) * accessor.ByteStride + accessor.ElementSize() : 0;
+			if (uint64_t(offset) + byteLength > view.Data.size())
+				return Fail(name + " is out of bounds of its buffer view");
+			accessor.Data = view.Data.subspan(size_t(offset), size_t(byteLength));
+
+			auto& min = source["min"];
+			auto& max = source["max"];
+			if (accessor.ComponentCount == 3 && min.Size() == 3 && max.Size() == 3)
+			{
+				accessor.HasBounds = true;
+				ReadFloats(min, accessor.Min);
+				ReadFloats(max, accessor.Max);
+			}
+		}
+		return true;
+	}
+
+	bool ReadMeshes(JsonValue const& json, GltfDocument& outDocument)
+	{
+		auto& meshes = json["meshes"];
+		size_t accessorCount = outDocument.Accessors.size();
+		size_t materialCount = json["materials"].Size();
+		auto optionalIndex = [](JsonValue const& value, size_t count, int32_t& outIndex)
+		{
+			if (value.IsNull())
+				return true;
+			outIndex = static_cast<int32_t>(value.AsInt());
+			return ValidIndex(value, count);
+		};
+
+		outDocument.Meshes.resize(meshes.Size());
+		for (size_t i = 0; i < meshes.Size(); ++i)
+		{
+			auto& mesh = outDocument.Meshes[i];
+			mesh.Name = meshes[i]["name"].AsString();
+			auto& primitives = meshes[i]["primitives"];
+			mesh.Primitives.resize(primitives.Size());
+			for (size_t p = 0; p < primitives.Size(); ++p)
+			{
+				auto& source = primitives[p];
+				auto& primitive = mesh.Primitives[p];
+				auto& attributes = source["attributes"];
+				primitive.Mode = static_cast<uint32_t>(source["mode"].AsInt(4));
+				if (!optionalIndex(attributes["POSITION"], accessorCount, primitive.Position) || !optionalIndex(attributes["NORMAL"], accessorCount, primitive.Normal)
+					|| !optionalIndex(attributes["TEXCOORD_0"], accessorCount, primitive.TexCoord) || !optionalIndex(source["indices"], accessorCount, primitive.Indices)
+					|| !optionalIndex(source["material"], materialCount, primitive.Material))
+					return Fail("Primitive " + std::to_string(p) + " of mesh " + std::to_string(i) + " references a missing accessor or material");
+			}
+		}
+		return true;
+	}
+
+	bool ReadMaterials(JsonValue const& json, GltfDocument& outDocument)
+	{
+		auto& images = json["images"];
+		outDocument.Images.resize(images.Size());
+		for (size_t i = 0; i < images.Size(); ++i)
+		{
+			auto& image = outDocument.Images[i];
+			image.Name = images[i]["name"].AsString();
+			image.Uri = images[i]["uri"].AsString();
+			image.MimeType = images[i]["mimeType"].AsString();
+			auto& view = images[i]["bufferView"];
+			if (!view.IsNull())
+			{
+				if (!ValidIndex(view, BufferViews.size()))
+					return Fail("Image " + std::to_string(i) + " has no valid buffer view");
+				image.Data = BufferViews[size_t(view.AsInt())].Data;
+			}
+		}
+
+		auto& textures = json["textures"];
+		auto& materials = json["materials"];
+		outDocument.Materials.resize(materials.Size());
+		for (size_t i = 0; i < materials.Size(); ++i)
+		{
+			auto& material = outDocument.Materials[i];
+			auto& pbr = materials[i]["pbrMetallicRoughness"];
+			material.Name = materials[i]["name"].AsString();
+			ReadFloats(pbr["baseColorFactor"], material.BaseColorFactor);
+			auto& texture = pbr["baseColorTexture"]["index"];
+			if (!texture.IsNull())
+			{
+				if (!ValidIndex(texture, textures.Size()))
+					return Fail("Material " + std::to_string(i) + " references a missing texture");
+				auto& source = textures[size_t(texture.AsInt())]["source"];
+				// Textures without a source only carry extension images, they fall back to the base color
+				if (ValidIndex(source, outDocument.Images.size()))
+					material.BaseColorImage = static_cast<int32_t>(source.AsInt());
+			}
+		}
+		return true;
+	}
+
+	bool ReadNodes(JsonValue const& json, GltfDocument& outDocument)
+	{
+		auto& nodes = json["nodes"];
+		outDocument.Nodes.resize(nodes.Size());
+		for (size_t i = 0; i < nodes.Size(); ++i)
+		{
+			auto& source = nodes[i];
+			auto& node = outDocument.Nodes[i];
+			node.Name = source["name"].AsString();
+			if (!source["mesh"].IsNull())
+			{
+				if (!ValidIndex(source["mesh"], outDocument.Meshes.size()))
+					return Fail("Node " + std::to_string(i) + " references a missing mesh");
+				node.Mesh = static_cast<int32_t>(source["mesh"].AsInt());
+			}
+			if (source["matrix"].Size() == 16)
+			{
+				std::array<float, 16> matrix;
+				ReadFloats(source["matrix"], matrix);
+				DecomposeMatrix(matrix, node);
+			}
+			else
+			{
+				ReadFloats(source["translation"], node.Translation);
+				ReadFloats(source["rotation"], node.Rotation);
+				ReadFloats(source["scale"], node.Scale);
+			}
+			auto& children = source["children"];
+			for (size_t c = 0; c < children.Size(); ++c)
+			{
+				if (!ValidIndex(children[c], nodes.Size()))
+					return Fail("Node " + std::to_string(i) + " has an invalid child");
+				node.Children.push_back(static_cast<uint32_t>(children[c].AsInt()));
+			}
+		}
+
+		// Every node has at most one parent, which also rules out cycles through the roots
+		for (uint32_t i = 0; i < outDocument.Nodes.size(); ++i)
+		{
+			for (uint32_t child : outDocument.Nodes[i].Children)
+			{
+				if (outDocument.Nodes[child].Parent != -1 || child == i)
+					return Fail("Node " + std::to_string(child) + " has more than one parent");
+				outDocument.Nodes[child].Parent = static_cast<int32_t>(i);
+			}
+		}
+
+		auto& scenes = json["scenes"];
+		int64_t scene = json["scene"].AsInt(0);
+		if (scenes.Size() > 0)
+		{
+			if (scene < 0 || uint64_t(scene) >= scenes.Size())
+				return Fail("Invalid default scene");
+			// A root listed twice would be imported twice
+			auto& roots = scenes[size_t(scene)]["nodes"];
+			std::vector<bool> isRoot(outDocument.Nodes.size(), false);
+			for (size_t r = 0; r < roots.Size(); ++r)
+			{
+				if (!ValidIndex(roots[r], nodes.Size()) || outDocument.Nodes[size_t(roots[r].AsInt())].Parent != -1)
+					return Fail("Scene root " + std::to_string(r) + " is not a root node");
+				uint32_t root = static_cast<uint32_t>(roots[r].AsInt());
+				if (isRoot[root])
+					return Fail("Scene root " + std::to_string(r) + " is listed twice");
+				isRoot[root] = true;
+				outDocument.SceneRoots.push_back(root);
+			}
+		}
+		else
+		{
+			for (uint32_t i = 0; i < outDocument.Nodes.size(); ++i)
+				if (outDocument.Nodes[i].Parent == -1)
+					outDocument.SceneRoots.push_back(i);
+		}
+		return true;
+	}
+};
+
+}
+
+bool ParseGlb(std::span<std::byte const> glb, GltfDocument& outDocument, std::string& outError)
+{
+	outDocument = {};
+	auto readU32 = [&](size_t offset)
+	{
+		return ReadUnaligned<uint32_t>(glb.data() + offset);
+	};
+	if (glb.size() < 20 || readU32(0) != GlbMagic)
+	{
+		outError = "Not a binary glTF file";
+		return false;
+	}
+	if (readU32(4) != 2)
+	{
+		outError = "Unsupported glTF version " + std::to_string(readU32(4));
+		return false;
+	}
+	size_t length = std::min<size_t>(readU32(8), glb.size());
+
+	// The JSON chunk comes first, an optional binary chunk follows, unknown chunks are skipped
+	std::string_view jsonText;
+	GlbReader reader;
+	bool hasJson = false;
+	for (size_t offset = 12; offset + 8 <= length;)
+	{
+		uint32_t chunkLength = readU32(offset);
+		uint32_t chunkType = readU32(offset + 4);
+		if (offset + 8 + uint64_t(chunkLength) > length)
+		{
+			outError = "Truncated chunk";
+			return false;
+		}
+		auto chunk = glb.subspan(offset + 8, chunkLength);
+		if (chunkType == GlbChunkJson && !hasJson)
+		{
+			jsonText = std::string_view(reinterpret_cast<char const*>(chunk.data()), chunk.size());
+			hasJson = true;
+		}
+		else if (chunkType == GlbChunkBin && hasJson && reader.Bin.empty())
+			reader.Bin = chunk;
+		offset += 8 + ((size_t(chunkLength) + 3) & ~size_t(3));
+	}
+	if (!hasJson)
+	{
+		outError = "Missing JSON chunk";
+		return false;
+	}
+
+	JsonValue json;
+	if (!ParseJson(jsonText, json, outError))
+		return false;
+	if (json["asset"]["version"].AsString().substr(0, 2) != "2.")
+	{
+		outError = "Unsupported asset version";
+		return false;
+	}
+
+	bool ok = reader.ReadBuffers(json) && reader.ReadAccessors(json, outDocument) && reader.ReadMaterials(json, outDocument)
+		&& reader.ReadMeshes(json, outDocument) && reader.ReadNodes(json, outDocument);
+	if (!ok)
+	{
+		outError = std::move(reader.Error);
+		outDocument = {};
+	}
+	return ok;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Json.h"
+
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace dxpg
+{
+
+enum class GltfComponentType : uint32_t
+{
+	Byte = 5120,
+	UnsignedByte = 5121,
+	Short = 5122,
+	UnsignedShort = 5123,
+	UnsignedInt = 5125,
+	Float = 5126
+};
+
+// Typed view of a buffer view, the bytes stay in the file
+struct GltfAccessor
+{
+	// Starts at the first element and ends after the last one
+	std::span<std::byte const> Data;
+	uint32_t Count = 0;
+	// Distance between elements, equal to ElementSize() unless the buffer view interleaves
+	uint32_t ByteStride = 0;
+	GltfComponentType ComponentType = GltfComponentType::Float;
+	// 1 for SCALAR up to 4 for VEC4, 16 for MAT4
+	uint32_t ComponentCount = 1;
+	bool Normalized = false;
+	bool HasBounds = false;
+	std::array<float, 3> Min{};
+	std::array<float, 3> Max{};
+
+	uint32_t ElementSize() const;
+	bool IsTightlyPacked() const { return ByteStride == ElementSize(); }
+	// Reads up to outValues.size() components of an element, missing ones are left untouched.
+	// Normalized integers map to [0, 1] or [-1, 1]
+	void Read(uint32_t index, std::span<float> outValues) const;
+	uint32_t ReadIndex(uint32_t index) const;
+};
+
+struct GltfPrimitive
+{
+	// Accessor indices, -1 when absent
+	int32_t Position = -1;
+	int32_t Normal = -1;
+	int32_t TexCoord = -1;
+	int32_t Indices = -1;
+	int32_t Material = -1;
+	// 4 is a triangle list
+	uint32_t Mode = 4;
+};
+
+struct GltfMesh
+{
+	std::string Name;
+	std::vector<GltfPrimitive> Primitives;
+};
+
+// Either a URI relative to the file or bytes embedded in the binary chunk
+struct GltfImage
+{
+	std::string Name;
+	std::string Uri;
+	std::string MimeType;
+	std::span<std::byte const> Data;
+};
+
+struct GltfMaterial
+{
+	std::string Name;
+	std::array<float, 4> BaseColorFactor = { 1.0f, 1.0f, 1.0f, 1.0f };
+	int32_t BaseColorImage = -1;
+};
+
+// Local transforms given as a matrix are decomposed into translation, rotation and scale
+struct GltfNode
+{
+	std::string Name;
+	int32_t Mesh = -1;
+	int32_t Parent = -1;
+	std::vector<uint32_t> Children;
+	std::array<float, 3> Translation{};
+	// Quaternion, x y z w
+	std::array<float, 4> Rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+	std::array<float, 3> Scale = { 1.0f, 1.0f, 1.0f };
+};
+
+struct GltfDocument
+{
+	std::vector<GltfAccessor> Accessors;
+	std::vector<GltfMesh> Meshes;
+	std::vector<GltfMaterial> Materials;
+	std::vector<GltfImage> Images;
+	std::vector<GltfNode> Nodes;
+	// Root nodes of the default scene
+	std::vector<uint32_t> SceneRoots;
+};
+
+// Parses a binary glTF 2.0 file. Accessors and embedded images point into glb, which has to outlive the document.
+// External buffers and sparse accessors are not supported
+bool ParseGlb(std::span<std::byte const> glb, GltfDocument& outDocument, std::string& outError);
+
+}
\ No newline at end of file
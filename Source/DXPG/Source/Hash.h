@@ -0,0 +1,47 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace dxpg
+{
+
+// 64-bit non-cryptographic hash over 8 byte words with murmur style mixing, fast enough to fingerprint source assets on load
+inline uint64_t HashBytes(std::span<std::byte const> data, uint64_t seed = 0)
+{
+	constexpr uint64_t K1 = 0x87C37B91114253D5ull;
+	constexpr uint64_t K2 = 0x4CF5AD432745937Full;
+	auto mixWord = [](uint64_t word)
+	{
+		return std::rotl(word * K1, 31) * K2;
+	};
+
+	uint64_t hash = seed ^ (data.size() * K2);
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= data.size(); i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, data.data() + i, sizeof(word));
+		hash ^= mixWord(word);
+		hash = std::rotl(hash, 27) * 5 + 0x52DCE729;
+	}
+	if (i < data.size())
+	{
+		uint64_t word = 0;
+		std::memcpy(&word, data.data() + i, data.size() - i);
+		hash ^= mixWord(word);
+	}
+
+	// Final avalanche so every input bit reaches every output bit
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+}
\ No newline at end of file
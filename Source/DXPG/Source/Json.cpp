@@ -0,0 +1,272 @@
+#include "Json.h"
+
+#include <charconv>
+
+namespace dxpg
+{
+
+static JsonValue const NullValue;
+
+JsonValue const* JsonValue::Find(std::string_view key) const
+{
+	if (Kind != JsonKind::Object)
+		return nullptr;
+	for (size_t i = 0; i < Keys.size(); ++i)
+		if (Keys[i] == key)
+			return &Items[i];
+	return nullptr;
+}
+
+JsonValue const& JsonValue::operator[](std::string_view key) const
+{
+	auto* value = Find(key);
+	return value ? *value : NullValue;
+}
+
+JsonValue const& JsonValue::operator[](size_t index) const
+{
+	return Kind == JsonKind::Array && index < Items.size() ? Items[index] : NullValue;
+}
+
+namespace
+{
+
+struct JsonReader
+{
+	static constexpr uint32_t MaxDepth = 256;
+
+	std::string_view Text;
+	size_t Pos = 0;
+	std::string Error;
+
+	bool Fail(char const* message)
+	{
+		if (Error.empty())
+			Error = std::string(message) + " at byte " + std::to_string(Pos);
+		return false;
+	}
+
+	void SkipWhitespace()
+	{
+		while (Pos < Text.size() && (Text[Pos] == ' ' || Text[Pos] == '\t' || Text[Pos] == '\n' || Text[Pos] == '\r'))
+			++Pos;
+	}
+
+	bool Consume(char c)
+	{
+		SkipWhitespace();
+		if (Pos < Text.size() && Text[Pos] == c)
+		{
+			++Pos;
+			return true;
+		}
+		return false;
+	}
+
+	bool Literal(std::string_view literal)
+	{
+		if (Text.substr(Pos, literal.size()) != literal)
+			return Fail("Invalid literal");
+		Pos += literal.size();
+		return true;
+	}
+
+	static void AppendUtf8(std::string& out, uint32_t codePoint)
+	{
+		if (codePoint < 0x80)
+			out += char(codePoint);
+		else if (codePoint < 0x800)
+		{
+			out += char(0xC0 | (codePoint >> 6));
+			out += char(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			out += char(0xE0 | (codePoint >> 12));
+			out += char(0x80 | ((codePoint >> 6) & 0x3F));
+			out += char(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			out += char(0xF0 | (codePoint >> 18));
+			out += char(0x80 | ((codePoint >> 12) & 0x3F));
+			out += char(0x80 | ((codePoint >> 6) & 0x3F));
+			out += char(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	bool Hex4(uint32_t& outValue)
+	{
+		if (Pos + 4 > Text.size())
+			return Fail("Truncated escape");
+		auto result = std::from_chars(Text.data() + Pos, Text.data() + Pos + 4, outValue, 16);
+		if (result.ec != std::errc() || result.ptr != Text.data() + Pos + 4)
+			return Fail("Invalid escape");
+		Pos += 4;
+		return true;
+	}
+
+	bool String(std::string& out)
+	{
+		// The opening quote is consumed by the caller
+		size_t runStart = Pos;
+		while (true)
+		{
+			if (Pos >= Text.size())
+				return Fail("Unterminated string");
+			char c = Text[Pos];
+			if (c == '"')
+			{
+				out.append(Text.substr(runStart, Pos - runStart));
+				++Pos;
+				return true;
+			}
+			if (static_cast<unsigned char>(c) < 0x20)
+				return Fail("Control character in string");
+			if (c != '\\')
+			{
+				++Pos;
+				continue;
+			}
+
+			out.append(Text.substr(runStart, Pos - runStart));
+			if (++Pos >= Text.size())
+				return Fail("Unterminated string");
+			char escape = Text[Pos++];
+			switch (escape)
+			{
+			case '"': out += '"'; break;
+			case '\\': out += '\\'; break;
+			case '/': out += '/'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u':
+			{
+				uint32_t codePoint;
+				if (!Hex4(codePoint))
+					return false;
+				// Surrogate pairs are written as two escapes
+				if (codePoint >= 0xD800 && codePoint < 0xDC00 && Text.substr(Pos, 2) == "\\u")
+				{
+					Pos += 2;
+					uint32_t low;
+					if (!Hex4(low))
+						return false;
+					if (low < 0xDC00 || low >= 0xE000)
+						return Fail("Invalid surrogate pair");
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				}
+				AppendUtf8(out, codePoint);
+				break;
+			}
+			default:
+				return Fail("Invalid escape");
+			}
+			runStart = Pos;
+		}
+	}
+
+	bool Number(double& out)
+	{
+		// Slightly more lenient than JSON, leading zeros are accepted
+		size_t start = Pos;
+		if (Pos < Text.size() && Text[Pos] == '-')
+			++Pos;
+		while (Pos < Text.size() && ((Text[Pos] >= '0' && Text[Pos] <= '9') || Text[Pos] == '.' || Text[Pos] == 'e' || Text[Pos] == 'E' || Text[Pos] == '+' || Text[Pos] == '-'))
+			++Pos;
+		auto result = std::from_chars(Text.data() + start, Text.data() + Pos, out);
+		if (result.ec != std::errc() || result.ptr != Text.data() + Pos)
+		{
+			Pos = start;
+			return Fail("Invalid number");
+		}
+		return true;
+	}
+
+	bool Value(JsonValue& out, uint32_t depth)
+	{
+		if (depth > MaxDepth)
+			return Fail("Nesting too deep");
+		SkipWhitespace();
+		if (Pos >= Text.size())
+			return Fail("Unexpected end");
+
+		char c = Text[Pos];
+		switch (c)
+		{
+		case '{':
+		{
+			++Pos;
+			out.Kind = JsonKind::Object;
+			if (Consume('}'))
+				return true;
+			do
+			{
+				if (!Consume('"'))
+					return Fail("Expected member name");
+				if (!String(out.Keys.emplace_back()))
+					return false;
+				if (!Consume(':'))
+					return Fail("Expected ':'");
+				if (!Value(out.Items.emplace_back(), depth + 1))
+					return false;
+			} while (Consume(','));
+			return Consume('}') || Fail("Expected '}'");
+		}
+		case '[':
+		{
+			++Pos;
+			out.Kind = JsonKind::Array;
+			if (Consume(']'))
+				return true;
+			do
+			{
+				if (!Value(out.Items.emplace_back(), depth + 1))
+					return false;
+			} while (Consume(','));
+			return Consume(']') || Fail("Expected ']'");
+		}
+		case '"':
+			++Pos;
+			out.Kind = JsonKind::String;
+			return String(out.String);
+		case 't':
+			out.Kind = JsonKind::Bool;
+			out.Bool = true;
+			return Literal("true");
+		case 'f':
+			out.Kind = JsonKind::Bool;
+			out.Bool = false;
+			return Literal("false");
+		case 'n':
+			out.Kind = JsonKind::Null;
+			return Literal("null");
+		default:
+			out.Kind = JsonKind::Number;
+			return Number(out.Number);
+		}
+	}
+};
+
+}
+
+bool ParseJson(std::string_view text, JsonValue& outValue, std::string& outError)
+{
+	outValue = {};
+	JsonReader reader;
+	reader.Text = text;
+	bool ok = reader.Value(outValue, 0);
+	if (ok)
+	{
+		reader.SkipWhitespace();
+		if (reader.Pos != text.size())
+			ok = reader.Fail("Trailing characters");
+	}
+	outError = std::move(reader.Error);
+	return ok;
+}
+
+}
\ No newline at end of file
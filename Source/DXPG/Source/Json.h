@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace dxpg
+{
+
+enum class JsonKind : uint8_t
+{
+	Null,
+	Bool,
+	Number,
+	String,
+	Array,
+	Object
+};
+
+// Read-only document tree, lookups of missing members or elements return a null value instead of failing
+struct JsonValue
+{
+	JsonKind Kind = JsonKind::Null;
+	bool Bool = false;
+	double Number = 0.0;
+	std::string String;
+	// Elements of an array or member values of an object
+	std::vector<JsonValue> Items;
+	// Member names of an object, parallel to Items
+	std::vector<std::string> Keys;
+
+	JsonValue const* Find(std::string_view key) const;
+	JsonValue const& operator[](std::string_view key) const;
+	JsonValue const& operator[](size_t index) const;
+	size_t Size() const { return Items.size(); }
+
+	bool IsNull() const { return Kind == JsonKind::Null; }
+	double AsNumber(double fallback = 0.0) const { return Kind == JsonKind::Number ? Number : fallback; }
+	int64_t AsInt(int64_t fallback = -1) const { return Kind == JsonKind::Number ? static_cast<int64_t>(Number) : fallback; }
+	bool AsBool(bool fallback = false) const { return Kind == JsonKind::Bool ? Bool : fallback; }
+	std::string_view AsString() const { return Kind == JsonKind::String ? std::string_view(String) : std::string_view(); }
+};
+
+// Parses a whole RFC 8259 document, outError names the byte offset of the first error
+bool ParseJson(std::string_view text, JsonValue& outValue, std::string& outError);
+
+}
\ No newline at end of file
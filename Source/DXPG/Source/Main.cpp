@@ -24,7 +24,12 @@
 #include "Pipelines/BlitPipeline.h"
 #include "ShaderManager.h"
 #include "TextureManager.h"
+#include "VirtualTextureManager.h"
 #include "ModelManager.h"
+#include "GltfImport.h"
+#include "TaskScheduler.h"
+#include "UploadQueue.h"
+#include "StagingRing.h"
 
 #include "SceneTree.h"
 
@@ -34,12 +39,14 @@ namespace dxpg
 // Data
 static int const                    NUM_FRAMES_IN_FLIGHT = 3;
 static FrameContext                 g_frameContext[NUM_FRAMES_IN_FLIGHT] = {};
+static_assert(NUM_FRAMES_IN_FLIGHT <= MaxFramesInFlight);
 static UINT                         g_frameIndex = 0;
 
 static int const                    NUM_BACK_BUFFERS = 3;
 static ComPtr<ID3D12Device2> g_pd3dDevice = nullptr;
 
 static ComPtr<ID3D12CommandQueue> g_pd3dCommandQueue = nullptr;
+static ComPtr<ID3D12CommandQueue> g_pd3dCopyQueue = nullptr;
 static ComPtr<ID3D12GraphicsCommandList2> g_pd3dCommandList = nullptr;
 static ComPtr<ID3D12Fence> g_fence = nullptr;
 static HANDLE                       g_fenceEvent = nullptr;
@@ -56,6 +63,13 @@ static HWND g_hWnd = nullptr;
 DeferredRenderingPipeline g_DeferredRenderingPipeline;
 BlitPipeline g_BlitPipeline;
 SceneTree g_SceneTree;
+TaskScheduler g_TaskScheduler;
+// Graphics queue uploads: mip generation, streaming and virtual texture tiles
+UploadQueue g_UploadQueue;
+// Model loads, they copy next to the frames
+UploadQueue g_CopyQueue;
+// Instance data and other per frame uploads, closed with the frame's fence value
+StagingRing g_FrameStaging;
 
 static int g_Width = 1920;
 static int g_Height = 1080;
@@ -238,7 +252,7 @@ void CleanupRenderTarget();
 void WaitForLastSubmittedFrame();
 FrameContext* WaitForNextFrameResources();
 
-void LoadSceneData();
+void LoadSceneData(std::string scenePath);
 void UploadToBuffer(ID3D12GraphicsCommandList* cmd, ID3D12Resource* dest, ID3D12Resource** intermediateBuf, size_t size, void* data);
 void UploadToTexture(ID3D12GraphicsCommandList* cmd, ID3D12Resource* dest, ID3D12Resource** intermediateBuf, size_t width, size_t height, size_t componentCount, void* data);
 
@@ -304,11 +318,20 @@ void UIDrawMeshTree(MeshObject* object)
 
 	if (ImGui::TreeNodeEx(object->Name.c_str(), ImGuiTreeNodeFlags_Framed))
     {
-		ImGui::InputFloat3("Position", &object->Position.m128_f32[0], "%.3f");
-		ImGui::InputFloat3("Rotation", &object->Rotation.m128_f32[0], "%.3f");
-		ImGui::InputFloat3("Scale", &object->Scale.m128_f32[0], "%.3f");
-
-        ImGui::Checkbox("TransformOnly", &object->TransformOnly);
+		bool transformChanged = ImGui::InputFloat3("Position", &object->Position.m128_f32[0], "%.3f");
+		transformChanged |= ImGui::InputFloat3("Rotation", &object->Rotation.m128_f32[0], "%.3f");
+		transformChanged |= ImGui::InputFloat3("Scale", &object->Scale.m128_f32[0], "%.3f");
+		if (transformChanged)
+			g_SceneTree.OnTransformChanged(*object);
+
+        if (ImGui::Checkbox("TransformOnly", &object->TransformOnly))
+			g_SceneTree.OnStructureChanged();
+		if (object->IndexedModel)
+		{
+			auto& bounds = object->IndexedModel->Bounds;
+			ImGui::Text("%u triangles, %u vertices", object->IndexedModel->TriangleCount, object->IndexedModel->VertexCount);
+			ImGui::Text("Extents %.3f %.3f %.3f", bounds.Extents.x, bounds.Extents.y, bounds.Extents.z);
+		}
 	    for (auto& child : object->Children)
         {
 		    UIDrawMeshTree(&child);
@@ -369,6 +392,93 @@ void UIUpdate(ImGuiIO& io, bool& showDemoWindow, bool& showAnotherWindow, ImVec4
             ImGui::PopID();
         }
 
+		if (ImGui::CollapsingHeader("Stats", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			ImGui::PushID("Stats");
+			ImGui::Checkbox("Frustum Culling", &g_DeferredRenderingPipeline.EnableFrustumCulling);
+			ImGui::Checkbox("Shadow Caster Culling", &g_DeferredRenderingPipeline.EnableShadowCasterCulling);
+			ImGui::Checkbox("Cluster Culling", &g_DeferredRenderingPipeline.EnableClusterCulling);
+			ImGui::SliderFloat("Cluster Min Culled", &g_DeferredRenderingPipeline.ClusterDraws.MinCulledFraction, 0.0f, 1.0f);
+			int maxClusterDraws = int(g_DeferredRenderingPipeline.ClusterDraws.MaxDraws);
+			if (ImGui::SliderInt("Cluster Max Draws", &maxClusterDraws, 1, 64))
+				g_DeferredRenderingPipeline.ClusterDraws.MaxDraws = uint32_t(maxClusterDraws);
+			ImGui::Checkbox("LOD Selection", &g_DeferredRenderingPipeline.EnableLodSelection);
+			ImGui::SliderFloat("LOD Error (px)", &g_DeferredRenderingPipeline.LodSelection.MaxErrorPixels, 0.25f, 8.0f);
+			auto& cullingStats = g_DeferredRenderingPipeline.GetCameraCullingStats();
+			ImGui::Text("Camera: %u visible, %u culled", cullingStats.Visible, cullingStats.Culled);
+			auto& shadowStats = g_DeferredRenderingPipeline.GetShadowCullingStats();
+			ImGui::Text("Shadow: %u casters, %u culled", shadowStats.Visible, shadowStats.Culled);
+			auto& clusterStats = g_DeferredRenderingPipeline.GetClusterCullingStats();
+			ImGui::Text("Clusters: %u visible, %u culled", clusterStats.Visible, clusterStats.Culled);
+			auto& lodStats = g_DeferredRenderingPipeline.GetLodStats();
+			ImGui::Text("LODs: %u / %u / %u / %u / %u, %u too small", lodStats.Selected[0], lodStats.Selected[1], lodStats.Selected[2], lodStats.Selected[3], lodStats.Selected[4], lodStats.Culled);
+			ImGui::Text("Triangles: %llu of %llu at LOD 0", (unsigned long long)lodStats.Triangles, (unsigned long long)lodStats.FullTriangles);
+			auto& gbufferQueueStats = g_DeferredRenderingPipeline.GetGBufferQueueStats();
+			ImGui::Text("G-Buffer: %u draws, %u instances, %u state changes, %u avoided, %u unbatched", gbufferQueueStats.Draws, gbufferQueueStats.Instances, gbufferQueueStats.StateChanges, gbufferQueueStats.StateChangesAvoided, gbufferQueueStats.Unbatched);
+			auto& shadowQueueStats = g_DeferredRenderingPipeline.GetShadowQueueStats();
+			ImGui::Text("Shadow Map: %u draws, %u instances, %u state changes, %u avoided, %u unbatched", shadowQueueStats.Draws, shadowQueueStats.Instances, shadowQueueStats.StateChanges, shadowQueueStats.StateChangesAvoided, shadowQueueStats.Unbatched);
+			ImGui::Text("Pipeline CPU: %.3f ms%s", g_DeferredRenderingPipeline.GetCpuMilliseconds(), ModelManager::Get().EnableStaticBatching ? ", static batching" : "");
+			ImGui::Text("Loading: %zu tasks, %zu renderables", g_TaskScheduler.ActiveTasks(), g_SceneTree.GetRenderables().size());
+			auto& decodeStats = TextureManager::Get().GetDecodeStats();
+			ImGui::Text("Textures: %u decoded, %u cached (%.1f MiB), %zu pending, %.1f MiB/s per thread", decodeStats.Images, decodeStats.CachedImages,
+				double(decodeStats.CachedBytes) / (1 << 20), TextureManager::Get().PendingTextures(),
+				decodeStats.DecodeMilliseconds > 0.0 ? double(decodeStats.DecodedBytes) / (1 << 20) / (decodeStats.DecodeMilliseconds / 1000.0) : 0.0);
+			auto& sharingStats = TextureManager::Get().GetSharingStats();
+			ImGui::Text("  %u shared by content (%.1f MiB saved), %u shared views (%u descriptors saved)", sharingStats.SharedTextures,
+				double(sharingStats.SavedBytes) / (1 << 20), sharingStats.SharedViews, sharingStats.SavedDescriptors);
+			auto& compressionStats = TextureManager::Get().GetCompressionStats();
+			ImGui::Text("Compression %s: %u BC1, %u BC3, %u BC4, %u BC7, %u cached, %.1f Mtexels/s per thread, %.2f dB PSNR", TextureCompressionName(TextureManager::Get().Compression),
+				compressionStats.Textures[uint32_t(BlockFormat::BC1)], compressionStats.Textures[uint32_t(BlockFormat::BC3)], compressionStats.Textures[uint32_t(BlockFormat::BC4)],
+				compressionStats.Textures[uint32_t(BlockFormat::BC7)], compressionStats.Cached, compressionStats.MegatexelsPerSecond(), compressionStats.Psnr());
+			ImGui::Text("  %.1f MiB instead of %.1f MiB as RGBA8, %.1f MiB saved", double(compressionStats.CompressedBytes) / (1 << 20), double(compressionStats.UncompressedBytes) / (1 << 20),
+				double(compressionStats.UncompressedBytes - compressionStats.CompressedBytes) / (1 << 20));
+			{
+				StagingStats staging;
+				for (auto const& stats : { g_UploadQueue.GetStagingStats(), g_CopyQueue.GetStagingStats(), g_FrameStaging.GetStats() })
+				{
+					staging.UsedBytes += stats.UsedBytes;
+					staging.CapacityBytes += stats.CapacityBytes;
+					staging.RingAllocations += stats.RingAllocations;
+					staging.DedicatedAllocations += stats.DedicatedAllocations;
+				}
+				ImGui::Text("Staging: %.1f of %.1f MiB in flight, %llu sub-allocations, %llu dedicated buffers", double(staging.UsedBytes) / (1 << 20),
+					double(staging.CapacityBytes) / (1 << 20), (unsigned long long)staging.RingAllocations, (unsigned long long)staging.DedicatedAllocations);
+			}
+			if (TextureManager::Get().EnableStreaming)
+			{
+				auto& streamingStats = TextureManager::Get().GetStreamingStats();
+				auto& streamingSettings = TextureManager::Get().StreamingSettings;
+				ImGui::Text("Streaming: %u textures, %.1f of %.1f MiB budget, %.1f MiB wanted, %.1f MiB fully resident", streamingStats.Textures,
+					double(streamingStats.AllocatedBytes) / (1 << 20), double(streamingSettings.BudgetBytes) / (1 << 20), double(streamingStats.WantedBytes) / (1 << 20), double(streamingStats.FullBytes) / (1 << 20));
+				ImGui::Text("  %u grown, %u evicted, %.1f MiB uploaded", streamingStats.Grown, streamingStats.Evicted, double(streamingStats.UploadedBytes) / (1 << 20));
+				int budgetMiB = int(streamingSettings.BudgetBytes >> 20);
+				if (ImGui::SliderInt("Texture Budget (MiB)", &budgetMiB, 16, 2048))
+					streamingSettings.BudgetBytes = uint64_t(budgetMiB) << 20;
+				ImGui::SliderFloat("Texture Mip Bias", &streamingSettings.MipBias, -3.0f, 3.0f);
+			}
+			if (TextureManager::Get().EnableVirtualTexturing)
+			{
+				auto& virtualStats = VirtualTextureManager::Get().GetStats();
+				auto& tileStats = VirtualTextureManager::Get().GetTileStats();
+				ImGui::Text("Virtual Textures: %u, %u feedback texels, %u tiles requested, %u missing", virtualStats.Textures, virtualStats.FeedbackTexels, tileStats.Requested, tileStats.Missing);
+				ImGui::Text("  %u of %u tiles resident, %llu mapped, %llu evicted, %.1f MiB uploaded", tileStats.Resident, tileStats.Slots,
+					(unsigned long long)tileStats.Mapped, (unsigned long long)tileStats.Evicted, double(virtualStats.UploadedBytes) / (1 << 20));
+			}
+			auto& sceneStats = g_SceneTree.GetStats();
+			ImGui::Text("Scene: %llu triangles, %llu vertices", (unsigned long long)sceneStats.Triangles, (unsigned long long)sceneStats.Vertices);
+			auto& geometry = ModelManager::Get().Geometry;
+			auto showPool = [](char const* name, GeometryBufferPool const& pool)
+			{
+				auto poolStats = pool.GetStats();
+				ImGui::Text("%s: %zu blocks, %u ranges, %.1f of %.1f MiB free, %.0f%% fragmented", name, pool.BlockCount(), poolStats.Allocations,
+					double(poolStats.FreeUnits) * pool.Stride / (1 << 20), double(poolStats.Size) * pool.Stride / (1 << 20), poolStats.Fragmentation() * 100.0f);
+			};
+			showPool("Vertices", geometry.Vertices(VertexFormat::Quantized));
+			showPool("Vertices (Full)", geometry.Vertices(VertexFormat::Full));
+			showPool("Indices", geometry.Indices);
+			ImGui::PopID();
+		}
+
 		UIDrawMeshTree(&g_SceneTree.Root);
 
         ImGui::End();
@@ -450,8 +560,16 @@ void Render(ImGuiIO& io, bool& showDemoWindow, bool& showAnotherWindow, ImVec4&
     FrameContext* frameCtx = WaitForNextFrameResources();
     BeginFrame(*frameCtx);
     UINT backBufferIdx = g_pSwapChain->GetCurrentBackBufferIndex();
-    
-    SceneDataView sceneDataView{.RenderableList = g_SceneTree.SceneToRenderableList(), .Light = g_DirectionalLight.ToLightData(), .LightView = g_DirectionalLight.ToViewData()};
+
+    // Loading tasks advance between frames, shapes whose uploads were submitted join the scene before it is updated
+    g_UploadQueue.Retire();
+    g_CopyQueue.Retire();
+    g_TaskScheduler.Pump();
+    g_SceneTree.Update();
+    // Sized after last frame's draws, the views this frame binds see the new resources
+    TextureManager::Get().UpdateStreaming(g_DeferredRenderingPipeline.GetTextureUses(), g_UploadQueue);
+    VirtualTextureManager::Get().Update(g_DeferredRenderingPipeline.GetTileFeedback(), g_UploadQueue);
+    SceneDataView sceneDataView{.RenderableList = g_SceneTree.GetRenderables(), .RenderableBounds = &g_SceneTree.GetRenderableBounds(), .Light = g_DirectionalLight.ToLightData(), .LightView = g_DirectionalLight.ToViewData()};
 	g_DeferredRenderingPipeline.Run(g_pd3dCommandList.Get(), g_Cam.ToViewData(), sceneDataView, *frameCtx);
 
     DXTexture* selectedView = nullptr;
@@ -488,6 +606,8 @@ void Render(ImGuiIO& io, bool& showDemoWindow, bool& showAnotherWindow, ImVec4&
 
     ID3D12CommandList* ppCommandLists[] = { g_pd3dCommandList.Get() };
 
+    // Only frames drawing shapes of a copy batch still in flight wait for it
+    g_CopyQueue.WaitOn(g_pd3dCommandQueue.Get(), g_DeferredRenderingPipeline.GetUploadFence());
     g_pd3dCommandQueue->ExecuteCommandLists(1, ppCommandLists);
 
     g_pSwapChain->Present(1, 0); // Present with vsync
@@ -497,6 +617,7 @@ void Render(ImGuiIO& io, bool& showDemoWindow, bool& showAnotherWindow, ImVec4&
     g_pd3dCommandQueue->Signal(g_fence.Get(), fenceValue);
     g_fenceLastSignaledValue = fenceValue;
     frameCtx->FenceValue = fenceValue;
+    g_FrameStaging.Close(fenceValue);
     EndFrame(*frameCtx);
 }
 
@@ -538,8 +659,9 @@ bool CreateDeviceD3D()
 		g_CPUDescriptorAllocator->CreateHeapType(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1024);
 
         g_GPUDescriptorAllocator = GPUDescriptorHeapAllocator::Create(g_pd3dDevice.Get());
-		g_GPUDescriptorAllocator->CreateHeapType(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 2048*12, NUM_BACK_BUFFERS, 2048*8);
-		g_GPUDescriptorAllocator->CreateHeapType(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 1024, NUM_BACK_BUFFERS);
+		// One page per frame in flight and one per upload batch in flight
+		g_GPUDescriptorAllocator->CreateHeapType(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 2048*14, NUM_BACK_BUFFERS + UploadQueue::ContextCount, 2048*8);
+		g_GPUDescriptorAllocator->CreateHeapType(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 1024, NUM_BACK_BUFFERS + UploadQueue::ContextCount);
 
     }
 
@@ -557,10 +679,28 @@ bool CreateDeviceD3D()
         if (g_pd3dDevice->CreateCommandQueue(&desc, IID_PPV_ARGS(&g_pd3dCommandQueue)) != S_OK)
             return false;
     }
+    {
+        D3D12_COMMAND_QUEUE_DESC desc = {};
+        desc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+        desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        desc.NodeMask = 1;
+        if (g_pd3dDevice->CreateCommandQueue(&desc, IID_PPV_ARGS(&g_pd3dCopyQueue)) != S_OK)
+            return false;
+    }
+    g_UploadQueue.Init(g_pd3dDevice.Get(), g_pd3dCommandQueue.Get());
+    g_CopyQueue.Init(g_pd3dDevice.Get(), g_pd3dCopyQueue.Get());
+    // 256 MiB of 64KB tiles
+    VirtualTextureManager::Create();
+    VirtualTextureManager::Get().Init(g_pd3dDevice.Get(), g_pd3dCommandQueue.Get(), 4096);
 
+    g_FrameStaging.Init(g_pd3dDevice.Get(), L"FrameStaging", 4ull << 20, 4);
     for (UINT i = 0; i < NUM_FRAMES_IN_FLIGHT; i++)
+    {
         if (g_pd3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&g_frameContext[i].CommandAllocator)) != S_OK)
             return false;
+        g_frameContext[i].Staging = &g_FrameStaging;
+        g_frameContext[i].Slot = i;
+    }
 
     if (g_pd3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&FrameIndependentCtx.CommandAllocator)) != S_OK)
 			return false;
@@ -587,6 +727,7 @@ void CleanupDeviceD3D()
 {
 	ModelManager::Destroy();
     TextureManager::Destroy();
+    VirtualTextureManager::Destroy();
     CleanupRenderTarget();
     if (g_pSwapChain) { g_pSwapChain->SetFullscreenState(false, nullptr); g_pSwapChain = nullptr; }
     if (g_hSwapChainWaitableObject != nullptr) { CloseHandle(g_hSwapChainWaitableObject); }
@@ -595,7 +736,11 @@ void CleanupDeviceD3D()
     FrameIndependentCtx.CommandAllocator = nullptr;
     g_DeferredRenderingPipeline = {};
 	g_BlitPipeline = {};
+	g_UploadQueue = {};
+	g_CopyQueue = {};
+	g_FrameStaging.Shutdown();
     g_pd3dCommandQueue = nullptr;
+    g_pd3dCopyQueue = nullptr;
     g_pd3dCommandList = nullptr;
     g_fence = nullptr;
     g_CPUDescriptorAllocator = nullptr;
@@ -733,38 +878,34 @@ FrameContext* WaitForNextFrameResources()
 
     WaitForMultipleObjects(numWaitableObjects, waitableObjects, TRUE, INFINITE);
     ClearFrame(*frameCtx);
+    g_FrameStaging.Reclaim(g_fence->GetCompletedValue());
     
     return frameCtx;
 }
 
-void LoadSceneData()
+void LoadSceneData(std::string scenePath)
 {
-
-    ClearFrame(FrameIndependentCtx);
-    BeginFrame(FrameIndependentCtx);
-
-
+    // Shapes join the scene as soon as their uploads are submitted, the frame loop renders whatever is loaded so far
+    if (!IsGlbPath(scenePath))
     {
-        auto sponzaObj = ModelManager::Get().LoadModel(DXPG_SPONZA_DIR "sponza.obj", FrameIndependentCtx, g_pd3dCommandList.Get());
-        auto* sponzaRoot = g_SceneTree.AddObject(MeshObject("SponzaRoot"));
-        for (auto& [indexed, materialInfo] : sponzaObj->Objects)
-			auto* mesh = g_SceneTree.AddObject(MeshObject(indexed->Name, indexed, materialInfo), sponzaRoot);
+        auto* sceneRoot = g_SceneTree.AddObject(MeshObject("SceneRoot"));
+        g_TaskScheduler.Spawn([](std::string path, MeshObject* root) -> Task<void>
+        {
+            co_await ModelManager::Get().LoadModelAsync(path, g_TaskScheduler, g_UploadQueue, g_CopyQueue, [root](IndexedModel* indexedModel, Material* material)
+            {
+                g_SceneTree.AddObject(MeshObject(indexedModel->Name, indexedModel, material), root);
+            });
+        }(scenePath, sceneRoot));
+        return;
     }
 
-    //Execute and flush
-    EndFrame(FrameIndependentCtx);
-    g_pd3dCommandList->Close();
-    ID3D12CommandList* ppCommandLists[] = { g_pd3dCommandList.Get() };
-    g_pd3dCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-
-    ComPtr<ID3D12Fence> fence;
-    g_pd3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
-    g_pd3dCommandQueue->Signal(fence.Get(), 1);
-    HANDLE fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    fence->SetEventOnCompletion(1, fenceEvent);
-    WaitForSingleObject(fenceEvent, INFINITE);
-	CloseHandle(fenceEvent);
-    ClearFrame(FrameIndependentCtx);
+    // glTF scenes keep their node hierarchy, which only exists once every shape is loaded
+    g_TaskScheduler.Spawn([](std::string path) -> Task<void>
+    {
+        ObjModel* model = co_await ModelManager::Get().LoadModelAsync(path, g_TaskScheduler, g_UploadQueue, g_CopyQueue, nullptr);
+        if (model)
+            g_SceneTree.AddObject(InstantiateModel(*model, std::filesystem::path(path).stem().string()));
+    }(scenePath));
 }
 
 void UploadToBuffer(ID3D12GraphicsCommandList* cmd, ID3D12Resource* dest, ID3D12Resource** intermediateBuf, size_t size, void* data)
@@ -815,6 +956,30 @@ void UploadToTexture(ID3D12GraphicsCommandList* cmd, ID3D12Resource* dest, ID3D1
 int main(int argv, char** args)
 {
     using namespace::dxpg;
+    // An OBJ or GLB scene can be passed on the command line, relative to the directory it was started from
+    std::string scenePath = DXPG_SPONZA_DIR "sponza.obj";
+    bool staticBatching = false;
+    TextureCompression textureCompression = TextureCompression::Fast;
+    bool textureStreaming = false;
+    bool virtualTexturing = false;
+    for (int i = 1; i < argv; ++i)
+    {
+        std::string_view arg = args[i];
+        if (arg == "--static-batching")
+            staticBatching = true;
+        else if (arg == "--texture-compression=none")
+            textureCompression = TextureCompression::None;
+        else if (arg == "--texture-compression=fast")
+            textureCompression = TextureCompression::Fast;
+        else if (arg == "--texture-compression=high")
+            textureCompression = TextureCompression::HighQuality;
+        else if (arg == "--texture-streaming")
+            textureStreaming = true;
+        else if (arg == "--virtual-texturing")
+            virtualTexturing = true;
+        else
+            scenePath = std::filesystem::absolute(args[i]).string();
+    }
     // Set working directory to executable directory
     {
         WCHAR path[MAX_PATH];
@@ -891,7 +1056,13 @@ int main(int argv, char** args)
     //IM_ASSERT(font != nullptr);
 
     InitGame();
-    LoadSceneData();
+    g_TaskScheduler.Init();
+    ModelManager::Get().EnableStaticBatching = staticBatching;
+    TextureManager::Get().Compression = textureCompression;
+    TextureManager::Get().EnableStreaming = textureStreaming;
+    TextureManager::Get().EnableVirtualTexturing = virtualTexturing && VirtualTextureManager::Get().IsSupported();
+    g_DeferredRenderingPipeline.EnableTileFeedback = TextureManager::Get().EnableVirtualTexturing;
+    LoadSceneData(scenePath);
     SDL_SetRelativeMouseMode(SDL_TRUE);
     // Main loop
     bool done = false;
@@ -953,6 +1124,12 @@ int main(int argv, char** args)
     }
 
 
+    // Loads still running at exit stop at their next step and are drained, so no task is left holding GPU resources
+    g_TaskScheduler.Cancel();
+    g_TaskScheduler.RunUntilIdle();
+    g_TaskScheduler.Shutdown();
+    g_UploadQueue.Shutdown();
+    g_CopyQueue.Shutdown();
     WaitForLastSubmittedFrame();
 
     // Cleanup
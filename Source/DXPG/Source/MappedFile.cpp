@@ -0,0 +1,137 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dxpg
+{
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		std::swap(Bytes, other.Bytes);
+		std::swap(Size, other.Size);
+		std::swap(Opened, other.Opened);
+#ifdef _WIN32
+		std::swap(FileHandle, other.FileHandle);
+		std::swap(MappingHandle, other.MappingHandle);
+#endif
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(std::filesystem::path const& path)
+{
+	Close();
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	FileHandle = file;
+	Opened = true;
+	// Empty files can not be mapped, they are open with an empty view
+	if (fileSize.QuadPart == 0)
+		return true;
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void const* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		if (mapping)
+			CloseHandle(mapping);
+		Close();
+		return false;
+	}
+	MappingHandle = mapping;
+	Bytes = static_cast<std::byte const*>(view);
+	Size = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (Bytes)
+		UnmapViewOfFile(Bytes);
+	if (MappingHandle)
+		CloseHandle(MappingHandle);
+	if (FileHandle)
+		CloseHandle(FileHandle);
+	Bytes = nullptr;
+	Size = 0;
+	Opened = false;
+	MappingHandle = nullptr;
+	FileHandle = nullptr;
+}
+#else
+bool MappedFile::Open(std::filesystem::path const& path)
+{
+	Close();
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat fileStat{};
+	if (fstat(file, &fileStat) != 0)
+	{
+		close(file);
+		return false;
+	}
+	Opened = true;
+	if (fileStat.st_size == 0)
+	{
+		close(file);
+		return true;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping keeps its own reference to the file
+	close(file);
+	if (view == MAP_FAILED)
+	{
+		Opened = false;
+		return false;
+	}
+	Bytes = static_cast<std::byte const*>(view);
+	Size = static_cast<size_t>(fileStat.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (Bytes)
+		munmap(const_cast<std::byte*>(Bytes), Size);
+	Bytes = nullptr;
+	Size = 0;
+	Opened = false;
+}
+#endif
+
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace dxpg
+{
+
+// Read-only mapping of a whole file, the view stays valid until the object is closed or destroyed
+struct MappedFile
+{
+	MappedFile() = default;
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	bool Open(std::filesystem::path const& path);
+	void Close();
+
+	bool IsOpen() const { return Opened; }
+	std::span<std::byte const> Data() const { return { Bytes, Size }; }
+
+private:
+	std::byte const* Bytes = nullptr;
+	size_t Size = 0;
+	bool Opened = false;
+#ifdef _WIN32
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#endif
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "DirectXMath.h"
+#include "DirectXCollision.h"
+using namespace DirectX;
+using Matrix4x4 = DirectX::XMMATRIX;
+using Vector4 = DirectX::XMVECTOR;
+using Vector3 = DirectX::XMFLOAT3;
+using Vector2 = DirectX::XMFLOAT2;
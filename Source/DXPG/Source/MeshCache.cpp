@@ -0,0 +1,296 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "Hash.h"
+
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+
+namespace dxpg
+{
+
+namespace
+{
+constexpr uint32_t MeshCacheMagic = 0x434D5844; // "DXMC"
+// Layout of the file itself, MeshImporterVersion covers its content
+constexpr uint32_t MeshCacheFormatVersion = 1;
+// Every blob starts aligned so typed views into the mapping are valid
+constexpr uint64_t BlobAlignment = 16;
+
+struct BlobRef
+{
+	uint64_t Offset;
+	uint64_t Size;
+};
+
+struct FileHeader
+{
+	uint32_t Magic;
+	uint32_t FormatVersion;
+	uint32_t ImporterVersion;
+	uint32_t VertexFormat;
+	uint64_t SourceSize;
+	int64_t SourceWriteTime;
+	uint64_t SourceHash;
+	uint32_t VertexStride;
+	uint32_t MaterialCount;
+	uint32_t ShapeCount;
+	uint32_t Padding;
+	BlobRef Vertices;
+	BlobRef Materials;
+	BlobRef Shapes;
+	MeshImportStats Stats;
+};
+
+struct MaterialRecord
+{
+	BlobRef Name;
+	BlobRef DiffuseTexture;
+	Vector3 DiffuseColor;
+	uint32_t Padding;
+};
+
+struct ShapeRecord
+{
+	BlobRef Name;
+	int32_t MaterialIndex;
+	uint32_t BaseVertex;
+	uint32_t VertexCount;
+	uint32_t IndexStride;
+	BlobRef Indices;
+	BlobRef Lods;
+	BlobRef Meshlets;
+	BlobRef MeshletVertices;
+	BlobRef MeshletTriangles;
+	DirectX::BoundingBox Bounds;
+	DirectX::BoundingSphere BoundingSphere;
+};
+
+static_assert(std::is_trivially_copyable_v<FileHeader> && std::is_trivially_copyable_v<ShapeRecord>);
+
+template<typename T>
+std::span<std::byte const> AsBytes(std::span<T const> data)
+{
+	return std::as_bytes(data);
+}
+
+std::span<std::byte const> AsBytes(std::string_view text)
+{
+	return { reinterpret_cast<std::byte const*>(text.data()), text.size() };
+}
+
+struct CacheWriter
+{
+	std::vector<std::byte> Bytes;
+
+	BlobRef Append(std::span<std::byte const> data)
+	{
+		Bytes.resize((Bytes.size() + BlobAlignment - 1) / BlobAlignment * BlobAlignment);
+		BlobRef blob{ .Offset = Bytes.size(), .Size = data.size() };
+		Bytes.insert(Bytes.end(), data.begin(), data.end());
+		return blob;
+	}
+};
+
+struct CacheReader
+{
+	std::span<std::byte const> Data;
+
+	bool Valid(BlobRef const& blob, size_t elementSize, size_t elementAlignment) const
+	{
+		return blob.Offset <= Data.size() && blob.Size <= Data.size() - blob.Offset
+			&& blob.Size % elementSize == 0 && blob.Offset % elementAlignment == 0;
+	}
+
+	template<typename T>
+	bool Get(BlobRef const& blob, std::span<T const>& outView) const
+	{
+		if (!Valid(blob, sizeof(T), alignof(T)))
+			return false;
+		outView = { reinterpret_cast<T const*>(Data.data() + blob.Offset), static_cast<size_t>(blob.Size / sizeof(T)) };
+		return true;
+	}
+
+	bool Get(BlobRef const& blob, std::string_view& outText) const
+	{
+		if (!Valid(blob, 1, 1))
+			return false;
+		outText = { reinterpret_cast<char const*>(Data.data() + blob.Offset), static_cast<size_t>(blob.Size) };
+		return true;
+	}
+};
+}
+
+bool MakeMeshCacheKey(std::filesystem::path const& sourcePath, VertexFormat format, MeshCacheKey& outKey)
+{
+	std::error_code error;
+	auto size = std::filesystem::file_size(sourcePath, error);
+	if (error)
+		return false;
+	auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+	if (error)
+		return false;
+
+	outKey.SourcePath = sourcePath;
+	outKey.SourceSize = size;
+	outKey.SourceWriteTime = writeTime.time_since_epoch().count();
+	outKey.Format = format;
+	outKey.ImporterVersion = MeshImporterVersion;
+	return true;
+}
+
+std::filesystem::path MeshCachePath(std::filesystem::path const& sourcePath)
+{
+	auto cachePath = sourcePath;
+	cachePath += ".meshcache";
+	return cachePath;
+}
+
+uint64_t HashFile(std::filesystem::path const& path)
+{
+	MappedFile file;
+	if (!file.Open(path))
+		return 0;
+	return HashBytes(file.Data());
+}
+
+bool WriteMeshCache(std::filesystem::path const& cachePath, MeshCacheKey const& key, CookedModel const& model)
+{
+	CacheWriter writer;
+	writer.Bytes.resize(sizeof(FileHeader));
+
+	FileHeader header{};
+	header.Magic = MeshCacheMagic;
+	header.FormatVersion = MeshCacheFormatVersion;
+	header.ImporterVersion = key.ImporterVersion;
+	header.VertexFormat = static_cast<uint32_t>(model.Format);
+	header.SourceSize = key.SourceSize;
+	header.SourceWriteTime = key.SourceWriteTime;
+	header.SourceHash = HashFile(key.SourcePath);
+	header.VertexStride = model.VertexStride;
+	header.MaterialCount = static_cast<uint32_t>(model.Materials.size());
+	header.ShapeCount = static_cast<uint32_t>(model.Shapes.size());
+	header.Stats = model.Stats;
+	header.Vertices = writer.Append(model.Vertices);
+
+	std::vector<MaterialRecord> materials;
+	materials.reserve(model.Materials.size());
+	for (auto& material : model.Materials)
+	{
+		materials.push_back({
+			.Name = writer.Append(AsBytes(material.Name)),
+			.DiffuseTexture = writer.Append(AsBytes(material.DiffuseTexture)),
+			.DiffuseColor = material.DiffuseColor,
+			.Padding = 0 });
+	}
+
+	std::vector<ShapeRecord> shapes;
+	shapes.reserve(model.Shapes.size());
+	for (auto& shape : model.Shapes)
+	{
+		shapes.push_back({
+			.Name = writer.Append(AsBytes(shape.Name)),
+			.MaterialIndex = shape.MaterialIndex,
+			.BaseVertex = shape.BaseVertex,
+			.VertexCount = shape.VertexCount,
+			.IndexStride = shape.IndexStride,
+			.Indices = writer.Append(shape.Indices),
+			.Lods = writer.Append(AsBytes(shape.Lods)),
+			.Meshlets = writer.Append(AsBytes(shape.Meshlets)),
+			.MeshletVertices = writer.Append(AsBytes(shape.MeshletVertices)),
+			.MeshletTriangles = writer.Append(AsBytes(shape.MeshletTriangles)),
+			.Bounds = shape.Bounds,
+			.BoundingSphere = shape.BoundingSphere });
+	}
+	header.Materials = writer.Append(AsBytes(std::span<MaterialRecord const>(materials)));
+	header.Shapes = writer.Append(AsBytes(std::span<ShapeRecord const>(shapes)));
+	std::memcpy(writer.Bytes.data(), &header, sizeof(header));
+
+	auto tempPath = cachePath;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+		file.write(reinterpret_cast<char const*>(writer.Bytes.data()), static_cast<std::streamsize>(writer.Bytes.size()));
+		if (!file)
+			return false;
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool ReadMeshCache(std::span<std::byte const> data, MeshCacheKey const& key, CookedModel& outModel)
+{
+	if (data.size() < sizeof(FileHeader))
+		return false;
+	FileHeader header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (header.Magic != MeshCacheMagic || header.FormatVersion != MeshCacheFormatVersion || header.ImporterVersion != key.ImporterVersion)
+		return false;
+	if (header.VertexFormat != static_cast<uint32_t>(key.Format) || header.SourceSize != key.SourceSize)
+		return false;
+	// A touched but unchanged source, e.g. after a checkout, keeps its cache
+	if (header.SourceWriteTime != key.SourceWriteTime && header.SourceHash != HashFile(key.SourcePath))
+		return false;
+
+	CacheReader reader{ data };
+	std::span<MaterialRecord const> materials;
+	std::span<ShapeRecord const> shapes;
+	if (!reader.Get(header.Vertices, outModel.Vertices) || !reader.Get(header.Materials, materials) || !reader.Get(header.Shapes, shapes))
+		return false;
+	if (materials.size() != header.MaterialCount || shapes.size() != header.ShapeCount)
+		return false;
+	if (header.VertexStride == 0 || outModel.Vertices.size() % header.VertexStride != 0)
+		return false;
+
+	outModel.Format = static_cast<VertexFormat>(header.VertexFormat);
+	outModel.VertexStride = header.VertexStride;
+	outModel.Stats = header.Stats;
+	uint32_t vertexCount = static_cast<uint32_t>(outModel.Vertices.size() / header.VertexStride);
+
+	outModel.Materials.resize(materials.size());
+	for (size_t i = 0; i < materials.size(); ++i)
+	{
+		auto& material = outModel.Materials[i];
+		if (!reader.Get(materials[i].Name, material.Name) || !reader.Get(materials[i].DiffuseTexture, material.DiffuseTexture))
+			return false;
+		material.DiffuseColor = materials[i].DiffuseColor;
+	}
+
+	outModel.Shapes.resize(shapes.size());
+	for (size_t i = 0; i < shapes.size(); ++i)
+	{
+		auto& record = shapes[i];
+		auto& shape = outModel.Shapes[i];
+		if (!reader.Get(record.Name, shape.Name) || !reader.Get(record.Lods, shape.Lods) || !reader.Get(record.Meshlets, shape.Meshlets)
+			|| !reader.Get(record.MeshletVertices, shape.MeshletVertices) || !reader.Get(record.MeshletTriangles, shape.MeshletTriangles))
+			return false;
+		if ((record.IndexStride != 2 && record.IndexStride != 4) || !reader.Valid(record.Indices, record.IndexStride, record.IndexStride))
+			return false;
+		if (record.MaterialIndex >= static_cast<int32_t>(materials.size()) || record.BaseVertex > vertexCount || record.VertexCount > vertexCount - record.BaseVertex)
+			return false;
+		shape.Indices = data.subspan(record.Indices.Offset, record.Indices.Size);
+		shape.MaterialIndex = record.MaterialIndex;
+		shape.BaseVertex = record.BaseVertex;
+		shape.VertexCount = record.VertexCount;
+		shape.IndexStride = record.IndexStride;
+		shape.Bounds = record.Bounds;
+		shape.BoundingSphere = record.BoundingSphere;
+
+		uint64_t indexCount = record.Indices.Size / record.IndexStride;
+		for (auto& lod : shape.Lods)
+			if (uint64_t(lod.FirstIndex) + lod.IndexCount > indexCount)
+				return false;
+	}
+	return true;
+}
+
+}
\ No newline at end of file
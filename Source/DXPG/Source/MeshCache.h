@@ -0,0 +1,101 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "MeshImport.h"
+#include "MeshLod.h"
+#include "Meshlet.h"
+#include "VertexQuantization.h"
+
+namespace dxpg
+{
+
+// Bump whenever the importer output changes, older caches are then cooked again
+constexpr uint32_t MeshImporterVersion = 1;
+
+// Imported model in its GPU layout. All views point into storage owned by whoever filled it,
+// either the importer or a mapped cache file.
+struct CookedMaterial
+{
+	std::string_view Name;
+	// Relative to the model's folder, empty without a diffuse texture
+	std::string_view DiffuseTexture;
+	// Encoded image embedded in the model file, DiffuseTexture then only names it. Never cached
+	std::span<std::byte const> DiffuseTextureData;
+	Vector3 DiffuseColor;
+};
+
+struct CookedShape
+{
+	std::string_view Name;
+	// Into CookedModel::Materials, -1 without a material
+	int32_t MaterialIndex;
+	uint32_t BaseVertex;
+	uint32_t VertexCount;
+	// 2 or 4 bytes, Indices holds every LOD level
+	uint32_t IndexStride;
+	std::span<std::byte const> Indices;
+	std::span<MeshLod const> Lods;
+	std::span<Meshlet const> Meshlets;
+	std::span<uint32_t const> MeshletVertices;
+	std::span<uint8_t const> MeshletTriangles;
+	DirectX::BoundingBox Bounds;
+	DirectX::BoundingSphere BoundingSphere;
+};
+
+// Node of a scene hierarchy, parents come before their children
+struct CookedNode
+{
+	std::string_view Name;
+	int32_t Parent;
+	// Scaled like the vertex positions
+	Vector3 Translation;
+	// Quaternion, applied after Scale
+	Vector4 Rotation;
+	Vector3 Scale;
+	// Range of CookedModel::Shapes drawn at the node
+	uint32_t FirstShape;
+	uint32_t ShapeCount;
+};
+
+struct CookedModel
+{
+	VertexFormat Format;
+	uint32_t VertexStride;
+	std::span<std::byte const> Vertices;
+	std::vector<CookedMaterial> Materials;
+	std::vector<CookedShape> Shapes;
+	// Empty for OBJ models, their shapes are placed side by side. Never cached
+	std::vector<CookedNode> Nodes;
+	MeshImportStats Stats;
+};
+
+// Identifies the source a cache was cooked from and the settings it was cooked with
+struct MeshCacheKey
+{
+	std::filesystem::path SourcePath;
+	uint64_t SourceSize = 0;
+	int64_t SourceWriteTime = 0;
+	VertexFormat Format = VertexFormat::Full;
+	uint32_t ImporterVersion = MeshImporterVersion;
+};
+
+bool MakeMeshCacheKey(std::filesystem::path const& sourcePath, VertexFormat format, MeshCacheKey& outKey);
+
+// The cache sits next to its source
+std::filesystem::path MeshCachePath(std::filesystem::path const& sourcePath);
+
+uint64_t HashFile(std::filesystem::path const& path);
+
+// Writes through a temporary file so a crash never leaves a truncated cache behind
+bool WriteMeshCache(std::filesystem::path const& cachePath, MeshCacheKey const& key, CookedModel const& model);
+
+// Validates data against the key and fills outModel with views into data, which has to outlive them.
+// A source whose write time changed is still accepted when its content hash matches the one it was cooked from.
+bool ReadMeshCache(std::span<std::byte const> data, MeshCacheKey const& key, CookedModel& outModel);
+
+}
\ No newline at end of file
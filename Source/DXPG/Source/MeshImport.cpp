@@ -0,0 +1,158 @@
+#include "MeshImport.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include "Parallel.h"
+
+namespace dxpg
+{
+
+static_assert(sizeof(MeshVertex) == 8 * sizeof(uint32_t));
+
+static uint64_t HashVertex(MeshVertex const& vertex)
+{
+	uint32_t words[8];
+	std::memcpy(words, &vertex, sizeof(words));
+	uint64_t hash = 0x9E3779B97F4A7C15ull;
+	for (uint32_t word : words)
+		hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+	return hash ^ (hash >> 32);
+}
+
+void DeduplicateVertices(std::span<MeshVertex const> corners, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	constexpr uint32_t EmptySlot = ~0u;
+
+	size_t const baseVertex = outVertices.size();
+	outIndices.resize(corners.size());
+	if (corners.empty())
+		return;
+
+	// Open addressing with linear probing, kept at most half full
+	size_t const capacity = std::bit_ceil(corners.size() * 2);
+	size_t const mask = capacity - 1;
+	std::vector<uint32_t> table(capacity, EmptySlot);
+
+	for (size_t i = 0; i < corners.size(); ++i)
+	{
+		auto& corner = corners[i];
+		size_t slot = HashVertex(corner) & mask;
+		while (true)
+		{
+			uint32_t vertex = table[slot];
+			if (vertex == EmptySlot)
+			{
+				vertex = static_cast<uint32_t>(outVertices.size() - baseVertex);
+				table[slot] = vertex;
+				outVertices.push_back(corner);
+				outIndices[i] = vertex;
+				break;
+			}
+			if (std::memcmp(&outVertices[baseVertex + vertex], &corner, sizeof(MeshVertex)) == 0)
+			{
+				outIndices[i] = vertex;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+}
+
+void NarrowIndices(std::span<uint32_t const> indices, std::vector<uint16_t>& outIndices)
+{
+	outIndices.resize(indices.size());
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		assert(indices[i] <= 0xFFFF);
+		outIndices[i] = static_cast<uint16_t>(indices[i]);
+	}
+}
+
+// Position is followed by the normal, so a 16 byte load of it stays inside the vertex. The w lane is ignored
+static_assert(offsetof(MeshVertex, Normal) == offsetof(MeshVertex, Position) + sizeof(Vector3));
+
+static Vector4 LoadPosition(MeshVertex const& vertex)
+{
+	return XMLoadFloat4(reinterpret_cast<XMFLOAT4 const*>(&vertex.Position));
+}
+
+// Four accumulators keep the min and max dependency chains short
+static void PositionRange(std::span<MeshVertex const> vertices, Vector4& outMin, Vector4& outMax)
+{
+	Vector4 minPos[4], maxPos[4];
+	for (uint32_t k = 0; k < 4; ++k)
+		minPos[k] = maxPos[k] = LoadPosition(vertices[0]);
+	size_t i = 0;
+	for (; i + 4 <= vertices.size(); i += 4)
+	{
+		for (uint32_t k = 0; k < 4; ++k)
+		{
+			Vector4 pos = LoadPosition(vertices[i + k]);
+			minPos[k] = XMVectorMin(minPos[k], pos);
+			maxPos[k] = XMVectorMax(maxPos[k], pos);
+		}
+	}
+	for (; i < vertices.size(); ++i)
+	{
+		Vector4 pos = LoadPosition(vertices[i]);
+		minPos[0] = XMVectorMin(minPos[0], pos);
+		maxPos[0] = XMVectorMax(maxPos[0], pos);
+	}
+	outMin = XMVectorMin(XMVectorMin(minPos[0], minPos[1]), XMVectorMin(minPos[2], minPos[3]));
+	outMax = XMVectorMax(XMVectorMax(maxPos[0], maxPos[1]), XMVectorMax(maxPos[2], maxPos[3]));
+}
+
+static float MaxDistanceSq(std::span<MeshVertex const> vertices, Vector4 center)
+{
+	Vector4 maxDistanceSq[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+	size_t i = 0;
+	for (; i + 4 <= vertices.size(); i += 4)
+	{
+		for (uint32_t k = 0; k < 4; ++k)
+			maxDistanceSq[k] = XMVectorMax(maxDistanceSq[k], XMVector3LengthSq(XMVectorSubtract(LoadPosition(vertices[i + k]), center)));
+	}
+	for (; i < vertices.size(); ++i)
+		maxDistanceSq[0] = XMVectorMax(maxDistanceSq[0], XMVector3LengthSq(XMVectorSubtract(LoadPosition(vertices[i]), center)));
+	return XMVectorGetX(XMVectorMax(XMVectorMax(maxDistanceSq[0], maxDistanceSq[1]), XMVectorMax(maxDistanceSq[2], maxDistanceSq[3])));
+}
+
+void ComputeMeshBounds(std::span<MeshVertex const> vertices, DirectX::BoundingBox& outBounds, DirectX::BoundingSphere& outSphere)
+{
+	if (vertices.empty())
+		return;
+
+	// Large meshes are split into chunks that are reduced in parallel, small ones stay on the calling thread
+	size_t chunkCount = (vertices.size() + BoundsChunkVertices - 1) / BoundsChunkVertices;
+	auto chunk = [&](size_t index)
+	{
+		return vertices.subspan(index * BoundsChunkVertices, std::min(BoundsChunkVertices, vertices.size() - index * BoundsChunkVertices));
+	};
+	std::vector<Vector4> chunkMin(chunkCount), chunkMax(chunkCount);
+	ParallelFor(chunkCount, [&](size_t index)
+	{
+		PositionRange(chunk(index), chunkMin[index], chunkMax[index]);
+	});
+	Vector4 minPos = chunkMin[0];
+	Vector4 maxPos = chunkMax[0];
+	for (size_t i = 1; i < chunkCount; ++i)
+	{
+		minPos = XMVectorMin(minPos, chunkMin[i]);
+		maxPos = XMVectorMax(maxPos, chunkMax[i]);
+	}
+	BoundingBox::CreateFromPoints(outBounds, minPos, maxPos);
+
+	// Center the sphere on the box but fit the radius to the actual vertices, it is tighter than the box diagonal
+	Vector4 center = XMLoadFloat3(&outBounds.Center);
+	std::vector<float> chunkDistanceSq(chunkCount);
+	ParallelFor(chunkCount, [&](size_t index)
+	{
+		chunkDistanceSq[index] = MaxDistanceSq(chunk(index), center);
+	});
+	outSphere = BoundingSphere(outBounds.Center, std::sqrt(*std::max_element(chunkDistanceSq.begin(), chunkDistanceSq.end())));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "MathTypes.h"
+
+namespace dxpg
+{
+
+// Interleaved layout of every imported vertex buffer
+struct MeshVertex
+{
+	Vector3 Position;
+	Vector3 Normal;
+	Vector2 TexCoord;
+};
+
+struct MeshImportStats
+{
+	// One source vertex per triangle corner, which is what the non-indexed path used to shade
+	uint32_t SourceVertices = 0;
+	uint32_t UniqueVertices = 0;
+	uint32_t Triangles = 0;
+	// Simulated post-transform cache misses before and after the mesh optimization passes
+	uint32_t TransformedBefore = 0;
+	uint32_t TransformedAfter = 0;
+	uint32_t Index16Shapes = 0;
+	uint32_t Index32Shapes = 0;
+	uint32_t Meshlets = 0;
+	// Triangles of all coarser LOD levels together
+	uint32_t LodTriangles = 0;
+	uint32_t VertexBufferBytes = 0;
+	double Milliseconds = 0.0;
+	// Whole LoadModel call, parsing or cache reads included
+	double LoadMilliseconds = 0.0;
+	bool FromCache = false;
+};
+
+// Welds bitwise identical corners. The unique vertices are appended to outVertices and outIndices receives
+// one index per corner, relative to the first appended vertex
+void DeduplicateVertices(std::span<MeshVertex const> corners, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices);
+
+inline bool FitsIndex16(uint32_t vertexCount)
+{
+	return vertexCount <= (1u << 16);
+}
+
+void NarrowIndices(std::span<uint32_t const> indices, std::vector<uint16_t>& outIndices);
+
+// Meshes with more vertices than this have their bounds reduced in parallel chunks
+constexpr size_t BoundsChunkVertices = 1 << 18;
+
+// Box around the positions and a sphere centered on the box, fitted to the positions
+void ComputeMeshBounds(std::span<MeshVertex const> vertices, DirectX::BoundingBox& outBounds, DirectX::BoundingSphere& outSphere);
+
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "MeshLod.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dxpg
+{
+
+namespace
+{
+float BoundingRadius(std::span<MeshVertex const> vertices)
+{
+	if (vertices.empty())
+		return 0.0f;
+	Vector4 minPos = XMLoadFloat3(&vertices[0].Position);
+	Vector4 maxPos = minPos;
+	for (auto& vertex : vertices)
+	{
+		Vector4 pos = XMLoadFloat3(&vertex.Position);
+		minPos = XMVectorMin(minPos, pos);
+		maxPos = XMVectorMax(maxPos, pos);
+	}
+	// Same sphere as the shape bounds, centered on the box
+	Vector4 center = XMVectorScale(XMVectorAdd(minPos, maxPos), 0.5f);
+	Vector4 maxDistanceSq = XMVectorZero();
+	for (auto& vertex : vertices)
+		maxDistanceSq = XMVectorMax(maxDistanceSq, XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&vertex.Position), center)));
+	return std::sqrt(XMVectorGetX(maxDistanceSq));
+}
+}
+
+void BuildLodChain(std::vector<uint32_t>& indices, std::span<MeshVertex const> vertices, std::vector<MeshLod>& outLods)
+{
+	outLods.clear();
+	outLods.push_back({ .FirstIndex = 0, .IndexCount = static_cast<uint32_t>(indices.size()), .Error = 0.0f });
+
+	float radius = BoundingRadius(vertices);
+	if (radius <= 0.0f)
+		return;
+
+	// Every level simplifies the previous one, its error adds on top of the error already made
+	std::vector<uint32_t> previous(indices);
+	std::vector<uint32_t> simplified;
+	float error = 0.0f;
+	while (outLods.size() < MaxMeshLods)
+	{
+		size_t targetTriangles = previous.size() / 3 / 2;
+		if (targetTriangles < MinLodTriangles)
+			break;
+		float levelError = SimplifyMesh(previous, vertices, targetTriangles * 3, radius * MaxLodError, simplified);
+		if (simplified.size() > previous.size() * (1.0f - MinLodReduction))
+			break;
+
+		error += levelError;
+		OptimizeVertexCache(simplified, static_cast<uint32_t>(vertices.size()));
+		outLods.push_back({ .FirstIndex = static_cast<uint32_t>(indices.size()), .IndexCount = static_cast<uint32_t>(simplified.size()), .Error = error / radius });
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		previous.swap(simplified);
+	}
+}
+
+float ProjectedSphereSize(Vector4 center, float radius, Vector4 cameraPosition, float projectionScale)
+{
+	float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, cameraPosition)));
+	if (distance <= radius)
+		return 1.0f;
+	return std::min(radius * projectionScale / distance, 1.0f);
+}
+
+uint32_t SelectLod(std::span<MeshLod const> lods, float screenSize, LodSettings const& settings)
+{
+	if (screenSize < settings.MinScreenSize)
+		return LodCulled;
+
+	// A relative error of e spans e * radius, half of the projected diameter times e in pixels
+	float pixelsPerRadius = 0.5f * screenSize * settings.ViewportHeight;
+	for (uint32_t lod = static_cast<uint32_t>(lods.size()); lod-- > 1;)
+	{
+		if (lods[lod].Error * pixelsPerRadius <= settings.MaxErrorPixels)
+			return lod;
+	}
+	return 0;
+}
+
+}
\ No newline at end of file
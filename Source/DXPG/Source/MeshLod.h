@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "MeshImport.h"
+
+namespace dxpg
+{
+
+constexpr uint32_t MaxMeshLods = 5;
+// Levels below this many triangles do not pay for their draw setup
+constexpr size_t MinLodTriangles = 16;
+// A level has to drop at least this fraction of the previous one to be kept
+constexpr float MinLodReduction = 0.15f;
+// Largest simplification error per level, relative to the bounding sphere radius
+constexpr float MaxLodError = 0.25f;
+
+// A range of the shape's index buffer, LOD 0 is the full resolution mesh
+struct MeshLod
+{
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+	// Simplification error relative to the shape's bounding sphere radius
+	float Error;
+};
+
+// Simplifies the LOD 0 triangles in indices down to at most MaxMeshLods levels, halving the triangle count per level.
+// The coarser levels are appended to indices, outLods receives one range per level starting with LOD 0.
+void BuildLodChain(std::vector<uint32_t>& indices, std::span<MeshVertex const> vertices, std::vector<MeshLod>& outLods);
+
+struct LodSettings
+{
+	float ViewportHeight = 1080.0f;
+	// Coarsest level whose simplification error stays below this on screen is picked
+	float MaxErrorPixels = 1.0f;
+	// Objects whose bounding sphere covers less than this fraction of the viewport height are not drawn
+	float MinScreenSize = 0.002f;
+};
+
+constexpr uint32_t LodCulled = ~0u;
+
+// Diameter of the sphere's projection as a fraction of the viewport height, 1 when the camera is inside of it.
+// projectionScale is the projection matrix' y scale, the cotangent of half the vertical field of view.
+float ProjectedSphereSize(Vector4 center, float radius, Vector4 cameraPosition, float projectionScale);
+
+// Returns the level to draw or LodCulled when the object is below settings.MinScreenSize
+uint32_t SelectLod(std::span<MeshLod const> lods, float screenSize, LodSettings const& settings);
+
+struct LodStats
+{
+	std::array<uint32_t, MaxMeshLods> Selected{};
+	uint32_t Culled = 0;
+	// Triangles of the selected levels and what the same objects cost at LOD 0
+	uint64_t Triangles = 0;
+	uint64_t FullTriangles = 0;
+};
+
+}
\ No newline at end of file
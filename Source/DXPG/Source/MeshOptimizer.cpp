@@ -0,0 +1,339 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+namespace dxpg
+{
+
+namespace
+{
+struct TriangleAdjacency
+{
+	std::vector<uint32_t> Offsets;
+	std::vector<uint32_t> Counts;
+	std::vector<uint32_t> Triangles;
+
+	TriangleAdjacency(std::span<uint32_t const> indices, uint32_t vertexCount)
+		: Offsets(vertexCount + 1, 0), Counts(vertexCount, 0), Triangles(indices.size())
+	{
+		for (uint32_t index : indices)
+			Counts[index]++;
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			Offsets[v + 1] = Offsets[v] + Counts[v];
+		std::fill(Counts.begin(), Counts.end(), 0);
+		for (uint32_t i = 0; i < indices.size(); ++i)
+			Triangles[Offsets[indices[i]] + Counts[indices[i]]++] = i / 3;
+	}
+
+	std::span<uint32_t> Get(uint32_t vertex) { return { Triangles.data() + Offsets[vertex], Counts[vertex] }; }
+
+	void Remove(uint32_t vertex, uint32_t triangle)
+	{
+		auto triangles = Get(vertex);
+		auto it = std::find(triangles.begin(), triangles.end(), triangle);
+		assert(it != triangles.end());
+		*it = triangles.back();
+		Counts[vertex]--;
+	}
+};
+
+constexpr uint32_t ForsythCacheSize = 32;
+
+float ForsythVertexScore(int32_t cachePosition, uint32_t remainingTriangles)
+{
+	if (remainingTriangles == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		// The last triangle's vertices get a fixed score so the next triangle does not just reuse a single edge
+		if (cachePosition < 3)
+			score = 0.75f;
+		else
+			score = std::pow(1.0f - float(cachePosition - 3) / float(ForsythCacheSize - 3), 1.5f);
+	}
+	// Favor vertices with few triangles left so they leave the working set early
+	return score + 2.0f / std::sqrt(float(remainingTriangles));
+}
+
+struct Float3
+{
+	float X, Y, Z;
+};
+
+Float3 operator-(Float3 a, Float3 b) { return { a.X - b.X, a.Y - b.Y, a.Z - b.Z }; }
+Float3 operator+(Float3 a, Float3 b) { return { a.X + b.X, a.Y + b.Y, a.Z + b.Z }; }
+Float3 operator*(Float3 a, float s) { return { a.X * s, a.Y * s, a.Z * s }; }
+float Dot(Float3 a, Float3 b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+Float3 Cross(Float3 a, Float3 b) { return { a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X }; }
+Float3 ToFloat3(Vector3 const& v) { return { v.x, v.y, v.z }; }
+
+// FIFO cache with timestamps, a vertex is cached while fewer than cacheSize misses happened since it was loaded
+struct FifoCache
+{
+	std::vector<uint32_t> LoadTime;
+	uint32_t Time;
+	uint32_t Size;
+
+	FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+		: LoadTime(vertexCount, 0), Time(cacheSize + 1), Size(cacheSize)
+	{
+	}
+
+	uint32_t Touch(uint32_t vertex)
+	{
+		if (Time - LoadTime[vertex] > Size)
+		{
+			LoadTime[vertex] = Time++;
+			return 1;
+		}
+		return 0;
+	}
+
+	uint32_t Touch(uint32_t const* triangle) { return Touch(triangle[0]) + Touch(triangle[1]) + Touch(triangle[2]); }
+
+	void Flush() { Time += Size + 1; }
+};
+}
+
+VertexCacheStats AnalyzeVertexCache(std::span<uint32_t const> indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats{};
+	if (indices.empty() || vertexCount == 0)
+		return stats;
+
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t i = 0; i < indices.size(); i += 3)
+		stats.TransformedVertices += cache.Touch(&indices[i]);
+
+	stats.ACMR = float(stats.TransformedVertices) / float(indices.size() / 3);
+	stats.ATVR = float(stats.TransformedVertices) / float(vertexCount);
+	return stats;
+}
+
+void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount)
+{
+	assert(indices.size() % 3 == 0);
+	uint32_t const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (triangleCount == 0)
+		return;
+
+	TriangleAdjacency adjacency(indices, vertexCount);
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		vertexScores[v] = ForsythVertexScore(-1, adjacency.Counts[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	for (uint32_t t = 0; t < triangleCount; ++t)
+		triangleScores[t] = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	// The cache may briefly hold three extra vertices, they are the ones being evicted
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(ForsythCacheSize + 3);
+	nextCache.reserve(ForsythCacheSize + 3);
+
+	uint32_t bestTriangle = static_cast<uint32_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+	uint32_t scanCursor = 0;
+	while (true)
+	{
+		emitted[bestTriangle] = 1;
+		uint32_t const* triangle = &indices[3 * bestTriangle];
+		output.insert(output.end(), triangle, triangle + 3);
+
+		nextCache.assign(triangle, triangle + 3);
+		for (uint32_t vertex : cache)
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				nextCache.push_back(vertex);
+		for (uint32_t i = 0; i < 3; ++i)
+			adjacency.Remove(triangle[i], bestTriangle);
+
+		// Rescore everything that was in the cache, evicted vertices fall back to their valence score
+		for (uint32_t i = 0; i < nextCache.size(); ++i)
+		{
+			uint32_t vertex = nextCache[i];
+			cachePositions[vertex] = i < ForsythCacheSize ? int32_t(i) : -1;
+			float score = ForsythVertexScore(cachePositions[vertex], adjacency.Counts[vertex]);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+			for (uint32_t t : adjacency.Get(vertex))
+				triangleScores[t] += delta;
+		}
+		if (nextCache.size() > ForsythCacheSize)
+			nextCache.resize(ForsythCacheSize);
+		std::swap(cache, nextCache);
+
+		bestTriangle = ~0u;
+		float bestScore = -1.0f;
+		for (uint32_t vertex : cache)
+		{
+			for (uint32_t t : adjacency.Get(vertex))
+			{
+				if (triangleScores[t] > bestScore || (triangleScores[t] == bestScore && t < bestTriangle))
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		// Nothing left around the cache, continue with the first triangle that was not emitted yet
+		if (bestTriangle == ~0u)
+		{
+			while (scanCursor < triangleCount && emitted[scanCursor])
+				scanCursor++;
+			if (scanCursor == triangleCount)
+				break;
+			bestTriangle = scanCursor;
+		}
+	}
+
+	assert(output.size() == indices.size());
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<MeshVertex const> vertices, float threshold)
+{
+	constexpr uint32_t CacheSize = 16;
+	uint32_t const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	uint32_t const vertexCount = static_cast<uint32_t>(vertices.size());
+	if (triangleCount < 2)
+		return;
+
+	// Hard boundaries, a triangle that misses all three vertices starts a new patch of the mesh
+	std::vector<uint32_t> hardBoundaries;
+	{
+		FifoCache cache(vertexCount, CacheSize);
+		for (uint32_t t = 0; t < triangleCount; ++t)
+			if (cache.Touch(&indices[3 * t]) == 3)
+				hardBoundaries.push_back(t);
+		hardBoundaries.push_back(triangleCount);
+	}
+
+	// Soft boundaries, split a patch further wherever its cache efficiency so far is within threshold of the whole patch
+	std::vector<uint32_t> clusters;
+	{
+		FifoCache cache(vertexCount, CacheSize);
+		for (size_t i = 0; i + 1 < hardBoundaries.size(); ++i)
+		{
+			uint32_t start = hardBoundaries[i];
+			uint32_t end = hardBoundaries[i + 1];
+
+			cache.Flush();
+			uint32_t patchMisses = 0;
+			for (uint32_t t = start; t < end; ++t)
+				patchMisses += cache.Touch(&indices[3 * t]);
+			float patchThreshold = threshold * float(patchMisses) / float(end - start);
+
+			cache.Flush();
+			uint32_t clusterStart = start;
+			uint32_t clusterMisses = 0;
+			clusters.push_back(start);
+			for (uint32_t t = start; t < end; ++t)
+			{
+				clusterMisses += cache.Touch(&indices[3 * t]);
+				if (t + 1 < end && float(clusterMisses) / float(t + 1 - clusterStart) <= patchThreshold)
+				{
+					clusters.push_back(t + 1);
+					clusterStart = t + 1;
+					clusterMisses = 0;
+					cache.Flush();
+				}
+			}
+		}
+		clusters.push_back(triangleCount);
+	}
+
+	size_t const clusterCount = clusters.size() - 1;
+	if (clusterCount < 2)
+		return;
+
+	// Area weighted centroid and normal of every cluster
+	std::vector<Float3> clusterCentroids(clusterCount);
+	std::vector<Float3> clusterNormals(clusterCount);
+	Float3 meshCentroid{};
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		Float3 centroid{};
+		Float3 normal{};
+		float clusterArea = 0.0f;
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			Float3 p0 = ToFloat3(vertices[indices[3 * t]].Position);
+			Float3 p1 = ToFloat3(vertices[indices[3 * t + 1]].Position);
+			Float3 p2 = ToFloat3(vertices[indices[3 * t + 2]].Position);
+			Float3 areaNormal = Cross(p1 - p0, p2 - p0);
+			float area = std::sqrt(Dot(areaNormal, areaNormal));
+			centroid = centroid + (p0 + p1 + p2) * (area / 3.0f);
+			normal = normal + areaNormal;
+			clusterArea += area;
+		}
+		meshCentroid = meshCentroid + centroid;
+		meshArea += clusterArea;
+
+		float normalLength = std::sqrt(Dot(normal, normal));
+		clusterCentroids[c] = clusterArea > 0.0f ? centroid * (1.0f / clusterArea) : ToFloat3(vertices[indices[3 * clusters[c]]].Position);
+		clusterNormals[c] = normalLength > 0.0f ? normal * (1.0f / normalLength) : Float3{};
+	}
+	if (meshArea > 0.0f)
+		meshCentroid = meshCentroid * (1.0f / meshArea);
+
+	// Clusters far out along their own normal are likely to occlude the rest, draw them first
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c)
+		sortKeys[c] = Dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+
+	std::vector<uint32_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (uint32_t c : order)
+		output.insert(output.end(), indices.begin() + 3 * clusters[c], indices.begin() + 3 * clusters[c + 1]);
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void OptimizeVertexFetch(std::vector<MeshVertex>& vertices, std::span<uint32_t> indices)
+{
+	constexpr uint32_t Unmapped = ~0u;
+	std::vector<uint32_t> remap(vertices.size(), Unmapped);
+	std::vector<MeshVertex> reordered;
+	reordered.reserve(vertices.size());
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == Unmapped)
+		{
+			remap[index] = static_cast<uint32_t>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices = std::move(reordered);
+}
+
+void OptimizeMesh(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, VertexCacheStats* outBefore, VertexCacheStats* outAfter)
+{
+	uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+	if (outBefore)
+		*outBefore = AnalyzeVertexCache(indices, vertexCount);
+
+	OptimizeVertexCache(indices, vertexCount);
+	OptimizeOverdraw(indices, vertices);
+	OptimizeVertexFetch(vertices, indices);
+
+	if (outAfter)
+		*outAfter = AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "MeshImport.h"
+
+namespace dxpg
+{
+
+struct VertexCacheStats
+{
+	uint32_t TransformedVertices = 0;
+	// Average cache miss ratio, transformed vertices per triangle, 0.5 is the ideal for a regular grid and 3 the worst case
+	float ACMR = 0.0f;
+	// Average transform to vertex ratio, 1 is the ideal
+	float ATVR = 0.0f;
+};
+
+// Simulates a FIFO post-transform cache of the given size
+VertexCacheStats AnalyzeVertexCache(std::span<uint32_t const> indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+// Forsyth's linear-speed vertex cache optimization, reorders triangles in place
+void OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount);
+
+// Splits cache optimized triangles into clusters and draws the outward facing clusters first for better early-Z.
+// Cluster splits only happen where the cache miss ratio stays within threshold of the original
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<MeshVertex const> vertices, float threshold = 1.05f);
+
+// Reorders vertices by first use so the vertex fetch walks memory linearly, unreferenced vertices are dropped
+void OptimizeVertexFetch(std::vector<MeshVertex>& vertices, std::span<uint32_t> indices);
+
+// Runs the three passes in order and fills the cache stats measured before and after
+void OptimizeMesh(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, VertexCacheStats* outBefore = nullptr, VertexCacheStats* outAfter = nullptr);
+
+}
\ No newline at end of file
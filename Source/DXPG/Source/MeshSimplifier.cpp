@@ -0,0 +1,345 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace dxpg
+{
+
+namespace
+{
+// Border planes are weighted up so open edges only move along themselves
+constexpr float BorderWeight = 10.0f;
+
+Vector3 Subtract(Vector3 const& a, Vector3 const& b)
+{
+	return Vector3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+Vector3 Cross(Vector3 const& a, Vector3 const& b)
+{
+	return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+float Dot(Vector3 const& a, Vector3 const& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Sum of squared distances to a set of planes, p'Ap + 2b'p + c, scaled by the accumulated plane weight
+struct Quadric
+{
+	float A00 = 0, A11 = 0, A22 = 0, A01 = 0, A02 = 0, A12 = 0;
+	float B0 = 0, B1 = 0, B2 = 0;
+	float C = 0;
+	float Weight = 0;
+
+	static Quadric FromPlane(Vector3 const& n, float d, float weight)
+	{
+		Quadric q;
+		q.A00 = weight * n.x * n.x;
+		q.A11 = weight * n.y * n.y;
+		q.A22 = weight * n.z * n.z;
+		q.A01 = weight * n.x * n.y;
+		q.A02 = weight * n.x * n.z;
+		q.A12 = weight * n.y * n.z;
+		q.B0 = weight * n.x * d;
+		q.B1 = weight * n.y * d;
+		q.B2 = weight * n.z * d;
+		q.C = weight * d * d;
+		q.Weight = weight;
+		return q;
+	}
+
+	Quadric& operator+=(Quadric const& other)
+	{
+		A00 += other.A00; A11 += other.A11; A22 += other.A22;
+		A01 += other.A01; A02 += other.A02; A12 += other.A12;
+		B0 += other.B0; B1 += other.B1; B2 += other.B2;
+		C += other.C;
+		Weight += other.Weight;
+		return *this;
+	}
+
+	// Mean squared distance of p to the planes
+	float Error(Vector3 const& p) const
+	{
+		float rx = A00 * p.x + A01 * p.y + A02 * p.z;
+		float ry = A01 * p.x + A11 * p.y + A12 * p.z;
+		float rz = A02 * p.x + A12 * p.y + A22 * p.z;
+		float error = rx * p.x + ry * p.y + rz * p.z + 2.0f * (B0 * p.x + B1 * p.y + B2 * p.z) + C;
+		error = std::abs(error);
+		return Weight > 0.0f ? error / Weight : error;
+	}
+};
+
+struct Collapse
+{
+	uint32_t From;
+	uint32_t To;
+	float Error;
+};
+
+uint64_t EdgeKey(uint32_t from, uint32_t to)
+{
+	return (uint64_t(from) << 32) | to;
+}
+
+// Directed edges between position representatives, sorted so their twins can be looked up
+void BuildEdges(std::span<uint32_t const> indices, std::span<uint32_t const> positionRemap, std::vector<uint64_t>& outEdges)
+{
+	outEdges.clear();
+	outEdges.reserve(indices.size());
+	for (size_t i = 0; i < indices.size(); i += 3)
+		for (uint32_t k = 0; k < 3; ++k)
+			outEdges.push_back(EdgeKey(positionRemap[indices[i + k]], positionRemap[indices[i + (k + 1) % 3]]));
+	std::sort(outEdges.begin(), outEdges.end());
+}
+
+// An edge without a twin in the opposite direction lies on an open border
+bool IsBorderEdge(std::span<uint64_t const> edges, uint32_t from, uint32_t to)
+{
+	return !std::binary_search(edges.begin(), edges.end(), EdgeKey(to, from));
+}
+
+// Vertex to triangle lists in compressed rows
+struct VertexTriangles
+{
+	std::vector<uint32_t> Offsets;
+	std::vector<uint32_t> Triangles;
+
+	void Build(std::span<uint32_t const> indices, size_t vertexCount)
+	{
+		Offsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : indices)
+			Offsets[index + 1]++;
+		std::partial_sum(Offsets.begin(), Offsets.end(), Offsets.begin());
+		Triangles.resize(indices.size());
+		std::vector<uint32_t> cursor(Offsets.begin(), Offsets.end() - 1);
+		for (uint32_t i = 0; i < indices.size(); ++i)
+			Triangles[cursor[indices[i]]++] = i / 3;
+	}
+
+	std::span<uint32_t const> Get(uint32_t vertex) const
+	{
+		return { Triangles.data() + Offsets[vertex], Offsets[vertex + 1] - Offsets[vertex] };
+	}
+};
+}
+
+float SimplifyMesh(std::span<uint32_t const> indices, std::span<MeshVertex const> vertices, size_t targetIndexCount, float targetError, std::vector<uint32_t>& outIndices)
+{
+	assert(indices.size() % 3 == 0);
+	outIndices.assign(indices.begin(), indices.end());
+	if (outIndices.size() <= targetIndexCount || vertices.empty())
+		return 0.0f;
+
+	uint32_t const vertexCount = static_cast<uint32_t>(vertices.size());
+
+	// Work in a unit cube so the quadric sums keep their precision on large meshes
+	Vector3 minPosition = vertices[0].Position;
+	Vector3 maxPosition = minPosition;
+	for (auto& vertex : vertices)
+	{
+		minPosition = Vector3(std::min(minPosition.x, vertex.Position.x), std::min(minPosition.y, vertex.Position.y), std::min(minPosition.z, vertex.Position.z));
+		maxPosition = Vector3(std::max(maxPosition.x, vertex.Position.x), std::max(maxPosition.y, vertex.Position.y), std::max(maxPosition.z, vertex.Position.z));
+	}
+	float scale = std::max({ maxPosition.x - minPosition.x, maxPosition.y - minPosition.y, maxPosition.z - minPosition.z });
+	scale = scale > 0.0f ? scale : 1.0f;
+	std::vector<Vector3> positions(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		Vector3 offset = Subtract(vertices[v].Position, minPosition);
+		positions[v] = Vector3(offset.x / scale, offset.y / scale, offset.z / scale);
+	}
+
+	// Vertices split by attributes share a position, map them to one representative so topology follows positions
+	std::vector<uint32_t> positionRemap(vertexCount);
+	std::vector<uint8_t> locked(vertexCount, 0);
+	{
+		std::vector<uint32_t> order(vertexCount);
+		std::iota(order.begin(), order.end(), 0u);
+		auto positionLess = [&](uint32_t a, uint32_t b)
+		{
+			return std::memcmp(&vertices[a].Position, &vertices[b].Position, sizeof(Vector3)) < 0;
+		};
+		std::sort(order.begin(), order.end(), positionLess);
+		for (uint32_t first = 0; first < vertexCount;)
+		{
+			uint32_t last = first + 1;
+			while (last < vertexCount && !positionLess(order[first], order[last]))
+				last++;
+			for (uint32_t i = first; i < last; ++i)
+			{
+				positionRemap[order[i]] = order[first];
+				// Seams stay where they are, collapsing them would need every wedge to move consistently
+				locked[order[i]] = last - first > 1;
+			}
+			first = last;
+		}
+	}
+
+	std::vector<uint64_t> edges;
+	BuildEdges(outIndices, positionRemap, edges);
+
+	// Plane quadrics of the triangles around each position, plus perpendicular planes along open borders
+	std::vector<Quadric> quadrics(vertexCount);
+	std::vector<uint8_t> border(vertexCount, 0);
+	for (size_t i = 0; i < outIndices.size(); i += 3)
+	{
+		uint32_t const corners[3] = { outIndices[i], outIndices[i + 1], outIndices[i + 2] };
+		Vector3 normal = Cross(Subtract(positions[corners[1]], positions[corners[0]]), Subtract(positions[corners[2]], positions[corners[0]]));
+		float length = std::sqrt(Dot(normal, normal));
+		if (length == 0.0f)
+			continue;
+		normal = Vector3(normal.x / length, normal.y / length, normal.z / length);
+		Quadric plane = Quadric::FromPlane(normal, -Dot(normal, positions[corners[0]]), 0.5f * length);
+		for (uint32_t k = 0; k < 3; ++k)
+			quadrics[positionRemap[corners[k]]] += plane;
+
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			uint32_t from = positionRemap[corners[k]];
+			uint32_t to = positionRemap[corners[(k + 1) % 3]];
+			if (!IsBorderEdge(edges, from, to))
+				continue;
+			border[from] = border[to] = 1;
+			Vector3 edge = Subtract(positions[to], positions[from]);
+			Vector3 borderNormal = Cross(edge, normal);
+			float borderLength = std::sqrt(Dot(borderNormal, borderNormal));
+			if (borderLength == 0.0f)
+				continue;
+			borderNormal = Vector3(borderNormal.x / borderLength, borderNormal.y / borderLength, borderNormal.z / borderLength);
+			Quadric borderPlane = Quadric::FromPlane(borderNormal, -Dot(borderNormal, positions[from]), Dot(edge, edge) * BorderWeight);
+			quadrics[from] += borderPlane;
+			quadrics[to] += borderPlane;
+		}
+	}
+
+	auto canCollapse = [&](uint32_t from, bool borderEdge)
+	{
+		return !locked[from] && (!border[positionRemap[from]] || borderEdge);
+	};
+	auto collapseError = [&](uint32_t from, uint32_t to)
+	{
+		Quadric quadric = quadrics[positionRemap[from]];
+		quadric += quadrics[positionRemap[to]];
+		return quadric.Error(positions[to]);
+	};
+	// Moving from onto to must not turn any of the remaining triangles around
+	auto flipsTriangles = [&](std::span<uint32_t const> triangles, uint32_t from, uint32_t to)
+	{
+		for (uint32_t triangle : triangles)
+		{
+			uint32_t const* corners = &outIndices[triangle * 3];
+			if (corners[0] == to || corners[1] == to || corners[2] == to)
+				continue;
+			Vector3 before[3], after[3];
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				before[k] = positions[corners[k]];
+				after[k] = corners[k] == from ? positions[to] : before[k];
+			}
+			Vector3 normalBefore = Cross(Subtract(before[1], before[0]), Subtract(before[2], before[0]));
+			Vector3 normalAfter = Cross(Subtract(after[1], after[0]), Subtract(after[2], after[0]));
+			if (Dot(normalBefore, normalAfter) <= 0.0f)
+				return true;
+		}
+		return false;
+	};
+
+	float const maxError = (targetError / scale) * (targetError / scale);
+	float resultError = 0.0f;
+	size_t const targetTriangles = targetIndexCount / 3;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint8_t> touched(vertexCount);
+	VertexTriangles adjacency;
+	// Every pass collapses an independent set of the cheapest edges, then rebuilds the topology
+	while (outIndices.size() > targetIndexCount)
+	{
+		collapses.clear();
+		for (size_t i = 0; i < outIndices.size(); i += 3)
+		{
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				uint32_t a = outIndices[i + k];
+				uint32_t b = outIndices[i + (k + 1) % 3];
+				bool borderEdge = IsBorderEdge(edges, positionRemap[a], positionRemap[b]);
+				// Interior edges show up in both triangles, only look at them once
+				if (!borderEdge && positionRemap[a] > positionRemap[b])
+					continue;
+
+				Collapse best{ .From = a, .To = b, .Error = -1.0f };
+				if (canCollapse(a, borderEdge))
+					best.Error = collapseError(a, b);
+				if (canCollapse(b, borderEdge))
+				{
+					float error = collapseError(b, a);
+					if (best.Error < 0.0f || error < best.Error)
+						best = { .From = b, .To = a, .Error = error };
+				}
+				if (best.Error >= 0.0f && best.Error <= maxError)
+					collapses.push_back(best);
+			}
+		}
+		if (collapses.empty())
+			break;
+		std::sort(collapses.begin(), collapses.end(), [](Collapse const& a, Collapse const& b) { return a.Error < b.Error; });
+
+		adjacency.Build(outIndices, vertexCount);
+		std::iota(remap.begin(), remap.end(), 0u);
+		std::fill(touched.begin(), touched.end(), uint8_t(0));
+		size_t triangleCount = outIndices.size() / 3;
+		uint32_t collapsed = 0;
+		for (auto& collapse : collapses)
+		{
+			if (triangleCount <= targetTriangles)
+				break;
+			if (touched[collapse.From] || touched[collapse.To])
+				continue;
+			auto triangles = adjacency.Get(collapse.From);
+			if (flipsTriangles(triangles, collapse.From, collapse.To))
+				continue;
+
+			remap[collapse.From] = collapse.To;
+			// The one-ring is frozen for the rest of the pass so the flip test above stays valid
+			for (uint32_t triangle : triangles)
+			{
+				uint32_t const* corners = &outIndices[triangle * 3];
+				for (uint32_t k = 0; k < 3; ++k)
+					touched[corners[k]] = 1;
+				if (corners[0] == collapse.To || corners[1] == collapse.To || corners[2] == collapse.To)
+					triangleCount--;
+			}
+			touched[collapse.To] = 1;
+			quadrics[positionRemap[collapse.To]] += quadrics[positionRemap[collapse.From]];
+			resultError = std::max(resultError, collapse.Error);
+			collapsed++;
+		}
+		if (collapsed == 0)
+			break;
+
+		size_t write = 0;
+		for (size_t i = 0; i < outIndices.size(); i += 3)
+		{
+			uint32_t a = remap[outIndices[i]];
+			uint32_t b = remap[outIndices[i + 1]];
+			uint32_t c = remap[outIndices[i + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+			outIndices[write++] = a;
+			outIndices[write++] = b;
+			outIndices[write++] = c;
+		}
+		outIndices.resize(write);
+		BuildEdges(outIndices, positionRemap, edges);
+	}
+
+	return std::sqrt(resultError) * scale;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "MeshImport.h"
+
+namespace dxpg
+{
+
+// Quadric error metric edge collapse simplification. Collapses move a vertex onto one of its neighbours, so the
+// result indexes the same vertex buffer and only needs a new index range. Vertices on UV or normal seams are kept
+// in place and open borders only collapse along themselves, which keeps silhouettes and texture layout intact.
+// Stops once outIndices is at or below targetIndexCount or the next collapse would exceed targetError.
+// Returns the largest error of a performed collapse, an object space distance.
+float SimplifyMesh(std::span<uint32_t const> indices, std::span<MeshVertex const> vertices, size_t targetIndexCount, float targetError, std::vector<uint32_t>& outIndices);
+
+}
\ No newline at end of file
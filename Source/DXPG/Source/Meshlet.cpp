@@ -0,0 +1,181 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace dxpg
+{
+
+namespace
+{
+void ComputeMeshletBounds(Meshlet& meshlet, std::span<uint32_t const> indices, std::span<MeshVertex const> vertices, std::span<uint32_t const> meshletVertices)
+{
+	Vector4 minPos = XMLoadFloat3(&vertices[meshletVertices[0]].Position);
+	Vector4 maxPos = minPos;
+	for (uint32_t vertex : meshletVertices)
+	{
+		Vector4 pos = XMLoadFloat3(&vertices[vertex].Position);
+		minPos = XMVectorMin(minPos, pos);
+		maxPos = XMVectorMax(maxPos, pos);
+	}
+	Vector4 center = XMVectorScale(XMVectorAdd(minPos, maxPos), 0.5f);
+	Vector4 maxDistanceSq = XMVectorZero();
+	for (uint32_t vertex : meshletVertices)
+		maxDistanceSq = XMVectorMax(maxDistanceSq, XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&vertices[vertex].Position), center)));
+	XMStoreFloat3(&meshlet.Center, center);
+	meshlet.Radius = std::sqrt(XMVectorGetX(maxDistanceSq));
+
+	// Cone around the average face normal, degenerate triangles have no say in it
+	auto triangles = indices.subspan(3 * meshlet.TriangleOffset, 3 * meshlet.TriangleCount);
+	auto faceNormal = [&](size_t t)
+	{
+		Vector4 p0 = XMLoadFloat3(&vertices[triangles[3 * t]].Position);
+		Vector4 p1 = XMLoadFloat3(&vertices[triangles[3 * t + 1]].Position);
+		Vector4 p2 = XMLoadFloat3(&vertices[triangles[3 * t + 2]].Position);
+		Vector4 normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+		float length = XMVectorGetX(XMVector3Length(normal));
+		return length > 0.0f ? XMVectorScale(normal, 1.0f / length) : XMVectorZero();
+	};
+
+	Vector4 axis = XMVectorZero();
+	for (size_t t = 0; t < meshlet.TriangleCount; ++t)
+		axis = XMVectorAdd(axis, faceNormal(t));
+	float axisLength = XMVectorGetX(XMVector3Length(axis));
+	meshlet.ConeCutoff = 1.0f;
+	meshlet.ConeAxis = Vector3(0, 0, 0);
+	if (axisLength <= 0.0f)
+		return;
+	axis = XMVectorScale(axis, 1.0f / axisLength);
+	XMStoreFloat3(&meshlet.ConeAxis, axis);
+
+	float minDot = 1.0f;
+	for (size_t t = 0; t < meshlet.TriangleCount; ++t)
+	{
+		Vector4 normal = faceNormal(t);
+		if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f)
+			minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(normal, axis)));
+	}
+	// A cone of 90 degrees or more contains opposite normals, some triangle always faces the camera
+	if (minDot > 0.0f)
+		meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+}
+
+void BuildMeshlets(std::span<uint32_t const> indices, std::span<MeshVertex const> vertices, MeshletData& outMeshlets)
+{
+	constexpr uint8_t NotInMeshlet = 0xFF;
+	static_assert(MeshletMaxVertices < NotInMeshlet);
+
+	outMeshlets = {};
+	uint32_t const triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (triangleCount == 0)
+		return;
+
+	// Meshlet local index of every vertex of the meshlet being built
+	std::vector<uint8_t> localIndices(vertices.size(), NotInMeshlet);
+	Meshlet current{};
+
+	auto finishMeshlet = [&]()
+	{
+		auto meshletVertices = std::span<uint32_t const>(outMeshlets.Vertices).subspan(current.VertexOffset, current.VertexCount);
+		for (uint32_t vertex : meshletVertices)
+			localIndices[vertex] = NotInMeshlet;
+		ComputeMeshletBounds(current, indices, vertices, meshletVertices);
+		outMeshlets.Meshlets.push_back(current);
+
+		current = {};
+		current.VertexOffset = static_cast<uint32_t>(outMeshlets.Vertices.size());
+		current.TriangleOffset = static_cast<uint32_t>(outMeshlets.Triangles.size() / 3);
+	};
+
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		uint32_t const* triangle = &indices[3 * t];
+		uint32_t newVertices = 0;
+		for (uint32_t i = 0; i < 3; ++i)
+			newVertices += localIndices[triangle[i]] == NotInMeshlet && (i == 0 || triangle[i] != triangle[0]) && (i < 2 || triangle[i] != triangle[1]);
+
+		if (current.VertexCount + newVertices > MeshletMaxVertices || current.TriangleCount == MeshletMaxTriangles)
+			finishMeshlet();
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			uint32_t vertex = triangle[i];
+			if (localIndices[vertex] == NotInMeshlet)
+			{
+				localIndices[vertex] = static_cast<uint8_t>(current.VertexCount++);
+				outMeshlets.Vertices.push_back(vertex);
+			}
+			outMeshlets.Triangles.push_back(localIndices[vertex]);
+		}
+		current.TriangleCount++;
+	}
+	finishMeshlet();
+}
+
+CullingStats CullMeshlets(std::span<Meshlet const> meshlets, Matrix4x4 const& world, Frustum const& frustum, Vector4 cameraPosition, std::vector<IndexRange>& outRanges)
+{
+	// Row vectors, rows 0 to 2 are the object axes in world space
+	float axisScales[3];
+	for (uint32_t i = 0; i < 3; ++i)
+		axisScales[i] = XMVectorGetX(XMVector3Length(world.r[i]));
+	float maxScale = std::max({ axisScales[0], axisScales[1], axisScales[2] });
+	float minScale = std::min({ axisScales[0], axisScales[1], axisScales[2] });
+	// A non-uniform scale skews the normals so the cone no longer bounds them, a mirror flips the winding
+	bool mirrored = XMVectorGetX(XMVector3Dot(world.r[0], XMVector3Cross(world.r[1], world.r[2]))) < 0.0f;
+	bool testCones = !mirrored && minScale > 0.0f && maxScale - minScale <= 1e-3f * maxScale;
+
+	CullingStats stats{};
+	bool extendLast = false;
+	for (auto& meshlet : meshlets)
+	{
+		Vector4 center = XMVector3Transform(XMLoadFloat3(&meshlet.Center), world);
+		float radius = meshlet.Radius * maxScale;
+		bool visible = true;
+		for (auto& plane : frustum.Planes)
+		{
+			if (XMVectorGetX(XMVector4Dot(plane, center)) < -radius)
+			{
+				visible = false;
+				break;
+			}
+		}
+
+		// Backfacing when the camera sees every normal of the cone from behind, see the cone cutoff in ComputeMeshletBounds
+		if (visible && testCones && meshlet.ConeCutoff < 1.0f)
+		{
+			Vector4 toCenter = XMVectorSubtract(center, cameraPosition);
+			float distance = XMVectorGetX(XMVector3Length(toCenter));
+			Vector4 axis = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&meshlet.ConeAxis), world));
+			if (XMVectorGetX(XMVector3Dot(toCenter, axis)) >= meshlet.ConeCutoff * distance + radius)
+				visible = false;
+		}
+
+		if (!visible)
+		{
+			stats.Culled++;
+			extendLast = false;
+			continue;
+		}
+		stats.Visible++;
+		if (extendLast)
+			outRanges.back().IndexCount += 3 * meshlet.TriangleCount;
+		else
+			outRanges.push_back({ .FirstIndex = 3 * meshlet.TriangleOffset, .IndexCount = 3 * meshlet.TriangleCount });
+		extendLast = true;
+	}
+	return stats;
+}
+
+bool SplitClusterDraws(std::span<IndexRange const> ranges, uint32_t indexCount, ClusterDrawSettings const& settings)
+{
+	if (ranges.size() > settings.MaxDraws)
+		return false;
+	uint32_t visibleIndices = 0;
+	for (auto& range : ranges)
+		visibleIndices += range.IndexCount;
+	return float(indexCount - visibleIndices) >= settings.MinCulledFraction * float(indexCount);
+}
+
+}
\ No newline at end of file
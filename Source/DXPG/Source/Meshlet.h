@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "MeshImport.h"
+#include "Culling.h"
+
+namespace dxpg
+{
+
+constexpr uint32_t MeshletMaxVertices = 64;
+constexpr uint32_t MeshletMaxTriangles = 124;
+
+// Laid out in 16 byte rows so the array can be uploaded as a structured buffer as is
+struct Meshlet
+{
+	// Into MeshletData::Vertices and MeshletData::Triangles
+	uint32_t VertexOffset;
+	uint32_t TriangleOffset;
+	uint32_t VertexCount;
+	uint32_t TriangleCount;
+
+	// Object space bounding sphere
+	Vector3 Center;
+	float Radius;
+
+	// Every triangle normal is within the cone around ConeAxis, ConeCutoff is the sine of its half angle
+	// and 1 when the cone is too wide to ever reject the meshlet
+	Vector3 ConeAxis;
+	float ConeCutoff;
+};
+static_assert(sizeof(Meshlet) % 16 == 0);
+
+struct MeshletData
+{
+	std::vector<Meshlet> Meshlets;
+	// Meshlet local vertex to mesh vertex
+	std::vector<uint32_t> Vertices;
+	// Three meshlet local vertices per triangle, the layout mesh shaders consume
+	std::vector<uint8_t> Triangles;
+};
+
+// Greedily groups triangles in index order, so the triangles of meshlet i are the contiguous index range
+// [3 * TriangleOffset, 3 * (TriangleOffset + TriangleCount)) of the source index buffer. Run it after the
+// vertex cache optimization so the groups are spatially coherent.
+void BuildMeshlets(std::span<uint32_t const> indices, std::span<MeshVertex const> vertices, MeshletData& outMeshlets);
+
+struct IndexRange
+{
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+};
+
+// CPU reference of the cluster culling, the bounds are moved to world space with the mesh's world matrix. Spheres
+// grow by its largest axis scale, the normal cone is only tested while the scale is uniform and not mirrored.
+// Visible meshlets are appended to outRanges as index ranges, adjacent visible meshlets are merged into one range.
+CullingStats CullMeshlets(std::span<Meshlet const> meshlets, Matrix4x4 const& world, Frustum const& frustum, Vector4 cameraPosition, std::vector<IndexRange>& outRanges);
+
+// Every draw has a fixed cost, splitting one into its visible ranges only pays off when culling skips enough of the mesh
+struct ClusterDrawSettings
+{
+	// Fraction of the mesh's indices culling has to skip
+	float MinCulledFraction = 0.5f;
+	// More ranges than this are drawn as the whole mesh
+	uint32_t MaxDraws = 8;
+};
+
+// True when the visible ranges are to be drawn one by one instead of the indexCount indices of the mesh in one draw
+bool SplitClusterDraws(std::span<IndexRange const> ranges, uint32_t indexCount, ClusterDrawSettings const& settings);
+
+}
\ No newline at end of file
@@ -2,6 +2,11 @@
 
 #include "DXResource.h"
 #include "RendererCommon.h"
+#include "MeshImport.h"
+#include "Meshlet.h"
+#include "VertexQuantization.h"
+#include "MeshLod.h"
+#include "GeometryPool.h"
 
 namespace dxpg
 {
@@ -12,10 +17,17 @@ struct HLSL_ShaderMaterialInfo
     Vector4 Diffuse;
     int UseDiffuseTexture;
     int UseAlphaTexture;
+    // Layout of the diffuse texture when it is virtual, the shader turns it into tile feedback
+    int UseVirtualTexture;
+    uint32_t VirtualTextureId;
+    uint32_t TextureSize[2];
+    uint32_t TileSize[2];
+    uint32_t StandardLevels;
 };
 
 struct Material
 {
+    uint32_t Id = 0;
     std::string Name;
     std::optional<std::string> DiffuseTextureName;
 
@@ -25,24 +37,49 @@ struct Material
 
     DXTypedBuffer<HLSL_ShaderMaterialInfo> MaterialInfoBuffer;
     DescriptorAllocation MaterialInfo;
-	std::optional<DescriptorAllocation> DiffuseTextureSRV = std::nullopt;
+	// Owned by the texture manager
+	TextureView* DiffuseTexture = nullptr;
+	// Residency map of a virtual diffuse texture
+	D3D12_GPU_DESCRIPTOR_HANDLE ResidencyMap{};
 };
 
 struct Model
 {
-    DXTypedBuffer<Vector3> PositionsBuffer;
-    DXTypedBuffer<Vector3> NormalsBuffer;
-    DXTypedBuffer<Vector2> TexCoordsBuffer;
-    DXTypedBuffer<Vector3> TangentsBuffer;
-
-    DescriptorAllocation VertexSRV;
+    uint32_t Id = 0;
+    VertexFormat Format = VertexFormat::Full;
+    // Range of the vertices in the geometry pool of the model's format
+    GeometryAllocation Vertices;
+    // Covers the whole pool block, Vertices.Offset() is folded into the BaseVertex of every shape
+    D3D12_VERTEX_BUFFER_VIEW VertexBufferView{};
 };
 
 struct IndexedModel
 {
+    uint32_t Id = 0;
 	std::string Name;
     Model* Model;
-    DXTypedBuffer<HLSL_VertexData> Indices;
-    D3D12_VERTEX_BUFFER_VIEW IndicesView{};
+    // Range of the indices in the geometry pool, in 4 byte elements
+    GeometryAllocation Indices;
+    // Covers the whole pool block, draws start at FirstIndex
+    D3D12_INDEX_BUFFER_VIEW IndexBufferView{};
+    uint32_t FirstIndex = 0;
+    // LOD 0 index count, the coarser levels follow it in the same index buffer
+    uint32_t IndexCount = 0;
+    std::vector<MeshLod> Lods;
+    // Indices are relative to this shape's first vertex in the pool block
+    int32_t BaseVertex = 0;
+    // Identity unless the model's vertices are quantized, then it maps them back into object space
+    Matrix4x4 PositionDequantize = XMMatrixIdentity();
+    // Index ranges of the shape's meshlets, used for cluster culling
+    MeshletData Meshlets;
+
+    // Object space bounds, already scaled by ModelPositionScale
+    DirectX::BoundingBox Bounds{};
+    DirectX::BoundingSphere BoundingSphere{};
+    // At LOD 0
+    uint32_t VertexCount = 0;
+    uint32_t TriangleCount = 0;
+    // Copy queue batch holding the shape's buffers, 0 when they were recorded on the graphics queue
+    uint64_t UploadFence = 0;
 };
 }
\ No newline at end of file
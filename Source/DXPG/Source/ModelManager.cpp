@@ -1,15 +1,390 @@
 #include "ModelManager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <iostream>
+#include <numeric>
 #include <tiny_obj_loader.h>
 #include "TextureManager.h"
+#include "VirtualTextureManager.h"
+#include "MeshOptimizer.h"
+#include "MeshLod.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "ObjParser.h"
+#include "GltfImport.h"
+#include "Parallel.h"
 
 namespace dxpg
 {
 std::unique_ptr<ModelManager> ModelManager::Instance = nullptr;
+
+static MeshVertex LoadObjCorner(tinyobj::attrib_t const& attrib, tinyobj::index_t index)
+{
+	MeshVertex vertex{};
+	auto& positions = attrib.vertices;
+	vertex.Position = Vector3(positions[3 * index.vertex_index] * ModelPositionScale, positions[3 * index.vertex_index + 1] * ModelPositionScale, positions[3 * index.vertex_index + 2] * ModelPositionScale);
+	if (index.normal_index >= 0)
+		vertex.Normal = Vector3(&attrib.normals[3 * index.normal_index]);
+	if (index.texcoord_index >= 0)
+		vertex.TexCoord = Vector2(&attrib.texcoords[2 * index.texcoord_index]);
+	return vertex;
+}
+
+struct ShapeMesh
+{
+	std::vector<MeshVertex> Vertices;
+	std::vector<uint32_t> Indices;
+	uint32_t SourceVertices = 0;
+	VertexCacheStats CacheBefore;
+	VertexCacheStats CacheAfter;
+	MeshletData Meshlets;
+	std::vector<MeshLod> Lods;
+	DirectX::BoundingBox Bounds;
+	DirectX::BoundingSphere BoundingSphere;
+
+	// Filled while packing the shapes into the model
+	std::string Name;
+	int32_t MaterialIndex = -1;
+	uint32_t BaseVertex = 0;
+	uint32_t IndexStride = sizeof(uint32_t);
+	std::vector<uint16_t> Indices16;
+};
+
+static void BuildShapeMesh(tinyobj::attrib_t const& attrib, tinyobj::shape_t const& shape, ShapeMesh& outMesh)
+{
+	std::vector<MeshVertex> corners;
+	corners.reserve(shape.mesh.indices.size());
+	for (auto& index : shape.mesh.indices)
+		corners.push_back(LoadObjCorner(attrib, index));
+	outMesh.SourceVertices = static_cast<uint32_t>(corners.size());
+	DeduplicateVertices(corners, outMesh.Vertices, outMesh.Indices);
+	OptimizeMesh(outMesh.Vertices, outMesh.Indices, &outMesh.CacheBefore, &outMesh.CacheAfter);
+	BuildMeshlets(outMesh.Indices, outMesh.Vertices, outMesh.Meshlets);
+	// Meshlets only cover LOD 0, the coarser levels are appended behind it
+	BuildLodChain(outMesh.Indices, outMesh.Vertices, outMesh.Lods);
+	ComputeMeshBounds(outMesh.Vertices, outMesh.Bounds, outMesh.BoundingSphere);
+}
+
+// Owns everything a CookedModel produced by the importer points to
+struct CookedObj
+{
+	struct MaterialSource
+	{
+		std::string Name;
+		std::string DiffuseTexture;
+		Vector3 DiffuseColor;
+	};
+
+	std::vector<std::byte> Vertices;
+	std::vector<MaterialSource> Materials;
+	std::vector<ShapeMesh> Shapes;
+	CookedModel Model;
+};
+
+// Parses the file again with tinyobj and reports where the parallel parser disagrees
+static void ValidateObjParse(std::string const& modelPath, ObjParseResult const& parsed)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	tinyobj::ObjReader reader;
+	reader.ParseFromFile(modelPath, tinyobj::ObjReaderConfig());
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	if (!reader.Valid())
+	{
+		std::cout << modelPath << ": tinyobj failed, " << reader.Error() << std::endl;
+		return;
+	}
+
+	auto& attrib = reader.GetAttrib();
+	auto& shapes = reader.GetShapes();
+	auto& materials = reader.GetMaterials();
+	std::string mismatch;
+	auto sameIndices = [](std::vector<tinyobj::index_t> const& a, std::vector<tinyobj::index_t> const& b)
+	{
+		return std::ranges::equal(a, b, [](tinyobj::index_t const& x, tinyobj::index_t const& y)
+		{
+			return x.vertex_index == y.vertex_index && x.normal_index == y.normal_index && x.texcoord_index == y.texcoord_index;
+		});
+	};
+	if (attrib.vertices != parsed.Attrib.vertices || attrib.normals != parsed.Attrib.normals || attrib.texcoords != parsed.Attrib.texcoords || attrib.colors != parsed.Attrib.colors)
+		mismatch = "vertex attributes";
+	else if (shapes.size() != parsed.Shapes.size())
+		mismatch = "shape count";
+	else if (materials.size() != parsed.Materials.size())
+		mismatch = "material count";
+	for (size_t i = 0; mismatch.empty() && i < shapes.size(); ++i)
+	{
+		auto& mesh = shapes[i].mesh;
+		auto& parsedMesh = parsed.Shapes[i].mesh;
+		if (shapes[i].name != parsed.Shapes[i].name || !sameIndices(mesh.indices, parsedMesh.indices) || mesh.num_face_vertices != parsedMesh.num_face_vertices
+			|| mesh.material_ids != parsedMesh.material_ids || mesh.smoothing_group_ids != parsedMesh.smoothing_group_ids)
+			mismatch = "shape " + shapes[i].name;
+	}
+	for (size_t i = 0; mismatch.empty() && i < materials.size(); ++i)
+	{
+		auto& material = materials[i];
+		auto& parsedMaterial = parsed.Materials[i];
+		if (material.name != parsedMaterial.name || material.diffuse_texname != parsedMaterial.diffuse_texname || !std::ranges::equal(material.diffuse, parsedMaterial.diffuse))
+			mismatch = "material " + material.name;
+	}
+
+	if (mismatch.empty())
+		std::cout << modelPath << ": parallel parse matches tinyobj, " << milliseconds << " ms in tinyobj" << std::endl;
+	else
+		std::cout << modelPath << ": parallel parse differs from tinyobj in " << mismatch << std::endl;
+}
+
+// Parses the OBJ and runs the whole import, the result is ready to be uploaded or written to the mesh cache
+static void CookObjModel(std::string const& modelPath, VertexFormat format, bool validateParser, CookedObj& outCooked)
+{
+	ObjParseResult parsed;
+	bool parseOk = ParseObj(modelPath, parsed);
+	if (!parsed.Warning.empty())
+		std::cout << modelPath << ": " << parsed.Warning;
+	if (!parseOk)
+		std::cout << modelPath << ": " << parsed.Error << std::endl;
+	assert(parseOk);
+	if (validateParser)
+		ValidateObjParse(modelPath, parsed);
+	auto& attrib = parsed.Attrib;
+	auto& shapes = parsed.Shapes;
+
+	for (auto& mat : parsed.Materials)
+		outCooked.Materials.push_back({ .Name = mat.name, .DiffuseTexture = mat.diffuse_texname, .DiffuseColor = Vector3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]) });
+
+	// Weld and optimize every shape on its own, shapes are independent so this runs in parallel
+	auto importStart = std::chrono::high_resolution_clock::now();
+	auto& shapeMeshes = outCooked.Shapes;
+	shapeMeshes.resize(shapes.size());
+	ParallelFor(shapes.size(), [&](size_t shapeIndex)
+	{
+		BuildShapeMesh(attrib, shapes[shapeIndex], shapeMeshes[shapeIndex]);
+	});
+
+    // Loop over shapes, every shape gets its own range of the shared vertex buffer
+	auto& cooked = outCooked.Model;
+	auto& stats = cooked.Stats;
+	stats = {};
+	cooked.Format = format;
+	cooked.VertexStride = format == VertexFormat::Quantized ? sizeof(QuantizedMeshVertex) : sizeof(MeshVertex);
+	std::vector<MeshVertex> vertices;
+	std::vector<QuantizedMeshVertex> quantizedVertices;
+	QuantizationError quantizationError;
+    for (size_t shapeIndex = 0; shapeIndex < shapes.size(); ++shapeIndex)
+    {
+		auto& shape = shapes[shapeIndex];
+		auto& shapeMesh = shapeMeshes[shapeIndex];
+		auto& indices = shapeMesh.Indices;
+		shapeMesh.Name = shape.name;
+		shapeMesh.MaterialIndex = shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[0];
+
+		shapeMesh.BaseVertex = static_cast<uint32_t>(vertices.size() + quantizedVertices.size());
+		uint32_t shapeVertexCount = static_cast<uint32_t>(shapeMesh.Vertices.size());
+		stats.SourceVertices += shapeMesh.SourceVertices;
+		stats.UniqueVertices += shapeVertexCount;
+		uint32_t lod0IndexCount = shapeMesh.Lods[0].IndexCount;
+		stats.Triangles += lod0IndexCount / 3;
+		stats.LodTriangles += static_cast<uint32_t>(indices.size()) / 3 - lod0IndexCount / 3;
+		stats.TransformedBefore += shapeMesh.CacheBefore.TransformedVertices;
+		stats.TransformedAfter += shapeMesh.CacheAfter.TransformedVertices;
+		stats.Meshlets += static_cast<uint32_t>(shapeMesh.Meshlets.Meshlets.size());
+
+		if (FitsIndex16(shapeVertexCount))
+		{
+			NarrowIndices(indices, shapeMesh.Indices16);
+			shapeMesh.IndexStride = sizeof(uint16_t);
+			stats.Index16Shapes++;
+		}
+		else
+			stats.Index32Shapes++;
+		// Positions are quantized within the shape bounds so every shape keeps the full 16 bits of precision
+		if (format == VertexFormat::Quantized)
+			QuantizeVertices(shapeMesh.Vertices, shapeMesh.Bounds, quantizedVertices, quantizationError);
+		else
+			vertices.insert(vertices.end(), shapeMesh.Vertices.begin(), shapeMesh.Vertices.end());
+    }
+
+	auto vertexBytes = format == VertexFormat::Quantized ? std::as_bytes(std::span(quantizedVertices)) : std::as_bytes(std::span(vertices));
+	outCooked.Vertices.assign(vertexBytes.begin(), vertexBytes.end());
+	cooked.Vertices = outCooked.Vertices;
+	stats.VertexBufferBytes = static_cast<uint32_t>(outCooked.Vertices.size());
+
+	for (auto& material : outCooked.Materials)
+		cooked.Materials.push_back({ .Name = material.Name, .DiffuseTexture = material.DiffuseTexture, .DiffuseColor = material.DiffuseColor });
+	for (auto& shapeMesh : shapeMeshes)
+	{
+		bool narrow = shapeMesh.IndexStride == sizeof(uint16_t);
+		cooked.Shapes.push_back({
+			.Name = shapeMesh.Name,
+			.MaterialIndex = shapeMesh.MaterialIndex,
+			.BaseVertex = shapeMesh.BaseVertex,
+			.VertexCount = static_cast<uint32_t>(shapeMesh.Vertices.size()),
+			.IndexStride = shapeMesh.IndexStride,
+			.Indices = narrow ? std::as_bytes(std::span(shapeMesh.Indices16)) : std::as_bytes(std::span(shapeMesh.Indices)),
+			.Lods = shapeMesh.Lods,
+			.Meshlets = shapeMesh.Meshlets.Meshlets,
+			.MeshletVertices = shapeMesh.Meshlets.Vertices,
+			.MeshletTriangles = shapeMesh.Meshlets.Triangles,
+			.Bounds = shapeMesh.Bounds,
+			.BoundingSphere = shapeMesh.BoundingSphere });
+	}
+
+	stats.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - importStart).count();
+	std::cout << modelPath << ": parsed in " << parsed.Milliseconds << " ms from " << parsed.Chunks << " chunks" << std::endl;
+	std::cout << modelPath << ": " << stats.SourceVertices << " corners welded to " << stats.UniqueVertices << " vertices, "
+		<< stats.Index16Shapes << " 16-bit / " << stats.Index32Shapes << " 32-bit index buffers, " << stats.Meshlets << " meshlets in " << stats.Milliseconds << " ms" << std::endl;
+	if (stats.Triangles > 0 && stats.UniqueVertices > 0)
+	{
+		std::cout << modelPath << ": ACMR " << float(stats.TransformedBefore) / stats.Triangles << " -> " << float(stats.TransformedAfter) / stats.Triangles
+			<< ", ATVR " << float(stats.TransformedBefore) / stats.UniqueVertices << " -> " << float(stats.TransformedAfter) / stats.UniqueVertices << std::endl;
+		std::cout << modelPath << ": " << stats.Triangles << " triangles, " << stats.LodTriangles << " more in coarser LODs" << std::endl;
+	}
+	std::cout << modelPath << ": " << stats.VertexBufferBytes / 1024 << " KiB of vertices";
+	if (format == VertexFormat::Quantized)
+	{
+		std::cout << " quantized, max error position " << quantizationError.Position / ModelPositionScale << ", normal " << quantizationError.NormalDegrees
+			<< " degrees, uv " << quantizationError.TexCoord;
+	}
+	std::cout << std::endl;
+}
+
+// Where a model is created from, either the mapped mesh cache, a fresh import or a GLB mapped as is
+struct ModelSource
+{
+	MappedFile CacheFile;
+	CookedModel CachedModel;
+	CookedObj Cooked;
+	CookedGlb Glb;
+	StaticBatches Batches;
+	bool FromCache = false;
+	bool FromGlb = false;
+	bool Batched = false;
+
+	CookedModel const& Model() const
+	{
+		if (Batched)
+			return Batches.Model;
+		return FromGlb ? Glb.Model : FromCache ? CachedModel : Cooked.Model;
+	}
+};
+
+// Reads the model from its cache or imports it and refreshes the cache, touches no D3D state so it can run on any thread
+static void ReadModelSource(std::string const& modelPath, VertexFormat format, bool useCache, bool validateParser, float gltfPositionScale, ModelSource& outSource)
+{
+	// GLB files are already laid out for the GPU, indices and images are used from the mapped file and there is nothing to cache
+	if (IsGlbPath(modelPath))
+	{
+		outSource.FromGlb = true;
+		std::string error;
+		bool cookOk = CookGlbModel(modelPath, format, gltfPositionScale, outSource.Glb, error);
+		if (!cookOk)
+			std::cout << modelPath << ": " << error << std::endl;
+		assert(cookOk);
+		auto& stats = outSource.Glb.Model.Stats;
+		std::cout << modelPath << ": " << stats.UniqueVertices << " vertices, " << stats.Triangles << " triangles, " << outSource.Glb.Model.Nodes.size() << " nodes, "
+			<< outSource.Glb.SkippedPrimitives << " primitives skipped in " << stats.Milliseconds << " ms" << std::endl;
+		if (outSource.Glb.GeneratedNormals > 0)
+			std::cout << modelPath << ": generated normals for " << outSource.Glb.GeneratedNormals << " vertex streams without them" << std::endl;
+		return;
+	}
+
+	// Warm loads upload straight out of the mapped cache, the mapping is only needed until the uploads are recorded
+	auto cachePath = MeshCachePath(modelPath);
+	MeshCacheKey cacheKey;
+	bool cacheable = useCache && MakeMeshCacheKey(modelPath, format, cacheKey);
+	outSource.FromCache = cacheable && outSource.CacheFile.Open(cachePath) && ReadMeshCache(outSource.CacheFile.Data(), cacheKey, outSource.CachedModel);
+	if (!outSource.FromCache)
+	{
+		outSource.CacheFile.Close();
+		CookObjModel(modelPath, format, validateParser, outSource.Cooked);
+		if (cacheable && !WriteMeshCache(cachePath, cacheKey, outSource.Cooked.Model))
+			std::cout << "Failed to write mesh cache " << cachePath.string() << std::endl;
+	}
+}
+
+// Batches are built from whatever was read, the mesh cache keeps the unbatched shapes
+static void BatchModelSource(std::string const& modelPath, StaticBatchSettings const& settings, ModelSource& source)
+{
+	std::vector<StaticBatchInstance> instances;
+	GatherStaticInstances(source.Model(), instances);
+	BuildStaticBatches(source.Model(), instances, settings, source.Batches);
+	source.Batched = true;
+	auto& stats = source.Batches.Model.Stats;
+	std::cout << modelPath << ": " << instances.size() << " static instances merged into " << source.Batches.Batches.size() << " batches, "
+		<< stats.Triangles << " triangles, " << stats.Meshlets << " meshlets in " << stats.Milliseconds << " ms" << std::endl;
+}
+
+static void FinishLoad(ObjModel& objModel, std::string const& modelPath, bool fromCache, std::chrono::high_resolution_clock::time_point loadStart)
+{
+	auto& stats = objModel.ImportStats;
+	stats.FromCache = fromCache;
+	stats.LoadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+	std::cout << modelPath << ": " << (fromCache ? "warm load from mesh cache" : "cold load") << " in " << stats.LoadMilliseconds << " ms" << std::endl;
+}
+
+// Key the material's diffuse texture is loaded under, empty without one. Embedded images are keyed by the model path
+static std::filesystem::path DiffuseTexturePath(CookedMaterial const& mat, std::string const& modelPath)
+{
+	if (!mat.DiffuseTextureData.empty())
+		return modelPath + "#" + std::string(mat.DiffuseTexture);
+	if (!mat.DiffuseTexture.empty())
+		return std::filesystem::path(modelPath).parent_path().string() + "/" + std::string(mat.DiffuseTexture);
+	return {};
+}
+
+static void AddModelNode(ObjModel const& objModel, std::vector<std::vector<uint32_t>> const& children, uint32_t nodeIndex, MeshObject& parent)
+{
+	auto& node = objModel.Nodes[nodeIndex];
+	auto& object = parent.Children.emplace_back(node.Name);
+	object.Position = node.Position;
+	object.Rotation = node.Rotation;
+	object.Scale = node.Scale;
+	// A node with a single shape draws it itself, otherwise every shape becomes a child at the node's origin
+	if (node.ObjectCount == 1)
+	{
+		auto [indexedModel, material] = objModel.Objects[node.FirstObject];
+		object.IndexedModel = indexedModel;
+		object.Material = material;
+		object.TransformOnly = false;
+	}
+	else
+	{
+		for (uint32_t i = node.FirstObject; i < node.FirstObject + node.ObjectCount; ++i)
+			object.Children.emplace_back(objModel.Objects[i].first->Name, objModel.Objects[i].first, objModel.Objects[i].second);
+	}
+	for (uint32_t child : children[nodeIndex])
+		AddModelNode(objModel, children, child, object);
+}
+
+MeshObject InstantiateModel(ObjModel const& objModel, std::string name)
+{
+	MeshObject root(std::move(name));
+	if (objModel.Nodes.empty())
+	{
+		for (auto& [indexedModel, material] : objModel.Objects)
+			root.Children.emplace_back(indexedModel->Name, indexedModel, material);
+		return root;
+	}
+
+	std::vector<std::vector<uint32_t>> children(objModel.Nodes.size());
+	for (uint32_t i = 0; i < objModel.Nodes.size(); ++i)
+	{
+		if (objModel.Nodes[i].Parent >= 0)
+			children[objModel.Nodes[i].Parent].push_back(i);
+	}
+	for (uint32_t i = 0; i < objModel.Nodes.size(); ++i)
+	{
+		if (objModel.Nodes[i].Parent < 0)
+			AddModelNode(objModel, children, i, root);
+	}
+	return root;
+}
+
 void ModelManager::Init(ID3D12Device* device)
 {
 	Device = device;
+	Geometry.Init(device);
 }
 
 ObjModel* ModelManager::LoadModel(const std::string& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
@@ -21,101 +396,250 @@ ObjModel* ModelManager::LoadModel(const std::string& modelPath, FrameContext& fr
 	}
     
 	auto& objModel = Models[modelPath] = std::make_unique<ObjModel>();
+	auto loadStart = std::chrono::high_resolution_clock::now();
 
-    tinyobj::ObjReaderConfig readerConfig;
-    tinyobj::ObjReader reader;
-    reader.ParseFromFile(modelPath, readerConfig);
-    assert(reader.Valid());
-    auto& attrib = reader.GetAttrib();
-    auto& shapes = reader.GetShapes();
+	ModelSource source;
+	ReadModelSource(modelPath, ImportVertexFormat, EnableMeshCache, ValidateObjParser, GltfPositionScale, source);
+	if (EnableStaticBatching)
+		BatchModelSource(modelPath, StaticBatching, source);
+	CreateModel(*objModel, source.Model(), modelPath, frameCtx, cmdList);
+	FinishLoad(*objModel, modelPath, source.FromCache, loadStart);
+    return objModel.get();
+}
 
-    objModel->ModelViews.reserve(shapes.size());
-	objModel->Materials.reserve(reader.GetMaterials().size());
+Task<ObjModel*> ModelManager::LoadModelAsync(std::string modelPath, TaskScheduler& scheduler, UploadQueue& uploads, UploadQueue& copies, ShapeReadyCallback onShapeReady)
+{
+	auto it = Models.find(modelPath);
+	if (it != Models.end())
+	{
+		// Shapes of a model that is still loading are not created yet
+		for (auto& [indexedModel, material] : it->second->Objects)
+		{
+			if (onShapeReady && indexedModel)
+				onShapeReady(indexedModel, material);
+		}
+		co_return it->second.get();
+	}
 
-    {
-		auto& model = objModel->Model;
+	auto& objModel = *(Models[modelPath] = std::make_unique<ObjModel>());
+	auto loadStart = std::chrono::high_resolution_clock::now();
 
-	    model.PositionsBuffer = DXTypedBuffer<Vector3>::CreateAndUpload(Device, s2ws(modelPath) + L"_Positions", cmdList, frameCtx.IntermediateResources.emplace_back(), std::span{ (Vector3 const*)attrib.vertices.data(), attrib.vertices.size() / (sizeof(Vector3)/sizeof(tinyobj::real_t))}, D3D12_RESOURCE_STATE_GENERIC_READ);
-	    model.NormalsBuffer = DXTypedBuffer<Vector3>::CreateAndUpload(Device, s2ws(modelPath) + L"_Normals", cmdList, frameCtx.IntermediateResources.emplace_back(), std::span{ (Vector3 const*)attrib.normals.data(), attrib.normals.size() / (sizeof(Vector3) / sizeof(tinyobj::real_t)) }, D3D12_RESOURCE_STATE_GENERIC_READ);
-	    model.TexCoordsBuffer = DXTypedBuffer<Vector2>::CreateAndUpload(Device, s2ws(modelPath) + L"_TexCoords", cmdList, frameCtx.IntermediateResources.emplace_back(), std::span{ (Vector2 const*)attrib.texcoords.data(), attrib.texcoords.size() / (sizeof(Vector2) / sizeof(tinyobj::real_t)) }, D3D12_RESOURCE_STATE_GENERIC_READ);
+	// Reading and parsing run on a worker, D3D objects and descriptors are only ever created on the main thread
+	ModelSource source;
+	co_await scheduler.ResumeOnWorker();
+	ReadModelSource(modelPath, ImportVertexFormat, EnableMeshCache, ValidateObjParser, GltfPositionScale, source);
+	if (EnableStaticBatching)
+		BatchModelSource(modelPath, StaticBatching, source);
+	co_await scheduler.ResumeOnMainThread();
 
-	    model.VertexSRV = g_GPUDescriptorAllocator->AllocateFromStatic(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 3);
-        model.PositionsBuffer.CreatePlacedSRV(model.VertexSRV.GetView(0), attrib.vertices.size());
-		model.NormalsBuffer.CreatePlacedSRV(model.VertexSRV.GetView(1), attrib.normals.size());
-		model.TexCoordsBuffer.CreatePlacedSRV(model.VertexSRV.GetView(2), attrib.texcoords.size());
-    }
+	auto const& cooked = source.Model();
+	BeginModel(objModel, cooked, modelPath, copies.Begin(), copies.CommandList());
 
+	// Textures decode on the workers while the geometry uploads, a shape is only created once its material's texture is uploaded or queued ahead of it
+	auto materialsReady = std::make_shared<std::vector<uint8_t>>(cooked.Materials.size(), 1);
+	std::vector<TextureManager::TextureRequest> textureRequests;
+	std::vector<size_t> requestMaterials;
+	for (size_t materialIndex = 0; materialIndex < cooked.Materials.size(); ++materialIndex)
+	{
+		auto texturePath = DiffuseTexturePath(cooked.Materials[materialIndex], modelPath);
+		if (texturePath.empty())
+			continue;
+		(*materialsReady)[materialIndex] = 0;
+		textureRequests.push_back({ .Path = texturePath, .Encoded = cooked.Materials[materialIndex].DiffuseTextureData });
+		requestMaterials.push_back(materialIndex);
+	}
+	TextureManager::Get().LoadTexturesAsync(textureRequests, scheduler, uploads, copies, [materialsReady, requestMaterials](size_t requestIndex, DXTexture*)
+	{
+		(*materialsReady)[requestMaterials[requestIndex]] = 1;
+	});
+	auto materialReady = [&](int32_t materialIndex)
+	{
+		return materialIndex < 0 || (*materialsReady)[materialIndex] != 0;
+	};
 
-    for (auto& mat : reader.GetMaterials())
-    {
-        auto& material = objModel->Materials[mat.name];
-        material.Name = mat.name;
+	// Shapes are uploaded in batches on the copy queue and handed out as soon as their batch is submitted, the frames drawing them
+	// wait for it on the GPU. Every batch covers the vertices, the materials and the copied textures recorded before it
+	std::vector<uint32_t> pendingShapes(cooked.Shapes.size());
+	std::iota(pendingShapes.begin(), pendingShapes.end(), 0);
+	std::vector<uint32_t> batchShapes;
+	size_t batchBytes = cooked.Vertices.size();
+	while (!pendingShapes.empty() && !scheduler.Cancelled())
+	{
+		batchShapes.clear();
+		std::erase_if(pendingShapes, [&](uint32_t shapeIndex)
+		{
+			if (batchBytes >= AsyncUploadBatchBytes || !materialReady(cooked.Shapes[shapeIndex].MaterialIndex))
+				return false;
+			CreateShape(objModel, cooked, shapeIndex, modelPath, copies.Begin(), copies.CommandList());
+			batchBytes += cooked.Shapes[shapeIndex].Indices.size();
+			batchShapes.push_back(shapeIndex);
+			return true;
+		});
+		// Nothing recorded, every remaining shape still waits for a texture
+		if (batchBytes == 0)
+		{
+			co_await scheduler.ResumeOnMainThread();
+			continue;
+		}
+		uint64_t uploadFence = copies.Submit();
+		for (uint32_t shapeIndex : batchShapes)
+		{
+			objModel.Objects[shapeIndex].first->UploadFence = uploadFence;
+			if (onShapeReady)
+				onShapeReady(objModel.Objects[shapeIndex].first, objModel.Objects[shapeIndex].second);
+		}
+		batchBytes = 0;
+		// The next batch is recorded next frame, or once a context is free instead of blocking the frame loop in Begin
+		if (uint64_t busy = copies.BusyValue())
+			co_await scheduler.WaitForFence(copies, busy);
+		else
+			co_await scheduler.ResumeOnMainThread();
+	}
+	// A model without shapes still has its vertex buffer recorded, the load time includes the last copy
+	co_await scheduler.WaitForFence(copies, copies.Submit());
+	// Textures of materials no shape uses may still decode from the source's memory
+	while (std::ranges::find(*materialsReady, 0) != materialsReady->end())
+		co_await scheduler.ResumeOnMainThread();
 
-        material.MaterialInfo = g_GPUDescriptorAllocator->AllocateFromStatic(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	if (scheduler.Cancelled())
+		co_return nullptr;
+	FinishLoad(objModel, modelPath, source.FromCache, loadStart);
+	co_return &objModel;
+}
 
-		HLSL_ShaderMaterialInfo matInfo = {};
-        bool difTexLoaded = false;
-        // Load the textures
-        if (!mat.diffuse_texname.empty())
-        {
-            material.DiffuseTextureName = std::filesystem::path(modelPath).parent_path().string() + "/" + mat.diffuse_texname;
-            // Load texture into memory
-            auto* tex = TextureManager::Get().LoadTexture(std::filesystem::path(*material.DiffuseTextureName), {}, frameCtx, cmdList, true);
-            if (tex)
-            {
-		        material.DiffuseTextureSRV = g_GPUDescriptorAllocator->AllocateFromStatic(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
-                D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-                srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-                srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-                srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-                srvDesc.Texture2D.MipLevels = -1;
-                tex->CreatePlacedSRV(material.DiffuseTextureSRV->GetView(0), &srvDesc);
-				difTexLoaded = true;
-				matInfo.UseDiffuseTexture = 1;
-            }
-        }
-        if (!difTexLoaded)
-        {
-            matInfo.Diffuse = Vector4{ mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], 1.0f };
-            material.DiffuseColor = Vector3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]);
-        }
+void ModelManager::CreateModel(ObjModel& objModel, CookedModel const& cooked, std::string const& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	BeginModel(objModel, cooked, modelPath, frameCtx, cmdList);
+	for (int materialIndex = 0; materialIndex < static_cast<int>(cooked.Materials.size()); ++materialIndex)
+		CreateMaterial(objModel, cooked, materialIndex, modelPath, frameCtx, cmdList);
+	for (size_t shapeIndex = 0; shapeIndex < cooked.Shapes.size(); ++shapeIndex)
+		CreateShape(objModel, cooked, shapeIndex, modelPath, frameCtx, cmdList);
+}
 
-        material.MaterialInfoBuffer = DXTypedSingularBuffer<HLSL_ShaderMaterialInfo>::CreateAndUpload(Device, s2ws(mat.name) + L"_MaterialInfo", cmdList, frameCtx.IntermediateResources.emplace_back(), matInfo, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-		material.MaterialInfoBuffer.CreatePlacedCBV(material.MaterialInfo.GetView(0));
-    }
+void ModelManager::BeginModel(ObjModel& objModel, CookedModel const& cooked, std::string const& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	objModel.ImportStats = cooked.Stats;
+    objModel.ModelViews.reserve(cooked.Shapes.size());
+	objModel.Materials.reserve(cooked.Materials.size());
+	// Indexed by shape, async loads create the shapes out of order
+	objModel.Objects.assign(cooked.Shapes.size(), { nullptr, nullptr });
 
-    // Loop over shapes
-    for (auto& shape : shapes)
-    {
-		auto& indexedModel = objModel->ModelViews[shape.name];
-		indexedModel.Model = &objModel->Model;
-        indexedModel.Name = shape.name;
-		static_assert(sizeof(HLSL_VertexData) == sizeof(tinyobj::index_t));
-        indexedModel.Indices = DXTypedBuffer<HLSL_VertexData>::CreateAndUpload(Device, s2ws(shape.name), cmdList, frameCtx.IntermediateResources.emplace_back(), std::span((HLSL_VertexData const*)shape.mesh.indices.data(), shape.mesh.indices.size()), D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-		indexedModel.IndicesView.BufferLocation = indexedModel.Indices.Resource->GetGPUVirtualAddress();
-		indexedModel.IndicesView.SizeInBytes = indexedModel.Indices.Size;
-		indexedModel.IndicesView.StrideInBytes = sizeof(HLSL_VertexData);
-    }
+	objModel.Model.Id = NextModelId++;
 
-	objModel->Objects.reserve(shapes.size());
+	// Shapes are created in order, so a node's shape range is also its range of Objects
+	objModel.Nodes.reserve(cooked.Nodes.size());
+	for (auto& cookedNode : cooked.Nodes)
+	{
+		auto& node = objModel.Nodes.emplace_back();
+		node.Name = cookedNode.Name;
+		node.Parent = cookedNode.Parent;
+		node.FirstObject = cookedNode.FirstShape;
+		node.ObjectCount = cookedNode.ShapeCount;
+		LocalTransformFromQuaternion(XMLoadFloat3(&cookedNode.Translation), cookedNode.Rotation, XMLoadFloat3(&cookedNode.Scale), node.Position, node.Rotation, node.Scale);
+	}
 
-    for (size_t i = 0; i < shapes.size(); ++i)
-    {
-		auto& shape = shapes[i];
-		auto& indexedModel = objModel->ModelViews[shape.name];
+	auto& model = objModel.Model;
+	model.Format = cooked.Format;
+	auto& vertexPool = Geometry.Vertices(cooked.Format);
+	assert(vertexPool.Stride == cooked.VertexStride);
+	model.Vertices = vertexPool.Allocate(static_cast<uint32_t>(cooked.Vertices.size() / cooked.VertexStride));
+	if (!model.Vertices.IsValid())
+		return;
+	vertexPool.Upload(cmdList, frameCtx, model.Vertices, cooked.Vertices);
+	model.VertexBufferView = vertexPool.VertexBufferView(model.Vertices);
+}
 
-		Material* mat = nullptr;
+Material* ModelManager::CreateMaterial(ObjModel& objModel, CookedModel const& cooked, int materialIndex, std::string const& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	if (materialIndex < 0)
+		return nullptr;
+	auto& mat = cooked.Materials[materialIndex];
+	auto [it, inserted] = objModel.Materials.try_emplace(std::string(mat.Name));
+	auto& material = it->second;
+	if (!inserted)
+		return &material;
 
-        if (!shape.mesh.material_ids.empty())
+    material.Id = NextMaterialId++;
+    material.Name = mat.Name;
+
+    material.MaterialInfo = g_GPUDescriptorAllocator->AllocateFromStatic(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+
+	HLSL_ShaderMaterialInfo matInfo = {};
+    bool difTexLoaded = false;
+    // Load the textures, async loads have them created already and record on a copy list, which could not generate mips
+    DXTexture* tex = nullptr;
+    auto texturePath = DiffuseTexturePath(mat, modelPath);
+    if (!texturePath.empty())
+    {
+        material.DiffuseTextureName = texturePath.string();
+        if (cmdList->GetType() == D3D12_COMMAND_LIST_TYPE_COPY)
+            tex = TextureManager::Get().FindTexture(texturePath);
+        else
+            tex = TextureManager::Get().LoadTexture(texturePath, mat.DiffuseTextureData, {}, frameCtx, cmdList, true);
+    }
+    if (tex)
+    {
+        material.DiffuseTexture = TextureManager::Get().CreateView(tex, true);
+        if (auto* virtualTexture = VirtualTextureManager::Get().Find(tex))
         {
-            auto matName =reader.GetMaterials()[shape.mesh.material_ids[0]].name;
-			assert(objModel->Materials.find(matName) != objModel->Materials.end());
-			mat = &objModel->Materials[matName];
+            auto& layout = virtualTexture->Layout;
+            matInfo.UseVirtualTexture = 1;
+            matInfo.VirtualTextureId = virtualTexture->Id;
+            matInfo.TextureSize[0] = layout.Width;
+            matInfo.TextureSize[1] = layout.Height;
+            matInfo.TileSize[0] = layout.TileWidth;
+            matInfo.TileSize[1] = layout.TileHeight;
+            matInfo.StandardLevels = layout.StandardLevels;
+            material.ResidencyMap = virtualTexture->ResidencyMapSRV.GetGPUHandle();
         }
-		objModel->Objects.emplace_back(&indexedModel, mat);
+        difTexLoaded = true;
+        matInfo.UseDiffuseTexture = 1;
+    }
+    if (!difTexLoaded)
+    {
+        matInfo.Diffuse = Vector4{ mat.DiffuseColor.x, mat.DiffuseColor.y, mat.DiffuseColor.z, 1.0f };
+        material.DiffuseColor = mat.DiffuseColor;
     }
 
-    return objModel.get();
+    material.MaterialInfoBuffer = DXTypedSingularBuffer<HLSL_ShaderMaterialInfo>::CreateAndUpload(Device, s2ws(material.Name) + L"_MaterialInfo", cmdList, frameCtx, matInfo, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+	material.MaterialInfoBuffer.CreatePlacedCBV(material.MaterialInfo.GetView(0));
+	return &material;
+}
+
+void ModelManager::CreateShape(ObjModel& objModel, CookedModel const& cooked, size_t shapeIndex, std::string const& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	auto& shape = cooked.Shapes[shapeIndex];
+	auto& model = objModel.Model;
+	auto& indexedModel = objModel.ModelViews[std::string(shape.Name)];
+	indexedModel.Model = &model;
+	indexedModel.Id = NextIndexedModelId++;
+    indexedModel.Name = shape.Name;
+	indexedModel.BaseVertex = static_cast<int32_t>(model.Vertices.Offset() + shape.BaseVertex);
+	indexedModel.Lods.assign(shape.Lods.begin(), shape.Lods.end());
+	indexedModel.IndexCount = indexedModel.Lods.empty() ? 0 : indexedModel.Lods[0].IndexCount;
+	indexedModel.VertexCount = shape.VertexCount;
+	indexedModel.TriangleCount = indexedModel.IndexCount / 3;
+
+	auto& indexPool = Geometry.Indices;
+	indexedModel.Indices = indexPool.Allocate(static_cast<uint32_t>((shape.Indices.size() + indexPool.Stride - 1) / indexPool.Stride));
+	if (indexedModel.Indices.IsValid())
+	{
+		indexPool.Upload(cmdList, frameCtx, indexedModel.Indices, shape.Indices);
+		indexedModel.IndexBufferView = indexPool.IndexBufferView(indexedModel.Indices, shape.IndexStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT);
+		indexedModel.FirstIndex = indexedModel.Indices.Offset() * (indexPool.Stride / shape.IndexStride);
+	}
+
+	indexedModel.Bounds = shape.Bounds;
+	indexedModel.BoundingSphere = shape.BoundingSphere;
+	if (model.Format == VertexFormat::Quantized)
+		indexedModel.PositionDequantize = PositionDequantizeMatrix(indexedModel.Bounds);
+	indexedModel.Meshlets.Meshlets.assign(shape.Meshlets.begin(), shape.Meshlets.end());
+	indexedModel.Meshlets.Vertices.assign(shape.MeshletVertices.begin(), shape.MeshletVertices.end());
+	indexedModel.Meshlets.Triangles.assign(shape.MeshletTriangles.begin(), shape.MeshletTriangles.end());
+
+	// Materials are created with their first shape so async loads spread the texture work over the batches
+	Material* mat = CreateMaterial(objModel, cooked, shape.MaterialIndex, modelPath, frameCtx, cmdList);
+	objModel.Objects[shapeIndex] = { &indexedModel, mat };
 }
 
 }
\ No newline at end of file
@@ -2,28 +2,91 @@
 
 #include "DXPGCommon.h"
 #include "DXHelpers.h"
+#include <functional>
 
 #include "Model.h"
+#include "MeshCache.h"
+#include "StaticBatching.h"
+#include "GeometryPool.h"
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "UploadQueue.h"
 
 #include "RendererCommon.h"
+#include "SceneObject.h"
 
 namespace dxpg
 {
 
+// Node of an imported scene hierarchy, in ComposeLocalMatrix terms
+struct ModelNode
+{
+	std::string Name;
+	// Into ObjModel::Nodes, parents come before their children
+	int32_t Parent = -1;
+	Vector4 Position;
+	Vector4 Rotation;
+	Vector4 Scale;
+	// Range of ObjModel::Objects drawn at the node
+	uint32_t FirstObject = 0;
+	uint32_t ObjectCount = 0;
+};
+
 struct ObjModel
 {
 	Model Model;
 	std::unordered_map<std::string, IndexedModel> ModelViews;
 	std::unordered_map<std::string, Material> Materials;
 	std::vector<std::pair<IndexedModel*, Material*>> Objects;
+	// Empty for OBJ models
+	std::vector<ModelNode> Nodes;
+	MeshImportStats ImportStats;
 };
 
+// Scene objects of a loaded model under a single root: glTF models keep their node hierarchy, OBJ shapes become direct children
+MeshObject InstantiateModel(ObjModel const& objModel, std::string name);
+
 struct ModelManager : Singleton<ModelManager>
 {
 	void Init(ID3D12Device* device);
 	ObjModel* LoadModel(const std::string& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
 
+	using ShapeReadyCallback = std::function<void(IndexedModel*, Material*)>;
+	// Loads without blocking the frame loop: the file is read and parsed on a worker, geometry and materials are copied in batches on copies
+	// and onShapeReady, when set, runs on the main thread for every shape once its batch is submitted. Frames drawing the shape have to wait
+	// for its UploadFence on copies. Textures that need the graphics queue go to uploads.
+	// The model is registered right away, LoadModel on the same path returns it while it is still loading.
+	// Once the scheduler is cancelled no more shapes are created and the load returns null after its pending textures completed
+	Task<ObjModel*> LoadModelAsync(std::string modelPath, TaskScheduler& scheduler, UploadQueue& uploads, UploadQueue& copies, ShapeReadyCallback onShapeReady);
+
+	// Creates the GPU resources of an imported or cached model
+	void CreateModel(ObjModel& objModel, CookedModel const& cooked, std::string const& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+	// Pieces of CreateModel: the model and its vertex buffer, then materials and shapes one at a time
+	void BeginModel(ObjModel& objModel, CookedModel const& cooked, std::string const& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+	Material* CreateMaterial(ObjModel& objModel, CookedModel const& cooked, int materialIndex, std::string const& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+	void CreateShape(ObjModel& objModel, CookedModel const& cooked, size_t shapeIndex, std::string const& modelPath, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+
 	ID3D12Device* Device = nullptr;
 	std::unordered_map<std::string, std::unique_ptr<ObjModel>> Models;
+	// Vertex and index buffers of every model are sub-allocated from here
+	GeometryPool Geometry;
+	// glTF is authored in meters, ModelPositionScale only converts the OBJ assets
+	float GltfPositionScale = 1.0f;
+	// Vertex format of models loaded from now on
+	VertexFormat ImportVertexFormat = VertexFormat::Quantized;
+	// Cooked models are cached next to their source and memory mapped on later loads
+	bool EnableMeshCache = true;
+	// Parses cold loads a second time with tinyobj and logs any difference to the parallel parser
+	bool ValidateObjParser = false;
+	// Merges the shapes of models loaded from now on into one shape per material and cell, with their transforms baked in.
+	// Fewer draws, but the merged objects can no longer be moved on their own
+	bool EnableStaticBatching = false;
+	StaticBatchSettings StaticBatching;
+	// Upload bytes LoadModelAsync records before it submits a batch, at most one batch per model and frame
+	size_t AsyncUploadBatchBytes = 4 << 20;
+
+	uint32_t NextModelId = 0;
+	uint32_t NextIndexedModelId = 0;
+	uint32_t NextMaterialId = 0;
 };
 }
\ No newline at end of file
@@ -0,0 +1,1165 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <set>
+#include <string_view>
+
+namespace dxpg
+{
+
+namespace
+{
+// Smoothing group of faces parsed before the first `s` of their chunk, resolved when the chunks are merged
+constexpr uint32_t InheritedSmoothingGroup = ~0u;
+
+enum class ObjEventType : uint8_t
+{
+	Group,
+	Object,
+	UseMaterial,
+	MaterialLibrary,
+	SmoothingGroup,
+};
+
+// Statement that changes the shape state, replayed in file order once every chunk is parsed
+struct ObjEvent
+{
+	ObjEventType Type;
+	// Faces of the chunk that come before the statement
+	uint32_t FaceIndex;
+	uint32_t SmoothingGroup;
+	std::string Value;
+};
+
+// Index relative to the vertex count of the chunk, the base of the chunk is added once it is known
+struct RelativeIndex
+{
+	uint32_t Corner;
+	uint8_t Component;
+};
+
+struct ObjChunk
+{
+	std::string_view Text;
+
+	std::vector<float> Positions;
+	std::vector<float> Colors;
+	std::vector<float> Normals;
+	std::vector<float> TexCoords;
+	std::vector<tinyobj::index_t> Corners;
+	// First corner of every face plus one past the last face
+	std::vector<uint32_t> FaceCorners = { 0 };
+	std::vector<uint32_t> FaceSmoothingGroups;
+	std::vector<RelativeIndex> RelativeIndices;
+	std::vector<ObjEvent> Events;
+
+	std::vector<tinyobj::index_t> Triangles;
+	std::vector<uint32_t> TriangleSmoothingGroups;
+	// First triangle of every face plus one past the last face
+	std::vector<uint32_t> FaceTriangles;
+
+	size_t PositionBase = 0;
+	size_t NormalBase = 0;
+	size_t TexCoordBase = 0;
+	std::string Error;
+};
+
+bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+void SkipSpaces(char const*& p, char const* end)
+{
+	while (p < end && IsSpace(*p))
+		++p;
+}
+
+void SkipSpacesAndReturns(char const*& p, char const* end)
+{
+	while (p < end && (IsSpace(*p) || *p == '\r'))
+		++p;
+}
+
+char const* TokenEnd(char const* p, char const* end)
+{
+	while (p < end && !IsSpace(*p) && *p != '\r')
+		++p;
+	return p;
+}
+
+char const* IndexEnd(char const* p, char const* end)
+{
+	while (p < end && *p != '/' && !IsSpace(*p) && *p != '\r')
+		++p;
+	return p;
+}
+
+bool StartsWith(char const* p, char const* end, std::string_view prefix)
+{
+	return size_t(end - p) >= prefix.size() && std::memcmp(p, prefix.data(), prefix.size()) == 0;
+}
+
+// Keyword followed by a space or tab
+bool IsKeyword(char const* p, char const* end, std::string_view keyword)
+{
+	return size_t(end - p) > keyword.size() && std::memcmp(p, keyword.data(), keyword.size()) == 0 && IsSpace(p[keyword.size()]);
+}
+
+// Same arithmetic as tinyobj so both parsers produce bit identical floats
+bool TryParseDouble(char const* s, char const* end, double& result)
+{
+	if (s >= end)
+		return false;
+
+	double mantissa = 0.0;
+	int exponent = 0;
+	char sign = '+';
+	char exponentSign = '+';
+	char const* curr = s;
+	int read = 0;
+	bool leadingDecimalDot = false;
+
+	if (*curr == '+' || *curr == '-')
+	{
+		sign = *curr;
+		curr++;
+		if (curr != end && *curr == '.')
+			leadingDecimalDot = true;
+	}
+	else if (*curr == '.')
+		leadingDecimalDot = true;
+	else if (!IsDigit(*curr))
+		return false;
+
+	if (!leadingDecimalDot)
+	{
+		while (curr != end && IsDigit(*curr))
+		{
+			mantissa *= 10;
+			mantissa += static_cast<int>(*curr - '0');
+			curr++;
+			read++;
+		}
+		if (read == 0)
+			return false;
+	}
+	if (curr != end)
+	{
+		if (*curr == '.')
+		{
+			constexpr double PowLut[] = { 1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001 };
+			constexpr int LutEntries = sizeof(PowLut) / sizeof(PowLut[0]);
+			curr++;
+			read = 1;
+			while (curr != end && IsDigit(*curr))
+			{
+				mantissa += static_cast<int>(*curr - '0') * (read < LutEntries ? PowLut[read] : std::pow(10.0, -read));
+				read++;
+				curr++;
+			}
+		}
+		if (curr != end && (*curr == 'e' || *curr == 'E'))
+		{
+			curr++;
+			if (curr != end && (*curr == '+' || *curr == '-'))
+			{
+				exponentSign = *curr;
+				curr++;
+			}
+			else if (curr == end || !IsDigit(*curr))
+				return false;
+
+			read = 0;
+			while (curr != end && IsDigit(*curr))
+			{
+				if (exponent > std::numeric_limits<int>::max() / 10)
+					return false;
+				exponent *= 10;
+				exponent += static_cast<int>(*curr - '0');
+				curr++;
+				read++;
+			}
+			exponent *= exponentSign == '+' ? 1 : -1;
+			if (read == 0)
+				return false;
+		}
+	}
+
+	result = (sign == '+' ? 1 : -1) * (exponent ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent) : mantissa);
+	return true;
+}
+
+bool TryParseReal(char const*& p, char const* end, float& out)
+{
+	SkipSpaces(p, end);
+	char const* tokenEnd = TokenEnd(p, end);
+	double value;
+	bool parsed = TryParseDouble(p, tokenEnd, value);
+	if (parsed)
+		out = static_cast<float>(value);
+	p = tokenEnd;
+	return parsed;
+}
+
+float ParseReal(char const*& p, char const* end, float defaultValue = 0.0f)
+{
+	float value = defaultValue;
+	TryParseReal(p, end, value);
+	return value;
+}
+
+void ParseReal3(char const*& p, char const* end, float* out, float defaultValue = 0.0f)
+{
+	for (int i = 0; i < 3; ++i)
+		out[i] = ParseReal(p, end, defaultValue);
+}
+
+// atoi on the text at p, without moving p
+int ParseIntAt(char const* p, char const* end)
+{
+	while (p < end && (IsSpace(*p) || *p == '\v' || *p == '\f' || *p == '\r'))
+		++p;
+	bool negative = false;
+	if (p < end && (*p == '+' || *p == '-'))
+		negative = *p++ == '-';
+	int value = 0;
+	while (p < end && IsDigit(*p))
+		value = value * 10 + (*p++ - '0');
+	return negative ? -value : value;
+}
+
+int ParseInt(char const*& p, char const* end)
+{
+	SkipSpaces(p, end);
+	int value = ParseIntAt(p, end);
+	p = TokenEnd(p, end);
+	return value;
+}
+
+std::string ParseString(char const*& p, char const* end)
+{
+	SkipSpaces(p, end);
+	char const* tokenEnd = TokenEnd(p, end);
+	std::string value(p, tokenEnd);
+	p = tokenEnd;
+	return value;
+}
+
+// Calls lineFunc with every non empty line without its leading spaces, '\r' and '\n' both end a line
+template<typename LineFunc>
+void ForEachLine(std::string_view text, LineFunc&& lineFunc)
+{
+	char const* p = text.data();
+	char const* end = p + text.size();
+	while (p < end)
+	{
+		char const* lineEnd = p;
+		while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r')
+			++lineEnd;
+		char const* token = p;
+		SkipSpaces(token, lineEnd);
+		if (token < lineEnd && *token != '#')
+		{
+			if (!lineFunc(token, lineEnd))
+				return;
+		}
+		p = lineEnd + 1;
+	}
+}
+
+// Resolves one component of a face corner, returns false where tinyobj rejects the face
+bool ParseCornerIndex(char const* p, char const* end, size_t localCount, bool allowZero, int& outIndex, bool& outRelative)
+{
+	int index = ParseIntAt(p, end);
+	outRelative = index < 0;
+	if (index > 0)
+		outIndex = index - 1;
+	else if (index == 0)
+	{
+		outIndex = -1;
+		return allowZero;
+	}
+	else
+		outIndex = static_cast<int>(localCount) + index;
+	return true;
+}
+
+bool ParseFace(char const* p, char const* end, ObjChunk& chunk)
+{
+	size_t const positionCount = chunk.Positions.size() / 3;
+	size_t const normalCount = chunk.Normals.size() / 3;
+	size_t const texCoordCount = chunk.TexCoords.size() / 2;
+	while (p < end)
+	{
+		tinyobj::index_t corner{ -1, -1, -1 };
+		uint32_t const cornerIndex = static_cast<uint32_t>(chunk.Corners.size());
+		bool relative;
+		if (!ParseCornerIndex(p, end, positionCount, false, corner.vertex_index, relative))
+			return false;
+		if (relative)
+			chunk.RelativeIndices.push_back({ cornerIndex, 0 });
+		p = IndexEnd(p, end);
+		if (p < end && *p == '/')
+		{
+			++p;
+			if (p < end && *p == '/')
+			{
+				++p;
+				if (!ParseCornerIndex(p, end, normalCount, true, corner.normal_index, relative))
+					return false;
+				if (relative)
+					chunk.RelativeIndices.push_back({ cornerIndex, 1 });
+				p = IndexEnd(p, end);
+			}
+			else
+			{
+				if (!ParseCornerIndex(p, end, texCoordCount, true, corner.texcoord_index, relative))
+					return false;
+				if (relative)
+					chunk.RelativeIndices.push_back({ cornerIndex, 2 });
+				p = IndexEnd(p, end);
+				if (p < end && *p == '/')
+				{
+					++p;
+					if (!ParseCornerIndex(p, end, normalCount, true, corner.normal_index, relative))
+						return false;
+					if (relative)
+						chunk.RelativeIndices.push_back({ cornerIndex, 1 });
+					p = IndexEnd(p, end);
+				}
+			}
+		}
+		chunk.Corners.push_back(corner);
+		SkipSpacesAndReturns(p, end);
+	}
+	return true;
+}
+
+void ParseObjChunk(ObjChunk& chunk, uint32_t& smoothingGroup)
+{
+	ForEachLine(chunk.Text, [&](char const* p, char const* end)
+	{
+		uint32_t const faceIndex = static_cast<uint32_t>(chunk.FaceCorners.size() - 1);
+		if (p[0] == 'v' && end - p > 1 && IsSpace(p[1]))
+		{
+			p += 2;
+			float position[3];
+			ParseReal3(p, end, position);
+			chunk.Positions.insert(chunk.Positions.end(), position, position + 3);
+			float color[3];
+			bool hasColor = TryParseReal(p, end, color[0]) && TryParseReal(p, end, color[1]) && TryParseReal(p, end, color[2]);
+			if (!hasColor)
+				color[0] = color[1] = color[2] = 1.0f;
+			chunk.Colors.insert(chunk.Colors.end(), color, color + 3);
+		}
+		else if (IsKeyword(p, end, "vn"))
+		{
+			p += 3;
+			float normal[3];
+			ParseReal3(p, end, normal);
+			chunk.Normals.insert(chunk.Normals.end(), normal, normal + 3);
+		}
+		else if (IsKeyword(p, end, "vt"))
+		{
+			p += 3;
+			float u = ParseReal(p, end);
+			float v = ParseReal(p, end);
+			chunk.TexCoords.push_back(u);
+			chunk.TexCoords.push_back(v);
+		}
+		else if (p[0] == 'f' && end - p > 1 && IsSpace(p[1]))
+		{
+			p += 2;
+			SkipSpaces(p, end);
+			if (!ParseFace(p, end, chunk))
+			{
+				chunk.Error = "Failed to parse `f' line (e.g. zero value for face index): " + std::string(p, end);
+				return false;
+			}
+			chunk.FaceCorners.push_back(static_cast<uint32_t>(chunk.Corners.size()));
+			chunk.FaceSmoothingGroups.push_back(smoothingGroup);
+		}
+		else if (StartsWith(p, end, "usemtl"))
+		{
+			p += 6;
+			chunk.Events.push_back({ .Type = ObjEventType::UseMaterial, .FaceIndex = faceIndex, .Value = ParseString(p, end) });
+		}
+		else if (IsKeyword(p, end, "mtllib"))
+		{
+			chunk.Events.push_back({ .Type = ObjEventType::MaterialLibrary, .FaceIndex = faceIndex, .Value = std::string(p + 7, end) });
+		}
+		else if (p[0] == 'g' && end - p > 1 && IsSpace(p[1]))
+		{
+			// Multiple group names are joined with single spaces
+			std::string name;
+			p += 1;
+			SkipSpacesAndReturns(p, end);
+			while (p < end)
+			{
+				if (!name.empty())
+					name += ' ';
+				name += ParseString(p, end);
+				SkipSpacesAndReturns(p, end);
+			}
+			chunk.Events.push_back({ .Type = ObjEventType::Group, .FaceIndex = faceIndex, .Value = std::move(name) });
+		}
+		else if (p[0] == 'o' && end - p > 1 && IsSpace(p[1]))
+		{
+			chunk.Events.push_back({ .Type = ObjEventType::Object, .FaceIndex = faceIndex, .Value = std::string(p + 2, end) });
+		}
+		else if (p[0] == 's' && end - p > 1 && IsSpace(p[1]))
+		{
+			p += 2;
+			SkipSpaces(p, end);
+			if (p == end || *p == '\r')
+				return true;
+			if (StartsWith(p, end, "off"))
+				smoothingGroup = 0;
+			else
+			{
+				int group = ParseInt(p, end);
+				smoothingGroup = group < 0 ? 0 : static_cast<uint32_t>(group);
+			}
+			chunk.Events.push_back({ .Type = ObjEventType::SmoothingGroup, .FaceIndex = faceIndex, .SmoothingGroup = smoothingGroup });
+		}
+		return true;
+	});
+}
+
+bool ResolveRelativeIndices(ObjChunk& chunk)
+{
+	for (auto& relative : chunk.RelativeIndices)
+	{
+		auto& corner = chunk.Corners[relative.Corner];
+		int& index = relative.Component == 0 ? corner.vertex_index : relative.Component == 1 ? corner.normal_index : corner.texcoord_index;
+		size_t base = relative.Component == 0 ? chunk.PositionBase : relative.Component == 1 ? chunk.NormalBase : chunk.TexCoordBase;
+		index += static_cast<int>(base);
+		if (index < 0)
+		{
+			chunk.Error = "Invalid relative index in `f' line";
+			return false;
+		}
+	}
+	return true;
+}
+
+int PointInTriangle(float const* vx, float const* vy, float testX, float testY)
+{
+	int inside = 0;
+	for (int i = 0, j = 2; i < 3; j = i++)
+	{
+		if (((vy[i] > testY) != (vy[j] > testY)) && (testX < (vx[j] - vx[i]) * (testY - vy[i]) / (vy[j] - vy[i]) + vx[i]))
+			inside = !inside;
+	}
+	return inside;
+}
+
+// Ear clipping in the plane of the two dominant axes, follows tinyobj step by step so the triangles match
+void TriangulatePolygon(std::span<tinyobj::index_t const> face, std::vector<float> const& positions, uint32_t smoothingGroup, ObjChunk& chunk)
+{
+	auto emit = [&](tinyobj::index_t a, tinyobj::index_t b, tinyobj::index_t c)
+	{
+		chunk.Triangles.insert(chunk.Triangles.end(), { a, b, c });
+		chunk.TriangleSmoothingGroups.push_back(smoothingGroup);
+	};
+	auto position = [&](tinyobj::index_t corner, size_t axis)
+	{
+		return positions[size_t(corner.vertex_index) * 3 + axis];
+	};
+	auto inRange = [&](tinyobj::index_t corner, size_t axis)
+	{
+		return size_t(corner.vertex_index) * 3 + axis < positions.size();
+	};
+
+	size_t cornerCount = face.size();
+	if (cornerCount == 3)
+	{
+		emit(face[0], face[1], face[2]);
+		return;
+	}
+	if (cornerCount == 4)
+	{
+		for (auto& corner : face)
+			if (!inRange(corner, 2))
+				return;
+		float sqr02 = 0.0f;
+		float sqr13 = 0.0f;
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			float e02 = position(face[2], axis) - position(face[0], axis);
+			float e13 = position(face[3], axis) - position(face[1], axis);
+			sqr02 += e02 * e02;
+			sqr13 += e13 * e13;
+		}
+		if (sqr02 < sqr13)
+		{
+			emit(face[0], face[1], face[2]);
+			emit(face[0], face[2], face[3]);
+		}
+		else
+		{
+			emit(face[0], face[1], face[3]);
+			emit(face[1], face[2], face[3]);
+		}
+		return;
+	}
+
+	size_t axes[2] = { 1, 2 };
+	for (size_t k = 0; k < cornerCount; ++k)
+	{
+		auto i0 = face[k % cornerCount];
+		auto i1 = face[(k + 1) % cornerCount];
+		auto i2 = face[(k + 2) % cornerCount];
+		if (!inRange(i0, 2) || !inRange(i1, 2) || !inRange(i2, 2))
+			continue;
+		float e0x = position(i1, 0) - position(i0, 0);
+		float e0y = position(i1, 1) - position(i0, 1);
+		float e0z = position(i1, 2) - position(i0, 2);
+		float e1x = position(i2, 0) - position(i1, 0);
+		float e1y = position(i2, 1) - position(i1, 1);
+		float e1z = position(i2, 2) - position(i1, 2);
+		float cx = std::fabs(e0y * e1z - e0z * e1y);
+		float cy = std::fabs(e0z * e1x - e0x * e1z);
+		float cz = std::fabs(e0x * e1y - e0y * e1x);
+		constexpr float Epsilon = std::numeric_limits<float>::epsilon();
+		if (cx > Epsilon || cy > Epsilon || cz > Epsilon)
+		{
+			if (!(cx > cy && cx > cz))
+			{
+				axes[0] = 0;
+				if (cz > cx && cz > cy)
+					axes[1] = 1;
+			}
+			break;
+		}
+	}
+
+	std::vector<tinyobj::index_t> remaining(face.begin(), face.end());
+	size_t guess = 0;
+	size_t remainingIterations = remaining.size();
+	size_t previousRemaining = remaining.size();
+	tinyobj::index_t ear[3];
+	float vx[3];
+	float vy[3];
+	while (remaining.size() > 3 && remainingIterations > 0)
+	{
+		cornerCount = remaining.size();
+		if (guess >= cornerCount)
+			guess -= cornerCount;
+		if (previousRemaining != cornerCount)
+		{
+			previousRemaining = cornerCount;
+			remainingIterations = cornerCount;
+		}
+		else
+			remainingIterations--;
+
+		for (size_t k = 0; k < 3; ++k)
+		{
+			ear[k] = remaining[(guess + k) % cornerCount];
+			bool valid = inRange(ear[k], axes[0]) && inRange(ear[k], axes[1]);
+			vx[k] = valid ? position(ear[k], axes[0]) : 0.0f;
+			vy[k] = valid ? position(ear[k], axes[1]) : 0.0f;
+		}
+		float e0x = vx[1] - vx[0];
+		float e0y = vy[1] - vy[0];
+		float e1x = vx[2] - vx[1];
+		float e1y = vy[2] - vy[1];
+		float cross = e0x * e1y - e0y * e1x;
+		float area = (vx[0] * vy[1] - vy[0] * vx[1]) * 0.5f;
+		// Reflex corner
+		if (cross * area < 0.0f)
+		{
+			guess++;
+			continue;
+		}
+
+		bool overlap = false;
+		for (size_t other = 3; other < cornerCount; ++other)
+		{
+			auto corner = remaining[(guess + other) % cornerCount];
+			if (!inRange(corner, axes[0]) || !inRange(corner, axes[1]))
+				continue;
+			if (PointInTriangle(vx, vy, position(corner, axes[0]), position(corner, axes[1])))
+			{
+				overlap = true;
+				break;
+			}
+		}
+		if (overlap)
+		{
+			guess++;
+			continue;
+		}
+
+		emit(ear[0], ear[1], ear[2]);
+		remaining.erase(remaining.begin() + (guess + 1) % cornerCount);
+	}
+	if (remaining.size() == 3)
+		emit(remaining[0], remaining[1], remaining[2]);
+}
+
+void TriangulateChunk(ObjChunk& chunk, std::vector<float> const& positions)
+{
+	size_t faceCount = chunk.FaceCorners.size() - 1;
+	chunk.Triangles.reserve(chunk.Corners.size());
+	chunk.TriangleSmoothingGroups.reserve(faceCount);
+	chunk.FaceTriangles.resize(faceCount + 1);
+	for (size_t face = 0; face < faceCount; ++face)
+	{
+		chunk.FaceTriangles[face] = static_cast<uint32_t>(chunk.TriangleSmoothingGroups.size());
+		std::span corners(chunk.Corners.data() + chunk.FaceCorners[face], chunk.FaceCorners[face + 1] - chunk.FaceCorners[face]);
+		if (corners.size() >= 3)
+			TriangulatePolygon(corners, positions, chunk.FaceSmoothingGroups[face], chunk);
+	}
+	chunk.FaceTriangles[faceCount] = static_cast<uint32_t>(chunk.TriangleSmoothingGroups.size());
+	// The corners are only needed for triangulation
+	chunk.Corners = {};
+	chunk.RelativeIndices = {};
+}
+
+// Faces collected for the next shape, tinyobj calls this the primitive group
+struct FaceRange
+{
+	ObjChunk const* Chunk;
+	uint32_t FirstFace;
+	uint32_t EndFace;
+	uint32_t SmoothingGroup;
+};
+
+struct ShapeBuilder
+{
+	std::vector<tinyobj::shape_t>& Shapes;
+	std::vector<tinyobj::material_t>& Materials;
+	std::map<std::string, int> MaterialMap;
+	std::set<std::string> MaterialFiles;
+	std::filesystem::path MaterialFolder;
+	std::string& Warning;
+
+	tinyobj::shape_t Shape;
+	std::vector<FaceRange> Faces;
+	std::string Name;
+	int Material = -1;
+	uint32_t SmoothingGroup = 0;
+
+	// Appends the collected faces to the shape, returns false when there were none
+	bool Export()
+	{
+		if (Faces.empty())
+			return false;
+		Shape.name = Name;
+		auto& mesh = Shape.mesh;
+		for (auto& range : Faces)
+		{
+			auto& chunk = *range.Chunk;
+			uint32_t firstTriangle = chunk.FaceTriangles[range.FirstFace];
+			uint32_t endTriangle = chunk.FaceTriangles[range.EndFace];
+			mesh.indices.insert(mesh.indices.end(), chunk.Triangles.begin() + firstTriangle * 3, chunk.Triangles.begin() + endTriangle * 3);
+			mesh.num_face_vertices.insert(mesh.num_face_vertices.end(), endTriangle - firstTriangle, 3);
+			mesh.material_ids.insert(mesh.material_ids.end(), endTriangle - firstTriangle, Material);
+			for (uint32_t triangle = firstTriangle; triangle < endTriangle; ++triangle)
+			{
+				uint32_t group = chunk.TriangleSmoothingGroups[triangle];
+				mesh.smoothing_group_ids.push_back(group == InheritedSmoothingGroup ? range.SmoothingGroup : group);
+			}
+		}
+		return true;
+	}
+
+	void AddFaces(ObjChunk const& chunk, uint32_t firstFace, uint32_t endFace)
+	{
+		if (firstFace < endFace)
+			Faces.push_back({ &chunk, firstFace, endFace, SmoothingGroup });
+	}
+
+	void LoadMaterialLibrary(std::string const& line)
+	{
+		// Space separated file names, a backslash escapes the next character
+		std::vector<std::string> fileNames;
+		std::string fileName;
+		bool escaped = false;
+		for (char c : line)
+		{
+			if (escaped)
+			{
+				fileName += c;
+				escaped = false;
+			}
+			else if (c == '\\')
+				escaped = true;
+			else if (c == ' ')
+			{
+				if (!fileName.empty())
+					fileNames.push_back(std::move(fileName));
+				fileName.clear();
+			}
+			else
+				fileName += c;
+		}
+		if (!fileName.empty())
+			fileNames.push_back(std::move(fileName));
+
+		bool found = false;
+		for (auto& name : fileNames)
+		{
+			if (MaterialFiles.contains(name))
+			{
+				found = true;
+				continue;
+			}
+			MappedFile file;
+			if (!file.Open(MaterialFolder / name))
+				continue;
+			auto bytes = file.Data();
+			ParseMtl({ reinterpret_cast<char const*>(bytes.data()), bytes.size() }, Materials, MaterialMap, Warning);
+			MaterialFiles.insert(name);
+			found = true;
+			break;
+		}
+		if (!found)
+			Warning += "Failed to load material file(s): " + line + "\n";
+	}
+
+	void Replay(ObjChunk const& chunk)
+	{
+		uint32_t face = 0;
+		for (auto& event : chunk.Events)
+		{
+			AddFaces(chunk, face, event.FaceIndex);
+			face = event.FaceIndex;
+			switch (event.Type)
+			{
+			case ObjEventType::Group:
+				Export();
+				if (!Shape.mesh.indices.empty())
+					Shapes.push_back(std::move(Shape));
+				Shape = {};
+				Faces.clear();
+				Name = event.Value;
+				break;
+			case ObjEventType::Object:
+				if (Export())
+					Shapes.push_back(std::move(Shape));
+				Shape = {};
+				Faces.clear();
+				Name = event.Value;
+				break;
+			case ObjEventType::UseMaterial:
+			{
+				auto it = MaterialMap.find(event.Value);
+				int material = it != MaterialMap.end() ? it->second : -1;
+				if (material < 0)
+					Warning += "material [ '" + event.Value + "' ] not found in .mtl\n";
+				if (material != Material)
+				{
+					Export();
+					Faces.clear();
+					Material = material;
+				}
+				break;
+			}
+			case ObjEventType::MaterialLibrary:
+				LoadMaterialLibrary(event.Value);
+				break;
+			case ObjEventType::SmoothingGroup:
+				SmoothingGroup = event.SmoothingGroup;
+				break;
+			}
+		}
+		AddFaces(chunk, face, static_cast<uint32_t>(chunk.FaceTriangles.size() - 1));
+	}
+
+	void Finish()
+	{
+		if (Export() || !Shape.mesh.indices.empty())
+			Shapes.push_back(std::move(Shape));
+		Faces.clear();
+	}
+};
+
+void InitTextureOption(tinyobj::texture_option_t& option, bool bump)
+{
+	option = {};
+	option.type = tinyobj::TEXTURE_TYPE_NONE;
+	option.sharpness = 1.0f;
+	option.brightness = 0.0f;
+	option.contrast = 1.0f;
+	for (int i = 0; i < 3; ++i)
+	{
+		option.origin_offset[i] = 0.0f;
+		option.scale[i] = 1.0f;
+		option.turbulence[i] = 0.0f;
+	}
+	option.texture_resolution = -1;
+	option.clamp = false;
+	option.imfchan = bump ? 'l' : 'm';
+	option.blendu = true;
+	option.blendv = true;
+	option.bump_multiplier = 1.0f;
+}
+
+void InitMaterial(tinyobj::material_t& material)
+{
+	material = {};
+	for (int i = 0; i < 3; ++i)
+	{
+		material.ambient[i] = 0.0f;
+		material.diffuse[i] = 0.0f;
+		material.specular[i] = 0.0f;
+		material.transmittance[i] = 0.0f;
+		material.emission[i] = 0.0f;
+	}
+	material.illum = 0;
+	material.dissolve = 1.0f;
+	material.shininess = 1.0f;
+	material.ior = 1.0f;
+	material.roughness = 0.0f;
+	material.metallic = 0.0f;
+	material.sheen = 0.0f;
+	material.clearcoat_thickness = 0.0f;
+	material.clearcoat_roughness = 0.0f;
+	material.anisotropy = 0.0f;
+	material.anisotropy_rotation = 0.0f;
+	for (auto* option : { &material.ambient_texopt, &material.diffuse_texopt, &material.specular_texopt, &material.specular_highlight_texopt,
+		&material.displacement_texopt, &material.alpha_texopt, &material.reflection_texopt, &material.roughness_texopt, &material.metallic_texopt,
+		&material.sheen_texopt, &material.emissive_texopt, &material.normal_texopt })
+		InitTextureOption(*option, false);
+	InitTextureOption(material.bump_texopt, true);
+}
+
+bool ParseOnOff(char const*& p, char const* end)
+{
+	SkipSpaces(p, end);
+	char const* tokenEnd = TokenEnd(p, end);
+	bool on = !StartsWith(p, end, "off");
+	p = tokenEnd;
+	return on;
+}
+
+tinyobj::texture_type_t ParseTextureType(char const*& p, char const* end)
+{
+	SkipSpaces(p, end);
+	char const* tokenEnd = TokenEnd(p, end);
+	std::string_view token(p, tokenEnd - p);
+	p = tokenEnd;
+	if (token.starts_with("cube_top"))
+		return tinyobj::TEXTURE_TYPE_CUBE_TOP;
+	if (token.starts_with("cube_bottom"))
+		return tinyobj::TEXTURE_TYPE_CUBE_BOTTOM;
+	if (token.starts_with("cube_left"))
+		return tinyobj::TEXTURE_TYPE_CUBE_LEFT;
+	if (token.starts_with("cube_right"))
+		return tinyobj::TEXTURE_TYPE_CUBE_RIGHT;
+	if (token.starts_with("cube_front"))
+		return tinyobj::TEXTURE_TYPE_CUBE_FRONT;
+	if (token.starts_with("cube_back"))
+		return tinyobj::TEXTURE_TYPE_CUBE_BACK;
+	if (token.starts_with("sphere"))
+		return tinyobj::TEXTURE_TYPE_SPHERE;
+	return tinyobj::TEXTURE_TYPE_NONE;
+}
+
+// Texture options followed by the file name, which runs to the end of the line so it may contain spaces
+void ParseTexture(char const* p, char const* end, std::string& outName, tinyobj::texture_option_t& option)
+{
+	while (p < end)
+	{
+		SkipSpaces(p, end);
+		if (IsKeyword(p, end, "-blendu"))
+			p += 8, option.blendu = ParseOnOff(p, end);
+		else if (IsKeyword(p, end, "-blendv"))
+			p += 8, option.blendv = ParseOnOff(p, end);
+		else if (IsKeyword(p, end, "-clamp"))
+			p += 7, option.clamp = ParseOnOff(p, end);
+		else if (IsKeyword(p, end, "-boost"))
+			p += 7, option.sharpness = ParseReal(p, end, 1.0f);
+		else if (IsKeyword(p, end, "-bm"))
+			p += 4, option.bump_multiplier = ParseReal(p, end, 1.0f);
+		else if (IsKeyword(p, end, "-o"))
+			p += 3, ParseReal3(p, end, option.origin_offset);
+		else if (IsKeyword(p, end, "-s"))
+			p += 3, ParseReal3(p, end, option.scale, 1.0f);
+		else if (IsKeyword(p, end, "-t"))
+			p += 3, ParseReal3(p, end, option.turbulence);
+		else if (IsKeyword(p, end, "-type"))
+			p += 5, option.type = ParseTextureType(p, end);
+		else if (IsKeyword(p, end, "-texres"))
+			p += 7, option.texture_resolution = ParseInt(p, end);
+		else if (IsKeyword(p, end, "-imfchan"))
+		{
+			p += 9;
+			SkipSpaces(p, end);
+			char const* tokenEnd = TokenEnd(p, end);
+			if (tokenEnd - p == 1)
+				option.imfchan = *p;
+			p = tokenEnd;
+		}
+		else if (IsKeyword(p, end, "-mm"))
+		{
+			p += 4;
+			option.brightness = ParseReal(p, end, 0.0f);
+			option.contrast = ParseReal(p, end, 1.0f);
+		}
+		else if (IsKeyword(p, end, "-colorspace"))
+			p += 12, option.colorspace = ParseString(p, end);
+		else
+		{
+			outName.assign(p, end);
+			return;
+		}
+	}
+}
+}
+
+bool ParseMtl(std::span<char const> text, std::vector<tinyobj::material_t>& materials, std::map<std::string, int>& materialMap, std::string& warning)
+{
+	tinyobj::material_t material;
+	InitMaterial(material);
+	// d wins over Tr, which is not part of the MTL specification
+	bool hasDissolve = false;
+	bool hasTransparency = false;
+	// Diffuse maps without a Kd get a default diffuse color
+	bool hasDiffuse = false;
+
+	ForEachLine({ text.data(), text.size() }, [&](char const* p, char const* end)
+	{
+		struct TextureKeyword
+		{
+			std::string_view Keyword;
+			std::string tinyobj::material_t::* Name;
+			tinyobj::texture_option_t tinyobj::material_t::* Option;
+		};
+		static TextureKeyword const TextureKeywords[] = {
+			{ "map_Ka", &tinyobj::material_t::ambient_texname, &tinyobj::material_t::ambient_texopt },
+			{ "map_Kd", &tinyobj::material_t::diffuse_texname, &tinyobj::material_t::diffuse_texopt },
+			{ "map_Ks", &tinyobj::material_t::specular_texname, &tinyobj::material_t::specular_texopt },
+			{ "map_Ns", &tinyobj::material_t::specular_highlight_texname, &tinyobj::material_t::specular_highlight_texopt },
+			{ "map_bump", &tinyobj::material_t::bump_texname, &tinyobj::material_t::bump_texopt },
+			{ "map_Bump", &tinyobj::material_t::bump_texname, &tinyobj::material_t::bump_texopt },
+			{ "bump", &tinyobj::material_t::bump_texname, &tinyobj::material_t::bump_texopt },
+			{ "map_d", &tinyobj::material_t::alpha_texname, &tinyobj::material_t::alpha_texopt },
+			{ "disp", &tinyobj::material_t::displacement_texname, &tinyobj::material_t::displacement_texopt },
+			{ "refl", &tinyobj::material_t::reflection_texname, &tinyobj::material_t::reflection_texopt },
+			{ "map_Pr", &tinyobj::material_t::roughness_texname, &tinyobj::material_t::roughness_texopt },
+			{ "map_Pm", &tinyobj::material_t::metallic_texname, &tinyobj::material_t::metallic_texopt },
+			{ "map_Ps", &tinyobj::material_t::sheen_texname, &tinyobj::material_t::sheen_texopt },
+			{ "map_Ke", &tinyobj::material_t::emissive_texname, &tinyobj::material_t::emissive_texopt },
+			{ "norm", &tinyobj::material_t::normal_texname, &tinyobj::material_t::normal_texopt },
+		};
+		struct RealKeyword
+		{
+			std::string_view Keyword;
+			float tinyobj::material_t::* Value;
+		};
+		static RealKeyword const RealKeywords[] = {
+			{ "Ni", &tinyobj::material_t::ior },
+			{ "Ns", &tinyobj::material_t::shininess },
+			{ "Pr", &tinyobj::material_t::roughness },
+			{ "Pm", &tinyobj::material_t::metallic },
+			{ "Ps", &tinyobj::material_t::sheen },
+			{ "Pc", &tinyobj::material_t::clearcoat_thickness },
+			{ "Pcr", &tinyobj::material_t::clearcoat_roughness },
+			{ "aniso", &tinyobj::material_t::anisotropy },
+			{ "anisor", &tinyobj::material_t::anisotropy_rotation },
+		};
+
+		if (IsKeyword(p, end, "newmtl"))
+		{
+			if (!material.name.empty())
+			{
+				materialMap.insert({ material.name, static_cast<int>(materials.size()) });
+				materials.push_back(std::move(material));
+			}
+			InitMaterial(material);
+			hasDissolve = hasTransparency = hasDiffuse = false;
+			p += 7;
+			material.name = ParseString(p, end);
+			if (material.name.empty())
+				warning += "empty material name in `newmtl`\n";
+			return true;
+		}
+		if (IsKeyword(p, end, "Ka"))
+			return p += 2, ParseReal3(p, end, material.ambient), true;
+		if (IsKeyword(p, end, "Kd"))
+			return p += 2, ParseReal3(p, end, material.diffuse), hasDiffuse = true;
+		if (IsKeyword(p, end, "Ks"))
+			return p += 2, ParseReal3(p, end, material.specular), true;
+		if (IsKeyword(p, end, "Kt") || IsKeyword(p, end, "Tf"))
+			return p += 2, ParseReal3(p, end, material.transmittance), true;
+		if (IsKeyword(p, end, "Ke"))
+			return p += 2, ParseReal3(p, end, material.emission), true;
+		if (IsKeyword(p, end, "illum"))
+			return p += 6, material.illum = ParseInt(p, end), true;
+		if (IsKeyword(p, end, "d"))
+		{
+			p += 1;
+			material.dissolve = ParseReal(p, end);
+			if (hasTransparency)
+				warning += "Both `d` and `Tr` parameters defined for \"" + material.name + "\". Use the value of `d` for dissolve\n";
+			hasDissolve = true;
+			return true;
+		}
+		if (IsKeyword(p, end, "Tr"))
+		{
+			if (hasDissolve)
+				warning += "Both `d` and `Tr` parameters defined for \"" + material.name + "\". Use the value of `d` for dissolve\n";
+			else
+			{
+				p += 2;
+				material.dissolve = 1.0f - ParseReal(p, end);
+			}
+			hasTransparency = true;
+			return true;
+		}
+		for (auto& keyword : RealKeywords)
+		{
+			if (IsKeyword(p, end, keyword.Keyword))
+			{
+				p += keyword.Keyword.size();
+				material.*keyword.Value = ParseReal(p, end);
+				return true;
+			}
+		}
+		for (auto& keyword : TextureKeywords)
+		{
+			if (IsKeyword(p, end, keyword.Keyword))
+			{
+				ParseTexture(p + keyword.Keyword.size() + 1, end, material.*keyword.Name, material.*keyword.Option);
+				if (keyword.Name == &tinyobj::material_t::diffuse_texname && !hasDiffuse)
+				{
+					for (auto& channel : material.diffuse)
+						channel = 0.6f;
+				}
+				return true;
+			}
+		}
+
+		// Everything else is kept as text
+		char const* space = std::find(p, end, ' ');
+		if (space == end)
+			space = std::find(p, end, '\t');
+		if (space != end)
+			material.unknown_parameter.insert({ std::string(p, space), std::string(space + 1, end) });
+		return true;
+	});
+
+	materialMap.insert({ material.name, static_cast<int>(materials.size()) });
+	materials.push_back(std::move(material));
+	return true;
+}
+
+bool ParseObj(std::span<char const> text, std::filesystem::path const& materialFolder, ObjParseResult& result, ObjParseSettings const& settings)
+{
+	result.Attrib = {};
+	result.Shapes.clear();
+	result.Materials.clear();
+	result.Warning.clear();
+	result.Error.clear();
+
+	// Line aligned chunks, every chunk starts right after a line break
+	std::vector<ObjChunk> chunks;
+	size_t chunkCount = std::max<size_t>(1, text.size() / std::max<size_t>(1, settings.MinChunkBytes));
+	size_t chunkStart = 0;
+	for (size_t chunk = 1; chunk <= chunkCount && chunkStart < text.size(); ++chunk)
+	{
+		size_t chunkEnd = chunk == chunkCount ? text.size() : std::max(chunkStart, text.size() * chunk / chunkCount);
+		while (chunkEnd < text.size() && text[chunkEnd] != '\n' && text[chunkEnd] != '\r')
+			chunkEnd++;
+		chunkEnd = std::min(chunkEnd + 1, text.size());
+		chunks.emplace_back().Text = std::string_view(text.data() + chunkStart, chunkEnd - chunkStart);
+		chunkStart = chunkEnd;
+	}
+	result.Chunks = static_cast<uint32_t>(chunks.size());
+
+	ParallelFor(chunks.size(), [&](size_t chunk)
+	{
+		uint32_t smoothingGroup = InheritedSmoothingGroup;
+		ParseObjChunk(chunks[chunk], smoothingGroup);
+	}, settings.ThreadCount);
+
+	// Vertices of a chunk follow the ones of all previous chunks
+	size_t positionCount = 0;
+	size_t normalCount = 0;
+	size_t texCoordCount = 0;
+	for (auto& chunk : chunks)
+	{
+		if (!chunk.Error.empty())
+		{
+			result.Error = chunk.Error;
+			return false;
+		}
+		chunk.PositionBase = positionCount;
+		chunk.NormalBase = normalCount;
+		chunk.TexCoordBase = texCoordCount;
+		positionCount += chunk.Positions.size() / 3;
+		normalCount += chunk.Normals.size() / 3;
+		texCoordCount += chunk.TexCoords.size() / 2;
+	}
+	auto& attrib = result.Attrib;
+	attrib.vertices.resize(positionCount * 3);
+	attrib.colors.resize(positionCount * 3);
+	attrib.normals.resize(normalCount * 3);
+	attrib.texcoords.resize(texCoordCount * 2);
+	ParallelFor(chunks.size(), [&](size_t chunkIndex)
+	{
+		auto& chunk = chunks[chunkIndex];
+		std::ranges::copy(chunk.Positions, attrib.vertices.begin() + chunk.PositionBase * 3);
+		std::ranges::copy(chunk.Colors, attrib.colors.begin() + chunk.PositionBase * 3);
+		std::ranges::copy(chunk.Normals, attrib.normals.begin() + chunk.NormalBase * 3);
+		std::ranges::copy(chunk.TexCoords, attrib.texcoords.begin() + chunk.TexCoordBase * 2);
+		chunk.Positions = {};
+		chunk.Colors = {};
+		chunk.Normals = {};
+		chunk.TexCoords = {};
+	}, settings.ThreadCount);
+	// Faces may use vertices of any earlier chunk, so triangulation waits until all positions are in place
+	ParallelFor(chunks.size(), [&](size_t chunkIndex)
+	{
+		auto& chunk = chunks[chunkIndex];
+		if (ResolveRelativeIndices(chunk))
+			TriangulateChunk(chunk, attrib.vertices);
+	}, settings.ThreadCount);
+
+	// Shapes depend on the state left by every earlier statement so they are put together in file order
+	ShapeBuilder builder{ .Shapes = result.Shapes, .Materials = result.Materials, .MaterialFolder = materialFolder, .Warning = result.Warning };
+	for (auto& chunk : chunks)
+	{
+		if (!chunk.Error.empty())
+		{
+			result.Error = chunk.Error;
+			return false;
+		}
+		builder.Replay(chunk);
+	}
+	builder.Finish();
+	return true;
+}
+
+bool ParseObj(std::filesystem::path const& path, ObjParseResult& result, ObjParseSettings const& settings)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		result.Error = "Cannot open file [" + path.string() + "]";
+		return false;
+	}
+	auto bytes = file.Data();
+	bool parsed = ParseObj({ reinterpret_cast<char const*>(bytes.data()), bytes.size() }, path.parent_path(), result, settings);
+	result.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return parsed;
+}
+
+}
\ No newline at end of file
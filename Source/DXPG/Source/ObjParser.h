@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+#include <tiny_obj_loader.h>
+
+namespace dxpg
+{
+
+struct ObjParseSettings
+{
+	// Files are split into line aligned chunks of at least this size, every chunk is parsed on its own thread
+	size_t MinChunkBytes = 1 << 20;
+	// 0 uses every hardware thread
+	size_t ThreadCount = 0;
+};
+
+// Same layout tinyobj::ObjReader produces with its default config: triangulated faces and vertex colors defaulting to white
+struct ObjParseResult
+{
+	tinyobj::attrib_t Attrib;
+	std::vector<tinyobj::shape_t> Shapes;
+	std::vector<tinyobj::material_t> Materials;
+	std::string Warning;
+	std::string Error;
+	uint32_t Chunks = 0;
+	double Milliseconds = 0.0;
+};
+
+// Memory maps the OBJ and parses it in parallel, material libraries are searched next to the file.
+// Lines, points, tags and texture options are skipped
+bool ParseObj(std::filesystem::path const& path, ObjParseResult& result, ObjParseSettings const& settings = {});
+bool ParseObj(std::span<char const> text, std::filesystem::path const& materialFolder, ObjParseResult& result, ObjParseSettings const& settings = {});
+
+// Appends the materials of an MTL file, materialMap maps names to indices into materials
+bool ParseMtl(std::span<char const> text, std::vector<tinyobj::material_t>& materials, std::map<std::string, int>& materialMap, std::string& warning);
+
+}
\ No newline at end of file
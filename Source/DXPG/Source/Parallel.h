@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace dxpg
+{
+
+// Runs func(i) for every i in [0, count) across the hardware threads, the calling thread takes part.
+// Work is handed out one index at a time so results must only depend on i to stay deterministic.
+// maxThreads limits the thread count, 0 uses every hardware thread
+template<typename Func>
+void ParallelFor(size_t count, Func&& func, size_t maxThreads = 0)
+{
+	size_t threadCount = maxThreads > 0 ? maxThreads : std::max(1u, std::thread::hardware_concurrency());
+	size_t workerCount = std::min<size_t>(threadCount, count);
+	if (workerCount <= 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+			func(i);
+		return;
+	}
+
+	std::atomic<size_t> next = 0;
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count; i = next++)
+			func(i);
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(workerCount - 1);
+	for (size_t i = 1; i < workerCount; ++i)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+}
\ No newline at end of file
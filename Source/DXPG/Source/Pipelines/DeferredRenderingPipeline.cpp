@@ -1,34 +1,99 @@
 #include "DeferredRenderingPipeline.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
 #include "ShaderManager.h"
+#include "MeshImport.h"
+#include "StagingRing.h"
 
 namespace dxpg
 {
 
 
-struct MVP_NORMAL_CB
+struct InstanceData
 {
-	Matrix4x4 ModelViewProjection;
+	Matrix4x4 ModelMatrix;
 	Matrix4x4 NormalMatrix;
 };
 
-struct MVP_CB
+struct VP_CB
 {
-	Matrix4x4 ModelViewProjection;
+	Matrix4x4 ViewProjection;
 };
 
 namespace StaticPipelineConsts
 {
-	constexpr const char* ModelViewProjectionCB = "ModelViewProjectionCB";
-	constexpr const char* VertexSRV = "VertexSRV";
+	constexpr const char* ViewProjectionCB = "ViewProjectionCB";
+	constexpr const char* InstanceOffset = "InstanceOffset";
+	constexpr const char* Instances = "Instances";
 	constexpr const char* MaterialInfo = "MaterialInfo";
 	constexpr const char* DiffuseSRV = "DiffuseSRV";
+	constexpr const char* ResidencyMapSRV = "ResidencyMapSRV";
+	constexpr const char* TileFeedback = "TileFeedback";
+	constexpr const char* FeedbackCB = "FeedbackCB";
+	// Pixels per side of the blocks sharing a feedback entry, one of their pixels writes it each frame
+	constexpr uint32_t FeedbackBlockSize = 8;
 }
 
 namespace ShadowMapPipelineConsts
 {
-	constexpr const char* ModelViewProjectionCB = "ModelViewProjectionCB";
-	constexpr const char* VertexSRV = "VertexSRV";
+	constexpr const char* ViewProjectionCB = "ViewProjectionCB";
+	constexpr const char* InstanceOffset = "InstanceOffset";
+	constexpr const char* Instances = "Instances";
+}
+
+namespace
+{
+	D3D12_INPUT_ELEMENT_DESC const FullInputLayout[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(MeshVertex, Position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(MeshVertex, Normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(MeshVertex, TexCoord), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	// Positions come out in [0, 1] of the shape bounds, the instance matrix maps them back
+	D3D12_INPUT_ELEMENT_DESC const QuantizedInputLayout[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offsetof(QuantizedMeshVertex, Position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(QuantizedMeshVertex, Normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, offsetof(QuantizedMeshVertex, TexCoord), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	D3D12_INPUT_LAYOUT_DESC InputLayoutFor(VertexFormat format)
+	{
+		if (format == VertexFormat::Quantized)
+			return { QuantizedInputLayout, _countof(QuantizedInputLayout) };
+		return { FullInputLayout, _countof(FullInputLayout) };
+	}
+
+	// The model matrix the vertex shaders see, quantized positions are decoded by it as well
+	Matrix4x4 VertexModelMatrix(Renderable const& renderable)
+	{
+		if (renderable.Format == VertexFormat::Quantized)
+			return XMMatrixMultiply(renderable.PositionDequantize, renderable.GlobalModelMatrix);
+		return renderable.GlobalModelMatrix;
+	}
+
+	// Clamps to the coarsest level, so LodCulled maps to it as well. Renderables without a chain only have LOD 0
+	uint32_t ClampLod(Renderable const& renderable, uint32_t lod)
+	{
+		return renderable.Lods.empty() ? 0 : std::min(lod, static_cast<uint32_t>(renderable.Lods.size() - 1));
+	}
+
+	MeshLod GetLod(Renderable const& renderable, uint32_t lod)
+	{
+		if (renderable.Lods.empty())
+			return { .FirstIndex = 0, .IndexCount = renderable.IndexCount, .Error = 0.0f };
+		return renderable.Lods[ClampLod(renderable, lod)];
+	}
+
+	// Levels share the index buffer but draw different ranges, they must not end up in one instanced batch.
+	// Index buffer ids are never reused, the queues map this to a per-frame ordinal before it enters a key
+	uint64_t LodIndexBufferKey(Renderable const& renderable, uint32_t lod)
+	{
+		return uint64_t(renderable.IndexBufferId) * MaxMeshLods + lod;
+	}
 }
 
 namespace LightingPipelineConsts
@@ -53,6 +118,14 @@ bool DeferredRenderingPipeline::Setup(ID3D12Device2* dev)
 	SetupShadowMapPipeline();
 	SetupLightingPipeline();
 
+	NullResidencyMapSRV = g_GPUDescriptorAllocator->AllocateFromStatic(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_R8_UINT;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Texture2D.MipLevels = 1;
+	Device->CreateShaderResourceView(nullptr, &srvDesc, NullResidencyMapSRV.GetCPUHandle());
+
 	return true;
 }
 
@@ -100,6 +173,16 @@ void DeferredRenderingPipeline::OnResize(uint32_t width, uint32_t height)
 	};
 	OutputBuffer = DXTexture::Create(Device, L"OutputBuffer", outputBufferInfo);
 
+	TileFeedbackWidth = (width + StaticPipelineConsts::FeedbackBlockSize - 1) / StaticPipelineConsts::FeedbackBlockSize;
+	uint32_t feedbackHeight = (height + StaticPipelineConsts::FeedbackBlockSize - 1) / StaticPipelineConsts::FeedbackBlockSize;
+	size_t feedbackBytes = size_t(TileFeedbackWidth) * feedbackHeight * sizeof(uint32_t);
+	TileFeedbackBuffer = DXBuffer::Create(Device, L"TileFeedback", feedbackBytes, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	TileFeedbackClear = DXBuffer::Create(Device, L"TileFeedbackClear", feedbackBytes, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+	std::memset(TileFeedbackClear.Map(), 0xFF, feedbackBytes);
+	TileFeedbackClear.Unmap();
+	TileFeedbackReadbacks = {};
+	TileFeedback.clear();
+
 	// Create RTVs and DSVs
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
 	dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
@@ -133,19 +216,207 @@ void DeferredRenderingPipeline::OnResize(uint32_t width, uint32_t height)
 
 void DeferredRenderingPipeline::Run(ID3D12GraphicsCommandList2* cmd, ViewData const& viewData, SceneDataView const& scene, FrameContext& frameCtx)
 {
+	auto start = std::chrono::high_resolution_clock::now();
+	CullRenderables(viewData, scene);
+	SelectLods(viewData, scene);
+	// Only what this frame draws, culled renderables of a batch still in flight do not hold the frame back
+	UploadFence = 0;
+	for (auto const* renderables : { &VisibleRenderables, &ShadowCasters })
+	{
+		for (uint32_t renderableIndex : *renderables)
+			UploadFence = std::max(UploadFence, scene.RenderableList[renderableIndex].UploadFence);
+	}
+	BuildRenderQueues(viewData, scene);
+	UploadInstances(scene, frameCtx);
+	BeginTileFeedback(cmd, frameCtx);
 	RunStaticMeshPipeline(cmd, viewData, scene);
+	EndTileFeedback(cmd, frameCtx);
 	RunShadowMapPipeline(cmd, scene);
 	RunLightingPipeline(cmd, viewData, scene, frameCtx); 
+	CpuMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+void DeferredRenderingPipeline::CullRenderables(ViewData const& viewData, SceneDataView const& scene)
+{
+	auto selectAll = [&](std::vector<uint32_t>& list)
+	{
+		for (uint32_t i = 0; i < scene.RenderableList.size(); ++i)
+			list.push_back(i);
+		return CullingStats{ .Visible = static_cast<uint32_t>(scene.RenderableList.size()), .Culled = 0 };
+	};
+
+	assert(!scene.RenderableBounds || scene.RenderableBounds->Count == scene.RenderableList.size());
+	VisibleRenderables.clear();
+	if (EnableFrustumCulling && scene.RenderableBounds)
+		CameraCullingStats = CullBoxes(Frustum::FromViewProjection(viewData.ViewProjection), *scene.RenderableBounds, VisibleRenderables);
+	else
+		CameraCullingStats = selectAll(VisibleRenderables);
+
+	ShadowCasters.clear();
+	if (EnableShadowCasterCulling && scene.RenderableBounds)
+		ShadowCullingStats = CullShadowCasters(scene.LightView.ViewProjection, *scene.RenderableBounds, ShadowCasters);
+	else
+		ShadowCullingStats = selectAll(ShadowCasters);
+}
+
+void DeferredRenderingPipeline::SelectLods(ViewData const& viewData, SceneDataView const& scene)
+{
+	CameraLodStats = {};
+	RenderableLods.assign(scene.RenderableList.size(), 0);
+	LodSelection.ViewportHeight = Viewport.Height;
+	float projectionScale = XMVectorGetY(viewData.Projection.r[1]);
+	if (EnableLodSelection)
+	{
+		for (uint32_t renderableIndex = 0; renderableIndex < scene.RenderableList.size(); ++renderableIndex)
+		{
+			auto& renderable = scene.RenderableList[renderableIndex];
+			float screenSize = ProjectedSphereSize(XMLoadFloat3(&renderable.WorldSphere.Center), renderable.WorldSphere.Radius, viewData.Position, projectionScale);
+			RenderableLods[renderableIndex] = SelectLod(renderable.Lods, screenSize, LodSelection);
+		}
+	}
+
+	// Too small to contribute to the camera image, they can still cast shadows at their coarsest level
+	std::erase_if(VisibleRenderables, [&](uint32_t renderableIndex)
+	{
+		auto& renderable = scene.RenderableList[renderableIndex];
+		uint32_t lod = RenderableLods[renderableIndex];
+		CameraLodStats.FullTriangles += renderable.TriangleCount;
+		if (lod == LodCulled)
+		{
+			CameraLodStats.Culled++;
+			return true;
+		}
+		CameraLodStats.Selected[ClampLod(renderable, lod)]++;
+		CameraLodStats.Triangles += GetLod(renderable, lod).IndexCount / 3;
+		return false;
+	});
+
+	// Texture streaming sizes the levels after what is drawn
+	TextureUses.clear();
+	for (uint32_t renderableIndex : VisibleRenderables)
+	{
+		auto& renderable = scene.RenderableList[renderableIndex];
+		if (renderable.DiffuseTexture)
+			TextureUses.push_back({ renderable.DiffuseTexture, ProjectedSphereSize(XMLoadFloat3(&renderable.WorldSphere.Center), renderable.WorldSphere.Radius, viewData.Position, projectionScale) * Viewport.Height });
+	}
+}
+
+void DeferredRenderingPipeline::BuildRenderQueues(ViewData const& viewData, SceneDataView const& scene)
+{
+	auto viewDepth = [&](ViewData const& view, Renderable const& renderable)
+	{
+		return XMVectorGetX(XMVector3Dot(XMVectorSubtract(XMLoadFloat3(&renderable.WorldBounds.Center), view.Position), view.Direction));
+	};
+
+	// G-buffer pass binds a material per draw, group by material first
+	GBufferQueue.Clear();
+	for (uint32_t renderableIndex : VisibleRenderables)
+	{
+		auto& renderable = scene.RenderableList[renderableIndex];
+		uint32_t lod = ClampLod(renderable, RenderableLods[renderableIndex]);
+		GBufferQueue.PushMaterialMajor(uint32_t(renderable.Format), renderable.MaterialId, renderable.VertexBufferId, LodIndexBufferKey(renderable, lod), viewDepth(viewData, renderable), renderableIndex);
+	}
+	GBufferQueue.Sort();
+
+	// Depth only, group by geometry and order the instances front to back from the light
+	ShadowQueue.Clear();
+	for (uint32_t renderableIndex : ShadowCasters)
+	{
+		auto& renderable = scene.RenderableList[renderableIndex];
+		uint32_t lod = ClampLod(renderable, RenderableLods[renderableIndex]);
+		ShadowQueue.PushGeometryMajor(uint32_t(renderable.Format), renderable.VertexBufferId, LodIndexBufferKey(renderable, lod), viewDepth(scene.LightView, renderable), renderableIndex);
+	}
+	ShadowQueue.Sort();
+
+	// Still drawn correctly, but without instancing
+	bool keysOverflowed = GBufferQueue.Stats.Unbatched > 0 || ShadowQueue.Stats.Unbatched > 0;
+	if (keysOverflowed && !ReportedKeyOverflow)
+		std::cout << "Sort keys overflowed, " << GBufferQueue.Stats.Unbatched << " G-buffer and " << ShadowQueue.Stats.Unbatched << " shadow draws are not instanced" << std::endl;
+	ReportedKeyOverflow = keysOverflowed;
+}
+
+void DeferredRenderingPipeline::UploadInstances(SceneDataView const& scene, FrameContext& frameCtx)
+{
+	// Instances follow queue packet order, G-buffer packets first then shadow packets
+	auto gbufferPackets = GBufferQueue.GetPackets();
+	auto shadowPackets = ShadowQueue.GetPackets();
+	ShadowInstanceBase = static_cast<uint32_t>(gbufferPackets.size());
+	size_t instanceCount = gbufferPackets.size() + shadowPackets.size();
+	if (instanceCount == 0)
+		return;
+
+	auto instanceBuffer = AllocateStaging(Device, frameCtx, instanceCount * sizeof(InstanceData));
+	InstanceBufferAddress = instanceBuffer.GPUAddress();
+
+	auto* instances = reinterpret_cast<InstanceData*>(instanceBuffer.Data);
+	for (auto& packet : gbufferPackets)
+	{
+		auto& renderable = scene.RenderableList[packet.RenderableIndex];
+		instances->ModelMatrix = VertexModelMatrix(renderable);
+		// Normals are decoded to object space directly, the dequantize scale must not skew them
+		instances->NormalMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, renderable.GlobalModelMatrix));
+		instances++;
+	}
+	// Depth only, the normal matrix is never read
+	for (auto& packet : shadowPackets)
+	{
+		instances->ModelMatrix = VertexModelMatrix(scene.RenderableList[packet.RenderableIndex]);
+		instances++;
+	}
+}
+
+void DeferredRenderingPipeline::BeginTileFeedback(ID3D12GraphicsCommandList2* cmd, FrameContext& frameCtx)
+{
+	if (!EnableTileFeedback)
+	{
+		TileFeedback.clear();
+		for (auto& readback : TileFeedbackReadbacks)
+			readback.Written = false;
+		return;
+	}
+
+	// The context's last frame completed before it was handed out again
+	assert(frameCtx.Slot < MaxFramesInFlight);
+	auto& readback = TileFeedbackReadbacks[frameCtx.Slot];
+	if (readback.Written)
+	{
+		auto* feedback = readback.Buffer.Map<uint32_t>();
+		TileFeedback.assign(feedback, feedback + readback.Buffer.Size / sizeof(uint32_t));
+		readback.Buffer.Unmap();
+	}
+
+	TransitionVec(TileFeedbackBuffer, D3D12_RESOURCE_STATE_COPY_DEST).Execute(cmd);
+	cmd->CopyResource(TileFeedbackBuffer.Resource.Get(), TileFeedbackClear.Resource.Get());
+	TransitionVec(TileFeedbackBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS).Execute(cmd);
 }
+
+void DeferredRenderingPipeline::EndTileFeedback(ID3D12GraphicsCommandList2* cmd, FrameContext& frameCtx)
+{
+	TileFeedbackFrame++;
+	if (!EnableTileFeedback)
+		return;
+
+	auto& readback = TileFeedbackReadbacks[frameCtx.Slot];
+	if (!readback.Buffer.Resource)
+		readback.Buffer = DXBuffer::Create(Device, L"TileFeedbackReadback", TileFeedbackBuffer.Size, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
+	readback.Written = true;
+	TransitionVec(TileFeedbackBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE).Execute(cmd);
+	cmd->CopyResource(readback.Buffer.Resource.Get(), TileFeedbackBuffer.Resource.Get());
+	TransitionVec(TileFeedbackBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS).Execute(cmd);
+}
+
 bool DeferredRenderingPipeline::SetupStaticMeshPipeline()
 {
 	RootSignatureBuilder builder{};
 
 	std::vector< CD3DX12_ROOT_PARAMETER1> rootParams;
-	builder.AddConstants(StaticPipelineConsts::ModelViewProjectionCB, sizeof(MVP_NORMAL_CB) / 4, { .ShaderRegister = 0, .Visibility = D3D12_SHADER_VISIBILITY_VERTEX });
-	builder.AddDescriptorTable(StaticPipelineConsts::VertexSRV, { { CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 3, 0) } }, D3D12_SHADER_VISIBILITY_VERTEX);
+	builder.AddConstants(StaticPipelineConsts::ViewProjectionCB, sizeof(VP_CB) / 4, { .ShaderRegister = 0, .Visibility = D3D12_SHADER_VISIBILITY_VERTEX });
+	builder.AddConstants(StaticPipelineConsts::InstanceOffset, 1, { .ShaderRegister = 2, .Visibility = D3D12_SHADER_VISIBILITY_VERTEX });
+	builder.AddShaderResourceView(StaticPipelineConsts::Instances, { .ShaderRegister = 0, .Visibility = D3D12_SHADER_VISIBILITY_VERTEX, .DescFlags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE });
 	builder.AddDescriptorTable(StaticPipelineConsts::MaterialInfo, { { CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 1) } }, D3D12_SHADER_VISIBILITY_PIXEL);
 	builder.AddDescriptorTable(StaticPipelineConsts::DiffuseSRV, { { CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 3) } }, D3D12_SHADER_VISIBILITY_PIXEL);
+	builder.AddDescriptorTable(StaticPipelineConsts::ResidencyMapSRV, { { CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 5) } }, D3D12_SHADER_VISIBILITY_PIXEL);
+	builder.AddUnorderedAccessView(StaticPipelineConsts::TileFeedback, { .ShaderRegister = 0, .Visibility = D3D12_SHADER_VISIBILITY_PIXEL });
+	builder.AddConstants(StaticPipelineConsts::FeedbackCB, 3, { .ShaderRegister = 3, .Visibility = D3D12_SHADER_VISIBILITY_PIXEL });
 
 	D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
@@ -174,19 +445,9 @@ bool DeferredRenderingPipeline::SetupStaticMeshPipeline()
 		CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER Rasterizer;
 	} pipelineStateStream;
 
-	D3D12_INPUT_ELEMENT_DESC inputLayout[] = {
-		{ "POSINDEX", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "NORMALINDEX", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORDINDEX", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-	};
-
-	pipelineStateStream.InputLayout = { inputLayout, _countof(inputLayout) };
 	pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 
-	auto* vertexShader = ShaderManager::Get().CompileShader(L"Triangle.vs", DXPG_SHADERS_DIR L"Vertex/StaticMesh.vs.hlsl", ShaderType::Vertex);
 	auto* pixelShader = ShaderManager::Get().CompileShader(L"Triangle.ps", DXPG_SHADERS_DIR L"Pixel/StaticMesh.ps.hlsl", ShaderType::Pixel);
-
-	pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(vertexShader->Blob.Get());
 	pipelineStateStream.PS = CD3DX12_SHADER_BYTECODE(pixelShader->Blob.Get());
 
 	pipelineStateStream.DSVFormat = DXGI_FORMAT_D32_FLOAT;
@@ -198,15 +459,26 @@ bool DeferredRenderingPipeline::SetupStaticMeshPipeline()
 
 	pipelineStateStream.Rasterizer = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 
-	StaticMeshPipelineState = PipelineState::Create("StaticMeshPipeline", Device, pipelineStateStream, &StaticMeshRootSignature);
+	std::wstring_view const quantizedDefines[] = { L"QUANTIZED_VERTICES" };
+	auto* vertexShader = ShaderManager::Get().CompileShader(L"Triangle.vs", DXPG_SHADERS_DIR L"Vertex/StaticMesh.vs.hlsl", ShaderType::Vertex);
+	auto* quantizedVertexShader = ShaderManager::Get().CompileShader(L"TriangleQuantized.vs", DXPG_SHADERS_DIR L"Vertex/StaticMesh.vs.hlsl", ShaderType::Vertex, L"main", {}, quantizedDefines);
+
+	pipelineStateStream.InputLayout = InputLayoutFor(VertexFormat::Full);
+	pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(vertexShader->Blob.Get());
+	StaticMeshPipelineStates[size_t(VertexFormat::Full)] = PipelineState::Create("StaticMeshPipeline", Device, pipelineStateStream, &StaticMeshRootSignature);
+
+	pipelineStateStream.InputLayout = InputLayoutFor(VertexFormat::Quantized);
+	pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(quantizedVertexShader->Blob.Get());
+	StaticMeshPipelineStates[size_t(VertexFormat::Quantized)] = PipelineState::Create("StaticMeshQuantizedPipeline", Device, pipelineStateStream, &StaticMeshRootSignature);
 	return true;
 }
 
 bool DeferredRenderingPipeline::SetupShadowMapPipeline()
 {
 	RootSignatureBuilder builder{};
-	builder.AddConstants(ShadowMapPipelineConsts::ModelViewProjectionCB, sizeof(MVP_CB) / 4, { .ShaderRegister = 0, .Visibility = D3D12_SHADER_VISIBILITY_VERTEX });
-	builder.AddDescriptorTable(ShadowMapPipelineConsts::VertexSRV, { { CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0) } }, D3D12_SHADER_VISIBILITY_VERTEX);
+	builder.AddConstants(ShadowMapPipelineConsts::ViewProjectionCB, sizeof(VP_CB) / 4, { .ShaderRegister = 0, .Visibility = D3D12_SHADER_VISIBILITY_VERTEX });
+	builder.AddConstants(ShadowMapPipelineConsts::InstanceOffset, 1, { .ShaderRegister = 1, .Visibility = D3D12_SHADER_VISIBILITY_VERTEX });
+	builder.AddShaderResourceView(ShadowMapPipelineConsts::Instances, { .ShaderRegister = 0, .Visibility = D3D12_SHADER_VISIBILITY_VERTEX, .DescFlags = D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE });
 	ShadowMapRootSignature = builder.Build("ShadowMapRS", Device, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
 	struct ShadowMapPipelineStateStream : PipelineStateStreamBase
@@ -215,22 +487,25 @@ bool DeferredRenderingPipeline::SetupShadowMapPipeline()
 		CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY PrimitiveTopologyType;
 		CD3DX12_PIPELINE_STATE_STREAM_VS VS;
 		CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT DSVFormat;
+		CD3DX12_PIPELINE_STATE_STREAM_RASTERIZER Rasterizer;
 	} pipelineStateStream;
 
-	D3D12_INPUT_ELEMENT_DESC inputLayout[] = {
-		{ "POSINDEX", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "NORMALINDEX", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORDINDEX", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-	};
-
-	pipelineStateStream.InputLayout = { inputLayout, _countof(inputLayout) };
 	pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 
 	pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(ShaderManager::Get().CompileShader(L"ShadowMap.vs", DXPG_SHADERS_DIR L"Vertex/ShadowMap.vs.hlsl", ShaderType::Vertex)->Blob.Get());
 
 	pipelineStateStream.DSVFormat = DXGI_FORMAT_D32_FLOAT;
 
-	ShadowMapPipelineState = PipelineState::Create("ShadowMapPipeline", Device, pipelineStateStream, &ShadowMapRootSignature);
+	// Casters in front of the light's near plane are kept by culling, clamp their depth instead of clipping them
+	CD3DX12_RASTERIZER_DESC rasterizer(D3D12_DEFAULT);
+	rasterizer.DepthClipEnable = FALSE;
+	pipelineStateStream.Rasterizer = rasterizer;
+
+	// Only the position is read, the shader is the same for both formats since the unorm fetch already yields floats
+	pipelineStateStream.InputLayout = InputLayoutFor(VertexFormat::Full);
+	ShadowMapPipelineStates[size_t(VertexFormat::Full)] = PipelineState::Create("ShadowMapPipeline", Device, pipelineStateStream, &ShadowMapRootSignature);
+	pipelineStateStream.InputLayout = InputLayoutFor(VertexFormat::Quantized);
+	ShadowMapPipelineStates[size_t(VertexFormat::Quantized)] = PipelineState::Create("ShadowMapQuantizedPipeline", Device, pipelineStateStream, &ShadowMapRootSignature);
 	ShadowMap = DXTexture::Create(Device, L"ShadowMap", {
 		.Width = 1024,
 		.Height = 1024,
@@ -348,42 +623,109 @@ void DeferredRenderingPipeline::RunStaticMeshPipeline(ID3D12GraphicsCommandList2
 	}
 
 	cmd->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	cmd->SetPipelineState(StaticMeshPipelineState.DXPipelineState.Get());
-	cmd->SetGraphicsRootSignature(StaticMeshPipelineState.RootSignature->DXSignature.Get());
+	cmd->SetPipelineState(StaticMeshPipelineStates[size_t(VertexFormat::Full)].DXPipelineState.Get());
+	cmd->SetGraphicsRootSignature(StaticMeshRootSignature.DXSignature.Get());
 
-	Renderable lastRenderableCfg{};
-	for (auto& renderable : scene.RenderableList)
+	auto* rootSignature = &StaticMeshRootSignature;
+	if (!GBufferQueue.GetBatches().empty())
 	{
-		if (lastRenderableCfg.VertexSRV.ptr != renderable.VertexSRV.ptr)
+		VP_CB vp{ .ViewProjection = viewData.ViewProjection };
+		cmd->SetGraphicsRoot32BitConstants(rootSignature->NameToParameterIndices[StaticPipelineConsts::ViewProjectionCB], sizeof(VP_CB) / sizeof(uint32_t), &vp, 0);
+		cmd->SetGraphicsRootShaderResourceView(rootSignature->NameToParameterIndices[StaticPipelineConsts::Instances], InstanceBufferAddress);
+		// Walks through every pixel of the feedback blocks over 64 frames
+		uint32_t feedback[] = { TileFeedbackWidth, TileFeedbackFrame % StaticPipelineConsts::FeedbackBlockSize, TileFeedbackFrame / StaticPipelineConsts::FeedbackBlockSize % StaticPipelineConsts::FeedbackBlockSize };
+		cmd->SetGraphicsRootUnorderedAccessView(rootSignature->NameToParameterIndices[StaticPipelineConsts::TileFeedback], TileFeedbackBuffer.GPUAddress());
+		cmd->SetGraphicsRoot32BitConstants(rootSignature->NameToParameterIndices[StaticPipelineConsts::FeedbackCB], 3, feedback, 0);
+	}
+
+	auto packets = GBufferQueue.GetPackets();
+	auto& stats = GBufferQueue.Stats;
+	ClusterCullingStats = {};
+	Frustum cameraFrustum = Frustum::FromViewProjection(viewData.ViewProjection);
+	Renderable lastRenderableCfg{ .Format = VertexFormat::Full };
+	for (auto& batch : GBufferQueue.GetBatches())
+	{
+		auto& renderable = scene.RenderableList[packets[batch.FirstPacket].RenderableIndex];
+		// Formats are the top key bits, the pipeline switches at most once per format
+		if (lastRenderableCfg.Format != renderable.Format)
 		{
-			lastRenderableCfg.VertexSRV = renderable.VertexSRV;
-			cmd->SetGraphicsRootDescriptorTable(StaticMeshPipelineState.RootSignature->NameToParameterIndices[StaticPipelineConsts::VertexSRV], renderable.VertexSRV);
+			lastRenderableCfg.Format = renderable.Format;
+			cmd->SetPipelineState(StaticMeshPipelineStates[size_t(renderable.Format)].DXPipelineState.Get());
+			stats.StateChanges++;
 		}
+		if (lastRenderableCfg.VertexBufferView.BufferLocation != renderable.VertexBufferView.BufferLocation)
+		{
+			lastRenderableCfg.VertexBufferView = renderable.VertexBufferView;
+			cmd->IASetVertexBuffers(0, 1, &renderable.VertexBufferView);
+			stats.StateChanges++;
+		}
+		else
+			stats.StateChangesAvoided++;
 
 		if (lastRenderableCfg.MaterialInfo.ptr != renderable.MaterialInfo.ptr)
 		{
 			lastRenderableCfg.MaterialInfo = renderable.MaterialInfo;
-			cmd->SetGraphicsRootDescriptorTable(StaticMeshPipelineState.RootSignature->NameToParameterIndices[StaticPipelineConsts::MaterialInfo], renderable.MaterialInfo);
+			cmd->SetGraphicsRootDescriptorTable(rootSignature->NameToParameterIndices[StaticPipelineConsts::MaterialInfo], renderable.MaterialInfo);
+			stats.StateChanges++;
 		}
-		if (renderable.DiffuseTextureSRV.ptr != 0)
+		else
+			stats.StateChangesAvoided++;
+		if (renderable.DiffuseTexture)
 		{
-			if (lastRenderableCfg.DiffuseTextureSRV.ptr != renderable.DiffuseTextureSRV.ptr)
+			if (lastRenderableCfg.DiffuseTexture != renderable.DiffuseTexture)
 			{
-				lastRenderableCfg.DiffuseTextureSRV = renderable.DiffuseTextureSRV;
-				cmd->SetGraphicsRootDescriptorTable(StaticMeshPipelineState.RootSignature->NameToParameterIndices[StaticPipelineConsts::DiffuseSRV], renderable.DiffuseTextureSRV);
+				lastRenderableCfg.DiffuseTexture = renderable.DiffuseTexture;
+				cmd->SetGraphicsRootDescriptorTable(rootSignature->NameToParameterIndices[StaticPipelineConsts::DiffuseSRV], renderable.DiffuseTexture->GetGPUHandle());
+				stats.StateChanges++;
 			}
+			else
+				stats.StateChangesAvoided++;
+		}
+		auto residencyMap = renderable.ResidencyMap.ptr != 0 ? renderable.ResidencyMap : NullResidencyMapSRV.GetGPUHandle();
+		if (lastRenderableCfg.ResidencyMap.ptr != residencyMap.ptr)
+		{
+			lastRenderableCfg.ResidencyMap = residencyMap;
+			cmd->SetGraphicsRootDescriptorTable(rootSignature->NameToParameterIndices[StaticPipelineConsts::ResidencyMapSRV], residencyMap);
+			stats.StateChanges++;
 		}
+		else
+			stats.StateChangesAvoided++;
 
-		if (lastRenderableCfg.IndicesView.BufferLocation != renderable.IndicesView.BufferLocation)
+		// Pooled shapes share the index buffer, only the block or the index format changes the binding
+		if (lastRenderableCfg.IndexBufferView.BufferLocation != renderable.IndexBufferView.BufferLocation || lastRenderableCfg.IndexBufferView.Format != renderable.IndexBufferView.Format)
 		{
-			lastRenderableCfg.IndicesView = renderable.IndicesView;
-			cmd->IASetVertexBuffers(0, 1, &renderable.IndicesView);
+			lastRenderableCfg.IndexBufferView = renderable.IndexBufferView;
+			cmd->IASetIndexBuffer(&renderable.IndexBufferView);
+			stats.StateChanges++;
+		}
+		else
+			stats.StateChangesAvoided++;
+		stats.Instances += batch.InstanceCount;
+		cmd->SetGraphicsRoot32BitConstant(rootSignature->NameToParameterIndices[StaticPipelineConsts::InstanceOffset], batch.FirstPacket, 0);
+
+		uint32_t lodIndex = ClampLod(renderable, RenderableLods[packets[batch.FirstPacket].RenderableIndex]);
+		MeshLod lod = GetLod(renderable, lodIndex);
+		// Clusters are culled per object, instanced batches share one index stream and are drawn whole.
+		// Meshlets only exist for LOD 0
+		if (EnableClusterCulling && batch.InstanceCount == 1 && lodIndex == 0 && !renderable.Meshlets.empty())
+		{
+			VisibleClusterRanges.clear();
+			CullingStats clusterStats = CullMeshlets(renderable.Meshlets, renderable.GlobalModelMatrix, cameraFrustum, viewData.Position, VisibleClusterRanges);
+			ClusterCullingStats.Visible += clusterStats.Visible;
+			ClusterCullingStats.Culled += clusterStats.Culled;
+			if (SplitClusterDraws(VisibleClusterRanges, lod.IndexCount, ClusterDraws))
+			{
+				for (auto& range : VisibleClusterRanges)
+				{
+					stats.Draws++;
+					cmd->DrawIndexedInstanced(range.IndexCount, 1, renderable.FirstIndex + range.FirstIndex, renderable.BaseVertex, 0);
+				}
+				continue;
+			}
 		}
-		MVP_NORMAL_CB mvp{};
-		mvp.ModelViewProjection = XMMatrixMultiply(renderable.GlobalModelMatrix, viewData.ViewProjection);
-		mvp.NormalMatrix = DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, renderable.GlobalModelMatrix));
-		cmd->SetGraphicsRoot32BitConstants(StaticMeshPipelineState.RootSignature->NameToParameterIndices[StaticPipelineConsts::ModelViewProjectionCB], sizeof(MVP_NORMAL_CB) / sizeof(uint32_t), &mvp, 0);
-		cmd->DrawInstanced(renderable.GetIndexCount(), 1, 0, 0);
+
+		stats.Draws++;
+		cmd->DrawIndexedInstanced(lod.IndexCount, batch.InstanceCount, renderable.FirstIndex + lod.FirstIndex, renderable.BaseVertex, 0);
 	}
 }
 void DeferredRenderingPipeline::RunShadowMapPipeline(ID3D12GraphicsCommandList2* cmd, SceneDataView const& scene)
@@ -405,26 +747,51 @@ void DeferredRenderingPipeline::RunShadowMapPipeline(ID3D12GraphicsCommandList2*
 	}
 
 	cmd->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	cmd->SetPipelineState(ShadowMapPipelineState.DXPipelineState.Get());
-	cmd->SetGraphicsRootSignature(ShadowMapPipelineState.RootSignature->DXSignature.Get());
+	cmd->SetPipelineState(ShadowMapPipelineStates[size_t(VertexFormat::Full)].DXPipelineState.Get());
+	cmd->SetGraphicsRootSignature(ShadowMapRootSignature.DXSignature.Get());
+
+	auto* rootSignature = &ShadowMapRootSignature;
+	if (!ShadowQueue.GetBatches().empty())
+	{
+		VP_CB vp{ .ViewProjection = scene.LightView.ViewProjection };
+		cmd->SetGraphicsRoot32BitConstants(rootSignature->NameToParameterIndices[ShadowMapPipelineConsts::ViewProjectionCB], sizeof(VP_CB) / sizeof(uint32_t), &vp, 0);
+		cmd->SetGraphicsRootShaderResourceView(rootSignature->NameToParameterIndices[ShadowMapPipelineConsts::Instances], InstanceBufferAddress);
+	}
 
-	Renderable lastRenderableCfg{};
-	for (auto& renderable : scene.RenderableList)
+	auto packets = ShadowQueue.GetPackets();
+	auto& stats = ShadowQueue.Stats;
+	Renderable lastRenderableCfg{ .Format = VertexFormat::Full };
+	for (auto& batch : ShadowQueue.GetBatches())
 	{
-		if (lastRenderableCfg.VertexSRV.ptr != renderable.VertexSRV.ptr)
+		auto& renderable = scene.RenderableList[packets[batch.FirstPacket].RenderableIndex];
+		// Formats are the top key bits, the pipeline switches at most once per format
+		if (lastRenderableCfg.Format != renderable.Format)
+		{
+			lastRenderableCfg.Format = renderable.Format;
+			cmd->SetPipelineState(ShadowMapPipelineStates[size_t(renderable.Format)].DXPipelineState.Get());
+			stats.StateChanges++;
+		}
+		if (lastRenderableCfg.VertexBufferView.BufferLocation != renderable.VertexBufferView.BufferLocation)
 		{
-			lastRenderableCfg.VertexSRV = renderable.VertexSRV;
-			cmd->SetGraphicsRootDescriptorTable(ShadowMapPipelineState.RootSignature->NameToParameterIndices[ShadowMapPipelineConsts::VertexSRV], renderable.VertexSRV);
+			lastRenderableCfg.VertexBufferView = renderable.VertexBufferView;
+			cmd->IASetVertexBuffers(0, 1, &renderable.VertexBufferView);
+			stats.StateChanges++;
 		}
-		if (lastRenderableCfg.IndicesView.BufferLocation != renderable.IndicesView.BufferLocation)
+		else
+			stats.StateChangesAvoided++;
+		if (lastRenderableCfg.IndexBufferView.BufferLocation != renderable.IndexBufferView.BufferLocation || lastRenderableCfg.IndexBufferView.Format != renderable.IndexBufferView.Format)
 		{
-			lastRenderableCfg.IndicesView = renderable.IndicesView;
-			cmd->IASetVertexBuffers(0, 1, &renderable.IndicesView);
+			lastRenderableCfg.IndexBufferView = renderable.IndexBufferView;
+			cmd->IASetIndexBuffer(&renderable.IndexBufferView);
+			stats.StateChanges++;
 		}
-		MVP_CB mvp{};
-		mvp.ModelViewProjection = XMMatrixMultiply(renderable.GlobalModelMatrix, scene.LightView.ViewProjection);
-		cmd->SetGraphicsRoot32BitConstants(ShadowMapPipelineState.RootSignature->NameToParameterIndices[ShadowMapPipelineConsts::ModelViewProjectionCB], sizeof(MVP_CB) / sizeof(uint32_t), &mvp, 0);
-		cmd->DrawInstanced(renderable.GetIndexCount(), 1, 0, 0);
+		else
+			stats.StateChangesAvoided++;
+		stats.Draws++;
+		stats.Instances += batch.InstanceCount;
+		cmd->SetGraphicsRoot32BitConstant(rootSignature->NameToParameterIndices[ShadowMapPipelineConsts::InstanceOffset], ShadowInstanceBase + batch.FirstPacket, 0);
+		MeshLod lod = GetLod(renderable, RenderableLods[packets[batch.FirstPacket].RenderableIndex]);
+		cmd->DrawIndexedInstanced(lod.IndexCount, batch.InstanceCount, renderable.FirstIndex + lod.FirstIndex, renderable.BaseVertex, 0);
 	}
 }
 void DeferredRenderingPipeline::RunLightingPipeline(ID3D12GraphicsCommandList2* cmd, ViewData const& viewData, SceneDataView const& scene, FrameContext& frameCtx)
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
+
 #include "RootSignature.h"
 #include "PipelineState.h"
 
 #include "RendererCommon.h"
 #include "DXResource.h"
+#include "RenderQueue.h"
 
 namespace dxpg
 {
@@ -19,11 +22,45 @@ struct DeferredRenderingPipeline
 	DescriptorAllocation& GetOutputBufferSRV() { return OutputBufferSRV; }
 	DXTexture& GetShadowMap() { return ShadowMap; }
 	DescriptorAllocation& GetShadowMapSRV() { return ShadowMapSRV; }
+	CullingStats const& GetCameraCullingStats() const { return CameraCullingStats; }
+	CullingStats const& GetShadowCullingStats() const { return ShadowCullingStats; }
+	CullingStats const& GetClusterCullingStats() const { return ClusterCullingStats; }
+	RenderQueueStats const& GetGBufferQueueStats() const { return GBufferQueue.Stats; }
+	RenderQueueStats const& GetShadowQueueStats() const { return ShadowQueue.Stats; }
+	LodStats const& GetLodStats() const { return CameraLodStats; }
+	// Textures of the renderables drawn by the last Run
+	std::span<TextureUse const> GetTextureUses() const { return TextureUses; }
+	// Tiles the G-buffer pass asked virtual textures for, one entry per 8x8 pixel block. Read back from the last frame that used the
+	// same frame context, so it lags the frame being recorded by the frames in flight, and tiles it asks for are mapped a frame later still
+	std::span<uint32_t const> GetTileFeedback() const { return TileFeedback; }
+	// Newest copy queue batch the renderables of the last Run were uploaded by, the graphics queue has to wait for it before the frame executes
+	uint64_t GetUploadFence() const { return UploadFence; }
+	// Culling, queue building and command recording of the last Run
+	double GetCpuMilliseconds() const { return CpuMilliseconds; }
+
+	bool EnableFrustumCulling = true;
+	bool EnableShadowCasterCulling = true;
+	// Draws only the visible meshlet ranges of single instance LOD 0 draws, off since the extra draws usually cost more than the culled triangles
+	bool EnableClusterCulling = false;
+	// When the visible ranges replace the whole draw
+	ClusterDrawSettings ClusterDraws;
+	bool EnableLodSelection = true;
+	// Clears and reads back the tile feedback, only needed when there are virtual textures
+	bool EnableTileFeedback = false;
+	// ViewportHeight is kept in sync with the output size
+	LodSettings LodSelection;
 private:
 	bool SetupStaticMeshPipeline();
 	bool SetupLightingPipeline();
 	bool SetupShadowMapPipeline();
 
+	void CullRenderables(ViewData const& viewData, SceneDataView const& scene);
+	void SelectLods(ViewData const& viewData, SceneDataView const& scene);
+	void BuildRenderQueues(ViewData const& viewData, SceneDataView const& scene);
+	void UploadInstances(SceneDataView const& scene, FrameContext& frameCtx);
+	void BeginTileFeedback(ID3D12GraphicsCommandList2* cmd, FrameContext& frameCtx);
+	void EndTileFeedback(ID3D12GraphicsCommandList2* cmd, FrameContext& frameCtx);
+
 	void RunStaticMeshPipeline(ID3D12GraphicsCommandList2* cmd, ViewData const& viewData, SceneDataView const& scene);
 	void RunShadowMapPipeline(ID3D12GraphicsCommandList2* cmd, SceneDataView const& scene);
 	void RunLightingPipeline(ID3D12GraphicsCommandList2* cmd, ViewData const& viewData, SceneDataView const& scene, FrameContext& frameCtx);
@@ -32,7 +69,8 @@ private:
 
 	ID3D12Device2* Device;
 	RootSignature StaticMeshRootSignature;
-	PipelineState StaticMeshPipelineState;
+	// One pipeline per vertex format, indexed by VertexFormat
+	std::array<PipelineState, size_t(VertexFormat::Count)> StaticMeshPipelineStates;
 
 	DXTexture DepthBuffer;
 	DXTexture AlbedoBuffer;
@@ -42,9 +80,26 @@ private:
 	DescriptorAllocation AlbedoBufferRTV;
 	DescriptorAllocation NormalBufferRTV;
 	DescriptorAllocation GBuffersSRV;
+	// Bound for materials without a virtual texture
+	DescriptorAllocation NullResidencyMapSRV;
+
+	DXBuffer TileFeedbackBuffer;
+	// Copied over the feedback before every G-buffer pass
+	DXBuffer TileFeedbackClear;
+	// Indexed by FrameContext::Slot, a context comes back only once its frame completed. Written is cleared whenever the
+	// feedback buffer is recreated or feedback is turned off, so stale results are never read
+	struct TileFeedbackReadback
+	{
+		DXBuffer Buffer;
+		bool Written = false;
+	};
+	std::array<TileFeedbackReadback, MaxFramesInFlight> TileFeedbackReadbacks;
+	std::vector<uint32_t> TileFeedback;
+	uint32_t TileFeedbackWidth = 0;
+	uint32_t TileFeedbackFrame = 0;
 
 	RootSignature ShadowMapRootSignature;
-	PipelineState ShadowMapPipelineState;
+	std::array<PipelineState, size_t(VertexFormat::Count)> ShadowMapPipelineStates;
 	DXTexture ShadowMap;
 	DescriptorAllocation ShadowMapDSV;
 	DescriptorAllocation ShadowMapSRV;
@@ -57,6 +112,25 @@ private:
 	DescriptorAllocation OutputBufferRTV;
 	DescriptorAllocation OutputBufferSRV;
 
+	std::vector<uint32_t> VisibleRenderables;
+	CullingStats CameraCullingStats;
+	std::vector<uint32_t> ShadowCasters;
+	CullingStats ShadowCullingStats;
+	CullingStats ClusterCullingStats;
+	std::vector<IndexRange> VisibleClusterRanges;
+	// Camera selected level per renderable, LodCulled for the ones too small to draw
+	std::vector<uint32_t> RenderableLods;
+	LodStats CameraLodStats;
+	std::vector<TextureUse> TextureUses;
+	uint64_t UploadFence = 0;
+	double CpuMilliseconds = 0.0;
+	RenderQueue GBufferQueue;
+	RenderQueue ShadowQueue;
+	// Logged when a frame starts falling back to unbatched draws, not every frame
+	bool ReportedKeyOverflow = false;
+	D3D12_GPU_VIRTUAL_ADDRESS InstanceBufferAddress = 0;
+	uint32_t ShadowInstanceBase = 0;
+
 	D3D12_VIEWPORT ShadowMapViewport;
 	D3D12_VIEWPORT Viewport;
 	D3D12_RECT ScissorRect;
@@ -2,6 +2,7 @@
 
 #include "ShaderManager.h"
 #include "DXResource.h"
+#include "StagingRing.h"
 
 #define A_CPU
 #include <ffx_a.h>
@@ -62,18 +63,14 @@ void GenerateMipsPipeline::GenerateMips(FrameContext& frameCtx, ID3D12GraphicsCo
 	uint32_t dispatchY = dispatchThreadGroupCountXY[1];
 	uint32_t dispatchZ = arraySize;
 
-	auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-
-	auto cb = DXBuffer::Create(Device, L"SPDConstants", sizeof(SpdConstants), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
-	frameCtx.IntermediateResources.push_back(cb.Resource);
-	auto* consts = cb.Map<SpdConstants>();
+	auto cb = AllocateStaging(Device, frameCtx, sizeof(SpdConstants));
 
 	SpdConstants constants;
 	constants.numWorkGroupsPerSlice = numWorkGroupsAndMips[0];
 	constants.mips = numWorkGroupsAndMips[1];
 	constants.workGroupOffset[0] = workGroupOffset[0];
 	constants.workGroupOffset[1] = workGroupOffset[1];
-	memcpy(consts, &constants, sizeof(SpdConstants));
+	memcpy(cb.Data, &constants, sizeof(SpdConstants));
 
 	cmdList->SetComputeRootSignature(RootSignature.DXSignature.Get());
 
@@ -0,0 +1,163 @@
+#include "RenderQueue.h"
+
+#include <array>
+#include <bit>
+
+namespace dxpg
+{
+
+namespace SortKey
+{
+namespace
+{
+constexpr bool Fits(uint64_t value, uint32_t bits)
+{
+	return value < (1ull << bits);
+}
+
+constexpr uint64_t Field(uint64_t value, uint32_t shift)
+{
+	return value << shift;
+}
+}
+
+uint32_t QuantizeDepth(float depth)
+{
+	// Non-negative floats compare like their bit patterns
+	depth = depth > 0.0f ? depth : 0.0f;
+	return std::bit_cast<uint32_t>(depth) >> (32 - DepthBits);
+}
+
+bool MaterialMajor(uint32_t pipeline, uint32_t material, uint32_t vertexBuffer, uint32_t indexBuffer, float depth, uint64_t& outKey)
+{
+	if (!Fits(pipeline, PipelineBits) || !Fits(material, MaterialBits) || !Fits(vertexBuffer, VertexBufferBits) || !Fits(indexBuffer, IndexBufferBits))
+		return false;
+
+	uint32_t shift = 64;
+	outKey = Field(pipeline, shift -= PipelineBits);
+	outKey |= Field(material, shift -= MaterialBits);
+	outKey |= Field(vertexBuffer, shift -= VertexBufferBits);
+	outKey |= Field(indexBuffer, shift -= IndexBufferBits);
+	outKey |= Field(QuantizeDepth(depth), shift -= DepthBits);
+	return true;
+}
+
+bool GeometryMajor(uint32_t pipeline, uint32_t vertexBuffer, uint32_t indexBuffer, float depth, uint64_t& outKey)
+{
+	if (!Fits(pipeline, PipelineBits) || !Fits(vertexBuffer, VertexBufferBits) || !Fits(indexBuffer, IndexBufferBits))
+		return false;
+
+	uint32_t shift = 64;
+	outKey = Field(pipeline, shift -= PipelineBits);
+	outKey |= Field(vertexBuffer, shift -= VertexBufferBits);
+	outKey |= Field(indexBuffer, shift -= IndexBufferBits);
+	// The material bits stay zero, depth keeps the lowest bits so InstanceGroupMask applies
+	outKey |= Field(QuantizeDepth(depth), 0);
+	return true;
+}
+}
+
+bool DenseKeyIds::Map(uint64_t id, uint32_t& outOrdinal)
+{
+	auto it = Ordinals.find(id);
+	if (it == Ordinals.end())
+	{
+		if (Ordinals.size() >= Capacity)
+			return false;
+		it = Ordinals.emplace(id, uint32_t(Ordinals.size())).first;
+	}
+	outOrdinal = it->second;
+	return true;
+}
+
+void RadixSort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch)
+{
+	constexpr uint32_t DigitBits = 8;
+	constexpr uint32_t BucketCount = 1u << DigitBits;
+	constexpr uint32_t PassCount = 64 / DigitBits;
+
+	size_t const count = packets.size();
+	if (count < 2)
+		return;
+
+	// Histograms for every digit in a single read of the keys
+	std::array<std::array<uint32_t, BucketCount>, PassCount> histograms{};
+	for (auto& packet : packets)
+		for (uint32_t pass = 0; pass < PassCount; ++pass)
+			histograms[pass][(packet.Key >> (pass * DigitBits)) & (BucketCount - 1)]++;
+
+	scratch.resize(count);
+	DrawPacket* src = packets.data();
+	DrawPacket* dst = scratch.data();
+	for (uint32_t pass = 0; pass < PassCount; ++pass)
+	{
+		auto& histogram = histograms[pass];
+		uint32_t shift = pass * DigitBits;
+		// Every key shares this digit, the pass would be an identity permutation
+		if (histogram[(src[0].Key >> shift) & (BucketCount - 1)] == count)
+			continue;
+
+		uint32_t offset = 0;
+		for (auto& bucket : histogram)
+		{
+			uint32_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+		for (size_t i = 0; i < count; ++i)
+			dst[histogram[(src[i].Key >> shift) & (BucketCount - 1)]++] = src[i];
+		std::swap(src, dst);
+	}
+
+	if (src != packets.data())
+		packets.swap(scratch);
+}
+
+void BuildInstanceBatches(std::span<DrawPacket const> packets, uint64_t groupMask, std::vector<InstanceBatch>& outBatches)
+{
+	outBatches.clear();
+	for (uint32_t i = 0; i < packets.size(); ++i)
+	{
+		if (!outBatches.empty() && ((packets[i].Key ^ packets[i - 1].Key) & groupMask) == 0)
+			outBatches.back().InstanceCount++;
+		else
+			outBatches.push_back({ .FirstPacket = i, .InstanceCount = 1 });
+	}
+}
+
+void RenderQueue::PushMaterialMajor(uint32_t pipeline, uint64_t material, uint64_t vertexBuffer, uint64_t indexBuffer, float depth, uint32_t renderableIndex)
+{
+	uint32_t materialOrdinal, vertexBufferOrdinal, indexBufferOrdinal;
+	uint64_t key;
+	if (Materials.Map(material, materialOrdinal) && VertexBuffers.Map(vertexBuffer, vertexBufferOrdinal) && IndexBuffers.Map(indexBuffer, indexBufferOrdinal)
+		&& SortKey::MaterialMajor(pipeline, materialOrdinal, vertexBufferOrdinal, indexBufferOrdinal, depth, key))
+		Push(key, renderableIndex);
+	else
+		PushUnbatched(renderableIndex);
+}
+
+void RenderQueue::PushGeometryMajor(uint32_t pipeline, uint64_t vertexBuffer, uint64_t indexBuffer, float depth, uint32_t renderableIndex)
+{
+	uint32_t vertexBufferOrdinal, indexBufferOrdinal;
+	uint64_t key;
+	if (VertexBuffers.Map(vertexBuffer, vertexBufferOrdinal) && IndexBuffers.Map(indexBuffer, indexBufferOrdinal)
+		&& SortKey::GeometryMajor(pipeline, vertexBufferOrdinal, indexBufferOrdinal, depth, key))
+		Push(key, renderableIndex);
+	else
+		PushUnbatched(renderableIndex);
+}
+
+void RenderQueue::Sort()
+{
+	RadixSort(Packets, Scratch);
+	BuildInstanceBatches(Packets, SortKey::InstanceGroupMask, Batches);
+	// One instance each, their keys are never compared
+	for (uint32_t renderableIndex : Unbatched)
+	{
+		Batches.push_back({ .FirstPacket = uint32_t(Packets.size()), .InstanceCount = 1 });
+		Packets.push_back({ ~0ull, renderableIndex });
+	}
+	Stats.Unbatched = uint32_t(Unbatched.size());
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <unordered_map>
+
+namespace dxpg
+{
+
+struct DrawPacket
+{
+	uint64_t Key;
+	uint32_t RenderableIndex;
+};
+
+// 64-bit draw sort keys, the most significant fields change least often after sorting
+namespace SortKey
+{
+	constexpr uint32_t PipelineBits = 4;
+	constexpr uint32_t MaterialBits = 14;
+	constexpr uint32_t VertexBufferBits = 10;
+	constexpr uint32_t IndexBufferBits = 16;
+	constexpr uint32_t DepthBits = 20;
+	static_assert(PipelineBits + MaterialBits + VertexBufferBits + IndexBufferBits + DepthBits == 64);
+
+	// Depth is always the lowest field, packets equal above it can be drawn as instances of one draw
+	constexpr uint64_t InstanceGroupMask = ~((1ull << DepthBits) - 1);
+
+	// Monotonic quantization of a non-negative view depth, keeps the top bits of its float representation
+	// so no far plane is needed and precision is relative to the distance
+	uint32_t QuantizeDepth(float depth);
+
+	// pipeline | material | vertex buffer | index buffer | depth
+	// Returns false when a field does not fit its bits, the key would alias another batch
+	bool MaterialMajor(uint32_t pipeline, uint32_t material, uint32_t vertexBuffer, uint32_t indexBuffer, float depth, uint64_t& outKey);
+	// pipeline | vertex buffer | index buffer | depth, for depth only passes that ignore the material
+	bool GeometryMajor(uint32_t pipeline, uint32_t vertexBuffer, uint32_t indexBuffer, float depth, uint64_t& outKey);
+}
+
+// Numbers the ids pushed during one frame densely in first use order, so a key field only has to hold
+// the ids drawn together instead of every id ever allocated
+struct DenseKeyIds
+{
+	explicit DenseKeyIds(uint32_t bits) : Capacity(1ull << bits) {}
+
+	void Clear() { Ordinals.clear(); }
+	// False once every ordinal is taken by other ids
+	bool Map(uint64_t id, uint32_t& outOrdinal);
+
+private:
+	std::unordered_map<uint64_t, uint32_t> Ordinals;
+	uint64_t Capacity;
+};
+
+// Stable LSD radix sort on DrawPacket::Key, byte passes where every key has the same digit are skipped
+void RadixSort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch);
+
+// Run of sorted packets submitted as a single instanced draw, instance i is packet FirstPacket + i
+struct InstanceBatch
+{
+	uint32_t FirstPacket;
+	uint32_t InstanceCount;
+};
+
+// Merges adjacent packets whose keys are equal under groupMask
+void BuildInstanceBatches(std::span<DrawPacket const> packets, uint64_t groupMask, std::vector<InstanceBatch>& outBatches);
+
+struct RenderQueueStats
+{
+	uint32_t Draws = 0;
+	uint32_t Instances = 0;
+	uint32_t StateChanges = 0;
+	uint32_t StateChangesAvoided = 0;
+	// Packets whose ids did not fit the key, drawn without instancing
+	uint32_t Unbatched = 0;
+};
+
+struct RenderQueue
+{
+	void Clear()
+	{
+		Packets.clear();
+		Unbatched.clear();
+		Batches.clear();
+		Materials.Clear();
+		VertexBuffers.Clear();
+		IndexBuffers.Clear();
+		Stats = {};
+	}
+	void Push(uint64_t key, uint32_t renderableIndex) { Packets.push_back({ key, renderableIndex }); }
+	// Drawn as a batch of its own after the sorted packets
+	void PushUnbatched(uint32_t renderableIndex) { Unbatched.push_back(renderableIndex); }
+	// Key from the per-frame ordinals of the ids, falls back to an unbatched draw when they run out
+	void PushMaterialMajor(uint32_t pipeline, uint64_t material, uint64_t vertexBuffer, uint64_t indexBuffer, float depth, uint32_t renderableIndex);
+	void PushGeometryMajor(uint32_t pipeline, uint64_t vertexBuffer, uint64_t indexBuffer, float depth, uint32_t renderableIndex);
+	void Sort();
+
+	std::span<DrawPacket const> GetPackets() const { return Packets; }
+	std::span<InstanceBatch const> GetBatches() const { return Batches; }
+
+	// Filled in by the pass while it submits the queue
+	RenderQueueStats Stats;
+
+private:
+	std::vector<DrawPacket> Packets;
+	std::vector<DrawPacket> Scratch;
+	std::vector<uint32_t> Unbatched;
+	std::vector<InstanceBatch> Batches;
+	DenseKeyIds Materials{ SortKey::MaterialBits };
+	DenseKeyIds VertexBuffers{ SortKey::VertexBufferBits };
+	DenseKeyIds IndexBuffers{ SortKey::IndexBufferBits };
+};
+
+}
@@ -1,16 +1,16 @@
 #pragma once
 
 #include "DXHelpers.h"
+#include "Culling.h"
+#include "Meshlet.h"
+#include "VertexQuantization.h"
+#include "MeshLod.h"
 
 namespace dxpg
 {
 
-struct HLSL_VertexData
-{
-    uint32_t PositionIdx;
-    uint32_t NormalIdx;
-    uint32_t TexCoordIdx;
-};
+// Imported model positions are scaled by this factor when the vertex buffers are built
+constexpr float ModelPositionScale = 1.0f / 100.0f;
 
 struct ViewData
 {
@@ -21,15 +21,24 @@ struct ViewData
 	Vector4 Direction;
 };
 
+struct StagingRing;
+
+// Upper bound of the frames in flight, for per frame resources kept in fixed arrays
+constexpr uint32_t MaxFramesInFlight = 4;
+
 struct FrameContext
 {
     bool Ready = false;
+	// Index of the context among the frames in flight, stays the same for as long as the context exists
+	uint32_t Slot = 0;
     ComPtr<ID3D12CommandAllocator> CommandAllocator;
     UINT64                  FenceValue;
     std::unordered_map<D3D12_DESCRIPTOR_HEAP_TYPE, DescriptorHeapPage*> GPUHeapPages = {};
     std::unordered_map<DescriptorAllocation*, DescriptorAllocation> CPUViewsToGPUViews = {};
 
 	std::vector<ComPtr<ID3D12Resource>> IntermediateResources;
+	// Upload memory of the timeline submitting this context, see AllocateStaging
+	StagingRing* Staging = nullptr;
 
     DescriptorAllocation GetGPUAllocation(DescriptorAllocation* cpuAllocation)
     {
@@ -41,19 +50,62 @@ struct FrameContext
     }
 };
 
+// Shader resource view of a texture whose resource texture streaming replaces. Every change goes to the next descriptor,
+// so frames still in flight keep sampling the one they were recorded with
+struct TextureView
+{
+    // More than the frames in flight, a view changes once per frame at most
+    static constexpr uint32_t Versions = 4;
+    static constexpr uint32_t NotStreamed = ~0u;
+
+    DescriptorAllocation Descriptors;
+    uint32_t Current = 0;
+    bool Srgb = false;
+    uint32_t StreamedTexture = NotStreamed;
+
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle() { return Descriptors.GetGPUHandle(Current); }
+};
+
+// Texture of something drawn this frame, Pixels is the on-screen size of the object
+struct TextureUse
+{
+    TextureView* View;
+    float Pixels;
+};
+
 struct Renderable
 {
     std::string Name;
     D3D12_GPU_DESCRIPTOR_HANDLE MaterialInfo;
-	D3D12_GPU_DESCRIPTOR_HANDLE DiffuseTextureSRV;
-    D3D12_GPU_DESCRIPTOR_HANDLE VertexSRV;
-    D3D12_VERTEX_BUFFER_VIEW IndicesView;
+	// Read when the draw is recorded, streaming changes the descriptor without rebuilding renderables
+	TextureView* DiffuseTexture;
+	// Set for virtual diffuse textures only
+	D3D12_GPU_DESCRIPTOR_HANDLE ResidencyMap;
+    VertexFormat Format;
+    D3D12_VERTEX_BUFFER_VIEW VertexBufferView;
+    D3D12_INDEX_BUFFER_VIEW IndexBufferView;
+    uint32_t IndexCount;
+    // Added to the first index of every LOD and meshlet range
+    uint32_t FirstIndex;
+    int32_t BaseVertex;
+    std::span<MeshLod const> Lods;
+    std::span<Meshlet const> Meshlets;
     Matrix4x4 GlobalModelMatrix;
+    Matrix4x4 PositionDequantize;
+    DirectX::BoundingBox ObjectBounds;
+    DirectX::BoundingSphere ObjectSphere;
+    // Follow GlobalModelMatrix, the box is the object box' world space AABB
+    DirectX::BoundingBox WorldBounds;
+    DirectX::BoundingSphere WorldSphere;
+    uint32_t VertexCount;
+    uint32_t TriangleCount;
 
-	__forceinline uint32_t GetIndexCount() const
-	{
-		return IndicesView.SizeInBytes / sizeof(HLSL_VertexData);
-	}
+    // Dense ids used to build draw sort keys
+    uint32_t MaterialId;
+    uint32_t VertexBufferId;
+    uint32_t IndexBufferId;
+    // Copy queue fence value the frame has to wait for before it draws this
+    uint64_t UploadFence;
 };
 
 struct LightData
@@ -79,7 +131,9 @@ struct LightData
 
 struct SceneDataView
 {
-    std::vector<Renderable> RenderableList;
+    std::span<Renderable const> RenderableList;
+    // World space bounds of RenderableList, same order
+    BoundsSoA const* RenderableBounds = nullptr;
     LightData Light;
     ViewData LightView;
 };
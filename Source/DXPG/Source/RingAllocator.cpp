@@ -0,0 +1,92 @@
+#include "RingAllocator.h"
+
+#include <cassert>
+
+namespace dxpg
+{
+
+void RingAllocator::Init(uint64_t pageSize, uint32_t maxPages)
+{
+	assert(pageSize > 0 && maxPages > 0);
+	PageSize = pageSize;
+	MaxPages = maxPages;
+	Current = 0;
+	Pages.clear();
+}
+
+bool RingAllocator::Allocate(uint64_t size, uint64_t alignment, RingAllocation& outAllocation)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && PageSize % alignment == 0);
+	if (size == 0 || size > PageSize)
+		return false;
+
+	// The page of the last allocation first, it is the only one with open ranges most of the time
+	for (uint32_t i = 0; i < Pages.size(); ++i)
+	{
+		uint32_t index = (Current + i) % uint32_t(Pages.size());
+		if (AllocateFrom(Pages[index], size, alignment, outAllocation.Offset))
+		{
+			Current = index;
+			outAllocation.Page = index;
+			return true;
+		}
+	}
+	if (Pages.size() == MaxPages)
+		return false;
+
+	Current = uint32_t(Pages.size());
+	AllocateFrom(Pages.emplace_back(), size, alignment, outAllocation.Offset);
+	outAllocation.Page = Current;
+	return true;
+}
+
+bool RingAllocator::AllocateFrom(Page& page, uint64_t size, uint64_t alignment, uint64_t& outOffset)
+{
+	uint64_t position = (page.Head + alignment - 1) & ~(alignment - 1);
+	// A range never wraps around the end of the page, the rest of the page is skipped instead
+	if (position % PageSize + size > PageSize)
+		position = (position / PageSize + 1) * PageSize;
+	if (position + size - page.Tail > PageSize)
+		return false;
+
+	page.Head = position + size;
+	outOffset = position % PageSize;
+	return true;
+}
+
+void RingAllocator::Close(uint64_t fenceValue)
+{
+	for (auto& page : Pages)
+	{
+		uint64_t closedEnd = page.Closed.empty() ? page.Tail : page.Closed.back().second;
+		if (page.Head == closedEnd)
+			continue;
+		assert(page.Closed.empty() || page.Closed.back().first <= fenceValue);
+		page.Closed.emplace_back(fenceValue, page.Head);
+	}
+}
+
+void RingAllocator::Reclaim(uint64_t completedValue)
+{
+	for (auto& page : Pages)
+	{
+		while (!page.Closed.empty() && page.Closed.front().first <= completedValue)
+		{
+			page.Tail = page.Closed.front().second;
+			page.Closed.pop_front();
+		}
+		// Starting an idle page over saves skipping its end on the next wrap
+		if (page.Head == page.Tail)
+			page.Head = page.Tail = 0;
+	}
+}
+
+uint64_t RingAllocator::GetUsedBytes() const
+{
+	uint64_t used = 0;
+	for (auto& page : Pages)
+		used += page.Head - page.Tail;
+	return used;
+}
+
+}
\ No newline at end of file
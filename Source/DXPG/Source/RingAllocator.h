@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace dxpg
+{
+
+struct RingAllocation
+{
+	uint32_t Page = 0;
+	uint64_t Offset = 0;
+};
+
+// Hands out aligned ranges of fixed size pages front to back. The ranges allocated since the last Close are tagged with
+// the fence value of the submit consuming them and come back in order once that value completed
+struct RingAllocator
+{
+	// Alignments have to divide pageSize, pages are only added once the existing ones are full
+	void Init(uint64_t pageSize, uint32_t maxPages);
+
+	// Fails for sizes above a page and when every page is full of ranges still in flight
+	bool Allocate(uint64_t size, uint64_t alignment, RingAllocation& outAllocation);
+	void Close(uint64_t fenceValue);
+	void Reclaim(uint64_t completedValue);
+
+	uint64_t GetPageSize() const { return PageSize; }
+	uint32_t GetPageCount() const { return uint32_t(Pages.size()); }
+	// Bytes allocated and not reclaimed yet, alignment and wrap padding included
+	uint64_t GetUsedBytes() const;
+
+private:
+	struct Page
+	{
+		// Positions grow without wrapping, the offset into the page is the position modulo the page size
+		uint64_t Head = 0;
+		uint64_t Tail = 0;
+		// Fence value and end position of every closed batch of ranges
+		std::deque<std::pair<uint64_t, uint64_t>> Closed;
+	};
+
+	bool AllocateFrom(Page& page, uint64_t size, uint64_t alignment, uint64_t& outOffset);
+
+	uint64_t PageSize = 0;
+	uint32_t MaxPages = 0;
+	uint32_t Current = 0;
+	std::vector<Page> Pages;
+};
+
+}
\ No newline at end of file
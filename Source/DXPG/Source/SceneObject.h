@@ -2,6 +2,9 @@
 
 #include "Model.h"
 #include "RendererCommon.h"
+#include "TransformHierarchy.h"
+
+#include <list>
 
 namespace dxpg
 {
@@ -13,10 +16,12 @@ struct MeshObject
 	Vector4 Scale = { 1, 1, 1, 0 };
 
 	MeshObject* Parent = nullptr;
-	std::vector<MeshObject> Children;
+	// A list so AddObject can hand out pointers that stay valid while siblings are added
+	std::list<MeshObject> Children;
 	IndexedModel* IndexedModel = nullptr;
 	Material* Material = nullptr;
 	bool TransformOnly = true;
+	TransformHierarchy::NodeId TransformNode = TransformHierarchy::InvalidNode;
 
 	MeshObject(std::string name)
 		: Name(std::move(name)), TransformOnly(true)
@@ -30,7 +35,7 @@ struct MeshObject
 
 	Matrix4x4 LocalModelMatrix() const
 	{
-		return DirectX::XMMatrixAffineTransformation(Scale, { 0, 1, 0, 0 }, DirectX::XMQuaternionRotationRollPitchYawFromVector(Rotation), Position);
+		return ComposeLocalMatrix(Position, Rotation, Scale);
 	}
 
 	bool IsRenderable() const
@@ -38,17 +43,32 @@ struct MeshObject
 		return !TransformOnly && IndexedModel && Material;
 	}
 
-	Renderable ToRenderable(Matrix4x4 parentModel = DirectX::XMMatrixIdentity()) const
+	Renderable ToRenderable(Matrix4x4 const& globalModelMatrix) const
 	{
 		assert(!TransformOnly);
 		Renderable renderable{};
 		renderable.Name = Name;
-		renderable.GlobalModelMatrix = XMMatrixMultiply(parentModel, LocalModelMatrix());
+		renderable.GlobalModelMatrix = globalModelMatrix;
 		renderable.MaterialInfo = Material->MaterialInfo.GetGPUHandle();
-		if (Material->DiffuseTextureSRV)
-			renderable.DiffuseTextureSRV = Material->DiffuseTextureSRV->GetGPUHandle();
-		renderable.VertexSRV = IndexedModel->Model->VertexSRV.GetGPUHandle();
-		renderable.IndicesView = IndexedModel->IndicesView;
+		renderable.DiffuseTexture = Material->DiffuseTexture;
+		renderable.ResidencyMap = Material->ResidencyMap;
+		renderable.Format = IndexedModel->Model->Format;
+		renderable.VertexBufferView = IndexedModel->Model->VertexBufferView;
+		renderable.IndexBufferView = IndexedModel->IndexBufferView;
+		renderable.IndexCount = IndexedModel->IndexCount;
+		renderable.FirstIndex = IndexedModel->FirstIndex;
+		renderable.BaseVertex = IndexedModel->BaseVertex;
+		renderable.Lods = IndexedModel->Lods;
+		renderable.Meshlets = IndexedModel->Meshlets.Meshlets;
+		renderable.PositionDequantize = IndexedModel->PositionDequantize;
+		renderable.ObjectBounds = IndexedModel->Bounds;
+		renderable.ObjectSphere = IndexedModel->BoundingSphere;
+		renderable.VertexCount = IndexedModel->VertexCount;
+		renderable.TriangleCount = IndexedModel->TriangleCount;
+		renderable.MaterialId = Material->Id;
+		renderable.VertexBufferId = IndexedModel->Model->Vertices.Block;
+		renderable.IndexBufferId = IndexedModel->Id;
+		renderable.UploadFence = IndexedModel->UploadFence;
 		return renderable;
 	}
 };
@@ -3,53 +3,118 @@
 namespace dxpg
 {
 
+SceneTree::SceneTree()
+{
+	Root.TransformNode = Transforms.AddNode(TransformHierarchy::InvalidNode, Root.Position, Root.Rotation, Root.Scale);
+}
+
+MeshObject* SceneTree::AddObject(MeshObject const& object, MeshObject* parent)
+{
+	if (!parent)
+		parent = &Root;
+	auto& newObj = parent->Children.emplace_back(object);
+	newObj.Parent = parent;
+	RegisterTransforms(newObj, parent->TransformNode);
+	// Appended at the next Update, unless the parent is new as well and brings it along
+	if (parent->TransformNode < UpdatedNodeCount)
+		AddedObjects.push_back(&newObj);
+	return &newObj;
+}
 
-std::vector<Renderable> SceneTree::SceneToRenderableList() const
+void SceneTree::RegisterTransforms(MeshObject& object, TransformHierarchy::NodeId parentNode)
 {
-	std::vector<Renderable> renderables;
-	std::stack<Matrix4x4> matrixStack;
-	std::stack<std::pair<MeshObject const*, uint32_t>> objectStackAndDepth;
-	objectStackAndDepth.push({ &Root, 1 });
-	matrixStack.push(DirectX::XMMatrixIdentity());
-	uint32_t lastDepth = 1;
-	while (!objectStackAndDepth.empty())
+	object.TransformNode = Transforms.AddNode(parentNode, object.Position, object.Rotation, object.Scale);
+	for (auto& child : object.Children)
 	{
-		auto [current, depth] = objectStackAndDepth.top();
-		objectStackAndDepth.pop();
-		if (depth < lastDepth)
+		child.Parent = &object;
+		RegisterTransforms(child, object.TransformNode);
+	}
+}
+
+void SceneTree::OnTransformChanged(MeshObject const& object)
+{
+	Transforms.SetLocalTransform(object.TransformNode, object.Position, object.Rotation, object.Scale);
+}
+
+void SceneTree::Update()
+{
+	auto changedNodes = Transforms.Update();
+	UpdatedNodeCount = Transforms.Size();
+	if (StructureDirty)
+	{
+		RebuildRenderables();
+		AddedObjects.clear();
+		StructureDirty = false;
+		return;
+	}
+	// New nodes have no renderable yet, their world matrices are picked up when they are appended
+	NodeToRenderable.resize(Transforms.Size(), NoRenderable);
+	for (auto node : changedNodes)
+	{
+		uint32_t renderableIndex = NodeToRenderable[node];
+		if (renderableIndex != NoRenderable)
 		{
-			for (uint32_t i = 0; i < lastDepth - depth; ++i)
-				matrixStack.pop();
+			Renderables[renderableIndex].GlobalModelMatrix = Transforms.GetWorldMatrix(node);
+			UpdateWorldBounds(renderableIndex);
 		}
-		assert(matrixStack.size() == depth);
-		lastDepth = depth;
-		auto parentMatrix = matrixStack.top();
-		Matrix4x4 globalModelMatrix;
+	}
+
+	if (AddedObjects.empty())
+		return;
+	// Only the new subtrees are walked, progressive loading adds a few shapes per frame to a large scene
+	uint32_t firstAdded = static_cast<uint32_t>(Renderables.size());
+	for (auto* object : AddedObjects)
+		AppendRenderables(*object);
+	AddedObjects.clear();
+	RenderableBounds.Resize(Renderables.size());
+	for (uint32_t i = firstAdded; i < Renderables.size(); ++i)
+	{
+		UpdateWorldBounds(i);
+		Stats.Vertices += Renderables[i].VertexCount;
+		Stats.Triangles += Renderables[i].TriangleCount;
+	}
+}
+
+void SceneTree::AppendRenderables(MeshObject const& object)
+{
+	std::stack<MeshObject const*> objectStack;
+	objectStack.push(&object);
+	while (!objectStack.empty())
+	{
+		auto* current = objectStack.top();
+		objectStack.pop();
 		if (current->IsRenderable())
 		{
-			const Renderable& renderable = current->ToRenderable(parentMatrix);
-			renderables.push_back(renderable);
-			globalModelMatrix = renderable.GlobalModelMatrix;
-		}
-		else
-			globalModelMatrix = XMMatrixMultiply(parentMatrix, current->LocalModelMatrix());
-		if (current->Children.size() > 0)
-		{
-			matrixStack.push(globalModelMatrix);
-			for (auto& child : current->Children)
-				objectStackAndDepth.push({ &child, depth + 1 });
+			NodeToRenderable[current->TransformNode] = static_cast<uint32_t>(Renderables.size());
+			Renderables.push_back(current->ToRenderable(Transforms.GetWorldMatrix(current->TransformNode)));
 		}
+		for (auto& child : current->Children)
+			objectStack.push(&child);
 	}
-	return renderables;
 }
 
-MeshObject* SceneTree::AddObject(MeshObject const& object, MeshObject* parent)
+void SceneTree::UpdateWorldBounds(uint32_t renderableIndex)
 {
-	if (!parent)
-		parent = &Root;
-	auto& newObj = parent->Children.emplace_back(object);
-	newObj.Parent = parent;
-	return &newObj;
+	auto& renderable = Renderables[renderableIndex];
+	renderable.ObjectBounds.Transform(renderable.WorldBounds, renderable.GlobalModelMatrix);
+	renderable.ObjectSphere.Transform(renderable.WorldSphere, renderable.GlobalModelMatrix);
+	RenderableBounds.Set(renderableIndex, renderable.WorldBounds);
 }
 
-}
\ No newline at end of file
+void SceneTree::RebuildRenderables()
+{
+	Renderables.clear();
+	NodeToRenderable.assign(Transforms.Size(), NoRenderable);
+	AppendRenderables(Root);
+
+	RenderableBounds.Resize(Renderables.size());
+	Stats = {};
+	for (uint32_t i = 0; i < Renderables.size(); ++i)
+	{
+		UpdateWorldBounds(i);
+		Stats.Vertices += Renderables[i].VertexCount;
+		Stats.Triangles += Renderables[i].TriangleCount;
+	}
+}
+
+}
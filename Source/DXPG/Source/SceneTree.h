@@ -2,18 +2,57 @@
 
 #include "DXPGCommon.h"
 #include "SceneObject.h"
+#include "TransformHierarchy.h"
+#include "Culling.h"
 
 namespace dxpg
 {
 
+// Totals over the renderables at LOD 0
+struct SceneStats
+{
+	uint64_t Vertices = 0;
+	uint64_t Triangles = 0;
+};
+
 struct SceneTree
 {
-	MeshObject Root{ "Root" };
+	SceneTree();
 
-	std::vector<Renderable> SceneToRenderableList() const;
+	MeshObject Root{ "Root" };
 
 	MeshObject* AddObject(MeshObject const& object, MeshObject* parent = nullptr);
 
+	// Call after editing an object's Position, Rotation or Scale
+	void OnTransformChanged(MeshObject const& object);
+	// Call after changing which objects are renderable (e.g. toggling TransformOnly), rebuilds the renderable list
+	void OnStructureChanged() { StructureDirty = true; }
+
+	// Recomputes dirty world matrices, patches the renderable list in place and appends the objects added since the last call
+	void Update();
+
+	std::span<Renderable const> GetRenderables() const { return Renderables; }
+	BoundsSoA const& GetRenderableBounds() const { return RenderableBounds; }
+	SceneStats const& GetStats() const { return Stats; }
+
+private:
+	void RegisterTransforms(MeshObject& object, TransformHierarchy::NodeId parentNode);
+	void RebuildRenderables();
+	void AppendRenderables(MeshObject const& object);
+	void UpdateWorldBounds(uint32_t renderableIndex);
+
+	static constexpr uint32_t NoRenderable = ~0u;
+
+	TransformHierarchy Transforms;
+	std::vector<Renderable> Renderables;
+	BoundsSoA RenderableBounds;
+	std::vector<uint32_t> NodeToRenderable;
+	SceneStats Stats;
+	// Subtrees added since the last Update, AddObject keeps them in place
+	std::vector<MeshObject const*> AddedObjects;
+	// Transform nodes that existed at the last Update, a node at or past it was added since
+	size_t UpdatedNodeCount = 0;
+	bool StructureDirty = true;
 };
 
-}
\ No newline at end of file
+}
@@ -13,7 +13,7 @@ ShaderManager::ShaderManager()
 	ThrowIfFailed(Utils->CreateDefaultIncludeHandler(&IncludeHandler));
 }
 
-Shader* ShaderManager::CompileShader(std::wstring_view name, std::wstring_view shaderPath, ShaderType type, std::wstring_view entryPoint, std::span<const std::wstring_view> includeFolders)
+Shader* ShaderManager::CompileShader(std::wstring_view name, std::wstring_view shaderPath, ShaderType type, std::wstring_view entryPoint, std::span<const std::wstring_view> includeFolders, std::span<const std::wstring_view> defines)
 {
 	LPCWSTR shaderType = nullptr;
 	switch (type)
@@ -44,6 +44,12 @@ Shader* ShaderManager::CompileShader(std::wstring_view name, std::wstring_view s
 		compilationArgs.push_back(includeFolder.data());
 	}
 
+	for (auto& define : defines)
+	{
+		compilationArgs.push_back(L"-D");
+		compilationArgs.push_back(define.data());
+	}
+
 	if constexpr (_DEBUG)
 		compilationArgs.push_back(DXC_ARG_DEBUG);
 	else
@@ -14,7 +14,7 @@ struct ShaderManager : Singleton<ShaderManager>
 {
 	ShaderManager();
 	
-	Shader* CompileShader(std::wstring_view name, std::wstring_view shaderPath, ShaderType type, std::wstring_view entryPoint = L"main", std::span<const std::wstring_view> includeFolders = {});
+	Shader* CompileShader(std::wstring_view name, std::wstring_view shaderPath, ShaderType type, std::wstring_view entryPoint = L"main", std::span<const std::wstring_view> includeFolders = {}, std::span<const std::wstring_view> defines = {});
 
 	std::unordered_map<std::wstring, std::unique_ptr<Shader>> LoadedShaders;
 
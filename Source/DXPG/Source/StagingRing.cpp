@@ -0,0 +1,69 @@
+#include "StagingRing.h"
+
+namespace dxpg
+{
+
+void StagingRing::Init(ID3D12Device* device, std::wstring name, uint64_t pageSize, uint32_t maxPages)
+{
+	Device = device;
+	Name = std::move(name);
+	Ring.Init(pageSize, maxPages);
+	Stats = {};
+	Stats.CapacityBytes = pageSize * maxPages;
+}
+
+void StagingRing::Shutdown()
+{
+	for (auto& page : Pages)
+		page.Unmap();
+	Pages.clear();
+	MappedPages.clear();
+	Ring = {};
+}
+
+bool StagingRing::Allocate(uint64_t size, uint64_t alignment, StagingAllocation& outAllocation)
+{
+	RingAllocation allocation;
+	if (!Ring.Allocate(size, alignment, allocation))
+	{
+		Stats.DedicatedAllocations++;
+		Stats.DedicatedBytes += size;
+		return false;
+	}
+	// Pages stay mapped for their whole life, upload heaps allow it
+	while (Pages.size() < Ring.GetPageCount())
+	{
+		auto& page = Pages.emplace_back(DXBuffer::Create(Device, Name + L"_Page" + std::to_wstring(Pages.size()), Ring.GetPageSize(), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ));
+		MappedPages.push_back(page.Map<std::byte>());
+	}
+
+	outAllocation.Resource = Pages[allocation.Page].Resource.Get();
+	outAllocation.Offset = allocation.Offset;
+	outAllocation.Data = MappedPages[allocation.Page] + allocation.Offset;
+	Stats.RingAllocations++;
+	Stats.RingBytes += size;
+	return true;
+}
+
+StagingStats StagingRing::GetStats() const
+{
+	StagingStats stats = Stats;
+	stats.UsedBytes = Ring.GetUsedBytes();
+	return stats;
+}
+
+StagingAllocation AllocateStaging(ID3D12Device* device, FrameContext& frameCtx, uint64_t size, uint64_t alignment)
+{
+	StagingAllocation allocation;
+	if (frameCtx.Staging && frameCtx.Staging->Allocate(size, alignment, allocation))
+		return allocation;
+
+	auto buffer = DXBuffer::Create(device, L"DedicatedStagingBuffer", size, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+	frameCtx.IntermediateResources.push_back(buffer.Resource);
+	allocation.Resource = buffer.Resource.Get();
+	allocation.Offset = 0;
+	allocation.Data = buffer.Map<std::byte>();
+	return allocation;
+}
+
+}
\ No newline at end of file
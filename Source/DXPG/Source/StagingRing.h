@@ -0,0 +1,58 @@
+#pragma once
+
+#include "DXHelpers.h"
+#include "DXResource.h"
+#include "RendererCommon.h"
+#include "RingAllocator.h"
+
+namespace dxpg
+{
+
+// Persistently mapped upload memory, valid until the submit it was recorded for completed
+struct StagingAllocation
+{
+	ID3D12Resource* Resource = nullptr;
+	uint64_t Offset = 0;
+	std::byte* Data = nullptr;
+
+	D3D12_GPU_VIRTUAL_ADDRESS GPUAddress() const { return Resource->GetGPUVirtualAddress() + Offset; }
+};
+
+struct StagingStats
+{
+	uint64_t RingAllocations = 0;
+	uint64_t RingBytes = 0;
+	// Uploads too large for a page or made while every page was in flight
+	uint64_t DedicatedAllocations = 0;
+	uint64_t DedicatedBytes = 0;
+	uint64_t UsedBytes = 0;
+	uint64_t CapacityBytes = 0;
+};
+
+// Upload pages of one fence timeline, the owner closes them with the fence value of every submit and reclaims them
+// with its completed value. Frame contexts point to the ring of whoever submits them
+struct StagingRing
+{
+	void Init(ID3D12Device* device, std::wstring name, uint64_t pageSize, uint32_t maxPages);
+	void Shutdown();
+
+	// Failures count as dedicated uploads, callers fall back to a buffer of their own
+	bool Allocate(uint64_t size, uint64_t alignment, StagingAllocation& outAllocation);
+	void Close(uint64_t fenceValue) { Ring.Close(fenceValue); }
+	void Reclaim(uint64_t completedValue) { Ring.Reclaim(completedValue); }
+
+	StagingStats GetStats() const;
+
+private:
+	ID3D12Device* Device = nullptr;
+	std::wstring Name;
+	RingAllocator Ring;
+	std::vector<DXBuffer> Pages;
+	std::vector<std::byte*> MappedPages;
+	StagingStats Stats;
+};
+
+// Sub-allocates from the context's ring. Without one, or when it is full, the upload gets a buffer of its own the context keeps alive
+StagingAllocation AllocateStaging(ID3D12Device* device, FrameContext& frameCtx, uint64_t size, uint64_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "StaticBatching.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+#include "MeshLod.h"
+#include "Meshlet.h"
+#include "Parallel.h"
+
+namespace dxpg
+{
+
+void GatherStaticInstances(CookedModel const& model, std::vector<StaticBatchInstance>& outInstances)
+{
+	if (model.Nodes.empty())
+	{
+		for (uint32_t shapeIndex = 0; shapeIndex < model.Shapes.size(); ++shapeIndex)
+			outInstances.push_back({ shapeIndex, XMMatrixIdentity() });
+		return;
+	}
+
+	// Parents come first, so their world matrix is always known
+	std::vector<Matrix4x4> worldMatrices(model.Nodes.size());
+	for (size_t nodeIndex = 0; nodeIndex < model.Nodes.size(); ++nodeIndex)
+	{
+		auto& node = model.Nodes[nodeIndex];
+		Matrix4x4 local = XMMatrixAffineTransformation(XMLoadFloat3(&node.Scale), XMVectorZero(), node.Rotation, XMLoadFloat3(&node.Translation));
+		worldMatrices[nodeIndex] = node.Parent >= 0 ? XMMatrixMultiply(local, worldMatrices[node.Parent]) : local;
+		for (uint32_t shapeIndex = node.FirstShape; shapeIndex < node.FirstShape + node.ShapeCount; ++shapeIndex)
+			outInstances.push_back({ shapeIndex, worldMatrices[nodeIndex] });
+	}
+}
+
+static void DecodeVertices(CookedModel const& model, CookedShape const& shape, std::vector<MeshVertex>& outVertices)
+{
+	auto bytes = model.Vertices.subspan(size_t(shape.BaseVertex) * model.VertexStride, size_t(shape.VertexCount) * model.VertexStride);
+	for (uint32_t i = 0; i < shape.VertexCount; ++i)
+	{
+		if (model.Format == VertexFormat::Quantized)
+		{
+			QuantizedMeshVertex quantized;
+			std::memcpy(&quantized, bytes.data() + size_t(i) * model.VertexStride, sizeof(quantized));
+			outVertices.push_back(DequantizeVertex(quantized, shape.Bounds));
+		}
+		else
+		{
+			MeshVertex vertex;
+			std::memcpy(&vertex, bytes.data() + size_t(i) * model.VertexStride, sizeof(vertex));
+			outVertices.push_back(vertex);
+		}
+	}
+}
+
+// LOD 0 of the shape, offset by baseVertex
+static void AppendIndices(CookedShape const& shape, uint32_t baseVertex, bool flipWinding, std::vector<uint32_t>& outIndices)
+{
+	MeshLod lod = shape.Lods.empty() ? MeshLod{ 0, static_cast<uint32_t>(shape.Indices.size() / shape.IndexStride), 0.0f } : shape.Lods[0];
+	size_t first = outIndices.size();
+	for (uint32_t i = lod.FirstIndex; i < lod.FirstIndex + lod.IndexCount; ++i)
+	{
+		uint32_t index = 0;
+		std::memcpy(&index, shape.Indices.data() + size_t(i) * shape.IndexStride, shape.IndexStride);
+		outIndices.push_back(baseVertex + index);
+	}
+	if (flipWinding)
+	{
+		for (size_t i = first; i + 2 < outIndices.size(); i += 3)
+			std::swap(outIndices[i + 1], outIndices[i + 2]);
+	}
+}
+
+static void BuildBatch(CookedModel const& source, std::span<StaticBatchInstance const> instances, StaticBatches::Batch& batch)
+{
+	std::vector<MeshVertex> shapeVertices;
+	for (uint32_t instanceIndex : batch.Instances)
+	{
+		auto& instance = instances[instanceIndex];
+		auto& shape = source.Shapes[instance.Shape];
+		shapeVertices.clear();
+		DecodeVertices(source, shape, shapeVertices);
+
+		// Normals go through the inverse transpose, mirroring transforms flip the triangles back to front facing
+		Matrix4x4 normalMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, instance.Transform));
+		float determinant = XMVectorGetX(XMVector3Dot(instance.Transform.r[0], XMVector3Cross(instance.Transform.r[1], instance.Transform.r[2])));
+		uint32_t baseVertex = static_cast<uint32_t>(batch.Vertices.size());
+		for (auto vertex : shapeVertices)
+		{
+			XMStoreFloat3(&vertex.Position, XMVector3TransformCoord(XMLoadFloat3(&vertex.Position), instance.Transform));
+			XMStoreFloat3(&vertex.Normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.Normal), normalMatrix)));
+			batch.Vertices.push_back(vertex);
+		}
+		AppendIndices(shape, baseVertex, determinant < 0.0f, batch.Indices);
+	}
+	batch.VertexCount = static_cast<uint32_t>(batch.Vertices.size());
+
+	// Meshlets only cover LOD 0, the coarser levels are appended behind it
+	BuildMeshlets(batch.Indices, batch.Vertices, batch.Meshlets);
+	BuildLodChain(batch.Indices, batch.Vertices, batch.Lods);
+	ComputeMeshBounds(batch.Vertices, batch.Bounds, batch.BoundingSphere);
+	if (FitsIndex16(batch.VertexCount))
+		NarrowIndices(batch.Indices, batch.Indices16);
+}
+
+void BuildStaticBatches(CookedModel const& source, std::span<StaticBatchInstance const> instances, StaticBatchSettings const& settings, StaticBatches& outBatches)
+{
+	auto batchStart = std::chrono::high_resolution_clock::now();
+
+	// Sort the instances by material, then by the cell their world space center falls into
+	using BatchKey = std::tuple<int32_t, int32_t, int32_t, int32_t>;
+	std::vector<BatchKey> keys(instances.size());
+	for (size_t instanceIndex = 0; instanceIndex < instances.size(); ++instanceIndex)
+	{
+		auto& instance = instances[instanceIndex];
+		auto& shape = source.Shapes[instance.Shape];
+		DirectX::BoundingBox worldBounds;
+		shape.Bounds.Transform(worldBounds, instance.Transform);
+		auto cell = [&](float center)
+		{
+			return static_cast<int32_t>(std::floor(center / settings.CellSize));
+		};
+		keys[instanceIndex] = { shape.MaterialIndex, cell(worldBounds.Center.x), cell(worldBounds.Center.y), cell(worldBounds.Center.z) };
+	}
+	std::vector<uint32_t> order(instances.size());
+	for (uint32_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		return keys[a] < keys[b];
+	});
+
+	// Instances larger than MaxVertices get a batch of their own
+	auto& batches = outBatches.Batches;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		uint32_t instanceIndex = order[i];
+		uint32_t vertexCount = source.Shapes[instances[instanceIndex].Shape].VertexCount;
+		bool sameCell = i > 0 && keys[order[i - 1]] == keys[instanceIndex];
+		if (batches.empty() || !sameCell || batches.back().VertexCount + vertexCount > settings.MaxVertices)
+		{
+			auto& batch = batches.emplace_back();
+			batch.MaterialIndex = std::get<0>(keys[instanceIndex]);
+		}
+		batches.back().Instances.push_back(instanceIndex);
+		batches.back().VertexCount += vertexCount;
+	}
+
+	ParallelFor(batches.size(), [&](size_t batchIndex)
+	{
+		BuildBatch(source, instances, batches[batchIndex]);
+	});
+
+	// Pack the batches into one vertex buffer like the importer packs shapes
+	auto& cooked = outBatches.Model;
+	auto& stats = cooked.Stats;
+	stats = source.Stats;
+	stats.UniqueVertices = stats.Triangles = stats.LodTriangles = stats.Meshlets = stats.Index16Shapes = stats.Index32Shapes = 0;
+	cooked.Format = source.Format;
+	cooked.VertexStride = source.VertexStride;
+	cooked.Materials = source.Materials;
+	std::vector<MeshVertex> vertices;
+	std::vector<QuantizedMeshVertex> quantizedVertices;
+	QuantizationError quantizationError;
+	std::vector<uint32_t> materialBatches(source.Materials.size() + 1, 0);
+	for (auto& batch : batches)
+	{
+		auto& materialBatch = materialBatches[batch.MaterialIndex < 0 ? source.Materials.size() : batch.MaterialIndex];
+		std::string materialName = batch.MaterialIndex < 0 ? "NoMaterial" : std::string(source.Materials[batch.MaterialIndex].Name);
+		batch.Name = materialName + "_Batch" + std::to_string(materialBatch++);
+		batch.BaseVertex = static_cast<uint32_t>(vertices.size() + quantizedVertices.size());
+		if (cooked.Format == VertexFormat::Quantized)
+			QuantizeVertices(batch.Vertices, batch.Bounds, quantizedVertices, quantizationError);
+		else
+			vertices.insert(vertices.end(), batch.Vertices.begin(), batch.Vertices.end());
+		batch.Vertices = {};
+
+		uint32_t lod0IndexCount = batch.Lods[0].IndexCount;
+		stats.UniqueVertices += batch.VertexCount;
+		stats.Triangles += lod0IndexCount / 3;
+		stats.LodTriangles += static_cast<uint32_t>(batch.Indices.size()) / 3 - lod0IndexCount / 3;
+		stats.Meshlets += static_cast<uint32_t>(batch.Meshlets.Meshlets.size());
+		if (!batch.Indices16.empty())
+			stats.Index16Shapes++;
+		else
+			stats.Index32Shapes++;
+	}
+	auto vertexBytes = cooked.Format == VertexFormat::Quantized ? std::as_bytes(std::span(quantizedVertices)) : std::as_bytes(std::span(vertices));
+	outBatches.Vertices.assign(vertexBytes.begin(), vertexBytes.end());
+	cooked.Vertices = outBatches.Vertices;
+	stats.VertexBufferBytes = static_cast<uint32_t>(outBatches.Vertices.size());
+
+	for (auto& batch : batches)
+	{
+		bool narrow = !batch.Indices16.empty();
+		cooked.Shapes.push_back({
+			.Name = batch.Name,
+			.MaterialIndex = batch.MaterialIndex,
+			.BaseVertex = batch.BaseVertex,
+			.VertexCount = batch.VertexCount,
+			.IndexStride = narrow ? uint32_t(sizeof(uint16_t)) : uint32_t(sizeof(uint32_t)),
+			.Indices = narrow ? std::as_bytes(std::span(batch.Indices16)) : std::as_bytes(std::span(batch.Indices)),
+			.Lods = batch.Lods,
+			.Meshlets = batch.Meshlets.Meshlets,
+			.MeshletVertices = batch.Meshlets.Vertices,
+			.MeshletTriangles = batch.Meshlets.Triangles,
+			.Bounds = batch.Bounds,
+			.BoundingSphere = batch.BoundingSphere });
+	}
+	stats.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - batchStart).count();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "MeshCache.h"
+
+namespace dxpg
+{
+
+struct StaticBatchSettings
+{
+	// Instances sharing a material are merged per cell of this size, every cell keeps its own bounds for culling
+	float CellSize = 8.0f;
+	// A batch is closed before it grows past this, the default keeps batches on 16 bit indices
+	uint32_t MaxVertices = 1 << 16;
+};
+
+// One placement of a cooked shape in the scene
+struct StaticBatchInstance
+{
+	uint32_t Shape;
+	Matrix4x4 Transform;
+};
+
+// Owns everything a batched CookedModel points to, except for the materials which still point into the source model
+struct StaticBatches
+{
+	struct Batch
+	{
+		std::string Name;
+		int32_t MaterialIndex = -1;
+		// Into the instances passed to BuildStaticBatches
+		std::vector<uint32_t> Instances;
+		std::vector<MeshVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		std::vector<uint16_t> Indices16;
+		std::vector<MeshLod> Lods;
+		MeshletData Meshlets;
+		uint32_t BaseVertex = 0;
+		uint32_t VertexCount = 0;
+		DirectX::BoundingBox Bounds{};
+		DirectX::BoundingSphere BoundingSphere{};
+	};
+
+	std::vector<std::byte> Vertices;
+	std::vector<Batch> Batches;
+	CookedModel Model;
+};
+
+// Every shape once at the identity for models without nodes, otherwise every shape of every node at the node's world transform
+void GatherStaticInstances(CookedModel const& model, std::vector<StaticBatchInstance>& outInstances);
+
+// Merges the instances sharing a material and a cell into one shape each, with their transforms baked into the vertices.
+// The merged shapes get new LOD chains and meshlets, outBatches.Model has no nodes and the source's vertex format
+void BuildStaticBatches(CookedModel const& source, std::span<StaticBatchInstance const> instances, StaticBatchSettings const& settings, StaticBatches& outBatches);
+
+}
\ No newline at end of file
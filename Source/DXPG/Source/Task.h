@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace dxpg
+{
+
+template<typename T>
+struct Task;
+
+namespace TaskDetail
+{
+struct PromiseBase
+{
+	// Resumed when the task finishes, symmetric transfer keeps long await chains off the stack
+	std::coroutine_handle<> Continuation = std::noop_coroutine();
+	std::exception_ptr Exception;
+
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept { return false; }
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept { return handle.promise().Continuation; }
+		void await_resume() noexcept {}
+	};
+
+	std::suspend_always initial_suspend() noexcept { return {}; }
+	FinalAwaiter final_suspend() noexcept { return {}; }
+	void unhandled_exception() { Exception = std::current_exception(); }
+};
+
+template<typename T>
+struct Promise : PromiseBase
+{
+	std::optional<T> Value;
+
+	Task<T> get_return_object();
+	template<typename U>
+	void return_value(U&& value) { Value.emplace(std::forward<U>(value)); }
+	T Result()
+	{
+		if (Exception)
+			std::rethrow_exception(Exception);
+		return std::move(*Value);
+	}
+};
+
+template<>
+struct Promise<void> : PromiseBase
+{
+	Task<void> get_return_object();
+	void return_void() {}
+	void Result()
+	{
+		if (Exception)
+			std::rethrow_exception(Exception);
+	}
+};
+}
+
+// Lazily started coroutine, the body runs once the task is awaited and the awaiter resumes when it returns
+template<typename T = void>
+struct Task
+{
+	using promise_type = TaskDetail::Promise<T>;
+	using Handle = std::coroutine_handle<promise_type>;
+
+	Task() = default;
+	explicit Task(Handle handle) : Coroutine(handle) {}
+	Task(Task const&) = delete;
+	Task& operator=(Task const&) = delete;
+	Task(Task&& other) noexcept : Coroutine(std::exchange(other.Coroutine, {})) {}
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (Coroutine)
+				Coroutine.destroy();
+			Coroutine = std::exchange(other.Coroutine, {});
+		}
+		return *this;
+	}
+	~Task()
+	{
+		if (Coroutine)
+			Coroutine.destroy();
+	}
+
+	bool IsValid() const { return bool(Coroutine); }
+	bool IsDone() const { return Coroutine && Coroutine.done(); }
+
+	auto operator co_await() && noexcept
+	{
+		struct Awaiter
+		{
+			Handle Coroutine;
+			bool await_ready() noexcept { return !Coroutine || Coroutine.done(); }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+			{
+				Coroutine.promise().Continuation = awaiting;
+				return Coroutine;
+			}
+			T await_resume() { return Coroutine.promise().Result(); }
+		};
+		assert(Coroutine);
+		return Awaiter{ Coroutine };
+	}
+
+private:
+	Handle Coroutine;
+};
+
+namespace TaskDetail
+{
+template<typename T>
+Task<T> Promise<T>::get_return_object()
+{
+	return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object()
+{
+	return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+}
+
+}
\ No newline at end of file
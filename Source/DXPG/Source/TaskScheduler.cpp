@@ -0,0 +1,127 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+namespace dxpg
+{
+
+namespace
+{
+// Owns a spawned task until it finishes, the frame frees itself at the end
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+DetachedTask RunDetached(Task<void> task, std::atomic<size_t>& active)
+{
+	co_await std::move(task);
+	active--;
+}
+}
+
+void TaskScheduler::Init(size_t workerCount)
+{
+	if (workerCount == 0)
+		workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	Stopping = false;
+	Cancelling = false;
+	for (size_t i = 0; i < workerCount; ++i)
+		Workers.emplace_back([this]() { WorkerLoop(); });
+}
+
+void TaskScheduler::Shutdown()
+{
+	assert(Active == 0);
+	{
+		std::lock_guard lock(WorkerMutex);
+		Stopping = true;
+	}
+	WorkerWake.notify_all();
+	for (auto& worker : Workers)
+		worker.join();
+	Workers.clear();
+}
+
+void TaskScheduler::ScheduleAwaiter::await_suspend(std::coroutine_handle<> coroutine)
+{
+	// The awaiter lives in the coroutine frame, which a worker may resume and free as soon as the lock is released
+	TaskScheduler* scheduler = Scheduler;
+	if (MainThread)
+	{
+		std::lock_guard lock(scheduler->MainMutex);
+		scheduler->MainQueue.push_back(coroutine);
+		return;
+	}
+	{
+		std::lock_guard lock(scheduler->WorkerMutex);
+		scheduler->WorkerQueue.push_back(coroutine);
+	}
+	scheduler->WorkerWake.notify_one();
+}
+
+void TaskScheduler::FenceAwaiter::await_suspend(std::coroutine_handle<> coroutine)
+{
+	std::lock_guard lock(Scheduler->MainMutex);
+	Scheduler->FenceWaits.push_back({ Fence, Value, coroutine });
+}
+
+void TaskScheduler::Spawn(Task<void> task)
+{
+	Active++;
+	RunDetached(std::move(task), Active);
+}
+
+void TaskScheduler::Pump()
+{
+	// Only what is ready now runs, tasks that queue themselves again wait for the next frame
+	std::vector<std::coroutine_handle<>> ready;
+	{
+		std::lock_guard lock(MainMutex);
+		ready.swap(MainQueue);
+		std::erase_if(FenceWaits, [&](FenceWait const& wait)
+		{
+			if (wait.Fence->CompletedValue() < wait.Value)
+				return false;
+			ready.push_back(wait.Coroutine);
+			return true;
+		});
+	}
+	for (auto coroutine : ready)
+		coroutine.resume();
+}
+
+void TaskScheduler::RunUntilIdle()
+{
+	while (Active > 0)
+	{
+		Pump();
+		std::this_thread::yield();
+	}
+}
+
+void TaskScheduler::WorkerLoop()
+{
+	while (true)
+	{
+		std::coroutine_handle<> coroutine;
+		{
+			std::unique_lock lock(WorkerMutex);
+			WorkerWake.wait(lock, [this]() { return Stopping || !WorkerQueue.empty(); });
+			if (WorkerQueue.empty())
+				return;
+			coroutine = WorkerQueue.front();
+			WorkerQueue.pop_front();
+		}
+		coroutine.resume();
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Task.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dxpg
+{
+
+// Timeline of submitted GPU work, tasks wait on it until their uploads are complete
+struct FenceTimeline
+{
+	virtual ~FenceTimeline() = default;
+	virtual uint64_t CompletedValue() = 0;
+};
+
+// Runs coroutine tasks on a worker pool and on the main thread. Tasks hop between the two with the awaitables below,
+// main thread work only runs inside Pump so it interleaves with the frame loop
+struct TaskScheduler
+{
+	// 0 workers leaves one hardware thread to the main thread
+	void Init(size_t workerCount = 0);
+	// Spawned tasks have to be finished, see RunUntilIdle
+	void Shutdown();
+
+	struct ScheduleAwaiter
+	{
+		TaskScheduler* Scheduler;
+		bool MainThread;
+		bool await_ready() noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> coroutine);
+		void await_resume() noexcept {}
+	};
+
+	struct FenceAwaiter
+	{
+		TaskScheduler* Scheduler;
+		FenceTimeline* Fence;
+		uint64_t Value;
+		bool await_ready() noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> coroutine);
+		void await_resume() noexcept {}
+	};
+
+	// Continues the awaiting task on a worker thread
+	ScheduleAwaiter ResumeOnWorker() { return { this, false }; }
+	// Continues the awaiting task on the main thread during the next Pump
+	ScheduleAwaiter ResumeOnMainThread() { return { this, true }; }
+	// Continues the awaiting task on the main thread once the fence has reached value
+	FenceAwaiter WaitForFence(FenceTimeline& fence, uint64_t value) { return { this, &fence, value }; }
+
+	// Starts a task nobody awaits, it runs on the calling thread until it first suspends
+	void Spawn(Task<void> task);
+	// Called once per frame on the main thread, resumes the tasks queued for it and those whose fences completed
+	void Pump();
+	// Pumps until every spawned task has finished
+	void RunUntilIdle();
+	// Asks running tasks to wrap up early, they check Cancelled after they resume. Stays set until the next Init
+	void Cancel() { Cancelling = true; }
+	bool Cancelled() const { return Cancelling; }
+
+	size_t ActiveTasks() const { return Active; }
+	size_t WorkerCount() const { return Workers.size(); }
+
+private:
+	struct FenceWait
+	{
+		FenceTimeline* Fence;
+		uint64_t Value;
+		std::coroutine_handle<> Coroutine;
+	};
+
+	void WorkerLoop();
+
+	std::vector<std::thread> Workers;
+	std::mutex WorkerMutex;
+	std::condition_variable WorkerWake;
+	std::deque<std::coroutine_handle<>> WorkerQueue;
+	bool Stopping = false;
+
+	std::mutex MainMutex;
+	std::vector<std::coroutine_handle<>> MainQueue;
+	std::vector<FenceWait> FenceWaits;
+
+	std::atomic<size_t> Active = 0;
+	std::atomic<bool> Cancelling = false;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "TextureCache.h"
+#include "Hash.h"
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+
+namespace dxpg
+{
+
+namespace
+{
+constexpr uint32_t TextureCacheMagic = 0x43545844; // "DXTC"
+// Layout of the file itself, TextureImporterVersion covers its content
+constexpr uint32_t TextureCacheFormatVersion = 2;
+
+struct FileHeader
+{
+	uint32_t Magic;
+	uint32_t FormatVersion;
+	uint32_t ImporterVersion;
+	uint32_t Compression;
+	uint32_t AlphaOnly;
+	uint32_t GenerateMips;
+	uint64_t SourceSize;
+	int64_t SourceWriteTime;
+	uint64_t SourceHash;
+	uint32_t Format;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t MipCount;
+	double SquaredError;
+	uint64_t Samples;
+	uint64_t UncompressedBytes;
+	uint64_t ContentHash;
+	// Aligned to TexturePlacementAlignment, so the payload of a mapped file keeps the footprint alignment
+	uint64_t PayloadOffset;
+	uint64_t PayloadSize;
+};
+
+static_assert(std::is_trivially_copyable_v<FileHeader>);
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+uint64_t HashCookedTexture(CookedTexture const& texture)
+{
+	uint64_t shape[] = { uint64_t(texture.Format), uint64_t(texture.Width()) << 32 | texture.Height(), texture.Footprints.size() };
+	return HashBytes(texture.Payload, HashBytes(std::as_bytes(std::span(shape))));
+}
+}
+
+TexelFormat ToTexelFormat(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1: return TexelFormat::BC1;
+	case BlockFormat::BC3: return TexelFormat::BC3;
+	case BlockFormat::BC4: return TexelFormat::BC4;
+	case BlockFormat::BC7: return TexelFormat::BC7;
+	default: assert(false); return TexelFormat::RGBA8;
+	}
+}
+
+BlockFormat ToBlockFormat(TexelFormat format)
+{
+	assert(IsBlockCompressed(format));
+	return BlockFormat(uint32_t(format) - uint32_t(TexelFormat::BC1));
+}
+
+uint32_t TexelFormatBytes(TexelFormat format)
+{
+	switch (format)
+	{
+	case TexelFormat::RGBA8: return 4;
+	case TexelFormat::R8: return 1;
+	default: return BlockBytes(ToBlockFormat(format));
+	}
+}
+
+uint64_t ComputeTextureFootprints(TexelFormat format, uint32_t width, uint32_t height, uint32_t mipCount, std::vector<TextureFootprint>& outFootprints)
+{
+	uint32_t blockSize = IsBlockCompressed(format) ? 4 : 1;
+	uint32_t unitBytes = TexelFormatBytes(format);
+	outFootprints.clear();
+	uint64_t size = 0;
+	for (uint32_t level = 0; level < mipCount; ++level)
+	{
+		auto& footprint = outFootprints.emplace_back();
+		footprint.Offset = AlignUp(size, TexturePlacementAlignment);
+		footprint.Width = std::max(width >> level, 1u);
+		footprint.Height = std::max(height >> level, 1u);
+		footprint.RowBytes = (footprint.Width + blockSize - 1) / blockSize * unitBytes;
+		footprint.RowPitch = uint32_t(AlignUp(footprint.RowBytes, TextureRowPitchAlignment));
+		footprint.RowCount = (footprint.Height + blockSize - 1) / blockSize;
+		footprint.Padding = 0;
+		size = footprint.Offset + uint64_t(footprint.RowPitch) * (footprint.RowCount - 1) + footprint.RowBytes;
+	}
+	return size;
+}
+
+uint64_t CookedTexture::TexelBytes() const
+{
+	uint64_t bytes = 0;
+	for (auto& footprint : Footprints)
+		bytes += uint64_t(footprint.RowBytes) * footprint.RowCount;
+	return bytes;
+}
+
+void CookTexture(TexelFormat format, uint32_t width, uint32_t height, std::span<std::span<uint8_t const> const> levels, std::vector<std::byte>& outStorage, CookedTexture& outTexture)
+{
+	outTexture = {};
+	outTexture.Format = format;
+	uint64_t size = ComputeTextureFootprints(format, width, height, uint32_t(levels.size()), outTexture.Footprints);
+	outStorage.assign(size, std::byte(0));
+	for (size_t level = 0; level < levels.size(); ++level)
+	{
+		auto& footprint = outTexture.Footprints[level];
+		assert(levels[level].size() == size_t(footprint.RowBytes) * footprint.RowCount);
+		for (uint32_t row = 0; row < footprint.RowCount; ++row)
+			std::memcpy(outStorage.data() + footprint.Offset + uint64_t(row) * footprint.RowPitch, levels[level].data() + size_t(row) * footprint.RowBytes, footprint.RowBytes);
+	}
+	outTexture.Payload = outStorage;
+	outTexture.ContentHash = HashCookedTexture(outTexture);
+}
+
+void CookTexture(CompressedTexture const& compressed, std::vector<std::byte>& outStorage, CookedTexture& outTexture)
+{
+	std::vector<std::span<uint8_t const>> levels;
+	for (auto& mip : compressed.Mips)
+		levels.push_back(mip.Blocks);
+	CookTexture(ToTexelFormat(compressed.Format), compressed.Mips[0].Width, compressed.Mips[0].Height, levels, outStorage, outTexture);
+	outTexture.SquaredError = compressed.SquaredError;
+	outTexture.Samples = compressed.Samples;
+	outTexture.UncompressedBytes = compressed.UncompressedBytes;
+}
+
+bool MakeTextureCacheKey(std::filesystem::path const& sourcePath, TextureCompression compression, bool alphaOnly, bool generateMips, TextureCacheKey& outKey)
+{
+	std::error_code error;
+	auto size = std::filesystem::file_size(sourcePath, error);
+	if (error)
+		return false;
+	auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+	if (error)
+		return false;
+
+	outKey.SourcePath = sourcePath;
+	outKey.SourceSize = size;
+	outKey.SourceWriteTime = writeTime.time_since_epoch().count();
+	outKey.Compression = compression;
+	outKey.AlphaOnly = alphaOnly;
+	outKey.GenerateMips = generateMips;
+	outKey.ImporterVersion = TextureImporterVersion;
+	return true;
+}
+
+std::filesystem::path TextureCachePath(std::filesystem::path const& sourcePath)
+{
+	auto cachePath = sourcePath;
+	cachePath += ".texcache";
+	return cachePath;
+}
+
+bool WriteTextureCache(std::filesystem::path const& cachePath, TextureCacheKey const& key, CookedTexture const& texture)
+{
+	FileHeader header = {};
+	header.Magic = TextureCacheMagic;
+	header.FormatVersion = TextureCacheFormatVersion;
+	header.ImporterVersion = key.ImporterVersion;
+	header.Compression = static_cast<uint32_t>(key.Compression);
+	header.AlphaOnly = key.AlphaOnly;
+	header.GenerateMips = key.GenerateMips;
+	header.SourceSize = key.SourceSize;
+	header.SourceWriteTime = key.SourceWriteTime;
+	header.SourceHash = HashFile(key.SourcePath);
+	header.Format = static_cast<uint32_t>(texture.Format);
+	header.Width = texture.Width();
+	header.Height = texture.Height();
+	header.MipCount = static_cast<uint32_t>(texture.Footprints.size());
+	header.SquaredError = texture.SquaredError;
+	header.Samples = texture.Samples;
+	header.UncompressedBytes = texture.UncompressedBytes;
+	header.ContentHash = texture.ContentHash;
+	header.PayloadOffset = AlignUp(sizeof(FileHeader), TexturePlacementAlignment);
+	header.PayloadSize = texture.Payload.size();
+
+	std::vector<std::byte> padding(header.PayloadOffset - sizeof(FileHeader), std::byte(0));
+	auto tempPath = cachePath;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+		file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		file.write(reinterpret_cast<char const*>(padding.data()), static_cast<std::streamsize>(padding.size()));
+		file.write(reinterpret_cast<char const*>(texture.Payload.data()), static_cast<std::streamsize>(texture.Payload.size()));
+		if (!file)
+			return false;
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool ReadTextureCache(std::span<std::byte const> data, TextureCacheKey const& key, CookedTexture& outTexture)
+{
+	if (data.size() < sizeof(FileHeader))
+		return false;
+	FileHeader header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (header.Magic != TextureCacheMagic || header.FormatVersion != TextureCacheFormatVersion || header.ImporterVersion != key.ImporterVersion)
+		return false;
+	if (header.Compression != static_cast<uint32_t>(key.Compression) || header.AlphaOnly != uint32_t(key.AlphaOnly) || header.GenerateMips != uint32_t(key.GenerateMips))
+		return false;
+	if (header.SourceSize != key.SourceSize)
+		return false;
+	// A touched but unchanged source, e.g. after a checkout, keeps its cache
+	if (header.SourceWriteTime != key.SourceWriteTime && header.SourceHash != HashFile(key.SourcePath))
+		return false;
+	if (header.Format >= static_cast<uint32_t>(TexelFormat::Count) || header.Width == 0 || header.Height == 0 || header.MipCount == 0 || header.MipCount > 32)
+		return false;
+	if (header.PayloadOffset % TexturePlacementAlignment != 0 || header.PayloadOffset > data.size() || header.PayloadSize > data.size() - header.PayloadOffset)
+		return false;
+
+	// The footprints are not stored, the layout is fully determined by the format and the size
+	outTexture = {};
+	outTexture.Format = static_cast<TexelFormat>(header.Format);
+	if (ComputeTextureFootprints(outTexture.Format, header.Width, header.Height, header.MipCount, outTexture.Footprints) != header.PayloadSize)
+		return false;
+	outTexture.Payload = data.subspan(header.PayloadOffset, header.PayloadSize);
+	outTexture.SquaredError = header.SquaredError;
+	outTexture.Samples = header.Samples;
+	outTexture.UncompressedBytes = header.UncompressedBytes;
+	outTexture.ContentHash = header.ContentHash;
+	return true;
+}
+
+}
\ No newline at end of file
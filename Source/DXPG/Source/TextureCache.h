@@ -0,0 +1,106 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include "TextureCompression.h"
+
+namespace dxpg
+{
+
+// Bump whenever the mip filter or the encoders change, older caches are then cooked again
+constexpr uint32_t TextureImporterVersion = 1;
+
+// Mirror D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, kept here so the layout builds without D3D
+constexpr uint32_t TextureRowPitchAlignment = 256;
+constexpr uint32_t TexturePlacementAlignment = 512;
+
+enum class TexelFormat : uint32_t
+{
+	RGBA8,
+	R8,
+	BC1,
+	BC3,
+	BC4,
+	BC7,
+	Count
+};
+
+TexelFormat ToTexelFormat(BlockFormat format);
+inline bool IsBlockCompressed(TexelFormat format)
+{
+	return format >= TexelFormat::BC1;
+}
+BlockFormat ToBlockFormat(TexelFormat format);
+// Bytes per texel, or per 4x4 block for the block compressed formats
+uint32_t TexelFormatBytes(TexelFormat format);
+
+// One mip level, laid out like the placed footprints GetCopyableFootprints returns for the whole chain
+struct TextureFootprint
+{
+	// From the start of the payload, aligned to TexturePlacementAlignment
+	uint64_t Offset;
+	uint32_t Width;
+	uint32_t Height;
+	// Aligned to TextureRowPitchAlignment
+	uint32_t RowPitch;
+	// Rows of texels, or of blocks
+	uint32_t RowCount;
+	// Bytes of one row without its padding
+	uint32_t RowBytes;
+	uint32_t Padding;
+};
+
+// Returns the payload size, the last row of the last level is not padded like in GetCopyableFootprints
+uint64_t ComputeTextureFootprints(TexelFormat format, uint32_t width, uint32_t height, uint32_t mipCount, std::vector<TextureFootprint>& outFootprints);
+
+// Texture in its upload layout. Payload is a view into storage owned by whoever filled it, either the cook or a mapped cache file
+struct CookedTexture
+{
+	TexelFormat Format = TexelFormat::RGBA8;
+	std::vector<TextureFootprint> Footprints;
+	std::span<std::byte const> Payload;
+	// Compression error of the top level and the RGBA8 size of the levels, zero when uncompressed
+	double SquaredError = 0.0;
+	uint64_t Samples = 0;
+	uint64_t UncompressedBytes = 0;
+	// Of the format, the levels and the payload, computed when cooking and stored in the cache so warm loads do not read the payload for it
+	uint64_t ContentHash = 0;
+
+	uint32_t Width() const { return Footprints.empty() ? 0 : Footprints[0].Width; }
+	uint32_t Height() const { return Footprints.empty() ? 0 : Footprints[0].Height; }
+	// Bytes the levels hold without row padding
+	uint64_t TexelBytes() const;
+};
+
+// Copies tightly packed levels into the footprint layout, outTexture's payload points into outStorage
+void CookTexture(TexelFormat format, uint32_t width, uint32_t height, std::span<std::span<uint8_t const> const> levels, std::vector<std::byte>& outStorage, CookedTexture& outTexture);
+void CookTexture(CompressedTexture const& compressed, std::vector<std::byte>& outStorage, CookedTexture& outTexture);
+
+// Identifies the source a cache was cooked from and the settings it was cooked with
+struct TextureCacheKey
+{
+	std::filesystem::path SourcePath;
+	uint64_t SourceSize = 0;
+	int64_t SourceWriteTime = 0;
+	TextureCompression Compression = TextureCompression::None;
+	bool AlphaOnly = false;
+	bool GenerateMips = true;
+	uint32_t ImporterVersion = TextureImporterVersion;
+};
+
+bool MakeTextureCacheKey(std::filesystem::path const& sourcePath, TextureCompression compression, bool alphaOnly, bool generateMips, TextureCacheKey& outKey);
+
+// The cache sits next to its source
+std::filesystem::path TextureCachePath(std::filesystem::path const& sourcePath);
+
+// Writes through a temporary file so a crash never leaves a truncated cache behind
+bool WriteTextureCache(std::filesystem::path const& cachePath, TextureCacheKey const& key, CookedTexture const& texture);
+
+// Validates data against the key and fills outTexture with a view into data, which has to outlive it.
+// A source whose write time changed is still accepted when its content hash matches the one it was cooked from.
+bool ReadTextureCache(std::span<std::byte const> data, TextureCacheKey const& key, CookedTexture& outTexture);
+
+}
\ No newline at end of file
@@ -0,0 +1,804 @@
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include "MathTypes.h"
+#include "Parallel.h"
+
+namespace dxpg
+{
+
+char const* BlockFormatName(BlockFormat format)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1: return "BC1";
+	case BlockFormat::BC3: return "BC3";
+	case BlockFormat::BC4: return "BC4";
+	case BlockFormat::BC7: return "BC7";
+	default: return "Unknown";
+	}
+}
+
+char const* TextureCompressionName(TextureCompression compression)
+{
+	switch (compression)
+	{
+	case TextureCompression::None: return "None";
+	case TextureCompression::Fast: return "Fast";
+	case TextureCompression::HighQuality: return "High Quality";
+	default: return "Unknown";
+	}
+}
+
+static Vector4 LoadTexel(uint8_t const* texel)
+{
+	return XMVectorSet(float(texel[0]), float(texel[1]), float(texel[2]), float(texel[3]));
+}
+
+static float DistanceSq(Vector4 a, Vector4 b)
+{
+	Vector4 d = XMVectorSubtract(a, b);
+	return XMVectorGetX(XMVector4Dot(d, d));
+}
+
+// Dominant direction of the texels around their mean by power iteration, mask zeroes the channels that do not take part
+static void PrincipalAxis(Vector4 const* texels, uint32_t count, Vector4 mask, Vector4& outMean, Vector4& outAxis)
+{
+	Vector4 sum = XMVectorZero();
+	Vector4 minTexel = texels[0];
+	Vector4 maxTexel = texels[0];
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		sum = XMVectorAdd(sum, texels[i]);
+		minTexel = XMVectorMin(minTexel, texels[i]);
+		maxTexel = XMVectorMax(maxTexel, texels[i]);
+	}
+	outMean = XMVectorScale(sum, 1.0f / float(count));
+
+	// Rows of the symmetric covariance matrix
+	Vector4 covariance[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Vector4 d = XMVectorMultiply(XMVectorSubtract(texels[i], outMean), mask);
+		covariance[0] = XMVectorMultiplyAdd(d, XMVectorSplatX(d), covariance[0]);
+		covariance[1] = XMVectorMultiplyAdd(d, XMVectorSplatY(d), covariance[1]);
+		covariance[2] = XMVectorMultiplyAdd(d, XMVectorSplatZ(d), covariance[2]);
+		covariance[3] = XMVectorMultiplyAdd(d, XMVectorSplatW(d), covariance[3]);
+	}
+
+	// The box diagonal is a good start for colors that mostly vary together
+	Vector4 axis = XMVectorMultiply(XMVectorSubtract(maxTexel, minTexel), mask);
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		Vector4 next = XMVectorMultiply(covariance[0], XMVectorSplatX(axis));
+		next = XMVectorMultiplyAdd(covariance[1], XMVectorSplatY(axis), next);
+		next = XMVectorMultiplyAdd(covariance[2], XMVectorSplatZ(axis), next);
+		next = XMVectorMultiplyAdd(covariance[3], XMVectorSplatW(axis), next);
+		float lengthSq = XMVectorGetX(XMVector4Dot(next, next));
+		if (lengthSq < 1e-12f)
+			break;
+		axis = XMVectorScale(next, 1.0f / std::sqrt(lengthSq));
+	}
+	float lengthSq = XMVectorGetX(XMVector4Dot(axis, axis));
+	outAxis = lengthSq > 1e-12f ? XMVectorScale(axis, 1.0f / std::sqrt(lengthSq)) : XMVectorZero();
+}
+
+// Ends of the texels' projection onto the axis
+static void FitEndpoints(Vector4 const* texels, uint32_t count, Vector4 mean, Vector4 axis, Vector4& outStart, Vector4& outEnd)
+{
+	float minT = std::numeric_limits<float>::max();
+	float maxT = std::numeric_limits<float>::lowest();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		float t = XMVectorGetX(XMVector4Dot(XMVectorSubtract(texels[i], mean), axis));
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	outStart = XMVectorMultiplyAdd(axis, XMVectorReplicate(minT), mean);
+	outEnd = XMVectorMultiplyAdd(axis, XMVectorReplicate(maxT), mean);
+}
+
+// Least squares endpoints for fixed interpolation weights, weights[i] is the share of the end endpoint in texel i
+static bool SolveEndpoints(Vector4 const* texels, uint32_t count, float const* weights, Vector4& outStart, Vector4& outEnd)
+{
+	float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+	Vector4 ax = XMVectorZero();
+	Vector4 bx = XMVectorZero();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		float b = weights[i];
+		float a = 1.0f - b;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		ax = XMVectorMultiplyAdd(texels[i], XMVectorReplicate(a), ax);
+		bx = XMVectorMultiplyAdd(texels[i], XMVectorReplicate(b), bx);
+	}
+	float det = aa * bb - ab * ab;
+	if (std::abs(det) < 1e-6f)
+		return false;
+	Vector4 invDet = XMVectorReplicate(1.0f / det);
+	Vector4 maxValue = XMVectorReplicate(255.0f);
+	outStart = XMVectorClamp(XMVectorMultiply(XMVectorSubtract(XMVectorScale(ax, bb), XMVectorScale(bx, ab)), invDet), XMVectorZero(), maxValue);
+	outEnd = XMVectorClamp(XMVectorMultiply(XMVectorSubtract(XMVectorScale(bx, aa), XMVectorScale(ax, ab)), invDet), XMVectorZero(), maxValue);
+	return true;
+}
+
+// 128 bit blocks are written and read least significant bit first
+struct BlockBits
+{
+	uint64_t Bits[2] = {};
+	uint32_t Offset = 0;
+
+	void Write(uint32_t value, uint32_t count)
+	{
+		if (Offset < 64)
+		{
+			Bits[0] |= uint64_t(value) << Offset;
+			if (Offset + count > 64)
+				Bits[1] |= uint64_t(value) >> (64 - Offset);
+		}
+		else
+			Bits[1] |= uint64_t(value) << (Offset - 64);
+		Offset += count;
+	}
+
+	uint32_t Read(uint32_t count)
+	{
+		uint64_t value;
+		if (Offset < 64)
+		{
+			value = Bits[0] >> Offset;
+			if (Offset + count > 64)
+				value |= Bits[1] << (64 - Offset);
+		}
+		else
+			value = Bits[1] >> (Offset - 64);
+		Offset += count;
+		return uint32_t(value & ((uint64_t(1) << count) - 1));
+	}
+};
+
+static uint16_t PackColor565(Vector4 color)
+{
+	XMFLOAT4 c;
+	XMStoreFloat4(&c, color);
+	auto quantize = [](float value, int maxValue)
+	{
+		return uint32_t(std::clamp(int(std::lround(value * float(maxValue) / 255.0f)), 0, maxValue));
+	};
+	return uint16_t(quantize(c.x, 31) << 11 | quantize(c.y, 63) << 5 | quantize(c.z, 31));
+}
+
+static void UnpackColor565(uint16_t color, uint8_t* outRgba)
+{
+	uint32_t r = color >> 11 & 31;
+	uint32_t g = color >> 5 & 63;
+	uint32_t b = color & 31;
+	outRgba[0] = uint8_t(r << 3 | r >> 2);
+	outRgba[1] = uint8_t(g << 2 | g >> 4);
+	outRgba[2] = uint8_t(b << 3 | b >> 2);
+	outRgba[3] = 255;
+}
+
+// Colors as they are decoded, the three color mode has transparent black as its last entry
+static void ColorPalette(uint16_t color0, uint16_t color1, bool fourColor, uint8_t outPalette[4][4])
+{
+	UnpackColor565(color0, outPalette[0]);
+	UnpackColor565(color1, outPalette[1]);
+	for (int c = 0; c < 3; ++c)
+	{
+		uint32_t a = outPalette[0][c];
+		uint32_t b = outPalette[1][c];
+		if (fourColor)
+		{
+			outPalette[2][c] = uint8_t((2 * a + b) / 3);
+			outPalette[3][c] = uint8_t((a + 2 * b) / 3);
+		}
+		else
+		{
+			outPalette[2][c] = uint8_t((a + b) / 2);
+			outPalette[3][c] = 0;
+		}
+	}
+	outPalette[2][3] = 255;
+	outPalette[3][3] = fourColor ? 255 : 0;
+}
+
+// BC1 layout, also the color half of BC3. Texels below half alpha use the transparent entry when allowTransparent is set
+static void EncodeColorBlock(uint8_t const* texels, bool allowTransparent, uint8_t* outBlock)
+{
+	Vector4 colors[16];
+	bool transparent[16];
+	uint32_t opaqueCount = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		transparent[i] = allowTransparent && texels[i * 4 + 3] < 128;
+		if (!transparent[i])
+			colors[opaqueCount++] = LoadTexel(texels + i * 4);
+	}
+
+	uint16_t bestColor0 = 0;
+	uint16_t bestColor1 = 0;
+	uint32_t bestIndices = 0xFFFFFFFF;
+	if (opaqueCount > 0)
+	{
+		bool threeColor = opaqueCount < 16;
+		Vector4 mean, axis, start, end;
+		PrincipalAxis(colors, opaqueCount, XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f), mean, axis);
+		FitEndpoints(colors, opaqueCount, mean, axis, start, end);
+
+		float bestError = std::numeric_limits<float>::max();
+		bool bestFourColor = false;
+		auto tryEndpoints = [&](Vector4 start, Vector4 end)
+		{
+			uint16_t color0 = PackColor565(start);
+			uint16_t color1 = PackColor565(end);
+			// Four colors need color0 > color1, three colors the opposite
+			if (threeColor ? color0 > color1 : color0 < color1)
+				std::swap(color0, color1);
+			bool fourColor = color0 > color1;
+			uint8_t palette[4][4];
+			ColorPalette(color0, color1, fourColor, palette);
+			Vector4 entries[4] = { LoadTexel(palette[0]), LoadTexel(palette[1]), LoadTexel(palette[2]), LoadTexel(palette[3]) };
+			uint32_t entryCount = fourColor ? 4 : 3;
+
+			uint32_t indices = 0;
+			float error = 0.0f;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				uint32_t index = 3;
+				if (!transparent[i])
+				{
+					Vector4 texel = XMVectorMultiply(LoadTexel(texels + i * 4), XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f));
+					float nearest = std::numeric_limits<float>::max();
+					for (uint32_t e = 0; e < entryCount; ++e)
+					{
+						float distance = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(texel, entries[e])));
+						if (distance < nearest)
+						{
+							nearest = distance;
+							index = e;
+						}
+					}
+					error += nearest;
+				}
+				indices |= index << (2 * i);
+			}
+			if (error >= bestError)
+				return false;
+			bestError = error;
+			bestColor0 = color0;
+			bestColor1 = color1;
+			bestIndices = indices;
+			bestFourColor = fourColor;
+			return true;
+		};
+
+		tryEndpoints(start, end);
+		for (int pass = 0; pass < 2 && bestColor0 != bestColor1; ++pass)
+		{
+			// Share of color1 for each palette entry
+			static constexpr float FourColorWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			static constexpr float ThreeColorWeights[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+			float weights[16];
+			uint32_t weightCount = 0;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				if (!transparent[i])
+					weights[weightCount++] = (bestFourColor ? FourColorWeights : ThreeColorWeights)[bestIndices >> (2 * i) & 3];
+			}
+			if (!SolveEndpoints(colors, opaqueCount, weights, start, end) || !tryEndpoints(start, end))
+				break;
+		}
+	}
+
+	outBlock[0] = uint8_t(bestColor0);
+	outBlock[1] = uint8_t(bestColor0 >> 8);
+	outBlock[2] = uint8_t(bestColor1);
+	outBlock[3] = uint8_t(bestColor1 >> 8);
+	for (int i = 0; i < 4; ++i)
+		outBlock[4 + i] = uint8_t(bestIndices >> (8 * i));
+}
+
+// BC3 and BC7 blocks always decode four colors, whatever the endpoint order
+static void DecodeColorBlock(uint8_t const* block, bool alwaysFourColor, uint8_t* outTexels)
+{
+	uint16_t color0 = uint16_t(block[0] | block[1] << 8);
+	uint16_t color1 = uint16_t(block[2] | block[3] << 8);
+	uint32_t indices = uint32_t(block[4]) | uint32_t(block[5]) << 8 | uint32_t(block[6]) << 16 | uint32_t(block[7]) << 24;
+	uint8_t palette[4][4];
+	ColorPalette(color0, color1, alwaysFourColor || color0 > color1, palette);
+	for (uint32_t i = 0; i < 16; ++i)
+		std::copy_n(palette[indices >> (2 * i) & 3], 4, outTexels + i * 4);
+}
+
+// BC4 layout, also the alpha half of BC3. Always uses the eight value mode
+static void EncodeChannelBlock(uint8_t const* texels, uint32_t channel, uint8_t* outBlock)
+{
+	uint32_t minValue = 255;
+	uint32_t maxValue = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		minValue = std::min<uint32_t>(minValue, texels[i * 4 + channel]);
+		maxValue = std::max<uint32_t>(maxValue, texels[i * 4 + channel]);
+	}
+
+	uint64_t indices = 0;
+	uint32_t range = maxValue - minValue;
+	if (range > 0)
+	{
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			// Step along the evenly spaced palette from the minimum, code 0 is the maximum and 1 the minimum
+			uint32_t step = ((texels[i * 4 + channel] - minValue) * 7 + range / 2) / range;
+			uint64_t code = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+			indices |= code << (3 * i);
+		}
+	}
+	outBlock[0] = uint8_t(maxValue);
+	outBlock[1] = uint8_t(minValue);
+	for (int i = 0; i < 6; ++i)
+		outBlock[2 + i] = uint8_t(indices >> (8 * i));
+}
+
+static void DecodeChannelBlock(uint8_t const* block, uint32_t channel, uint8_t* outTexels)
+{
+	uint32_t value0 = block[0];
+	uint32_t value1 = block[1];
+	uint8_t palette[8] = { uint8_t(value0), uint8_t(value1) };
+	if (value0 > value1)
+	{
+		for (uint32_t code = 2; code < 8; ++code)
+			palette[code] = uint8_t(((8 - code) * value0 + (code - 1) * value1) / 7);
+	}
+	else
+	{
+		for (uint32_t code = 2; code < 6; ++code)
+			palette[code] = uint8_t(((6 - code) * value0 + (code - 1) * value1) / 5);
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; ++i)
+		indices |= uint64_t(block[2 + i]) << (8 * i);
+	for (uint32_t i = 0; i < 16; ++i)
+		outTexels[i * 4 + channel] = palette[indices >> (3 * i) & 7];
+}
+
+static constexpr uint32_t Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Nearest 4 bit index for each weight out of 64
+static constexpr std::array<uint8_t, 65> Bc7IndexOfWeight = []()
+{
+	std::array<uint8_t, 65> indices = {};
+	for (uint32_t weight = 0; weight <= 64; ++weight)
+	{
+		uint32_t best = 0;
+		for (uint32_t index = 1; index < 16; ++index)
+		{
+			if ((Bc7Weights[index] > weight ? Bc7Weights[index] - weight : weight - Bc7Weights[index]) < (Bc7Weights[best] > weight ? Bc7Weights[best] - weight : weight - Bc7Weights[best]))
+				best = index;
+		}
+		indices[weight] = uint8_t(best);
+	}
+	return indices;
+}();
+
+static void Bc7Palette(uint8_t const* endpoint0, uint8_t const* endpoint1, uint8_t outPalette[16][4])
+{
+	for (uint32_t index = 0; index < 16; ++index)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+			outPalette[index][c] = uint8_t(((64 - Bc7Weights[index]) * endpoint0[c] + Bc7Weights[index] * endpoint1[c] + 32) >> 6);
+	}
+}
+
+// Mode 6: one subset, RGBA endpoints of 7 bits plus a shared low bit per endpoint, 4 bit indices
+static void EncodeBc7Block(uint8_t const* texels, uint8_t* outBlock)
+{
+	Vector4 colors[16];
+	for (uint32_t i = 0; i < 16; ++i)
+		colors[i] = LoadTexel(texels + i * 4);
+	Vector4 mean, axis, start, end;
+	PrincipalAxis(colors, 16, XMVectorSplatOne(), mean, axis);
+	FitEndpoints(colors, 16, mean, axis, start, end);
+
+	uint8_t bestEndpoints[2][4] = {};
+	uint8_t bestIndices[16] = {};
+	float bestError = std::numeric_limits<float>::max();
+	auto tryEndpoints = [&](Vector4 start, Vector4 end)
+	{
+		XMFLOAT4 ends[2];
+		XMStoreFloat4(&ends[0], start);
+		XMStoreFloat4(&ends[1], end);
+		bool improved = false;
+		// Every combination of the two shared low bits
+		for (uint32_t pbits = 0; pbits < 4; ++pbits)
+		{
+			uint8_t endpoints[2][4];
+			for (uint32_t e = 0; e < 2; ++e)
+			{
+				uint32_t pbit = pbits >> e & 1;
+				float const* values = &ends[e].x;
+				for (uint32_t c = 0; c < 4; ++c)
+					endpoints[e][c] = uint8_t(std::clamp(int(std::lround((values[c] - float(pbit)) * 0.5f)), 0, 127) << 1 | pbit);
+			}
+			uint8_t palette[16][4];
+			Bc7Palette(endpoints[0], endpoints[1], palette);
+			Vector4 first = LoadTexel(endpoints[0]);
+			Vector4 direction = XMVectorSubtract(LoadTexel(endpoints[1]), first);
+			float lengthSq = XMVectorGetX(XMVector4Dot(direction, direction));
+			float scale = lengthSq > 0.0f ? 64.0f / lengthSq : 0.0f;
+
+			uint8_t indices[16];
+			float error = 0.0f;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				// Projecting onto the endpoint line picks the nearest palette entry up to rounding
+				float weight = XMVectorGetX(XMVector4Dot(XMVectorSubtract(colors[i], first), direction)) * scale;
+				indices[i] = Bc7IndexOfWeight[std::clamp(int(std::lround(weight)), 0, 64)];
+				error += DistanceSq(colors[i], LoadTexel(palette[indices[i]]));
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				std::copy_n(&endpoints[0][0], 8, &bestEndpoints[0][0]);
+				std::copy_n(indices, 16, bestIndices);
+				improved = true;
+			}
+		}
+		return improved;
+	};
+
+	tryEndpoints(start, end);
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		float weights[16];
+		for (uint32_t i = 0; i < 16; ++i)
+			weights[i] = float(Bc7Weights[bestIndices[i]]) / 64.0f;
+		if (!SolveEndpoints(colors, 16, weights, start, end) || !tryEndpoints(start, end))
+			break;
+	}
+
+	// The first index has an implicit zero top bit
+	if (bestIndices[0] >= 8)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+			std::swap(bestEndpoints[0][c], bestEndpoints[1][c]);
+		for (uint32_t i = 0; i < 16; ++i)
+			bestIndices[i] = uint8_t(15 - bestIndices[i]);
+	}
+
+	BlockBits bits;
+	bits.Write(1 << 6, 7);
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		bits.Write(bestEndpoints[0][c] >> 1, 7);
+		bits.Write(bestEndpoints[1][c] >> 1, 7);
+	}
+	bits.Write(bestEndpoints[0][0] & 1, 1);
+	bits.Write(bestEndpoints[1][0] & 1, 1);
+	bits.Write(bestIndices[0], 3);
+	for (uint32_t i = 1; i < 16; ++i)
+		bits.Write(bestIndices[i], 4);
+	assert(bits.Offset == 128);
+	for (int i = 0; i < 16; ++i)
+		outBlock[i] = uint8_t(bits.Bits[i / 8] >> (8 * (i % 8)));
+}
+
+static void DecodeBc7Block(uint8_t const* block, uint8_t* outTexels)
+{
+	BlockBits bits;
+	for (int i = 0; i < 16; ++i)
+		bits.Bits[i / 8] |= uint64_t(block[i]) << (8 * (i % 8));
+	// Only mode 6 is ever written, anything else decodes to black
+	if (bits.Read(7) != 1 << 6)
+	{
+		std::fill_n(outTexels, 64, uint8_t(0));
+		return;
+	}
+	uint8_t endpoints[2][4];
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] = uint8_t(bits.Read(7) << 1);
+		endpoints[1][c] = uint8_t(bits.Read(7) << 1);
+	}
+	uint32_t pbit0 = bits.Read(1);
+	uint32_t pbit1 = bits.Read(1);
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] |= pbit0;
+		endpoints[1][c] |= pbit1;
+	}
+	uint8_t palette[16][4];
+	Bc7Palette(endpoints[0], endpoints[1], palette);
+	for (uint32_t i = 0; i < 16; ++i)
+		std::copy_n(palette[bits.Read(i == 0 ? 3 : 4)], 4, outTexels + i * 4);
+}
+
+void EncodeBlock(BlockFormat format, uint8_t const* texels, uint8_t* outBlock)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		EncodeColorBlock(texels, true, outBlock);
+		break;
+	case BlockFormat::BC3:
+		EncodeChannelBlock(texels, 3, outBlock);
+		EncodeColorBlock(texels, false, outBlock + 8);
+		break;
+	case BlockFormat::BC4:
+		EncodeChannelBlock(texels, 0, outBlock);
+		break;
+	case BlockFormat::BC7:
+		EncodeBc7Block(texels, outBlock);
+		break;
+	default:
+		assert(false);
+	}
+}
+
+void DecodeBlock(BlockFormat format, uint8_t const* block, uint8_t* outTexels)
+{
+	switch (format)
+	{
+	case BlockFormat::BC1:
+		DecodeColorBlock(block, false, outTexels);
+		break;
+	case BlockFormat::BC3:
+		DecodeColorBlock(block + 8, true, outTexels);
+		DecodeChannelBlock(block, 3, outTexels);
+		break;
+	case BlockFormat::BC4:
+		DecodeChannelBlock(block, 0, outTexels);
+		break;
+	case BlockFormat::BC7:
+		DecodeBc7Block(block, outTexels);
+		break;
+	default:
+		assert(false);
+	}
+}
+
+static std::array<float, 256> const& SrgbToLinearTable()
+{
+	static std::array<float, 256> const table = []()
+	{
+		std::array<float, 256> values;
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			float srgb = float(i) / 255.0f;
+			values[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+		}
+		return values;
+	}();
+	return table;
+}
+
+// Indexed by linear intensity in 1/4095 steps, fine enough to round trip every 8 bit value
+static std::array<uint8_t, 4096> const& LinearToSrgbTable()
+{
+	static std::array<uint8_t, 4096> const table = []()
+	{
+		std::array<uint8_t, 4096> values;
+		for (uint32_t i = 0; i < 4096; ++i)
+		{
+			float linear = float(i) / 4095.0f;
+			float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+			values[i] = uint8_t(std::clamp(int(std::lround(srgb * 255.0f)), 0, 255));
+		}
+		return values;
+	}();
+	return table;
+}
+
+void BuildMipChain(std::span<uint8_t const> pixels, uint32_t width, uint32_t height, uint32_t components, bool srgb, std::vector<ImageMip>& outMips, size_t maxThreads)
+{
+	auto& toLinear = SrgbToLinearTable();
+	auto& toSrgb = LinearToSrgbTable();
+	uint32_t colorComponents = srgb ? std::min(components, 3u) : 0;
+
+	outMips.clear();
+	// Levels below the source, the source spans stay valid without reallocation
+	outMips.reserve(std::bit_width(std::max(width, height)) - 1);
+	std::span<uint8_t const> source = pixels;
+	uint32_t sourceWidth = width;
+	uint32_t sourceHeight = height;
+	while (sourceWidth > 1 || sourceHeight > 1)
+	{
+		auto& mip = outMips.emplace_back();
+		mip.Width = std::max(sourceWidth / 2, 1u);
+		mip.Height = std::max(sourceHeight / 2, 1u);
+		mip.Pixels.resize(size_t(mip.Width) * mip.Height * components);
+		size_t rowThreads = size_t(mip.Width) * mip.Height < (1 << 14) ? 1 : maxThreads;
+		ParallelFor(mip.Height, [&](size_t y)
+		{
+			// Odd sizes repeat the last row or column
+			uint8_t const* row0 = source.data() + std::min<size_t>(y * 2, sourceHeight - 1) * sourceWidth * components;
+			uint8_t const* row1 = source.data() + std::min<size_t>(y * 2 + 1, sourceHeight - 1) * sourceWidth * components;
+			uint8_t* out = mip.Pixels.data() + y * mip.Width * components;
+			for (uint32_t x = 0; x < mip.Width; ++x)
+			{
+				size_t x0 = std::min<size_t>(x * 2, sourceWidth - 1) * components;
+				size_t x1 = std::min<size_t>(x * 2 + 1, sourceWidth - 1) * components;
+				for (uint32_t c = 0; c < components; ++c)
+				{
+					if (c < colorComponents)
+					{
+						float linear = (toLinear[row0[x0 + c]] + toLinear[row0[x1 + c]] + toLinear[row1[x0 + c]] + toLinear[row1[x1 + c]]) * 0.25f;
+						out[x * components + c] = toSrgb[size_t(linear * 4095.0f + 0.5f)];
+					}
+					else
+						out[x * components + c] = uint8_t((uint32_t(row0[x0 + c]) + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+				}
+			}
+		}, rowThreads);
+		source = mip.Pixels;
+		sourceWidth = mip.Width;
+		sourceHeight = mip.Height;
+	}
+}
+
+AlphaUsage ClassifyAlpha(std::span<uint8_t const> rgba)
+{
+	AlphaUsage usage = AlphaUsage::Opaque;
+	for (size_t i = 3; i < rgba.size(); i += 4)
+	{
+		if (rgba[i] == 255)
+			continue;
+		if (rgba[i] != 0)
+			return AlphaUsage::Blended;
+		usage = AlphaUsage::Binary;
+	}
+	return usage;
+}
+
+BlockFormat ChooseBlockFormat(std::span<uint8_t const> pixels, uint32_t components, TextureCompression compression)
+{
+	if (components == 1)
+		return BlockFormat::BC4;
+	if (compression == TextureCompression::HighQuality)
+		return BlockFormat::BC7;
+	return ClassifyAlpha(pixels) == AlphaUsage::Blended ? BlockFormat::BC3 : BlockFormat::BC1;
+}
+
+uint64_t CompressedTexture::Bytes() const
+{
+	uint64_t bytes = 0;
+	for (auto& mip : Mips)
+		bytes += mip.Blocks.size();
+	return bytes;
+}
+
+bool CompressTexture(std::span<uint8_t const> pixels, uint32_t width, uint32_t height, uint32_t components, bool srgb, bool generateMips, TextureCompression compression, CompressedTexture& outTexture, size_t maxThreads)
+{
+	if (compression == TextureCompression::None || !CanBlockCompress(width, height))
+		return false;
+	assert(components == 1 || components == 4);
+	assert(pixels.size() == size_t(width) * height * components);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	outTexture = {};
+	outTexture.Format = ChooseBlockFormat(pixels, components, compression);
+	uint32_t blockBytes = BlockBytes(outTexture.Format);
+
+	std::vector<ImageMip> mips;
+	if (generateMips)
+		BuildMipChain(pixels, width, height, components, srgb, mips, maxThreads);
+
+	struct BlockRow
+	{
+		uint32_t Level;
+		uint32_t Row;
+	};
+	std::vector<BlockRow> rows;
+	outTexture.Mips.resize(mips.size() + 1);
+	for (uint32_t level = 0; level < outTexture.Mips.size(); ++level)
+	{
+		auto& mip = outTexture.Mips[level];
+		mip.Width = level == 0 ? width : mips[level - 1].Width;
+		mip.Height = level == 0 ? height : mips[level - 1].Height;
+		mip.BlocksWide = (mip.Width + 3) / 4;
+		mip.BlocksHigh = (mip.Height + 3) / 4;
+		mip.Blocks.resize(size_t(mip.BlocksWide) * mip.BlocksHigh * blockBytes);
+		for (uint32_t row = 0; row < mip.BlocksHigh; ++row)
+			rows.push_back({ level, row });
+		outTexture.Texels += uint64_t(mip.Width) * mip.Height;
+		outTexture.UncompressedBytes += uint64_t(mip.Width) * mip.Height * 4;
+	}
+
+	// One job per block row of every level, small levels do not get a pass of their own
+	std::vector<double> rowErrors(rows.size(), 0.0);
+	std::vector<uint64_t> rowSamples(rows.size(), 0);
+	ParallelFor(rows.size(), [&](size_t rowIndex)
+	{
+		auto [level, row] = rows[rowIndex];
+		auto& mip = outTexture.Mips[level];
+		uint8_t const* source = level == 0 ? pixels.data() : mips[level - 1].Pixels.data();
+		uint8_t texels[64];
+		uint8_t decoded[64];
+		for (uint32_t blockX = 0; blockX < mip.BlocksWide; ++blockX)
+		{
+			// Edge blocks of small levels repeat the last row and column
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				uint32_t x = std::min(blockX * 4 + i % 4, mip.Width - 1);
+				uint32_t y = std::min(row * 4 + i / 4, mip.Height - 1);
+				uint8_t const* texel = source + (size_t(y) * mip.Width + x) * components;
+				if (components == 1)
+				{
+					texels[i * 4 + 0] = texel[0];
+					texels[i * 4 + 1] = 0;
+					texels[i * 4 + 2] = 0;
+					texels[i * 4 + 3] = 255;
+				}
+				else
+					std::copy_n(texel, 4, texels + i * 4);
+			}
+			uint8_t* block = mip.Blocks.data() + (size_t(row) * mip.BlocksWide + blockX) * blockBytes;
+			EncodeBlock(outTexture.Format, texels, block);
+			if (level != 0)
+				continue;
+
+			DecodeBlock(outTexture.Format, block, decoded);
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				// Texels the alpha test discards either way only count their alpha
+				bool discarded = outTexture.Format == BlockFormat::BC1 && texels[i * 4 + 3] < 128 && decoded[i * 4 + 3] == 0;
+				for (uint32_t c = discarded ? 3 : 0; c < components; ++c)
+				{
+					double difference = double(texels[i * 4 + c]) - double(decoded[i * 4 + c]);
+					rowErrors[rowIndex] += difference * difference;
+					rowSamples[rowIndex]++;
+				}
+			}
+		}
+	}, maxThreads);
+
+	for (size_t i = 0; i < rows.size(); ++i)
+	{
+		outTexture.SquaredError += rowErrors[i];
+		outTexture.Samples += rowSamples[i];
+	}
+	outTexture.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
+
+double PsnrFromSquaredError(double squaredError, uint64_t samples)
+{
+	if (samples == 0)
+		return 0.0;
+	if (squaredError <= 0.0)
+		return std::numeric_limits<double>::infinity();
+	return 10.0 * std::log10(255.0 * 255.0 * double(samples) / squaredError);
+}
+
+void TextureCompressionStats::Add(CompressedTexture const& texture)
+{
+	Textures[uint32_t(texture.Format)]++;
+	Texels += texture.Texels;
+	UncompressedBytes += texture.UncompressedBytes;
+	CompressedBytes += texture.Bytes();
+	SquaredError += texture.SquaredError;
+	Samples += texture.Samples;
+	Milliseconds += texture.Milliseconds;
+}
+
+void TextureCompressionStats::AddCached(BlockFormat format, uint64_t uncompressedBytes, uint64_t compressedBytes, double squaredError, uint64_t samples)
+{
+	Textures[uint32_t(format)]++;
+	Cached++;
+	UncompressedBytes += uncompressedBytes;
+	CompressedBytes += compressedBytes;
+	SquaredError += squaredError;
+	Samples += samples;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace dxpg
+{
+
+enum class BlockFormat : uint32_t
+{
+	// RGB with 1 bit alpha, 8 bytes per 4x4 block
+	BC1,
+	// BC1 colors with a BC4 alpha block, 16 bytes
+	BC3,
+	// Single channel, 8 bytes
+	BC4,
+	// RGBA, only mode 6 is encoded, 16 bytes
+	BC7,
+	Count
+};
+
+enum class TextureCompression : uint32_t
+{
+	// Uploaded as RGBA8, mips generated on the GPU
+	None,
+	// BC1 for opaque and alpha tested images, BC3 for blended alpha, BC4 for single channel
+	Fast,
+	// BC7 for every color image, BC4 for single channel
+	HighQuality,
+	Count
+};
+
+char const* BlockFormatName(BlockFormat format);
+char const* TextureCompressionName(TextureCompression compression);
+
+inline uint32_t BlockBytes(BlockFormat format)
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+// Encodes 16 RGBA texels in row order, single channel formats read red
+void EncodeBlock(BlockFormat format, uint8_t const* texels, uint8_t* outBlock);
+// Writes 16 RGBA texels, single channel formats only write red
+void DecodeBlock(BlockFormat format, uint8_t const* block, uint8_t* outTexels);
+
+struct ImageMip
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	// Tightly packed, one byte per component
+	std::vector<uint8_t> Pixels;
+};
+
+// Box filters down to 1x1 starting with the level below the source. Colors are averaged in linear space when srgb is set, alpha never is
+void BuildMipChain(std::span<uint8_t const> pixels, uint32_t width, uint32_t height, uint32_t components, bool srgb, std::vector<ImageMip>& outMips, size_t maxThreads = 0);
+
+enum class AlphaUsage : uint32_t
+{
+	Opaque,
+	// Only fully opaque and fully transparent texels, what the alpha test needs
+	Binary,
+	Blended
+};
+AlphaUsage ClassifyAlpha(std::span<uint8_t const> rgba);
+BlockFormat ChooseBlockFormat(std::span<uint8_t const> pixels, uint32_t components, TextureCompression compression);
+
+struct CompressedMip
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t BlocksWide = 0;
+	uint32_t BlocksHigh = 0;
+	std::vector<uint8_t> Blocks;
+};
+
+struct CompressedTexture
+{
+	BlockFormat Format = BlockFormat::BC1;
+	std::vector<CompressedMip> Mips;
+	// Top level only, alpha tested texels that stay transparent only count their alpha
+	double SquaredError = 0.0;
+	uint64_t Samples = 0;
+	// Texels of every level
+	uint64_t Texels = 0;
+	// What the same levels take as RGBA8
+	uint64_t UncompressedBytes = 0;
+	double Milliseconds = 0.0;
+
+	uint64_t Bytes() const;
+};
+
+// Top level dimensions have to be a multiple of the block size
+inline bool CanBlockCompress(uint32_t width, uint32_t height)
+{
+	return width % 4 == 0 && height % 4 == 0;
+}
+
+// Picks the format, builds the mips when asked to and encodes every level's blocks in parallel.
+// Returns false for TextureCompression::None and for images that cannot be block compressed
+bool CompressTexture(std::span<uint8_t const> pixels, uint32_t width, uint32_t height, uint32_t components, bool srgb, bool generateMips, TextureCompression compression, CompressedTexture& outTexture, size_t maxThreads = 0);
+
+double PsnrFromSquaredError(double squaredError, uint64_t samples);
+
+struct TextureCompressionStats
+{
+	uint32_t Textures[uint32_t(BlockFormat::Count)] = {};
+	// Of those, read already compressed from the texture cache
+	uint32_t Cached = 0;
+	// Texels compressed, cached textures only count towards the sizes and the error
+	uint64_t Texels = 0;
+	uint64_t UncompressedBytes = 0;
+	uint64_t CompressedBytes = 0;
+	double SquaredError = 0.0;
+	uint64_t Samples = 0;
+	// Summed over the compressing threads
+	double Milliseconds = 0.0;
+
+	void Add(CompressedTexture const& texture);
+	void AddCached(BlockFormat format, uint64_t uncompressedBytes, uint64_t compressedBytes, double squaredError, uint64_t samples);
+	double Psnr() const { return PsnrFromSquaredError(SquaredError, Samples); }
+	double MegatexelsPerSecond() const { return Milliseconds > 0.0 ? double(Texels) / 1e6 / (Milliseconds / 1000.0) : 0.0; }
+};
+
+}
\ No newline at end of file
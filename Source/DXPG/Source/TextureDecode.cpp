@@ -0,0 +1,31 @@
+#include "TextureDecode.h"
+
+#include <stb_image.h>
+
+#include <chrono>
+
+namespace dxpg
+{
+
+void DecodedPixels::Free::operator()(uint8_t* pixels) const
+{
+	stbi_image_free(pixels);
+}
+
+bool DecodePixels(std::filesystem::path const& path, std::span<std::byte const> encoded, bool alphaOnly, DecodedPixels& outPixels)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	int comp;
+	outPixels.Components = alphaOnly ? STBI_grey : STBI_rgb_alpha;
+	stbi_set_flip_vertically_on_load_thread(true);
+	if (!encoded.empty())
+		outPixels.Pixels.reset(stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(encoded.data()), int(encoded.size()), &outPixels.Width, &outPixels.Height, &comp, outPixels.Components));
+	else
+		outPixels.Pixels.reset(stbi_load(path.string().c_str(), &outPixels.Width, &outPixels.Height, &comp, outPixels.Components));
+	if (!outPixels.Pixels)
+		outPixels.Error = stbi_failure_reason();
+	outPixels.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return outPixels.Pixels != nullptr;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace dxpg
+{
+
+// Pixels as stb_image returns them, tightly packed rows of Components bytes per texel
+struct DecodedPixels
+{
+	struct Free
+	{
+		void operator()(uint8_t* pixels) const;
+	};
+
+	std::unique_ptr<uint8_t, Free> Pixels;
+	int Width = 0;
+	int Height = 0;
+	int Components = 0;
+	double Milliseconds = 0.0;
+	std::string Error;
+
+	size_t Size() const { return size_t(Width) * Height * Components; }
+};
+
+// Decodes encoded, or the file at path when encoded is empty, flipped vertically into RGBA or a single channel when alphaOnly.
+// Safe to call from any thread, the flip and the failure reason are thread local in stb_image
+bool DecodePixels(std::filesystem::path const& path, std::span<std::byte const> encoded, bool alphaOnly, DecodedPixels& outPixels);
+
+}
\ No newline at end of file
@@ -1,6 +1,14 @@
 #include "TextureManager.h"
 
-#include <stb_image.h>
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <cstring>
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "StagingRing.h"
+#include "VirtualTextureManager.h"
 
 namespace dxpg
 {
@@ -11,22 +19,509 @@ void TextureManager::Init(ID3D12Device2* device)
 	Device = device;
 	GenerateMips.Setup(device);
 }
-DXTexture* dxpg::TextureManager::LoadTexture(std::filesystem::path const& path, TextureManager::TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips)
+
+// Decoded pixels, ready to be uploaded
+struct TextureManager::DecodedImage : DecodedPixels
+{
+	CompressedTexture Compressed;
+	bool IsCompressed = false;
+	// Upload layout of every level, from the compressed blocks, the CPU built mips or the mapped cache file
+	CookedTexture Cooked;
+	std::vector<std::byte> CookedStorage;
+	MappedFile CacheFile;
+	bool IsCooked = false;
+	bool FromCache = false;
+	// Of what gets uploaded and how, see HashImage
+	uint64_t ContentHash = 0;
+};
+
+void TextureManager::CompressImage(DecodedImage& image, TextureLoadInfo const& info, bool generateMips, TextureCompression compression, size_t maxThreads)
+{
+	std::span<uint8_t const> pixels(image.Pixels.get(), image.Size());
+	// Color images are sampled through sRGB views, their mips are filtered in linear space
+	image.IsCompressed = CompressTexture(pixels, uint32_t(image.Width), uint32_t(image.Height), uint32_t(image.Components), !info.AlphaOnly, generateMips, compression, image.Compressed, maxThreads);
+	if (image.IsCompressed)
+		image.Pixels.reset();
+}
+
+// Covers the upload payload and everything that shapes the resource, so only images that would create the same texture match.
+// Cooked images come with the hash of their levels, warm loads read it from the cache instead of going over the payload again
+static uint64_t HashImage(TextureManager::TextureLoadInfo const& info, bool generateMips, bool isCooked, CookedTexture const& cooked, std::span<std::byte const> pixels, int width, int height, int components)
+{
+	if (isCooked)
+	{
+		std::array<uint64_t, 2> shape = { uint64_t(info.Flags), cooked.ContentHash };
+		return HashBytes(std::as_bytes(std::span(shape)));
+	}
+	std::array<uint64_t, 3> shape = {
+		uint64_t(info.Flags),
+		uint64_t(components) | uint64_t(generateMips) << 32,
+		uint64_t(width) << 32 | uint32_t(height),
+	};
+	return HashBytes(pixels, HashBytes(std::as_bytes(std::span(shape))));
+}
+
+bool TextureManager::ReadImage(std::filesystem::path const& path, std::span<std::byte const> encoded, TextureLoadInfo const& info, bool generateMips, TextureCompression compression, bool useCache, size_t maxThreads, DecodedImage& outImage)
 {
-	auto it = LoadedTextures.find(path);
+	// Embedded images have no file of their own to key a cache with
+	auto cachePath = TextureCachePath(path);
+	TextureCacheKey cacheKey;
+	bool cacheable = useCache && encoded.empty() && MakeTextureCacheKey(path, compression, info.AlphaOnly, generateMips, cacheKey);
+	if (cacheable && outImage.CacheFile.Open(cachePath) && ReadTextureCache(outImage.CacheFile.Data(), cacheKey, outImage.Cooked))
+	{
+		outImage.IsCooked = true;
+		outImage.FromCache = true;
+		outImage.ContentHash = HashImage(info, generateMips, true, outImage.Cooked, {}, 0, 0, 0);
+		return true;
+	}
+	outImage.CacheFile.Close();
+
+	if (!DecodePixels(path, encoded, info.AlphaOnly, outImage))
+		return false;
+	CompressImage(outImage, info, generateMips, compression, maxThreads);
+	if (outImage.IsCompressed)
+	{
+		CookTexture(outImage.Compressed, outImage.CookedStorage, outImage.Cooked);
+		outImage.IsCooked = true;
+	}
+	else if (cacheable)
+	{
+		// Uncompressed images build their mips on the CPU as well when cached, so warm loads skip the GPU pass
+		std::vector<ImageMip> mips;
+		if (generateMips)
+			BuildMipChain({ outImage.Pixels.get(), outImage.Size() }, uint32_t(outImage.Width), uint32_t(outImage.Height), uint32_t(outImage.Components), !info.AlphaOnly, mips, maxThreads);
+		std::vector<std::span<uint8_t const>> levels = { { outImage.Pixels.get(), outImage.Size() } };
+		for (auto& mip : mips)
+			levels.push_back(mip.Pixels);
+		CookTexture(outImage.Components == 1 ? TexelFormat::R8 : TexelFormat::RGBA8, uint32_t(outImage.Width), uint32_t(outImage.Height), levels, outImage.CookedStorage, outImage.Cooked);
+		outImage.IsCooked = true;
+		outImage.Pixels.reset();
+	}
+	if (cacheable && outImage.IsCooked && !WriteTextureCache(cachePath, cacheKey, outImage.Cooked))
+		std::cout << "Failed to write texture cache " << cachePath.string() << std::endl;
+	outImage.ContentHash = HashImage(info, generateMips, outImage.IsCooked, outImage.Cooked, { reinterpret_cast<std::byte const*>(outImage.Pixels.get()), outImage.Pixels ? outImage.Size() : 0 },
+		outImage.Width, outImage.Height, outImage.Components);
+	return true;
+}
+
+void TextureManager::RecordStats(DecodedImage const& image)
+{
+	if (image.FromCache)
+	{
+		DecodeStats.CachedImages++;
+		DecodeStats.CachedBytes += image.Cooked.Payload.size();
+		if (IsBlockCompressed(image.Cooked.Format))
+			CompressionStats.AddCached(ToBlockFormat(image.Cooked.Format), image.Cooked.UncompressedBytes, image.Cooked.TexelBytes(), image.Cooked.SquaredError, image.Cooked.Samples);
+		return;
+	}
+	DecodeStats.Images++;
+	DecodeStats.DecodedBytes += image.Size();
+	DecodeStats.DecodeMilliseconds += image.Milliseconds;
+	if (image.IsCompressed)
+		CompressionStats.Add(image.Compressed);
+}
+
+DXTexture* TextureManager::ShareTexture(TextureId id, std::filesystem::path const& key)
+{
+	DXTexture* texture = Textures[id].get();
+	LoadedTextures[key] = id;
+	auto desc = texture->Resource->GetDesc();
+	SharingStats.SharedTextures++;
+	SharingStats.SavedBytes += Device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+	return texture;
+}
+
+DXTexture* TextureManager::LoadTexture(std::filesystem::path const& path, TextureManager::TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips)
+{
+	return LoadTexture(path, {}, info, frameCtx, cmdList, generateMips);
+}
+
+DXTexture* TextureManager::LoadTexture(std::filesystem::path const& key, std::span<std::byte const> encoded, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips)
+{
+	auto it = LoadedTextures.find(key);
 	if (it != LoadedTextures.end())
 	{
 		return Textures[it->second].get();
 	}
 
-	int width, height, comp;
-
-	if (stbi_info(path.string().c_str(), &width, &height, &comp) == 0)
+	DecodedImage image;
+	if (!ReadImage(key, encoded, info, generateMips, Compression, EnableTextureCache, 0, image))
 	{
-		std::cout << "Failed to load texture info for " << path << ". Reason: " << stbi_failure_reason() << std::endl;
+		std::cout << "Failed to load texture " << key << ". Reason: " << image.Error << std::endl;
 		return { 0 };
 	}
+	RecordStats(image);
+
+	TextureContentTable::Match match;
+	bool known = Contents.Find(image.ContentHash, match);
+	if (known && match.Texture)
+		return ShareTexture({ match.Texture }, key);
+	// Content an asynchronous load is still uploading is loaded again, this one cannot wait for it
+	auto* texture = CreateTexture(image, key, info, frameCtx, cmdList, generateMips);
+	if (texture && !known)
+	{
+		// Recorded into the caller's list ahead of anything drawing with it, so it is handed out right away
+		Contents.Claim(image.ContentHash, key, match);
+		Contents.Publish(image.ContentHash, LoadedTextures[key].Id);
+	}
+	return texture;
+}
+
+DXTexture* TextureManager::FindTexture(std::filesystem::path const& key)
+{
+	auto it = LoadedTextures.find(key);
+	return it != LoadedTextures.end() ? Textures[it->second].get() : nullptr;
+}
+
+void TextureManager::LoadTexturesAsync(std::span<TextureRequest const> requests, TaskScheduler& scheduler, UploadQueue& uploads, UploadQueue& copies, TextureLoadedCallback const& onLoaded)
+{
+	for (size_t requestIndex = 0; requestIndex < requests.size(); ++requestIndex)
+	{
+		auto& request = requests[requestIndex];
+		if (request.Path.empty())
+		{
+			onLoaded(requestIndex, nullptr);
+			continue;
+		}
+		auto it = LoadedTextures.find(request.Path);
+		if (it != LoadedTextures.end())
+		{
+			onLoaded(requestIndex, Textures[it->second].get());
+			continue;
+		}
+		auto [pending, inserted] = Pending.try_emplace(request.Path);
+		pending->second.push_back([onLoaded, requestIndex](DXTexture* texture)
+		{
+			onLoaded(requestIndex, texture);
+		});
+		if (inserted)
+			scheduler.Spawn(LoadTextureTask(request, scheduler, uploads, copies));
+	}
+}
+
+Task<void> TextureManager::LoadTextureTask(TextureRequest request, TaskScheduler& scheduler, UploadQueue& uploads, UploadQueue& copies)
+{
+	auto compression = Compression;
+	bool useCache = EnableTextureCache;
+	co_await scheduler.ResumeOnWorker();
+	DecodedImage image;
+	// Other textures keep the remaining workers busy, so each one compresses on a single thread
+	bool decoded = !scheduler.Cancelled() && ReadImage(request.Path, request.Encoded, request.Info, request.GenerateMips, compression, useCache, 1, image);
+	co_await scheduler.ResumeOnMainThread();
+	// Cancelled loads still complete their requests, with a null texture
+	bool cancelled = scheduler.Cancelled();
+	decoded = decoded && !cancelled;
+
+	DXTexture* texture = nullptr;
+	bool owner = false;
+	if (decoded)
+	{
+		RecordStats(image);
+		TextureContentTable::Match match;
+		owner = !Contents.Claim(image.ContentHash, request.Path, match);
+		if (!owner && match.Texture)
+			texture = ShareTexture({ match.Texture }, request.Path);
+		else if (!owner)
+		{
+			// The texture's upload is not submitted yet, so this request completes together with the load creating it
+			assert(Pending.contains(match.Owner));
+			Pending[match.Owner].push_back([this, key = request.Path, hash = image.ContentHash](DXTexture* created)
+			{
+				TextureContentTable::Match published;
+				CompleteRequests(key, created && Contents.Find(hash, published) ? ShareTexture({ published.Texture }, key) : nullptr);
+			});
+			co_return;
+		}
+	}
+	if (owner)
+	{
+		auto& queue = NeedsGraphicsQueue(image) ? uploads : copies;
+		texture = CreateTexture(image, request.Path, request.Info, queue.Begin(), queue.CommandList(), request.GenerateMips);
+		image.Pixels.reset();
+		image.Compressed = {};
+		image.CookedStorage.clear();
+		image.CacheFile.Close();
+		// Textures decoded during the same frame share the upload batch, the first one to get here submits it.
+		// Frames are submitted after graphics queue batches and wait for copy queue ones on the GPU, so neither is waited for here
+		co_await scheduler.ResumeOnMainThread();
+		queue.Submit();
+		// Only handed out from here on, before the submit a texture shared in the same Pump could be drawn with before it is uploaded
+		if (texture)
+			Contents.Publish(image.ContentHash, LoadedTextures[request.Path].Id);
+		else
+			Contents.Release(image.ContentHash);
+	}
+	if (!decoded && !cancelled)
+		std::cout << "Failed to load texture " << request.Path << ". Reason: " << image.Error << std::endl;
 
+	CompleteRequests(request.Path, texture);
+}
+
+void TextureManager::CompleteRequests(std::filesystem::path const& key, DXTexture* texture)
+{
+	auto callbacks = std::move(Pending[key]);
+	Pending.erase(key);
+	for (auto& callback : callbacks)
+		callback(texture);
+}
+
+static DXGI_FORMAT TexelDxgiFormat(TexelFormat format)
+{
+	switch (format)
+	{
+	case TexelFormat::RGBA8: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case TexelFormat::R8: return DXGI_FORMAT_R8_UNORM;
+	case TexelFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+	case TexelFormat::BC3: return DXGI_FORMAT_BC3_UNORM;
+	case TexelFormat::BC4: return DXGI_FORMAT_BC4_UNORM;
+	case TexelFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+	default: return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+DXTexture* TextureManager::CreateTexture(DecodedImage& image, std::filesystem::path const& path, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips)
+{
+	if (image.IsCooked && EnableVirtualTexturing)
+	{
+		if (auto* texture = CreateVirtualTexture(image, path, info, frameCtx, cmdList))
+			return texture;
+	}
+	if (image.IsCooked && EnableStreaming && image.Cooked.Footprints.size() > 1)
+		return CreateStreamedTexture(image, path, info, frameCtx, cmdList);
+	if (image.IsCooked)
+		return CreateCookedTexture(path, image.Cooked, info, frameCtx, cmdList);
+	return CreateTexture(path, image.Pixels.get(), image.Width, image.Height, image.Components, info, frameCtx, cmdList, generateMips);
+}
+
+bool TextureManager::NeedsGraphicsQueue(DecodedImage const& image) const
+{
+	return !image.IsCooked || EnableVirtualTexturing || (EnableStreaming && image.Cooked.Footprints.size() > 1);
+}
+
+DXTexture* TextureManager::CreateCookedTexture(std::filesystem::path const& path, CookedTexture const& cooked, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	// Textures copied on a copy queue decay to the common state, the graphics queue promotes them when it samples them
+	bool copyQueue = cmdList->GetType() == D3D12_COMMAND_LIST_TYPE_COPY;
+	auto texture = CreateCookedResource(path.filename().wstring(), cooked, 0, info.Flags, copyQueue ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_COPY_DEST);
+	UploadCookedLevels(texture, cooked, 0, 0, uint32_t(cooked.Footprints.size()), frameCtx, cmdList);
+	if (!copyQueue)
+		TransitionVec(texture, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE).Execute(cmdList);
+	return AddTexture(path, texture);
+}
+
+DXTexture* TextureManager::CreateVirtualTexture(DecodedImage& image, std::filesystem::path const& path, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	auto& cooked = image.Cooked;
+	DXTexture::TextureCreateInfo createInfo = {
+	.Width = cooked.Width(),
+	.Height = cooked.Height(),
+	.MipLevels = uint16_t(cooked.Footprints.size()),
+	.Format = TexelDxgiFormat(cooked.Format),
+	.Flags = info.Flags,
+	};
+
+	DXTexture texture;
+	auto* virtualTexture = VirtualTextureManager::Get().CreateTexture(path.filename().wstring(), createInfo, cooked, frameCtx, cmdList, texture);
+	if (!virtualTexture)
+		return nullptr;
+
+	// Only the packed levels are uploaded now, the tiles of the others follow the feedback
+	uint32_t standardLevels = virtualTexture->Layout.StandardLevels;
+	if (standardLevels < createInfo.MipLevels)
+		UploadCookedLevels(texture, cooked, 0, standardLevels, createInfo.MipLevels, frameCtx, cmdList);
+	TransitionVec(texture, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE).Execute(cmdList);
+	virtualTexture->CookedStorage = std::move(image.CookedStorage);
+	virtualTexture->CacheFile = std::move(image.CacheFile);
+	return AddTexture(path, texture);
+}
+
+// Block compressed resources need a top level that is whole blocks, the levels below such a top are never streamed on their own
+static uint32_t StreamableLevels(CookedTexture const& cooked)
+{
+	if (!IsBlockCompressed(cooked.Format))
+		return uint32_t(cooked.Footprints.size());
+	uint32_t levels = 0;
+	while (levels < cooked.Footprints.size() && cooked.Footprints[levels].Width % 4 == 0 && cooked.Footprints[levels].Height % 4 == 0)
+		++levels;
+	return std::max(levels, 1u);
+}
+
+DXTexture* TextureManager::CreateStreamedTexture(DecodedImage& image, std::filesystem::path const& path, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	auto& cooked = image.Cooked;
+	uint32_t mipCount = uint32_t(cooked.Footprints.size());
+	std::vector<uint64_t> levelBytes;
+	for (auto& footprint : cooked.Footprints)
+		levelBytes.push_back(uint64_t(footprint.RowPitch) * footprint.RowCount);
+	// The streamer sees the levels that cannot be a top as part of the last one that can
+	uint32_t streamable = StreamableLevels(cooked);
+	levelBytes[streamable - 1] = std::accumulate(levelBytes.begin() + streamable - 1, levelBytes.end(), uint64_t(0));
+	levelBytes.resize(streamable);
+
+	Streamer.Settings = StreamingSettings;
+	uint32_t handle = Streamer.Add(cooked.Width(), cooked.Height(), levelBytes);
+	uint32_t top = Streamer.GetAllocatedTop(handle);
+
+	auto texture = CreateCookedResource(path.filename().wstring(), cooked, top, info.Flags);
+	UploadCookedLevels(texture, cooked, top, top, mipCount, frameCtx, cmdList);
+	TransitionVec(texture, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE).Execute(cmdList);
+	DXTexture* added = AddTexture(path, texture);
+
+	// Moving the storage and the mapping keeps the payload where it is
+	auto& streamed = StreamedTextures.emplace_back();
+	streamed.Texture = added;
+	streamed.Cooked = cooked;
+	streamed.CookedStorage = std::move(image.CookedStorage);
+	streamed.CacheFile = std::move(image.CacheFile);
+	StreamedHandles[added] = handle;
+	return added;
+}
+
+DXTexture TextureManager::CreateCookedResource(std::wstring const& name, CookedTexture const& cooked, uint32_t top, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state)
+{
+	DXTexture::TextureCreateInfo createInfo = {
+	.Width = cooked.Footprints[top].Width,
+	.Height = cooked.Footprints[top].Height,
+	.MipLevels = uint16_t(cooked.Footprints.size() - top),
+	.Format = TexelDxgiFormat(cooked.Format),
+	.Flags = flags,
+	};
+
+	return DXTexture::Create(Device, name, createInfo, state);
+}
+
+void TextureManager::UploadCookedLevels(DXTexture& texture, CookedTexture const& cooked, uint32_t top, uint32_t begin, uint32_t end, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	// The cooked layout is built to match the device's, then the levels go into the upload buffer with one copy
+	uint32_t subresourceCount = end - begin;
+	auto desc = texture.Resource->GetDesc();
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+	std::vector<UINT> rowCounts(subresourceCount);
+	std::vector<UINT64> rowBytes(subresourceCount);
+	UINT64 totalBytes = 0;
+	Device->GetCopyableFootprints(&desc, begin - top, subresourceCount, 0, layouts.data(), rowCounts.data(), rowBytes.data(), &totalBytes);
+	uint64_t base = cooked.Footprints[begin].Offset;
+	bool sameLayout = base + totalBytes <= cooked.Payload.size();
+	for (uint32_t i = 0; i < subresourceCount && sameLayout; ++i)
+	{
+		auto& footprint = cooked.Footprints[begin + i];
+		sameLayout = layouts[i].Offset == footprint.Offset - base && layouts[i].Footprint.RowPitch == footprint.RowPitch && rowCounts[i] == footprint.RowCount && rowBytes[i] == footprint.RowBytes;
+	}
+
+	auto staging = AllocateStaging(Device, frameCtx, totalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	auto* mapped = staging.Data;
+	if (sameLayout)
+		std::memcpy(mapped, cooked.Payload.data() + base, totalBytes);
+	else
+	{
+		for (uint32_t i = 0; i < subresourceCount; ++i)
+		{
+			auto& footprint = cooked.Footprints[begin + i];
+			for (uint32_t row = 0; row < footprint.RowCount; ++row)
+				std::memcpy(mapped + layouts[i].Offset + uint64_t(row) * layouts[i].Footprint.RowPitch, cooked.Payload.data() + footprint.Offset + uint64_t(row) * footprint.RowPitch, footprint.RowBytes);
+		}
+	}
+
+	for (uint32_t i = 0; i < subresourceCount; ++i)
+	{
+		layouts[i].Offset += staging.Offset;
+		CD3DX12_TEXTURE_COPY_LOCATION dst(texture.Resource.Get(), begin - top + i);
+		CD3DX12_TEXTURE_COPY_LOCATION src(staging.Resource, layouts[i]);
+		cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	}
+}
+
+TextureView* TextureManager::CreateView(DXTexture* texture, bool srgb)
+{
+	auto& shared = SharedViews[texture][srgb];
+	if (shared)
+	{
+		SharingStats.SharedViews++;
+		SharingStats.SavedDescriptors += TextureView::Versions;
+		return shared;
+	}
+
+	auto& view = *Views.emplace_back(std::make_unique<TextureView>());
+	shared = &view;
+	view.Descriptors = g_GPUDescriptorAllocator->AllocateFromStatic(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, TextureView::Versions);
+	view.Srgb = srgb;
+	view.Current = TextureView::Versions - 1;
+	float minLod = 0.0f;
+	auto it = StreamedHandles.find(texture);
+	if (it != StreamedHandles.end())
+	{
+		view.StreamedTexture = it->second;
+		StreamedTextures[it->second].Views.push_back(&view);
+		minLod = float(Streamer.GetResidentTop(it->second) - Streamer.GetAllocatedTop(it->second));
+	}
+	WriteView(view, *texture, minLod);
+	return &view;
+}
+
+void TextureManager::WriteView(TextureView& view, DXTexture& texture, float minLod)
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = view.Srgb ? ToSrgbFormat(texture.Info.Format) : texture.Info.Format;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Texture2D.MipLevels = -1;
+	// Levels above the clamp are allocated but not uploaded yet
+	srvDesc.Texture2D.ResourceMinLODClamp = minLod;
+	view.Current = (view.Current + 1) % TextureView::Versions;
+	texture.CreatePlacedSRV(view.Descriptors.GetView(view.Current), &srvDesc);
+}
+
+void TextureManager::UpdateStreaming(std::span<TextureUse const> uses, UploadQueue& uploads)
+{
+	if (StreamedTextures.empty())
+		return;
+
+	Streamer.Settings = StreamingSettings;
+	for (auto& use : uses)
+	{
+		if (use.View->StreamedTexture != TextureView::NotStreamed)
+			Streamer.Request(use.View->StreamedTexture, use.Pixels);
+	}
+	Streamer.Update(StreamingActions);
+	if (StreamingActions.empty())
+		return;
+
+	// Recorded on the graphics queue, frames sampling the old resources were submitted before it
+	auto& frameCtx = uploads.Begin();
+	auto* cmdList = uploads.CommandList();
+	for (auto& action : StreamingActions)
+	{
+		auto& streamed = StreamedTextures[action.Texture];
+		DXTexture& texture = *streamed.Texture;
+		uint32_t mipCount = uint32_t(streamed.Cooked.Footprints.size());
+		if (action.NewTop != action.OldTop)
+		{
+			auto resized = CreateCookedResource(texture.Name, streamed.Cooked, action.NewTop, texture.Info.Flags);
+			// Levels both resources hold are copied on the GPU, the old resource is released once the batch executed
+			TransitionVec(texture, D3D12_RESOURCE_STATE_COPY_SOURCE).Execute(cmdList);
+			for (uint32_t level = action.CopyBegin; level < mipCount; ++level)
+			{
+				CD3DX12_TEXTURE_COPY_LOCATION dst(resized.Resource.Get(), level - action.NewTop);
+				CD3DX12_TEXTURE_COPY_LOCATION src(texture.Resource.Get(), level - action.OldTop);
+				cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+			}
+			frameCtx.IntermediateResources.push_back(texture.Resource);
+			texture = std::move(resized);
+		}
+		else
+			TransitionVec(texture, D3D12_RESOURCE_STATE_COPY_DEST).Execute(cmdList);
+
+		if (action.UploadBegin < action.UploadEnd)
+			UploadCookedLevels(texture, streamed.Cooked, action.NewTop, action.UploadBegin, action.UploadEnd, frameCtx, cmdList);
+		TransitionVec(texture, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE).Execute(cmdList);
+		for (TextureView* view : streamed.Views)
+			WriteView(*view, texture, float(action.ResidentTop - action.NewTop));
+	}
+	uploads.Submit();
+}
+
+DXTexture* TextureManager::CreateTexture(std::filesystem::path const& path, unsigned char const* data, int width, int height, int desiredComp, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips)
+{
 	DXTexture::TextureCreateInfo createInfo = {
 	.Width = uint32_t(width),
 	.Height = uint32_t(height),
@@ -39,41 +534,30 @@ DXTexture* dxpg::TextureManager::LoadTexture(std::filesystem::path const& path,
 	if (generateMips)
 		createInfo.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 
-	int desiredComp = info.AlphaOnly ? STBI_grey : STBI_rgb_alpha;
-	stbi_set_flip_vertically_on_load(true);
-	stbi_uc* data = stbi_load(path.string().c_str(), &width, &height, &comp, desiredComp);
-
-	if (data == nullptr)
-	{
-		std::cout << "Failed to load texture " << path << ". Reason: " << stbi_failure_reason() << std::endl;
-		return { 0 };
-	}
-
 	auto texture = DXTexture::Create(Device, path.filename().wstring(), createInfo, D3D12_RESOURCE_STATE_COPY_DEST);
 
 	// Copy the data to the texture
 	{
-		// Create the intermediate upload heap
-		auto intermediateBuf = DXBuffer::Create(Device, path.filename().wstring() + L"_IntermediateBuffer", width * height * desiredComp, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
-
-		frameCtx.IntermediateResources.push_back(intermediateBuf.Resource);
+		auto staging = AllocateStaging(Device, frameCtx, GetRequiredIntermediateSize(texture.Resource.Get(), 0, 1), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
 
 		D3D12_SUBRESOURCE_DATA subresourceData = {};
 		subresourceData.pData = data;
 		subresourceData.RowPitch = width * desiredComp;
 		subresourceData.SlicePitch = height * subresourceData.RowPitch;
 
-		UpdateSubresources(cmdList, texture.Resource.Get(), intermediateBuf.Resource.Get(), 0, 0, 1, &subresourceData);
+		UpdateSubresources(cmdList, texture.Resource.Get(), staging.Resource, staging.Offset, 0, 1, &subresourceData);
 	}
 
-	stbi_image_free(data);
-
 	if (generateMips)
 	{
 		GenerateMips.GenerateMips(frameCtx, cmdList, texture, width, height);
 	}
 
+	return AddTexture(path, texture);
+}
 
+DXTexture* TextureManager::AddTexture(std::filesystem::path const& path, DXTexture const& texture)
+{
 	TextureId id = NextId;
 	NextId.Id++;
 	
@@ -3,17 +3,63 @@
 #include "DXResource.h"
 #include "DXPGCommon.h"
 #include "filesystem"
+#include <array>
+#include <functional>
+#include <span>
 #include "Pipelines/GenerateMipsPipeline.h"
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "TextureCache.h"
+#include "TextureCompression.h"
+#include "TextureDecode.h"
+#include "TextureSharing.h"
+#include "TextureStreaming.h"
+#include "MappedFile.h"
+#include "RendererCommon.h"
+#include "UploadQueue.h"
 
 DXPG_ID_STRUCT_U32(dxpg, TextureId)
 
 namespace dxpg
 {
 
+struct TextureDecodeStats
+{
+	uint32_t Images = 0;
+	uint64_t DecodedBytes = 0;
+	// Summed over the decoding threads
+	double DecodeMilliseconds = 0.0;
+	// Read from the texture cache instead of decoded
+	uint32_t CachedImages = 0;
+	uint64_t CachedBytes = 0;
+};
+
+// Textures and views shared instead of created again
+struct TextureSharingStats
+{
+	// Images whose content matched a loaded texture under another key
+	uint32_t SharedTextures = 0;
+	// GPU memory the shared textures would have taken
+	uint64_t SavedBytes = 0;
+	// Views handed out again instead of allocating their descriptors
+	uint32_t SharedViews = 0;
+	uint32_t SavedDescriptors = 0;
+};
+
 struct TextureManager : public Singleton<TextureManager>
 {
 	void Init(ID3D12Device2* device);
 
+	// Block compresses textures whose size is a multiple of 4, their mips are built on the CPU instead of the GPU
+	TextureCompression Compression = TextureCompression::Fast;
+	// Cooks textures loaded from files with all their levels next to the source, warm loads copy them as they are
+	bool EnableTextureCache = true;
+	// Cooked textures load only their levels up to StreamingSettings.ResidentSize, UpdateStreaming brings in the rest as they are drawn
+	bool EnableStreaming = false;
+	TextureStreamingSettings StreamingSettings;
+	// Cooked textures with at least one full tile become virtual textures, this takes precedence over streaming
+	bool EnableVirtualTexturing = false;
+
 	struct TextureLoadInfo
 	{
 		bool AlphaOnly = false;
@@ -21,10 +67,101 @@ struct TextureManager : public Singleton<TextureManager>
 	};
 
 	DXTexture* LoadTexture(std::filesystem::path const& path, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips = true);
+	// Decodes an image already in memory, key only identifies it for later loads
+	DXTexture* LoadTexture(std::filesystem::path const& key, std::span<std::byte const> encoded, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips = true);
+
+	struct TextureRequest
+	{
+		// File to decode, or only the key when Encoded is set
+		std::filesystem::path Path;
+		// Has to stay valid until the request completed
+		std::span<std::byte const> Encoded;
+		TextureLoadInfo Info;
+		bool GenerateMips = true;
+	};
+	// Gets the index of the request, the texture is null when the image could not be decoded or the scheduler was cancelled.
+	// Every request completes exactly once
+	using TextureLoadedCallback = std::function<void(size_t, DXTexture*)>;
+	// Decodes and compresses every image on the scheduler's workers, each one is created, uploaded and has its mips generated if uncompressed on the main thread
+	// as soon as its decode finished. Cooked textures that neither stream nor are virtual upload on copies, the others on uploads.
+	// onLoaded runs on the main thread once the upload is submitted, right away for loaded textures. Uploads of copies have to be
+	// waited for by the frames drawing with the texture, a batch of copies submitted later covers them.
+	// Requests for a texture that is already on its way wait for that load instead of decoding it again
+	void LoadTexturesAsync(std::span<TextureRequest const> requests, TaskScheduler& scheduler, UploadQueue& uploads, UploadQueue& copies, TextureLoadedCallback const& onLoaded);
+	bool IsLoaded(std::filesystem::path const& key) const { return LoadedTextures.contains(key); }
+	// Null when the texture is not loaded
+	DXTexture* FindTexture(std::filesystem::path const& key);
+	size_t PendingTextures() const { return Pending.size(); }
+
+	TextureDecodeStats const& GetDecodeStats() const { return DecodeStats; }
+	TextureCompressionStats const& GetCompressionStats() const { return CompressionStats; }
+
+	// View to bind the texture through, follows its resident levels when it streams. Every caller asking for the same texture and format shares one
+	TextureView* CreateView(DXTexture* texture, bool srgb);
+	TextureSharingStats const& GetSharingStats() const { return SharingStats; }
+	// Grows and evicts the streamed textures after last frame's uses and records their copies. Has to run before the frame is recorded,
+	// the uploads are submitted ahead of it and the views it binds already point to the new resources
+	void UpdateStreaming(std::span<TextureUse const> uses, UploadQueue& uploads);
+	TextureStreamingStats const& GetStreamingStats() const { return Streamer.GetStats(); }
 
 private:
+	struct DecodedImage;
+	// Replaces the pixels with their compressed mip chain when the image can be compressed
+	static void CompressImage(DecodedImage& image, TextureLoadInfo const& info, bool generateMips, TextureCompression compression, size_t maxThreads);
+	// Maps the cooked texture from its cache, or decodes, compresses and cooks the image and refreshes the cache. Touches no D3D state
+	static bool ReadImage(std::filesystem::path const& path, std::span<std::byte const> encoded, TextureLoadInfo const& info, bool generateMips, TextureCompression compression, bool useCache, size_t maxThreads, DecodedImage& outImage);
+	void RecordStats(DecodedImage const& image);
+	// Loads key as the texture with the same content, which was published already
+	DXTexture* ShareTexture(TextureId id, std::filesystem::path const& key);
+	// Streamed textures take over the image's cooked source
+	DXTexture* CreateTexture(DecodedImage& image, std::filesystem::path const& path, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips);
+	// Mip generation, streaming and tile mappings are graphics queue work
+	bool NeedsGraphicsQueue(DecodedImage const& image) const;
+	// On a copy list the texture is left in the common state
+	DXTexture* CreateCookedTexture(std::filesystem::path const& path, CookedTexture const& cooked, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+	// Null when the texture cannot be virtual, it then loads as usual
+	DXTexture* CreateVirtualTexture(DecodedImage& image, std::filesystem::path const& path, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+	DXTexture* CreateStreamedTexture(DecodedImage& image, std::filesystem::path const& path, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+	// Resource holding the cooked levels from top on
+	DXTexture CreateCookedResource(std::wstring const& name, CookedTexture const& cooked, uint32_t top, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COPY_DEST);
+	// Copies levels [begin, end) into a resource whose first level is top
+	void UploadCookedLevels(DXTexture& texture, CookedTexture const& cooked, uint32_t top, uint32_t begin, uint32_t end, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+	// Writes the view's next descriptor
+	void WriteView(TextureView& view, DXTexture& texture, float minLod);
+	DXTexture* CreateTexture(std::filesystem::path const& path, unsigned char const* data, int width, int height, int desiredComp, TextureLoadInfo const& info, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, bool generateMips);
+	DXTexture* AddTexture(std::filesystem::path const& path, DXTexture const& texture);
+	Task<void> LoadTextureTask(TextureRequest request, TaskScheduler& scheduler, UploadQueue& uploads, UploadQueue& copies);
+	// Runs and drops the callbacks waiting for key
+	void CompleteRequests(std::filesystem::path const& key, DXTexture* texture);
+
 	std::unordered_map<TextureId, std::unique_ptr<DXTexture>> Textures;
 	std::unordered_map<std::filesystem::path, TextureId> LoadedTextures;
+	// Keyed by the content hash ReadImage computes, identical images under different paths or embedded twice load once
+	TextureContentTable Contents;
+	// Callbacks of the textures being decoded or uploaded, only touched on the main thread
+	std::unordered_map<std::filesystem::path, std::vector<std::function<void(DXTexture*)>>> Pending;
+	TextureDecodeStats DecodeStats;
+	TextureCompressionStats CompressionStats;
+
+	struct StreamedTexture
+	{
+		DXTexture* Texture;
+		// Source of the levels that are not resident, open for as long as the texture lives
+		CookedTexture Cooked;
+		std::vector<std::byte> CookedStorage;
+		MappedFile CacheFile;
+		std::vector<TextureView*> Views;
+	};
+	// Indexed by the streamer's handles
+	std::vector<StreamedTexture> StreamedTextures;
+	std::unordered_map<DXTexture const*, uint32_t> StreamedHandles;
+	TextureStreamer Streamer;
+	std::vector<TextureStreamingAction> StreamingActions;
+	std::vector<std::unique_ptr<TextureView>> Views;
+	// Indexed by srgb
+	std::unordered_map<DXTexture const*, std::array<TextureView*, 2>> SharedViews;
+	TextureSharingStats SharingStats;
+
 	ID3D12Device2* Device;
 	TextureId NextId = { 1 };
 	GenerateMipsPipeline GenerateMips;
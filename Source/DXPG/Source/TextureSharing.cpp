@@ -0,0 +1,37 @@
+#include "TextureSharing.h"
+
+#include <cassert>
+
+namespace dxpg
+{
+
+bool TextureContentTable::Claim(uint64_t hash, std::filesystem::path const& key, Match& outMatch)
+{
+	auto [it, inserted] = Contents.try_emplace(hash, Match{ 0, key });
+	outMatch = it->second;
+	return !inserted;
+}
+
+bool TextureContentTable::Find(uint64_t hash, Match& outMatch) const
+{
+	auto it = Contents.find(hash);
+	if (it == Contents.end())
+		return false;
+	outMatch = it->second;
+	return true;
+}
+
+void TextureContentTable::Publish(uint64_t hash, uint32_t texture)
+{
+	auto it = Contents.find(hash);
+	assert(it != Contents.end() && it->second.Texture == 0 && texture != 0);
+	it->second.Texture = texture;
+}
+
+void TextureContentTable::Release(uint64_t hash)
+{
+	assert(Contents.contains(hash) && Contents[hash].Texture == 0);
+	Contents.erase(hash);
+}
+
+}
\ No newline at end of file
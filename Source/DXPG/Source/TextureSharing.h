@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+
+namespace dxpg
+{
+
+// Identical images under different keys resolve to the texture of the first one by their content hash. A texture is only handed out
+// once its upload was submitted, images matching one that is still on its way wait for the load creating it
+struct TextureContentTable
+{
+	struct Match
+	{
+		// Texture id once published, 0 while it is still loading
+		uint32_t Texture = 0;
+		// Key of the load creating the texture
+		std::filesystem::path Owner;
+	};
+
+	// False when the content is new, key then owns it and has to Publish or Release it
+	bool Claim(uint64_t hash, std::filesystem::path const& key, Match& outMatch);
+	// Looks up without claiming, for loads that cannot wait for another one
+	bool Find(uint64_t hash, Match& outMatch) const;
+	// The owner's upload was submitted, texture is handed out from now on
+	void Publish(uint64_t hash, uint32_t texture);
+	// The owner failed, the next image with the content loads it again
+	void Release(uint64_t hash);
+
+private:
+	std::unordered_map<uint64_t, Match> Contents;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "TextureStreaming.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+namespace dxpg
+{
+
+uint32_t DesiredMipLevel(uint32_t width, uint32_t height, uint32_t mipCount, float pixels, float bias)
+{
+	assert(mipCount > 0);
+	if (!(pixels > 0.0f))
+	{
+		return mipCount - 1;
+	}
+
+	float const level = std::floor(std::log2(float(std::max(width, height)) / pixels) + bias);
+	return uint32_t(std::clamp(level, 0.0f, float(mipCount - 1)));
+}
+
+uint32_t ResidentMipLevel(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t size)
+{
+	assert(mipCount > 0);
+	uint32_t level = 0;
+	while (level + 1 < mipCount && std::max(width >> level, height >> level) > size)
+	{
+		++level;
+	}
+	return level;
+}
+
+uint32_t TextureStreamer::Add(uint32_t width, uint32_t height, std::span<uint64_t const> levelBytes)
+{
+	assert(!levelBytes.empty());
+
+	Entry& entry = Entries.emplace_back();
+	entry.Width = width;
+	entry.Height = height;
+	entry.LevelBytes.assign(levelBytes.begin(), levelBytes.end());
+	entry.BaseTop = ResidentMipLevel(width, height, uint32_t(levelBytes.size()), Settings.ResidentSize);
+	entry.AllocatedTop = entry.BaseTop;
+	entry.ResidentTop = entry.BaseTop;
+	entry.Wanted = entry.BaseTop;
+
+	uint64_t const baseBytes = LevelBytes(entry, entry.BaseTop, uint32_t(levelBytes.size()));
+	++Stats.Textures;
+	Stats.AllocatedBytes += baseBytes;
+	Stats.WantedBytes += baseBytes;
+	Stats.FullBytes += LevelBytes(entry, 0, uint32_t(levelBytes.size()));
+	return uint32_t(Entries.size() - 1);
+}
+
+void TextureStreamer::Request(uint32_t texture, float pixels)
+{
+	Entry& entry = Entries[texture];
+	uint32_t const level = DesiredMipLevel(entry.Width, entry.Height, uint32_t(entry.LevelBytes.size()), pixels, Settings.MipBias);
+	if (entry.LastUsed != Frame)
+	{
+		entry.LastUsed = Frame;
+		entry.Wanted = entry.BaseTop;
+	}
+	entry.Wanted = std::min(entry.Wanted, level);
+}
+
+uint64_t TextureStreamer::LevelBytes(Entry const& entry, uint32_t begin, uint32_t end) const
+{
+	if (begin >= end)
+	{
+		return 0;
+	}
+	return std::accumulate(entry.LevelBytes.begin() + begin, entry.LevelBytes.begin() + end, uint64_t(0));
+}
+
+uint32_t TextureStreamer::KeepTop(Entry const& entry) const
+{
+	// Used this frame, only what it did not ask for can go
+	return entry.LastUsed == Frame ? entry.Wanted : entry.BaseTop;
+}
+
+TextureStreamingAction& TextureStreamer::GetAction(uint32_t texture, std::vector<int32_t>& actionIndex, std::vector<TextureStreamingAction>& actions)
+{
+	if (actionIndex[texture] < 0)
+	{
+		Entry const& entry = Entries[texture];
+		actionIndex[texture] = int32_t(actions.size());
+		actions.push_back({ texture, entry.AllocatedTop, entry.AllocatedTop, entry.ResidentTop, entry.ResidentTop, entry.ResidentTop, entry.ResidentTop });
+	}
+	return actions[actionIndex[texture]];
+}
+
+bool TextureStreamer::MakeRoom(uint64_t bytes, uint32_t exclude, std::vector<int32_t>& actionIndex, std::vector<TextureStreamingAction>& actions)
+{
+	if (Stats.AllocatedBytes + bytes <= Settings.BudgetBytes)
+	{
+		return true;
+	}
+
+	std::vector<uint32_t> victims;
+	uint64_t evictable = 0;
+	for (uint32_t i = 0; i < Entries.size(); ++i)
+	{
+		Entry const& entry = Entries[i];
+		if (i != exclude && actionIndex[i] < 0 && entry.AllocatedTop < KeepTop(entry))
+		{
+			victims.push_back(i);
+			evictable += LevelBytes(entry, entry.AllocatedTop, KeepTop(entry));
+		}
+	}
+	// Shrinking to the budget is best effort, growing is not worth a partial eviction
+	if (bytes > 0 && Stats.AllocatedBytes - evictable + bytes > Settings.BudgetBytes)
+	{
+		return false;
+	}
+
+	std::stable_sort(victims.begin(), victims.end(), [this](uint32_t a, uint32_t b) { return Entries[a].LastUsed < Entries[b].LastUsed; });
+	for (uint32_t victim : victims)
+	{
+		if (Stats.AllocatedBytes + bytes <= Settings.BudgetBytes)
+		{
+			break;
+		}
+
+		Entry& entry = Entries[victim];
+		uint32_t const keepTop = KeepTop(entry);
+		uint32_t newTop = entry.AllocatedTop;
+		while (newTop < keepTop && Stats.AllocatedBytes + bytes > Settings.BudgetBytes)
+		{
+			Stats.AllocatedBytes -= entry.LevelBytes[newTop++];
+		}
+
+		TextureStreamingAction& action = GetAction(victim, actionIndex, actions);
+		entry.AllocatedTop = newTop;
+		entry.ResidentTop = std::max(entry.ResidentTop, newTop);
+		action.NewTop = newTop;
+		action.CopyBegin = entry.ResidentTop;
+		action.UploadBegin = entry.ResidentTop;
+		action.UploadEnd = entry.ResidentTop;
+		action.ResidentTop = entry.ResidentTop;
+		++Stats.Evicted;
+	}
+	return Stats.AllocatedBytes + bytes <= Settings.BudgetBytes;
+}
+
+void TextureStreamer::Update(std::vector<TextureStreamingAction>& outActions)
+{
+	outActions.clear();
+	std::vector<int32_t> actionIndex(Entries.size(), -1);
+	uint32_t const none = uint32_t(Entries.size());
+
+	// The budget may have shrunk since the last frame
+	MakeRoom(0, none, actionIndex, outActions);
+
+	// Grow the textures missing the most levels first, settling for coarser ones when the budget cannot hold what they want
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < Entries.size(); ++i)
+	{
+		Entry const& entry = Entries[i];
+		if (entry.LastUsed == Frame && entry.Wanted < entry.AllocatedTop && actionIndex[i] < 0)
+		{
+			candidates.push_back(i);
+		}
+	}
+	std::stable_sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+	{
+		return Entries[a].AllocatedTop - Entries[a].Wanted > Entries[b].AllocatedTop - Entries[b].Wanted;
+	});
+	for (uint32_t candidate : candidates)
+	{
+		Entry& entry = Entries[candidate];
+		uint32_t target = entry.Wanted;
+		while (target < entry.AllocatedTop && !MakeRoom(LevelBytes(entry, target, entry.AllocatedTop), candidate, actionIndex, outActions))
+		{
+			++target;
+		}
+		if (target == entry.AllocatedTop)
+		{
+			continue;
+		}
+
+		TextureStreamingAction& action = GetAction(candidate, actionIndex, outActions);
+		Stats.AllocatedBytes += LevelBytes(entry, target, entry.AllocatedTop);
+		entry.AllocatedTop = target;
+		action.NewTop = target;
+		++Stats.Grown;
+	}
+
+	// Fill in missing levels, textures used this frame before the rest
+	std::vector<uint32_t> pending;
+	for (uint32_t i = 0; i < Entries.size(); ++i)
+	{
+		if (Entries[i].ResidentTop > Entries[i].AllocatedTop)
+		{
+			pending.push_back(i);
+		}
+	}
+	std::stable_sort(pending.begin(), pending.end(), [this](uint32_t a, uint32_t b) { return Entries[a].LastUsed > Entries[b].LastUsed; });
+
+	uint64_t uploaded = 0;
+	for (uint32_t texture : pending)
+	{
+		Entry& entry = Entries[texture];
+		uint32_t residentTop = entry.ResidentTop;
+		while (residentTop > entry.AllocatedTop)
+		{
+			uint64_t const bytes = entry.LevelBytes[residentTop - 1];
+			if (uploaded > 0 && uploaded + bytes > Settings.UploadBytesPerFrame)
+			{
+				break;
+			}
+			uploaded += bytes;
+			--residentTop;
+		}
+		if (residentTop == entry.ResidentTop)
+		{
+			break;
+		}
+
+		TextureStreamingAction& action = GetAction(texture, actionIndex, outActions);
+		action.UploadBegin = residentTop;
+		action.UploadEnd = entry.ResidentTop;
+		action.ResidentTop = residentTop;
+		entry.ResidentTop = residentTop;
+	}
+	Stats.UploadedBytes += uploaded;
+
+	Stats.WantedBytes = 0;
+	for (Entry& entry : Entries)
+	{
+		Stats.WantedBytes += LevelBytes(entry, entry.LastUsed == Frame ? entry.Wanted : entry.BaseTop, uint32_t(entry.LevelBytes.size()));
+	}
+	++Frame;
+}
+
+}
\ No newline at end of file
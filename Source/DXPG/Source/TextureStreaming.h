@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace dxpg
+{
+
+struct TextureStreamingSettings
+{
+	// Levels up to this size are loaded up front and never evicted
+	uint32_t ResidentSize = 64;
+	uint64_t BudgetBytes = uint64_t(256) << 20;
+	// Uploads of a frame stop at this many bytes, the first level always goes through
+	uint64_t UploadBytesPerFrame = uint64_t(16) << 20;
+	// Added to the estimated level, UVs usually tile so the default streams one level finer than the object's size asks for
+	float MipBias = -1.0f;
+};
+
+// Finest level worth having when the texture's larger side covers pixels on screen
+uint32_t DesiredMipLevel(uint32_t width, uint32_t height, uint32_t mipCount, float pixels, float bias);
+// First level no larger than size along either side
+uint32_t ResidentMipLevel(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t size);
+
+// What the GPU side has to do for a texture, there is at most one per texture and frame so its views change once per frame.
+// Levels are counted from the full resolution one
+struct TextureStreamingAction
+{
+	uint32_t Texture;
+	// First level of the resource before and after, the resource is replaced when they differ
+	uint32_t OldTop;
+	uint32_t NewTop;
+	// The replacement gets [CopyBegin, mip count) from the old resource
+	uint32_t CopyBegin;
+	// Levels [UploadBegin, UploadEnd) come from the cooked source
+	uint32_t UploadBegin;
+	uint32_t UploadEnd;
+	// Finest level with data afterwards, the views are clamped to it
+	uint32_t ResidentTop;
+};
+
+struct TextureStreamingStats
+{
+	uint32_t Textures = 0;
+	uint64_t AllocatedBytes = 0;
+	// What the textures would take with the levels wanted last frame, and with all of their levels
+	uint64_t WantedBytes = 0;
+	uint64_t FullBytes = 0;
+	// Totals since the start
+	uint32_t Grown = 0;
+	uint32_t Evicted = 0;
+	uint64_t UploadedBytes = 0;
+};
+
+// Decides which levels of which textures are resident. Knows nothing about D3D, the texture manager carries out its actions
+struct TextureStreamer
+{
+	TextureStreamingSettings Settings;
+
+	// levelBytes holds every level, finest first. The texture starts out with the levels up to Settings.ResidentSize resident
+	uint32_t Add(uint32_t width, uint32_t height, std::span<uint64_t const> levelBytes);
+	uint32_t GetAllocatedTop(uint32_t texture) const { return Entries[texture].AllocatedTop; }
+	uint32_t GetResidentTop(uint32_t texture) const { return Entries[texture].ResidentTop; }
+
+	// Called for every use of the texture this frame, pixels is the on-screen size of the object using it. The finest level asked for wins
+	void Request(uint32_t texture, float pixels);
+	// Grows the wanted textures within the budget by evicting the least recently used levels, then spends the frame's
+	// upload budget on the missing levels, coarsest first. The state already reflects the actions once this returns
+	void Update(std::vector<TextureStreamingAction>& outActions);
+
+	TextureStreamingStats const& GetStats() const { return Stats; }
+
+private:
+	struct Entry
+	{
+		uint32_t Width;
+		uint32_t Height;
+		std::vector<uint64_t> LevelBytes;
+		// Levels from here on are always resident
+		uint32_t BaseTop;
+		uint32_t AllocatedTop;
+		uint32_t ResidentTop;
+		// Finest level asked for this frame, BaseTop when unused
+		uint32_t Wanted;
+		uint64_t LastUsed = 0;
+	};
+
+	uint64_t LevelBytes(Entry const& entry, uint32_t begin, uint32_t end) const;
+	// Level the entry keeps when it is evicted from
+	uint32_t KeepTop(Entry const& entry) const;
+	// Evicts until bytes more fit, entries that already have an action this frame are left alone. False when they do not fit
+	bool MakeRoom(uint64_t bytes, uint32_t exclude, std::vector<int32_t>& actionIndex, std::vector<TextureStreamingAction>& actions);
+	TextureStreamingAction& GetAction(uint32_t texture, std::vector<int32_t>& actionIndex, std::vector<TextureStreamingAction>& actions);
+
+	std::vector<Entry> Entries;
+	uint64_t Frame = 1;
+	TextureStreamingStats Stats;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace dxpg
+{
+
+uint32_t TlsfAllocator::SizeToBinRoundUp(uint32_t size)
+{
+	// Sizes below the mantissa range map to themselves
+	if (size < LeafBinCount)
+		return size;
+	uint32_t shift = std::bit_width(size) - 1 - MantissaBits;
+	uint32_t mantissa = (size >> shift) & (LeafBinCount - 1);
+	// Rounding up may carry into the exponent, which is still the next bin
+	if (size & ((1u << shift) - 1))
+		mantissa++;
+	return ((shift + 1) << MantissaBits) + mantissa;
+}
+
+uint32_t TlsfAllocator::SizeToBinRoundDown(uint32_t size)
+{
+	if (size < LeafBinCount)
+		return size;
+	uint32_t shift = std::bit_width(size) - 1 - MantissaBits;
+	uint32_t mantissa = (size >> shift) & (LeafBinCount - 1);
+	return ((shift + 1) << MantissaBits) + mantissa;
+}
+
+void TlsfAllocator::Reset(uint32_t size)
+{
+	Nodes.clear();
+	UnusedNodes.clear();
+	BinHeads.fill(InvalidOffset);
+	UsedLeafBins.fill(0);
+	UsedTopBins = 0;
+	TotalSize = size;
+	FreeUnits = 0;
+	FreeRegions = 0;
+	Allocations = 0;
+	if (size > 0)
+		InsertFree(NewNode(0, size));
+}
+
+uint32_t TlsfAllocator::NewNode(uint32_t offset, uint32_t size)
+{
+	uint32_t node;
+	if (!UnusedNodes.empty())
+	{
+		node = UnusedNodes.back();
+		UnusedNodes.pop_back();
+		Nodes[node] = {};
+	}
+	else
+	{
+		node = static_cast<uint32_t>(Nodes.size());
+		Nodes.emplace_back();
+	}
+	Nodes[node].Offset = offset;
+	Nodes[node].Size = size;
+	return node;
+}
+
+void TlsfAllocator::ReleaseNode(uint32_t node)
+{
+	UnusedNodes.push_back(node);
+}
+
+void TlsfAllocator::InsertFree(uint32_t node)
+{
+	auto& n = Nodes[node];
+	// Round down so every region in a bin is at least the bin size
+	uint32_t bin = SizeToBinRoundDown(n.Size);
+	uint32_t top = bin / LeafBinCount;
+	uint32_t leaf = bin % LeafBinCount;
+	UsedTopBins |= 1u << top;
+	UsedLeafBins[top] |= 1u << leaf;
+
+	n.Used = false;
+	n.BinPrev = InvalidOffset;
+	n.BinNext = BinHeads[bin];
+	if (n.BinNext != InvalidOffset)
+		Nodes[n.BinNext].BinPrev = node;
+	BinHeads[bin] = node;
+	FreeUnits += n.Size;
+	FreeRegions++;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t node)
+{
+	auto& n = Nodes[node];
+	if (n.BinPrev != InvalidOffset)
+		Nodes[n.BinPrev].BinNext = n.BinNext;
+	else
+	{
+		uint32_t bin = SizeToBinRoundDown(n.Size);
+		assert(BinHeads[bin] == node);
+		BinHeads[bin] = n.BinNext;
+		if (n.BinNext == InvalidOffset)
+		{
+			uint32_t top = bin / LeafBinCount;
+			UsedLeafBins[top] &= ~(1u << (bin % LeafBinCount));
+			if (UsedLeafBins[top] == 0)
+				UsedTopBins &= ~(1u << top);
+		}
+	}
+	if (n.BinNext != InvalidOffset)
+		Nodes[n.BinNext].BinPrev = n.BinPrev;
+	n.BinPrev = InvalidOffset;
+	n.BinNext = InvalidOffset;
+	FreeUnits -= n.Size;
+	FreeRegions--;
+}
+
+TlsfAllocator::Allocation TlsfAllocator::Allocate(uint32_t size)
+{
+	if (size == 0 || size > FreeUnits)
+		return {};
+
+	// Round up so any region in the found bin fits without walking its list
+	uint32_t minBin = SizeToBinRoundUp(size);
+	uint32_t top = minBin / LeafBinCount;
+	uint32_t leaf = minBin % LeafBinCount;
+	uint32_t bin = InvalidOffset;
+	if (top < TopBinCount && (UsedTopBins & (1u << top)))
+	{
+		uint32_t leafMask = UsedLeafBins[top] & (~0u << leaf);
+		if (leafMask)
+			bin = top * LeafBinCount + std::countr_zero(leafMask);
+	}
+	if (bin == InvalidOffset)
+	{
+		uint32_t topMask = top + 1 < TopBinCount ? UsedTopBins & (~0u << (top + 1)) : 0;
+		if (topMask)
+		{
+			top = std::countr_zero(topMask);
+			bin = top * LeafBinCount + std::countr_zero(uint32_t(UsedLeafBins[top]));
+		}
+	}
+
+	uint32_t node = bin != InvalidOffset ? BinHeads[bin] : InvalidOffset;
+	if (node == InvalidOffset)
+	{
+		// Only the bin the size rounds down to is left, some of its regions may still fit
+		for (node = BinHeads[SizeToBinRoundDown(size)]; node != InvalidOffset; node = Nodes[node].BinNext)
+			if (Nodes[node].Size >= size)
+				break;
+		if (node == InvalidOffset)
+			return {};
+	}
+	RemoveFree(node);
+	assert(Nodes[node].Size >= size);
+
+	uint32_t remainder = Nodes[node].Size - size;
+	Nodes[node].Size = size;
+	Nodes[node].Used = true;
+	if (remainder > 0)
+	{
+		uint32_t split = NewNode(Nodes[node].Offset + size, remainder);
+		// NewNode may have grown Nodes, index again
+		auto& n = Nodes[node];
+		auto& s = Nodes[split];
+		s.Prev = node;
+		s.Next = n.Next;
+		if (n.Next != InvalidOffset)
+			Nodes[n.Next].Prev = split;
+		n.Next = split;
+		InsertFree(split);
+	}
+	Allocations++;
+	return { Nodes[node].Offset, node };
+}
+
+void TlsfAllocator::Free(Allocation allocation)
+{
+	if (!allocation.IsValid())
+		return;
+	uint32_t node = allocation.Node;
+	assert(node < Nodes.size() && Nodes[node].Used && Nodes[node].Offset == allocation.Offset && "Allocation freed twice or not from this allocator");
+
+	// Absorb free neighbours into this node
+	uint32_t prev = Nodes[node].Prev;
+	if (prev != InvalidOffset && !Nodes[prev].Used)
+	{
+		RemoveFree(prev);
+		auto& n = Nodes[node];
+		n.Offset = Nodes[prev].Offset;
+		n.Size += Nodes[prev].Size;
+		n.Prev = Nodes[prev].Prev;
+		if (n.Prev != InvalidOffset)
+			Nodes[n.Prev].Next = node;
+		ReleaseNode(prev);
+	}
+	uint32_t next = Nodes[node].Next;
+	if (next != InvalidOffset && !Nodes[next].Used)
+	{
+		RemoveFree(next);
+		auto& n = Nodes[node];
+		n.Size += Nodes[next].Size;
+		n.Next = Nodes[next].Next;
+		if (n.Next != InvalidOffset)
+			Nodes[n.Next].Prev = node;
+		ReleaseNode(next);
+	}
+	Allocations--;
+	InsertFree(node);
+}
+
+uint32_t TlsfAllocator::AllocationSize(Allocation allocation) const
+{
+	return allocation.IsValid() ? Nodes[allocation.Node].Size : 0;
+}
+
+TlsfAllocator::Stats TlsfAllocator::GetStats() const
+{
+	Stats stats;
+	stats.Size = TotalSize;
+	stats.FreeUnits = FreeUnits;
+	stats.FreeRegions = FreeRegions;
+	stats.Allocations = Allocations;
+	if (UsedTopBins)
+	{
+		// The largest region is in the highest used bin, regions in one bin differ in size so walk it
+		uint32_t top = 31 - std::countl_zero(UsedTopBins);
+		uint32_t bin = top * LeafBinCount + 31 - std::countl_zero(uint32_t(UsedLeafBins[top]));
+		for (uint32_t node = BinHeads[bin]; node != InvalidOffset; node = Nodes[node].BinNext)
+			stats.LargestFreeRegion = std::max(stats.LargestFreeRegion, Nodes[node].Size);
+	}
+	return stats;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace dxpg
+{
+
+// Two level segregated fit allocator over an abstract range of units, it never touches the memory it hands out.
+// Free regions are binned by a small float of their size (5 bit exponent, 3 bit mantissa), a lookup finds a fitting
+// bin with two bit scans. Allocate and Free are O(1), freed regions merge with free neighbours right away
+struct TlsfAllocator
+{
+	static constexpr uint32_t InvalidOffset = UINT32_MAX;
+
+	struct Allocation
+	{
+		uint32_t Offset = InvalidOffset;
+		uint32_t Node = InvalidOffset;
+
+		bool IsValid() const { return Offset != InvalidOffset; }
+	};
+
+	struct Stats
+	{
+		uint32_t Size = 0;
+		uint32_t FreeUnits = 0;
+		uint32_t LargestFreeRegion = 0;
+		uint32_t FreeRegions = 0;
+		uint32_t Allocations = 0;
+
+		// 0 when all free units are in one region, close to 1 when they are scattered in small pieces
+		float Fragmentation() const { return FreeUnits ? 1.0f - float(LargestFreeRegion) / float(FreeUnits) : 0.0f; }
+	};
+
+	TlsfAllocator() = default;
+	explicit TlsfAllocator(uint32_t size) { Reset(size); }
+
+	// Drops every allocation and starts over with a single free region
+	void Reset(uint32_t size);
+
+	// Returns an invalid allocation when no free region fits
+	Allocation Allocate(uint32_t size);
+	void Free(Allocation allocation);
+
+	uint32_t AllocationSize(Allocation allocation) const;
+	Stats GetStats() const;
+	uint32_t Size() const { return TotalSize; }
+
+private:
+	static constexpr uint32_t MantissaBits = 3;
+	static constexpr uint32_t LeafBinCount = 1 << MantissaBits;
+	static constexpr uint32_t TopBinCount = 32;
+	static constexpr uint32_t BinCount = TopBinCount * LeafBinCount;
+
+	struct Node
+	{
+		uint32_t Offset = 0;
+		uint32_t Size = 0;
+		// Free list of the bin while free
+		uint32_t BinPrev = InvalidOffset;
+		uint32_t BinNext = InvalidOffset;
+		// Address ordered neighbours
+		uint32_t Prev = InvalidOffset;
+		uint32_t Next = InvalidOffset;
+		bool Used = false;
+	};
+
+	static uint32_t SizeToBinRoundUp(uint32_t size);
+	static uint32_t SizeToBinRoundDown(uint32_t size);
+
+	uint32_t NewNode(uint32_t offset, uint32_t size);
+	void InsertFree(uint32_t node);
+	void RemoveFree(uint32_t node);
+	void ReleaseNode(uint32_t node);
+
+	std::vector<Node> Nodes;
+	std::vector<uint32_t> UnusedNodes;
+	std::array<uint32_t, BinCount> BinHeads{};
+	std::array<uint8_t, TopBinCount> UsedLeafBins{};
+	uint32_t UsedTopBins = 0;
+	uint32_t TotalSize = 0;
+	uint32_t FreeUnits = 0;
+	uint32_t FreeRegions = 0;
+	uint32_t Allocations = 0;
+};
+
+}
\ No newline at end of file
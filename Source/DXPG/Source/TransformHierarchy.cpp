@@ -0,0 +1,108 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace dxpg
+{
+
+void LocalTransformFromQuaternion(Vector4 translation, Vector4 quaternion, Vector4 scale, Vector4& outPosition, Vector4& outRotation, Vector4& outScale)
+{
+	using namespace DirectX;
+	XMFLOAT4 q;
+	XMStoreFloat4(&q, XMQuaternionNormalize(quaternion));
+	// Inverse of XMMatrixRotationRollPitchYaw, which rolls around z, then pitches around x, then yaws around y
+	float sinPitch = std::clamp(-2.0f * (q.y * q.z - q.x * q.w), -1.0f, 1.0f);
+	float pitch = std::asin(sinPitch);
+	float yaw, roll;
+	if (std::abs(sinPitch) < 0.99999f)
+	{
+		yaw = std::atan2(2.0f * (q.x * q.z + q.y * q.w), 1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+		roll = std::atan2(2.0f * (q.x * q.y + q.z * q.w), 1.0f - 2.0f * (q.x * q.x + q.z * q.z));
+	}
+	else
+	{
+		// Gimbal lock, yaw and roll turn around the same axis
+		yaw = std::atan2(-2.0f * (q.x * q.z - q.y * q.w), 1.0f - 2.0f * (q.y * q.y + q.z * q.z));
+		roll = 0.0f;
+	}
+	outRotation = XMVectorSet(pitch, yaw, roll, 0.0f);
+	outScale = XMVectorSetW(scale, 0.0f);
+	// ComposeLocalMatrix rotates about (0, 1, 0), move the result back to rotating about the origin
+	Vector4 origin = XMVectorSet(0, 1, 0, 0);
+	Vector4 rotatedOrigin = XMVector3Rotate(origin, XMQuaternionRotationRollPitchYawFromVector(outRotation));
+	outPosition = XMVectorSetW(XMVectorAdd(translation, XMVectorSubtract(rotatedOrigin, origin)), 1.0f);
+}
+
+TransformHierarchy::NodeId TransformHierarchy::AddNode(NodeId parent, Vector4 position, Vector4 rotation, Vector4 scale)
+{
+	assert(parent == InvalidNode || parent < Size());
+	NodeId node = static_cast<NodeId>(Size());
+	Parents.push_back(parent);
+	Positions.push_back(position);
+	Rotations.push_back(rotation);
+	Scales.push_back(scale);
+	WorldMatrices.push_back(DirectX::XMMatrixIdentity());
+	Dirty.push_back(0);
+	MarkDirty(node);
+	return node;
+}
+
+void TransformHierarchy::SetLocalTransform(NodeId node, Vector4 position, Vector4 rotation, Vector4 scale)
+{
+	Positions[node] = position;
+	Rotations[node] = rotation;
+	Scales[node] = scale;
+	MarkDirty(node);
+}
+
+void TransformHierarchy::MarkDirty(NodeId node)
+{
+	assert(node < Size());
+	Dirty[node] = 1;
+	if (FirstDirty == InvalidNode || node < FirstDirty)
+		FirstDirty = node;
+}
+
+void TransformHierarchy::Clear()
+{
+	Parents.clear();
+	Positions.clear();
+	Rotations.clear();
+	Scales.clear();
+	WorldMatrices.clear();
+	Dirty.clear();
+	ChangedNodes.clear();
+	FirstDirty = InvalidNode;
+}
+
+std::span<TransformHierarchy::NodeId const> TransformHierarchy::Update()
+{
+	ChangedNodes.clear();
+	if (FirstDirty == InvalidNode)
+		return ChangedNodes;
+
+	// Nodes before the first dirty one can't be affected, a child is never stored before its parent
+	NodeId const count = static_cast<NodeId>(Size());
+	for (NodeId node = FirstDirty; node < count; ++node)
+	{
+		NodeId parent = Parents[node];
+		bool parentDirty = parent != InvalidNode && Dirty[parent];
+		if (!Dirty[node] && !parentDirty)
+			continue;
+		// Keep the flag raised until the pass is over so it reaches the whole subtree
+		Dirty[node] = 1;
+		Matrix4x4 local = ComposeLocalMatrix(Positions[node], Rotations[node], Scales[node]);
+		// Row vectors, the local transform applies first and the parent's moves the result
+		WorldMatrices[node] = parent == InvalidNode ? local : XMMatrixMultiply(local, WorldMatrices[parent]);
+		ChangedNodes.push_back(node);
+	}
+
+	for (NodeId node : ChangedNodes)
+		Dirty[node] = 0;
+	FirstDirty = InvalidNode;
+	return ChangedNodes;
+}
+
+}
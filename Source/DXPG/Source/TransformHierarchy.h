@@ -0,0 +1,52 @@
+#pragma once
+
+#include "MathTypes.h"
+
+#include <vector>
+#include <span>
+#include <cstdint>
+
+namespace dxpg
+{
+
+inline Matrix4x4 ComposeLocalMatrix(Vector4 position, Vector4 rotation, Vector4 scale)
+{
+	return DirectX::XMMatrixAffineTransformation(scale, DirectX::XMVectorSet(0, 1, 0, 0), DirectX::XMQuaternionRotationRollPitchYawFromVector(rotation), position);
+}
+
+// ComposeLocalMatrix arguments that scale, rotate by the quaternion about the local origin and then translate
+void LocalTransformFromQuaternion(Vector4 translation, Vector4 quaternion, Vector4 scale, Vector4& outPosition, Vector4& outRotation, Vector4& outScale);
+
+// Flattened structure-of-arrays transform hierarchy. Nodes are stored in topological order
+// (a parent always precedes its children), so dirty world matrices propagate in a single forward pass.
+struct TransformHierarchy
+{
+	using NodeId = uint32_t;
+	static constexpr NodeId InvalidNode = ~0u;
+
+	NodeId AddNode(NodeId parent, Vector4 position, Vector4 rotation, Vector4 scale);
+	void SetLocalTransform(NodeId node, Vector4 position, Vector4 rotation, Vector4 scale);
+	void MarkDirty(NodeId node);
+	void Clear();
+
+	// Recomputes the world matrices of dirty nodes and their descendants.
+	// Returns the nodes whose world matrix changed, valid until the next call.
+	std::span<NodeId const> Update();
+
+	bool HasDirtyNodes() const { return FirstDirty != InvalidNode; }
+	size_t Size() const { return Parents.size(); }
+	Matrix4x4 const& GetWorldMatrix(NodeId node) const { return WorldMatrices[node]; }
+
+	std::vector<NodeId> Parents;
+	std::vector<Vector4> Positions;
+	std::vector<Vector4> Rotations;
+	std::vector<Vector4> Scales;
+	std::vector<Matrix4x4> WorldMatrices;
+	std::vector<uint8_t> Dirty;
+
+private:
+	std::vector<NodeId> ChangedNodes;
+	NodeId FirstDirty = InvalidNode;
+};
+
+}
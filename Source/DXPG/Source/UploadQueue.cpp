@@ -0,0 +1,129 @@
+#include "UploadQueue.h"
+
+namespace dxpg
+{
+
+void UploadQueue::Init(ID3D12Device* device, ID3D12CommandQueue* queue)
+{
+	Device = device;
+	Queue = queue;
+	Type = queue->GetDesc().Type;
+	Schedule.Init(ContextCount);
+	Staging.Init(device, IsCopyQueue() ? L"CopyStaging" : L"UploadStaging", StagingPageSize, StagingPages);
+	for (auto& context : Contexts)
+	{
+		ThrowIfFailed(Device->CreateCommandAllocator(Type, IID_PPV_ARGS(&context.CommandAllocator)));
+		context.FenceValue = 0;
+		context.Staging = &Staging;
+	}
+	ThrowIfFailed(Device->CreateCommandList(0, Type, Contexts[0].CommandAllocator.Get(), nullptr, IID_PPV_ARGS(&List)));
+	ThrowIfFailed(List->Close());
+	ThrowIfFailed(Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&Fence)));
+	FenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	assert(FenceEvent);
+}
+
+void UploadQueue::Shutdown()
+{
+	if (OpenContext)
+		Submit();
+	if (Fence->GetCompletedValue() < Schedule.LastSubmitted())
+	{
+		Fence->SetEventOnCompletion(Schedule.LastSubmitted(), FenceEvent);
+		WaitForSingleObject(FenceEvent, INFINITE);
+	}
+	Retire();
+	Staging.Shutdown();
+	CloseHandle(FenceEvent);
+	FenceEvent = nullptr;
+}
+
+FrameContext& UploadQueue::Begin()
+{
+	if (OpenContext)
+		return *OpenContext;
+
+	// Recycle the oldest batch, it only blocks when every context is still in flight
+	Retire();
+	uint64_t waitValue = 0;
+	auto* context = &Contexts[Schedule.Acquire(waitValue)];
+	if (waitValue != 0)
+	{
+		Fence->SetEventOnCompletion(waitValue, FenceEvent);
+		WaitForSingleObject(FenceEvent, INFINITE);
+		Retire();
+	}
+
+	List->Reset(context->CommandAllocator.Get(), nullptr);
+	// Copy lists bind no descriptors
+	if (!IsCopyQueue())
+	{
+		context->GPUHeapPages[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV] = g_GPUDescriptorAllocator->Heaps[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->AllocatePage();
+		context->GPUHeapPages[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER] = g_GPUDescriptorAllocator->Heaps[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER]->AllocatePage();
+		auto heaps = g_GPUDescriptorAllocator->GetHeaps();
+		List->SetDescriptorHeaps(heaps.size(), heaps.data());
+	}
+	context->Ready = true;
+	OpenContext = context;
+	return *context;
+}
+
+uint64_t UploadQueue::Submit()
+{
+	// Loaders sharing a batch all submit it, the later calls only get its fence value
+	if (!OpenContext)
+		return Schedule.LastSubmitted();
+
+	ThrowIfFailed(List->Close());
+	ID3D12CommandList* commandLists[] = { List.Get() };
+	Queue->ExecuteCommandLists(_countof(commandLists), commandLists);
+	uint64_t value = Schedule.Submit(uint32_t(OpenContext - Contexts.data()));
+	Queue->Signal(Fence.Get(), value);
+	Staging.Close(value);
+	OpenContext->FenceValue = value;
+	OpenContext->Ready = false;
+	OpenContext = nullptr;
+	return value;
+}
+
+void UploadQueue::Retire()
+{
+	uint64_t completed = Fence->GetCompletedValue();
+	for (uint32_t i = 0; i < ContextCount; ++i)
+	{
+		if (Schedule.Retire(i, completed))
+			Release(Contexts[i]);
+	}
+	Staging.Reclaim(completed);
+}
+
+uint64_t UploadQueue::BusyValue() const
+{
+	if (OpenContext)
+		return 0;
+	uint64_t waitValue = 0;
+	Schedule.Acquire(waitValue);
+	return waitValue;
+}
+
+void UploadQueue::WaitOn(ID3D12CommandQueue* consumer, uint64_t value)
+{
+	if (OpenContext && Schedule.IsPending(value))
+		Submit();
+	assert(!Schedule.IsPending(value) && "Waiting for a batch that was never submitted");
+	if (uint64_t waitValue = Schedule.ConsumerWait(value, Fence->GetCompletedValue()))
+		consumer->Wait(Fence.Get(), waitValue);
+}
+
+void UploadQueue::Release(FrameContext& context)
+{
+	for (auto& [type, heapPage] : context.GPUHeapPages)
+		g_GPUDescriptorAllocator->Heaps[type]->FreePage(heapPage);
+	context.GPUHeapPages.clear();
+	context.CPUViewsToGPUViews.clear();
+	context.CommandAllocator->Reset();
+	context.IntermediateResources.clear();
+	context.FenceValue = 0;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "DXPGCommon.h"
+#include "DXHelpers.h"
+#include "RendererCommon.h"
+#include "StagingRing.h"
+#include "TaskScheduler.h"
+#include "UploadSchedule.h"
+
+#include <array>
+
+namespace dxpg
+{
+
+// Records uploads on its own command list and submits them to its queue without waiting for them,
+// loaders await the fence value of their batch instead of blocking the frame loop.
+// On a copy queue batches run next to the frames, which wait for them on the GPU when they first draw what a batch uploaded
+struct UploadQueue : FenceTimeline
+{
+	// Batches in flight at once, on the graphics queue each one holds a page of the GPU descriptor heap
+	static constexpr uint32_t ContextCount = 2;
+	// Batches larger than the staging pages get dedicated upload buffers for the rest
+	static constexpr uint64_t StagingPageSize = 32ull << 20;
+	static constexpr uint32_t StagingPages = 4;
+
+	// The list type follows the queue's, copy lists can only copy and transition between the common and copy states
+	void Init(ID3D12Device* device, ID3D12CommandQueue* queue);
+	// Waits for every submitted batch
+	void Shutdown();
+
+	// Opens a batch or returns the open one, uploads recorded until the next Submit share it.
+	// The context keeps the intermediate resources alive until the batch completed
+	FrameContext& Begin();
+	ID3D12GraphicsCommandList2* CommandList() { return List.Get(); }
+	// Executes the open batch, the returned fence value marks its completion
+	uint64_t Submit();
+	// Recycles the contexts of completed batches, called once per frame
+	void Retire();
+	// Fence value Begin would block on to open a batch, 0 when it would not block
+	uint64_t BusyValue() const;
+	// Makes work submitted to consumer afterwards wait for the batch of value, unless it completed or an earlier wait covers it.
+	// A queue can only wait for a signal that was already enqueued, so the open batch is submitted first when value is its own
+	void WaitOn(ID3D12CommandQueue* consumer, uint64_t value);
+
+	bool IsCopyQueue() const { return Type == D3D12_COMMAND_LIST_TYPE_COPY; }
+	uint64_t CompletedValue() override { return Fence->GetCompletedValue(); }
+	StagingStats GetStagingStats() const { return Staging.GetStats(); }
+
+private:
+	void Release(FrameContext& context);
+
+	ID3D12Device* Device = nullptr;
+	ID3D12CommandQueue* Queue = nullptr;
+	D3D12_COMMAND_LIST_TYPE Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+	ComPtr<ID3D12GraphicsCommandList2> List;
+	ComPtr<ID3D12Fence> Fence;
+	HANDLE FenceEvent = nullptr;
+	std::array<FrameContext, ContextCount> Contexts = {};
+	FrameContext* OpenContext = nullptr;
+	UploadSchedule Schedule;
+	StagingRing Staging;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "UploadSchedule.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace dxpg
+{
+
+void UploadSchedule::Init(uint32_t contextCount)
+{
+	assert(contextCount > 0);
+	Values.assign(contextCount, 0);
+	Last = 0;
+	Waited = 0;
+}
+
+uint32_t UploadSchedule::Acquire(uint64_t& outWaitValue) const
+{
+	uint32_t oldest = 0;
+	for (uint32_t i = 0; i < Values.size(); ++i)
+	{
+		if (Values[i] == 0)
+		{
+			outWaitValue = 0;
+			return i;
+		}
+		if (Values[i] < Values[oldest])
+			oldest = i;
+	}
+	outWaitValue = Values[oldest];
+	return oldest;
+}
+
+uint64_t UploadSchedule::Submit(uint32_t context)
+{
+	assert(Values[context] == 0);
+	Values[context] = ++Last;
+	return Last;
+}
+
+bool UploadSchedule::Retire(uint32_t context, uint64_t completedValue)
+{
+	if (Values[context] == 0 || Values[context] > completedValue)
+		return false;
+	Values[context] = 0;
+	return true;
+}
+
+uint64_t UploadSchedule::ConsumerWait(uint64_t value, uint64_t completedValue)
+{
+	assert(value <= Last);
+	// Completed batches need no wait, they also cover every earlier one
+	Waited = std::max(Waited, completedValue);
+	if (value <= Waited)
+		return 0;
+	Waited = value;
+	return value;
+}
+
+}
\ No newline at end of file
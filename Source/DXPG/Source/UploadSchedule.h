@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace dxpg
+{
+
+// Batch bookkeeping of an upload timeline, kept free of D3D so it runs against a fake fence
+struct UploadSchedule
+{
+	void Init(uint32_t contextCount);
+
+	// Context the next batch records into, a free one or else the one submitted first.
+	// outWaitValue is the value that has to complete before it is reused, 0 when it is free
+	uint32_t Acquire(uint64_t& outWaitValue) const;
+	// The context's batch was executed, returns the value its signal carries
+	uint64_t Submit(uint32_t context);
+	// True when the context's batch completed, the context is free again afterwards
+	bool Retire(uint32_t context, uint64_t completedValue);
+
+	// Value the consuming queue has to wait for before it uses what the batch of value uploaded, 0 when the batch
+	// completed or an earlier wait covers it. Assumes a single consuming queue, every wait returned is enqueued on it
+	uint64_t ConsumerWait(uint64_t value, uint64_t completedValue);
+
+	// Values past the last submitted batch have no signal enqueued yet, nothing can wait for them
+	bool IsPending(uint64_t value) const { return value > Last; }
+	uint64_t LastSubmitted() const { return Last; }
+	uint64_t LastWaited() const { return Waited; }
+
+private:
+	// Fence value of the batch in flight per context, 0 when it is free
+	std::vector<uint64_t> Values;
+	uint64_t Last = 0;
+	uint64_t Waited = 0;
+};
+
+}
\ No newline at end of file
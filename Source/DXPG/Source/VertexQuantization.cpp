@@ -0,0 +1,136 @@
+#include "VertexQuantization.h"
+
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+
+namespace dxpg
+{
+
+namespace
+{
+// Quantization range of every axis, flat axes keep a unit range so the decode stays invertible
+Vector4 BoundsSize(DirectX::BoundingBox const& bounds)
+{
+	Vector4 size = XMVectorScale(XMLoadFloat3(&bounds.Extents), 2.0f);
+	return XMVectorSelect(size, XMVectorSplatOne(), XMVectorLessOrEqual(size, XMVectorZero()));
+}
+
+Vector4 BoundsMin(DirectX::BoundingBox const& bounds)
+{
+	return XMVectorSubtract(XMLoadFloat3(&bounds.Center), XMLoadFloat3(&bounds.Extents));
+}
+}
+
+uint16_t QuantizeUnorm16(float value)
+{
+	return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+float DequantizeUnorm16(uint16_t value)
+{
+	return float(value) / 65535.0f;
+}
+
+int16_t QuantizeSnorm16(float value)
+{
+	return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+float DequantizeSnorm16(int16_t value)
+{
+	// Both -32768 and -32767 decode to -1, like the R16_SNORM format
+	return std::max(float(value) / 32767.0f, -1.0f);
+}
+
+Vector2 OctahedralEncode(Vector3 const& normal)
+{
+	auto signNotZero = [](float v) { return v >= 0.0f ? 1.0f : -1.0f; };
+	float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (l1 == 0.0f)
+		return Vector2(0.0f, 0.0f);
+
+	float x = normal.x / l1;
+	float y = normal.y / l1;
+	// Fold the lower hemisphere over the diagonals
+	if (normal.z < 0.0f)
+	{
+		float foldedX = (1.0f - std::abs(y)) * signNotZero(x);
+		float foldedY = (1.0f - std::abs(x)) * signNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+	return Vector2(x, y);
+}
+
+Vector3 OctahedralDecode(Vector2 const& encoded)
+{
+	// Matches OctahedralDecode in StaticMesh.vs.hlsl
+	float x = encoded.x;
+	float y = encoded.y;
+	float z = 1.0f - std::abs(x) - std::abs(y);
+	float t = std::clamp(-z, 0.0f, 1.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+	Vector3 normal;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(x, y, z, 0.0f)));
+	return normal;
+}
+
+QuantizedMeshVertex QuantizeVertex(MeshVertex const& vertex, DirectX::BoundingBox const& bounds)
+{
+	Vector3 unitPosition;
+	XMStoreFloat3(&unitPosition, XMVectorDivide(XMVectorSubtract(XMLoadFloat3(&vertex.Position), BoundsMin(bounds)), BoundsSize(bounds)));
+	Vector2 normal = OctahedralEncode(vertex.Normal);
+
+	QuantizedMeshVertex quantized{};
+	quantized.Position[0] = QuantizeUnorm16(unitPosition.x);
+	quantized.Position[1] = QuantizeUnorm16(unitPosition.y);
+	quantized.Position[2] = QuantizeUnorm16(unitPosition.z);
+	quantized.Normal[0] = QuantizeSnorm16(normal.x);
+	quantized.Normal[1] = QuantizeSnorm16(normal.y);
+	quantized.TexCoord[0] = PackedVector::XMConvertFloatToHalf(vertex.TexCoord.x);
+	quantized.TexCoord[1] = PackedVector::XMConvertFloatToHalf(vertex.TexCoord.y);
+	return quantized;
+}
+
+MeshVertex DequantizeVertex(QuantizedMeshVertex const& vertex, DirectX::BoundingBox const& bounds)
+{
+	Vector4 unitPosition = XMVectorSet(DequantizeUnorm16(vertex.Position[0]), DequantizeUnorm16(vertex.Position[1]), DequantizeUnorm16(vertex.Position[2]), 0.0f);
+
+	MeshVertex dequantized{};
+	XMStoreFloat3(&dequantized.Position, XMVectorMultiplyAdd(unitPosition, BoundsSize(bounds), BoundsMin(bounds)));
+	dequantized.Normal = OctahedralDecode(Vector2(DequantizeSnorm16(vertex.Normal[0]), DequantizeSnorm16(vertex.Normal[1])));
+	dequantized.TexCoord = Vector2(PackedVector::XMConvertHalfToFloat(vertex.TexCoord[0]), PackedVector::XMConvertHalfToFloat(vertex.TexCoord[1]));
+	return dequantized;
+}
+
+Matrix4x4 PositionDequantizeMatrix(DirectX::BoundingBox const& bounds)
+{
+	return XMMatrixMultiply(XMMatrixScalingFromVector(BoundsSize(bounds)), XMMatrixTranslationFromVector(BoundsMin(bounds)));
+}
+
+void QuantizeVertices(std::span<MeshVertex const> vertices, DirectX::BoundingBox const& bounds, std::vector<QuantizedMeshVertex>& outVertices, QuantizationError& outError)
+{
+	outVertices.reserve(outVertices.size() + vertices.size());
+	for (auto& vertex : vertices)
+	{
+		auto& quantized = outVertices.emplace_back(QuantizeVertex(vertex, bounds));
+		MeshVertex decoded = DequantizeVertex(quantized, bounds);
+
+		float positionError = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&decoded.Position), XMLoadFloat3(&vertex.Position))));
+		outError.Position = std::max(outError.Position, positionError);
+
+		Vector4 normal = XMLoadFloat3(&vertex.Normal);
+		if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f)
+		{
+			float cosAngle = XMVectorGetX(XMVector3Dot(XMVector3Normalize(normal), XMLoadFloat3(&decoded.Normal)));
+			outError.NormalDegrees = std::max(outError.NormalDegrees, XMConvertToDegrees(std::acos(std::clamp(cosAngle, -1.0f, 1.0f))));
+		}
+
+		float texCoordError = std::max(std::abs(decoded.TexCoord.x - vertex.TexCoord.x), std::abs(decoded.TexCoord.y - vertex.TexCoord.y));
+		outError.TexCoord = std::max(outError.TexCoord, texCoordError);
+	}
+}
+
+}
\ No newline at end of file
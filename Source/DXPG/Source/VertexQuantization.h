@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "MeshImport.h"
+
+namespace dxpg
+{
+
+enum class VertexFormat : uint32_t
+{
+	Full,
+	Quantized,
+	Count
+};
+
+// 16 bytes, half of MeshVertex
+struct QuantizedMeshVertex
+{
+	// Unorm within the mesh bounds, w is padding
+	uint16_t Position[4];
+	// Snorm octahedral encoding
+	int16_t Normal[2];
+	// Half floats, UVs can tile outside of [0, 1]
+	uint16_t TexCoord[2];
+};
+static_assert(sizeof(QuantizedMeshVertex) == 16);
+
+uint16_t QuantizeUnorm16(float value);
+float DequantizeUnorm16(uint16_t value);
+int16_t QuantizeSnorm16(float value);
+float DequantizeSnorm16(int16_t value);
+
+// Maps a unit vector onto the [-1, 1] square
+Vector2 OctahedralEncode(Vector3 const& normal);
+Vector3 OctahedralDecode(Vector2 const& encoded);
+
+QuantizedMeshVertex QuantizeVertex(MeshVertex const& vertex, DirectX::BoundingBox const& bounds);
+MeshVertex DequantizeVertex(QuantizedMeshVertex const& vertex, DirectX::BoundingBox const& bounds);
+
+// Maps quantized positions back into object space, the vertex shaders get it folded into the model matrix
+Matrix4x4 PositionDequantizeMatrix(DirectX::BoundingBox const& bounds);
+
+// Largest round-trip error seen
+struct QuantizationError
+{
+	float Position = 0.0f;
+	float NormalDegrees = 0.0f;
+	float TexCoord = 0.0f;
+};
+
+// Appends the quantized vertices to outVertices and accumulates the error into outError
+void QuantizeVertices(std::span<MeshVertex const> vertices, DirectX::BoundingBox const& bounds, std::vector<QuantizedMeshVertex>& outVertices, QuantizationError& outError);
+
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "VirtualTexture.h"
+
+#include <cassert>
+
+namespace dxpg
+{
+
+void StandardTileShape(uint32_t elementBytes, uint32_t blockSize, uint32_t& outWidth, uint32_t& outHeight)
+{
+	// 64KB of elements, twice as wide as high when the element count is not square
+	uint32_t elements = VirtualTileBytes / elementBytes;
+	uint32_t height = 1;
+	while (height * 2 * height * 2 <= elements)
+		height *= 2;
+	uint32_t width = elements / height;
+	outWidth = width * blockSize;
+	outHeight = height * blockSize;
+}
+
+TilePage VirtualTextureLayout::Parent(TilePage page) const
+{
+	uint32_t level = page.Level + 1;
+	return { page.Texture, level, std::min(page.X >> 1, TilesWide(level) - 1), std::min(page.Y >> 1, TilesHigh(level) - 1) };
+}
+
+bool IsVirtualTextureLayoutValid(VirtualTextureLayout const& layout)
+{
+	return layout.StandardLevels > 0 && layout.StandardLevels <= MaxVirtualTileLevels && layout.TilesWide(0) <= MaxVirtualTilesPerSide && layout.TilesHigh(0) <= MaxVirtualTilesPerSide;
+}
+
+void AnalyzeTileFeedback(std::span<uint32_t const> feedback, std::span<VirtualTextureLayout const> layouts, std::vector<TileRequest>& outRequests)
+{
+	outRequests.clear();
+	std::unordered_map<uint32_t, uint32_t> counts;
+	for (uint32_t packed : feedback)
+	{
+		if (packed == EmptyTilePage)
+			continue;
+		TilePage page = UnpackTilePage(packed);
+		if (page.Texture >= layouts.size() || !layouts[page.Texture].Contains(page))
+			continue;
+		++counts[packed];
+	}
+
+	// Every page needs its chain of coarser pages, walk up until an ancestor is already known
+	std::vector<std::pair<uint32_t, uint32_t>> leaves(counts.begin(), counts.end());
+	for (auto [packed, count] : leaves)
+	{
+		TilePage page = UnpackTilePage(packed);
+		auto& layout = layouts[page.Texture];
+		while (page.Level + 1 < layout.StandardLevels)
+		{
+			page = layout.Parent(page);
+			counts[PackTilePage(page)] += count;
+		}
+	}
+
+	outRequests.reserve(counts.size());
+	for (auto [packed, count] : counts)
+		outRequests.push_back({ packed, count });
+	std::sort(outRequests.begin(), outRequests.end(), [](TileRequest const& a, TileRequest const& b)
+	{
+		uint32_t levelA = UnpackTilePage(a.Page).Level;
+		uint32_t levelB = UnpackTilePage(b.Page).Level;
+		if (levelA != levelB)
+			return levelA > levelB;
+		if (a.Count != b.Count)
+			return a.Count > b.Count;
+		return a.Page < b.Page;
+	});
+}
+
+void TileCache::Init(uint32_t slotCount)
+{
+	Slots.assign(slotCount, {});
+	PageSlots.clear();
+	Frame = 1;
+	Stats = {};
+	Stats.Slots = slotCount;
+}
+
+void TileCache::Update(std::span<TileRequest const> requests, uint32_t maxMappings, std::vector<TileMapping>& outMappings)
+{
+	outMappings.clear();
+	Stats.Requested = uint32_t(requests.size());
+	Stats.Missing = 0;
+
+	std::vector<uint32_t> missing;
+	for (auto& request : requests)
+	{
+		auto it = PageSlots.find(request.Page);
+		if (it != PageSlots.end())
+			Slots[it->second].LastUsed = Frame;
+		else
+			missing.push_back(request.Page);
+	}
+
+	// Free slots first, then the least recently used, pages requested this frame stay
+	std::vector<uint32_t> victims;
+	for (uint32_t slot = 0; slot < Slots.size(); ++slot)
+	{
+		if (Slots[slot].LastUsed != Frame)
+			victims.push_back(slot);
+	}
+	std::sort(victims.begin(), victims.end(), [this](uint32_t a, uint32_t b)
+	{
+		bool freeA = Slots[a].Page == EmptyTilePage;
+		bool freeB = Slots[b].Page == EmptyTilePage;
+		if (freeA != freeB)
+			return freeA;
+		return Slots[a].LastUsed != Slots[b].LastUsed ? Slots[a].LastUsed < Slots[b].LastUsed : a < b;
+	});
+
+	size_t mapCount = std::min({ missing.size(), victims.size(), size_t(maxMappings) });
+	for (size_t i = 0; i < mapCount; ++i)
+	{
+		uint32_t slotIndex = victims[i];
+		auto& slot = Slots[slotIndex];
+		uint32_t evicted = slot.Page;
+		if (evicted != EmptyTilePage)
+		{
+			PageSlots.erase(evicted);
+			++Stats.Evicted;
+		}
+		slot.Page = missing[i];
+		slot.LastUsed = Frame;
+		PageSlots[missing[i]] = slotIndex;
+		outMappings.push_back({ missing[i], slotIndex, evicted });
+		++Stats.Mapped;
+	}
+	Stats.Missing = uint32_t(missing.size() - mapCount);
+	Stats.Resident = uint32_t(PageSlots.size());
+	++Frame;
+}
+
+void BuildResidencyMap(VirtualTextureLayout const& layout, uint32_t texture, TileCache const& cache, std::vector<uint8_t>& outMap)
+{
+	assert(layout.StandardLevels > 0);
+	// From the coarsest standard level down, a tile only refines when its parent got as far as the level above
+	uint32_t level = layout.StandardLevels - 1;
+	std::vector<uint8_t> coarser;
+	std::vector<uint8_t> current(size_t(layout.TilesWide(level)) * layout.TilesHigh(level));
+	for (uint32_t y = 0; y < layout.TilesHigh(level); ++y)
+	{
+		for (uint32_t x = 0; x < layout.TilesWide(level); ++x)
+			current[y * layout.TilesWide(level) + x] = uint8_t(cache.IsResident(PackTilePage({ texture, level, x, y })) ? level : layout.StandardLevels);
+	}
+	while (level > 0)
+	{
+		--level;
+		coarser.swap(current);
+		uint32_t wide = layout.TilesWide(level);
+		uint32_t high = layout.TilesHigh(level);
+		uint32_t coarserWide = layout.TilesWide(level + 1);
+		current.resize(size_t(wide) * high);
+		for (uint32_t y = 0; y < high; ++y)
+		{
+			for (uint32_t x = 0; x < wide; ++x)
+			{
+				TilePage parent = layout.Parent({ texture, level, x, y });
+				uint8_t fallback = coarser[parent.Y * coarserWide + parent.X];
+				bool refines = fallback == level + 1 && cache.IsResident(PackTilePage({ texture, level, x, y }));
+				current[y * wide + x] = refines ? uint8_t(level) : fallback;
+			}
+		}
+	}
+	outMap = std::move(current);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace dxpg
+{
+
+// Tiles of reserved resources are always this large, whatever their format
+constexpr uint32_t VirtualTileBytes = 64 * 1024;
+// Feedback packs a page into 32 bits, which bounds the texture count, the levels and the tiles per side
+constexpr uint32_t MaxVirtualTextures = 1 << 12;
+constexpr uint32_t MaxVirtualTileLevels = 1 << 4;
+constexpr uint32_t MaxVirtualTilesPerSide = 1 << 8;
+// Feedback texels nothing wrote to
+constexpr uint32_t EmptyTilePage = ~0u;
+
+struct TilePage
+{
+	uint32_t Texture;
+	uint32_t Level;
+	uint32_t X;
+	uint32_t Y;
+};
+
+// Same layout as the feedback written by StaticMesh.ps.hlsl
+inline uint32_t PackTilePage(TilePage page)
+{
+	return (page.Texture << 20) | (page.Level << 16) | (page.Y << 8) | page.X;
+}
+
+inline TilePage UnpackTilePage(uint32_t packed)
+{
+	return { packed >> 20, (packed >> 16) & 0xF, packed & 0xFF, (packed >> 8) & 0xFF };
+}
+
+// Texels covered by a 64KB tile of the standard swizzle, elementBytes is the size of a texel or of a block of blockSize texels
+void StandardTileShape(uint32_t elementBytes, uint32_t blockSize, uint32_t& outWidth, uint32_t& outHeight);
+
+// Tile grid of a virtual texture. The levels from StandardLevels on are packed, they are mapped up front and always resident
+struct VirtualTextureLayout
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t MipCount = 0;
+	uint32_t StandardLevels = 0;
+	uint32_t TileWidth = 0;
+	uint32_t TileHeight = 0;
+
+	uint32_t LevelWidth(uint32_t level) const { return std::max(Width >> level, 1u); }
+	uint32_t LevelHeight(uint32_t level) const { return std::max(Height >> level, 1u); }
+	uint32_t TilesWide(uint32_t level) const { return (LevelWidth(level) + TileWidth - 1) / TileWidth; }
+	uint32_t TilesHigh(uint32_t level) const { return (LevelHeight(level) + TileHeight - 1) / TileHeight; }
+	bool Contains(TilePage page) const { return page.Level < StandardLevels && page.X < TilesWide(page.Level) && page.Y < TilesHigh(page.Level); }
+	// Tile of the next coarser level covering the same area
+	TilePage Parent(TilePage page) const;
+};
+
+// Fits the packing limits, textures that do not stay regular resources
+bool IsVirtualTextureLayoutValid(VirtualTextureLayout const& layout);
+
+struct TileRequest
+{
+	uint32_t Page;
+	// Feedback texels that asked for it or for a finer page falling back to it
+	uint32_t Count;
+};
+
+// Counts the distinct pages of the feedback and adds the coarser ones each page falls back to. Pages of unknown textures,
+// outside their grid or in packed levels are dropped. Sorted coarsest first, then by count, so fallbacks map before the pages needing them
+void AnalyzeTileFeedback(std::span<uint32_t const> feedback, std::span<VirtualTextureLayout const> layouts, std::vector<TileRequest>& outRequests);
+
+struct TileMapping
+{
+	uint32_t Page;
+	uint32_t Slot;
+	// Page that held the slot before, EmptyTilePage for a free slot
+	uint32_t EvictedPage;
+};
+
+struct TileCacheStats
+{
+	uint32_t Slots = 0;
+	uint32_t Resident = 0;
+	// Distinct pages the last feedback asked for, and how many of them were still missing afterwards
+	uint32_t Requested = 0;
+	uint32_t Missing = 0;
+	// Totals since the start
+	uint64_t Mapped = 0;
+	uint64_t Evicted = 0;
+};
+
+// Assigns pages to the slots of the physical tile pool, least recently requested pages are evicted first
+struct TileCache
+{
+	void Init(uint32_t slotCount);
+
+	// Marks the requested pages used and maps the missing ones in request order, at most maxMappings of them.
+	// Pages requested by this feedback are never evicted for each other
+	void Update(std::span<TileRequest const> requests, uint32_t maxMappings, std::vector<TileMapping>& outMappings);
+	bool IsResident(uint32_t page) const { return PageSlots.contains(page); }
+
+	TileCacheStats const& GetStats() const { return Stats; }
+
+private:
+	struct Slot
+	{
+		uint32_t Page = EmptyTilePage;
+		uint64_t LastUsed = 0;
+	};
+
+	std::vector<Slot> Slots;
+	std::unordered_map<uint32_t, uint32_t> PageSlots;
+	uint64_t Frame = 1;
+	TileCacheStats Stats;
+};
+
+// Finest level resident all the way down from the packed levels, one texel per level 0 tile.
+// The shader clamps its sampling to it, so it never reads a tile that is not mapped
+void BuildResidencyMap(VirtualTextureLayout const& layout, uint32_t texture, TileCache const& cache, std::vector<uint8_t>& outMap);
+
+}
\ No newline at end of file
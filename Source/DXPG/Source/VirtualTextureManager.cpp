@@ -0,0 +1,232 @@
+#include "VirtualTextureManager.h"
+#include "StagingRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dxpg
+{
+
+std::unique_ptr<VirtualTextureManager> VirtualTextureManager::Instance = nullptr;
+void VirtualTextureManager::Init(ID3D12Device2* device, ID3D12CommandQueue* queue, uint32_t poolTiles)
+{
+	Device = device;
+	Queue = queue;
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	Supported = SUCCEEDED(Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) && options.TiledResourcesTier >= D3D12_TILED_RESOURCES_TIER_2;
+	if (!Supported)
+	{
+		std::cout << "Tiled resources tier 2 is not supported, virtual texturing is disabled" << std::endl;
+		return;
+	}
+
+	CD3DX12_HEAP_DESC heapDesc(uint64_t(poolTiles) * VirtualTileBytes, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+	ThrowIfFailed(Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&Pool)));
+	Pool->SetName(L"VirtualTexturePool");
+	Tiles.Init(poolTiles);
+}
+
+VirtualTexture* VirtualTextureManager::CreateTexture(std::wstring const& name, DXTexture::TextureCreateInfo const& info, CookedTexture const& cooked, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, DXTexture& outTexture)
+{
+	if (!Supported || Textures.size() == MaxVirtualTextures)
+		return nullptr;
+
+	auto desc = CD3DX12_RESOURCE_DESC::Tex2D(info.Format, info.Width, info.Height, 1, info.MipLevels, 1, 0, info.Flags, D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE);
+	ComPtr<ID3D12Resource> resource;
+	if (FAILED(Device->CreateReservedResource(&desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&resource))))
+		return nullptr;
+
+	D3D12_PACKED_MIP_INFO packedMips = {};
+	D3D12_TILE_SHAPE tileShape = {};
+	Device->GetResourceTiling(resource.Get(), nullptr, &packedMips, &tileShape, nullptr, 0, nullptr);
+	VirtualTextureLayout layout = {
+		.Width = info.Width,
+		.Height = info.Height,
+		.MipCount = info.MipLevels,
+		.StandardLevels = packedMips.NumStandardMips,
+		.TileWidth = tileShape.WidthInTexels,
+		.TileHeight = tileShape.HeightInTexels,
+	};
+	if (!IsVirtualTextureLayoutValid(layout))
+		return nullptr;
+
+	auto& texture = *Textures.emplace_back(std::make_unique<VirtualTexture>());
+	texture.Id = uint32_t(Textures.size() - 1);
+	texture.Layout = layout;
+	texture.Resource = resource;
+	texture.Cooked = cooked;
+	Layouts.push_back(layout);
+	TextureIds[resource.Get()] = texture.Id;
+
+	// The packed levels get a heap of their own, they never leave
+	if (packedMips.NumTilesForPackedMips > 0)
+	{
+		CD3DX12_HEAP_DESC heapDesc(uint64_t(packedMips.NumTilesForPackedMips) * VirtualTileBytes, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+		ThrowIfFailed(Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&texture.PackedHeap)));
+		D3D12_TILED_RESOURCE_COORDINATE coordinate = { 0, 0, 0, packedMips.NumStandardMips };
+		D3D12_TILE_REGION_SIZE regionSize = { packedMips.NumTilesForPackedMips, FALSE, 0, 0, 0 };
+		D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NONE;
+		UINT heapOffset = 0;
+		UINT rangeTiles = packedMips.NumTilesForPackedMips;
+		Queue->UpdateTileMappings(resource.Get(), 1, &coordinate, &regionSize, texture.PackedHeap.Get(), 1, &rangeFlags, &heapOffset, &rangeTiles, D3D12_TILE_MAPPING_FLAG_NONE);
+	}
+
+	DXTexture::TextureCreateInfo residencyInfo = {
+	.Width = layout.TilesWide(0),
+	.Height = layout.TilesHigh(0),
+	.MipLevels = 1,
+	.Format = DXGI_FORMAT_R8_UINT,
+	};
+	texture.ResidencyMap = DXTexture::Create(Device, name + L"_ResidencyMap", residencyInfo, D3D12_RESOURCE_STATE_COPY_DEST);
+	texture.ResidencyMapSRV = g_GPUDescriptorAllocator->AllocateFromStatic(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_R8_UINT;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Texture2D.MipLevels = 1;
+	texture.ResidencyMap.CreatePlacedSRV(texture.ResidencyMapSRV.GetView(0), &srvDesc);
+	UploadResidencyMap(texture, frameCtx, cmdList);
+
+	outTexture = DXTexture(name, resource, D3D12_RESOURCE_STATE_COPY_DEST, Device, info);
+	Stats.Textures++;
+	return &texture;
+}
+
+VirtualTexture* VirtualTextureManager::Find(DXTexture const* texture)
+{
+	auto it = TextureIds.find(texture->Resource.Get());
+	return it != TextureIds.end() ? Textures[it->second].get() : nullptr;
+}
+
+void VirtualTextureManager::MapTile(VirtualTexture& texture, TilePage page, ID3D12Heap* heap, uint32_t heapTile)
+{
+	D3D12_TILED_RESOURCE_COORDINATE coordinate = { page.X, page.Y, 0, page.Level };
+	D3D12_TILE_REGION_SIZE regionSize = { 1, FALSE, 0, 0, 0 };
+	D3D12_TILE_RANGE_FLAGS rangeFlags = heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL;
+	UINT heapOffset = heapTile;
+	UINT rangeTiles = 1;
+	Queue->UpdateTileMappings(texture.Resource.Get(), 1, &coordinate, &regionSize, heap, 1, &rangeFlags, &heapOffset, &rangeTiles, D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+void VirtualTextureManager::UploadResidencyMap(VirtualTexture& texture, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList)
+{
+	std::vector<uint8_t> map;
+	BuildResidencyMap(texture.Layout, texture.Id, Tiles, map);
+
+	uint32_t width = texture.Layout.TilesWide(0);
+	uint32_t height = texture.Layout.TilesHigh(0);
+	uint32_t rowPitch = (width + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+	auto staging = AllocateStaging(Device, frameCtx, uint64_t(rowPitch) * height, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	for (uint32_t y = 0; y < height; ++y)
+		std::memcpy(staging.Data + uint64_t(y) * rowPitch, map.data() + uint64_t(y) * width, width);
+
+	if (texture.ResidencyMap.State != D3D12_RESOURCE_STATE_COPY_DEST)
+		TransitionVec(texture.ResidencyMap, D3D12_RESOURCE_STATE_COPY_DEST).Execute(cmdList);
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = { staging.Offset, { DXGI_FORMAT_R8_UINT, width, height, 1, rowPitch } };
+	CD3DX12_TEXTURE_COPY_LOCATION dst(texture.ResidencyMap.Resource.Get(), 0);
+	CD3DX12_TEXTURE_COPY_LOCATION src(staging.Resource, footprint);
+	cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	TransitionVec(texture.ResidencyMap, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE).Execute(cmdList);
+}
+
+void VirtualTextureManager::Update(std::span<uint32_t const> feedback, UploadQueue& uploads)
+{
+	if (!Supported || Textures.empty())
+		return;
+
+	Stats.FeedbackTexels = uint32_t(std::count_if(feedback.begin(), feedback.end(), [](uint32_t packed) { return packed != EmptyTilePage; }));
+	AnalyzeTileFeedback(feedback, Layouts, Requests);
+	Tiles.Update(Requests, MaxMappingsPerFrame, Mappings);
+	if (Mappings.empty())
+		return;
+
+	// Frames that sampled the evicted tiles were submitted before these queue operations, the uploads after them
+	std::vector<bool> changed(Textures.size(), false);
+	for (auto& mapping : Mappings)
+	{
+		if (mapping.EvictedPage != EmptyTilePage)
+		{
+			TilePage evicted = UnpackTilePage(mapping.EvictedPage);
+			MapTile(*Textures[evicted.Texture], evicted, nullptr, 0);
+			changed[evicted.Texture] = true;
+		}
+		TilePage page = UnpackTilePage(mapping.Page);
+		MapTile(*Textures[page.Texture], page, Pool.Get(), mapping.Slot);
+		changed[page.Texture] = true;
+	}
+
+	// Tiles are copied out of the cooked levels, block rows for the compressed formats
+	struct TileCopy
+	{
+		TilePage Page;
+		uint64_t Offset;
+		D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+		uint32_t Rows;
+		uint32_t RowBytes;
+	};
+	std::vector<TileCopy> copies;
+	uint64_t uploadBytes = 0;
+	for (auto& mapping : Mappings)
+	{
+		TilePage page = UnpackTilePage(mapping.Page);
+		auto& texture = *Textures[page.Texture];
+		auto& layout = texture.Layout;
+		uint32_t blockSize = IsBlockCompressed(texture.Cooked.Format) ? 4 : 1;
+		// Edge tiles stop at the level's block aligned size
+		uint32_t x = page.X * layout.TileWidth;
+		uint32_t y = page.Y * layout.TileHeight;
+		uint32_t width = std::min(layout.TileWidth, (layout.LevelWidth(page.Level) + blockSize - 1) / blockSize * blockSize - x);
+		uint32_t height = std::min(layout.TileHeight, (layout.LevelHeight(page.Level) + blockSize - 1) / blockSize * blockSize - y);
+		uint32_t rowBytes = width / blockSize * TexelFormatBytes(texture.Cooked.Format);
+		uint32_t rowPitch = (rowBytes + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+		uint32_t rows = height / blockSize;
+		uploadBytes = (uploadBytes + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~uint64_t(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+		copies.push_back({ page, uploadBytes, { texture.Resource->GetDesc().Format, width, height, 1, rowPitch }, rows, rowBytes });
+		uploadBytes += uint64_t(rowPitch) * rows;
+	}
+
+	auto& frameCtx = uploads.Begin();
+	auto* cmdList = uploads.CommandList();
+	auto staging = AllocateStaging(Device, frameCtx, uploadBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	auto* mapped = staging.Data;
+	for (auto& copy : copies)
+	{
+		auto& texture = *Textures[copy.Page.Texture];
+		auto& footprint = texture.Cooked.Footprints[copy.Page.Level];
+		uint32_t blockSize = IsBlockCompressed(texture.Cooked.Format) ? 4 : 1;
+		uint64_t source = footprint.Offset + uint64_t(copy.Page.Y * texture.Layout.TileHeight / blockSize) * footprint.RowPitch + uint64_t(copy.Page.X * texture.Layout.TileWidth / blockSize) * TexelFormatBytes(texture.Cooked.Format);
+		for (uint32_t row = 0; row < copy.Rows; ++row)
+			std::memcpy(mapped + copy.Offset + uint64_t(row) * copy.Footprint.RowPitch, texture.Cooked.Payload.data() + source + uint64_t(row) * footprint.RowPitch, copy.RowBytes);
+	}
+	Stats.UploadedBytes += uploadBytes;
+
+	// The textures stay in the shader resource state outside of this batch, their DXTexture keeps tracking that
+	TransitionVec toCopy;
+	TransitionVec toShader;
+	for (uint32_t id = 0; id < Textures.size(); ++id)
+	{
+		if (!changed[id])
+			continue;
+		toCopy.push_back(CD3DX12_RESOURCE_BARRIER::Transition(Textures[id]->Resource.Get(), D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+		toShader.push_back(CD3DX12_RESOURCE_BARRIER::Transition(Textures[id]->Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE));
+	}
+	toCopy.Execute(cmdList);
+	for (auto& copy : copies)
+	{
+		auto& texture = *Textures[copy.Page.Texture];
+		CD3DX12_TEXTURE_COPY_LOCATION dst(texture.Resource.Get(), copy.Page.Level);
+		CD3DX12_TEXTURE_COPY_LOCATION src(staging.Resource, { staging.Offset + copy.Offset, copy.Footprint });
+		cmdList->CopyTextureRegion(&dst, copy.Page.X * texture.Layout.TileWidth, copy.Page.Y * texture.Layout.TileHeight, 0, &src, nullptr);
+	}
+	toShader.Execute(cmdList);
+
+	for (uint32_t id = 0; id < Textures.size(); ++id)
+	{
+		if (changed[id])
+			UploadResidencyMap(*Textures[id], frameCtx, cmdList);
+	}
+	uploads.Submit();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "DXResource.h"
+#include "DXPGCommon.h"
+#include "MappedFile.h"
+#include "RendererCommon.h"
+#include "TextureCache.h"
+#include "UploadQueue.h"
+#include "VirtualTexture.h"
+
+namespace dxpg
+{
+
+struct VirtualTexture
+{
+	uint32_t Id;
+	VirtualTextureLayout Layout;
+	ComPtr<ID3D12Resource> Resource;
+	// Holds the packed levels, mapped for as long as the texture lives
+	ComPtr<ID3D12Heap> PackedHeap;
+	// Finest resident level per level 0 tile, R8_UINT
+	DXTexture ResidencyMap;
+	DescriptorAllocation ResidencyMapSRV;
+	// Source of the tiles, open for as long as the texture lives
+	CookedTexture Cooked;
+	std::vector<std::byte> CookedStorage;
+	MappedFile CacheFile;
+};
+
+struct VirtualTextureStats
+{
+	uint32_t Textures = 0;
+	// Texels of the last feedback that asked for a tile
+	uint32_t FeedbackTexels = 0;
+	uint64_t UploadedBytes = 0;
+};
+
+// Textures backed by reserved resources, their 64KB tiles are mapped from one shared heap after what the G-buffer pass sampled
+struct VirtualTextureManager : public Singleton<VirtualTextureManager>
+{
+	// Needs tiled resources tier 2 for the clamped sampling, without it textures load as regular ones
+	void Init(ID3D12Device2* device, ID3D12CommandQueue* queue, uint32_t poolTiles);
+	bool IsSupported() const { return Supported; }
+
+	// Tiles mapped and uploaded per frame
+	uint32_t MaxMappingsPerFrame = 64;
+
+	// Reserved resource with the packed levels mapped and the residency map uploaded, left in the copy destination state for
+	// the packed levels. Null when the texture is too small to have a tile or too large for the feedback packing
+	VirtualTexture* CreateTexture(std::wstring const& name, DXTexture::TextureCreateInfo const& info, CookedTexture const& cooked, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList, DXTexture& outTexture);
+	VirtualTexture* Find(DXTexture const* texture);
+
+	// Maps and uploads the tiles the feedback asked for and refreshes the residency maps of the textures that changed.
+	// Runs before the frame is recorded, like texture streaming
+	void Update(std::span<uint32_t const> feedback, UploadQueue& uploads);
+
+	VirtualTextureStats const& GetStats() const { return Stats; }
+	TileCacheStats const& GetTileStats() const { return Tiles.GetStats(); }
+
+private:
+	void MapTile(VirtualTexture& texture, TilePage page, ID3D12Heap* heap, uint32_t heapTile);
+	void UploadResidencyMap(VirtualTexture& texture, FrameContext& frameCtx, ID3D12GraphicsCommandList2* cmdList);
+
+	ID3D12Device2* Device = nullptr;
+	ID3D12CommandQueue* Queue = nullptr;
+	bool Supported = false;
+	ComPtr<ID3D12Heap> Pool;
+	TileCache Tiles;
+	std::vector<std::unique_ptr<VirtualTexture>> Textures;
+	std::unordered_map<ID3D12Resource const*, uint32_t> TextureIds;
+	std::vector<VirtualTextureLayout> Layouts;
+	std::vector<TileRequest> Requests;
+	std::vector<TileMapping> Mappings;
+	VirtualTextureStats Stats;
+};
+
+}
\ No newline at end of file
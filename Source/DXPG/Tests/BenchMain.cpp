@@ -0,0 +1,29 @@
+#include "TestFramework.h"
+
+#include <cstring>
+#include <iostream>
+
+// DXPGBench [--quick] [name], runs every benchmark or only the named one
+int main(int argc, char** argv)
+{
+	using namespace dxpg::test;
+	BenchmarkContext context;
+	char const* name = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--quick") == 0)
+			context.Quick = true;
+		else
+			name = argv[i];
+	}
+	uint32_t run = 0;
+	for (auto& benchmark : Benchmarks())
+	{
+		if (name && std::strcmp(name, benchmark.Name) != 0)
+			continue;
+		std::cout << "== " << benchmark.Name << std::endl;
+		benchmark.Run(context);
+		run++;
+	}
+	return (name && run == 0) || FailedChecks() > 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "TestFramework.h"
+
+#include "Culling.h"
+
+#include <iostream>
+#include <random>
+
+using namespace dxpg;
+
+DXPG_BENCHMARK(Culling)
+{
+	size_t const count = context.Size<size_t>(1000000, 10000);
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> extent(0.1f, 5.0f);
+	std::vector<DirectX::BoundingBox> boxes(count);
+	BoundsSoA bounds;
+	bounds.Resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		boxes[i] = DirectX::BoundingBox(Vector3(position(random), position(random), position(random)), Vector3(extent(random), extent(random), extent(random)));
+		bounds.Set(i, boxes[i]);
+	}
+	Matrix4x4 view = XMMatrixLookAtLH(XMVectorSet(0, 0, 0, 1), XMVectorSet(1, 0, 1, 1), XMVectorSet(0, 1, 0, 0));
+	Frustum frustum = Frustum::FromViewProjection(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 400.0f)));
+
+	std::vector<uint32_t> visible;
+	visible.reserve(count);
+	CullingStats stats;
+	double simd = test::TimeMilliseconds([&]() { stats = CullBoxes(frustum, bounds, visible); });
+
+	// Array of structures, one box and one plane at a time
+	uint32_t scalarVisible = 0;
+	double scalar = test::TimeMilliseconds([&]()
+	{
+		XMFLOAT4 planes[Frustum::PlaneCount];
+		for (uint32_t i = 0; i < Frustum::PlaneCount; ++i)
+			XMStoreFloat4(&planes[i], frustum.Planes[i]);
+		for (auto const& box : boxes)
+		{
+			bool inside = true;
+			for (auto const& plane : planes)
+			{
+				float distance = plane.x * box.Center.x + plane.y * box.Center.y + plane.z * box.Center.z + plane.w;
+				float radius = std::abs(plane.x) * box.Extents.x + std::abs(plane.y) * box.Extents.y + std::abs(plane.z) * box.Extents.z;
+				inside &= distance + radius >= 0.0f;
+			}
+			scalarVisible += inside ? 1 : 0;
+		}
+	});
+	CHECK(scalarVisible == stats.Visible);
+	std::cout << count << " boxes: " << stats.Visible << " visible, " << stats.Culled << " culled, SoA " << simd << " ms, scalar " << scalar << " ms" << std::endl;
+}
\ No newline at end of file
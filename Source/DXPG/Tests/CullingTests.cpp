@@ -0,0 +1,125 @@
+#include "TestFramework.h"
+
+#include "Culling.h"
+
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+Matrix4x4 CameraViewProjection()
+{
+	Matrix4x4 view = XMMatrixLookAtLH(XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 0, 1, 1), XMVectorSet(0, 1, 0, 0));
+	return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 1.0f, 100.0f));
+}
+
+DirectX::BoundingBox Box(float x, float y, float z, float extent)
+{
+	return DirectX::BoundingBox(Vector3(x, y, z), Vector3(extent, extent, extent));
+}
+
+// One box at a time against the same planes, the reference the 4 wide loop has to agree with
+bool ScalarIntersects(Frustum const& frustum, DirectX::BoundingBox const& box, uint32_t planeMask)
+{
+	for (uint32_t i = 0; i < Frustum::PlaneCount; ++i)
+	{
+		if (!(planeMask & (1u << i)))
+			continue;
+		XMFLOAT4 plane;
+		XMStoreFloat4(&plane, frustum.Planes[i]);
+		float distance = plane.x * box.Center.x + plane.y * box.Center.y + plane.z * box.Center.z + plane.w;
+		float radius = std::abs(plane.x) * box.Extents.x + std::abs(plane.y) * box.Extents.y + std::abs(plane.z) * box.Extents.z;
+		if (distance + radius < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+BoundsSoA ToSoA(std::vector<DirectX::BoundingBox> const& boxes)
+{
+	BoundsSoA bounds;
+	bounds.Resize(boxes.size());
+	for (size_t i = 0; i < boxes.size(); ++i)
+		bounds.Set(i, boxes[i]);
+	return bounds;
+}
+
+}
+
+DXPG_TEST(Culling, PlanesPointInwardAndAreNormalized)
+{
+	Frustum frustum = Frustum::FromViewProjection(CameraViewProjection());
+	Vector4 inside = XMVectorSet(0, 0, 50, 1);
+	for (Vector4 plane : frustum.Planes)
+	{
+		CHECK_NEAR(XMVectorGetX(XMVector3Length(plane)), 1.0f, 1e-5f);
+		CHECK(XMVectorGetX(XMVector4Dot(plane, inside)) > 0.0f);
+	}
+	// A 90 degree field of view puts the side planes at 45 degrees and the depth planes at the clip distances
+	CHECK_NEAR(XMVectorGetX(XMVector4Dot(frustum.Planes[Frustum::Near], XMVectorSet(0, 0, 1, 1))), 0.0f, 1e-4f);
+	CHECK_NEAR(XMVectorGetX(XMVector4Dot(frustum.Planes[Frustum::Far], XMVectorSet(0, 0, 100, 1))), 0.0f, 1e-3f);
+	CHECK_NEAR(XMVectorGetX(XMVector4Dot(frustum.Planes[Frustum::Left], XMVectorSet(-10, 0, 10, 1))), 0.0f, 1e-4f);
+	CHECK_NEAR(XMVectorGetX(XMVector4Dot(frustum.Planes[Frustum::Top], XMVectorSet(0, 10, 10, 1))), 0.0f, 1e-4f);
+}
+
+DXPG_TEST(Culling, BoxesAroundTheFrustum)
+{
+	Frustum frustum = Frustum::FromViewProjection(CameraViewProjection());
+	std::vector<DirectX::BoundingBox> boxes = {
+		Box(0, 0, 10, 1),     // in front
+		Box(0, 0, -10, 1),    // behind
+		Box(-30, 0, 10, 1),   // left
+		Box(0, 30, 10, 1),    // above
+		Box(0, 0, 200, 1),    // past the far plane
+		Box(-10.5f, 0, 10, 1), // straddles the left plane
+		Box(0, 0, 0.5f, 1),   // straddles the near plane
+	};
+	std::vector<uint32_t> visible;
+	CullingStats stats = CullBoxes(frustum, ToSoA(boxes), visible);
+	CHECK(stats.Visible == 3 && stats.Culled == 4);
+	CHECK((visible == std::vector<uint32_t>{ 0, 5, 6 }));
+}
+
+DXPG_TEST(Culling, SimdMatchesScalarOnRandomScenes)
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+	std::uniform_real_distribution<float> extent(0.01f, 8.0f);
+	Frustum frustum = Frustum::FromViewProjection(CameraViewProjection());
+	// Counts that are not a multiple of 4 exercise the padded tail
+	for (size_t count : { size_t(1), size_t(3), size_t(4), size_t(1001), size_t(10000) })
+	{
+		std::vector<DirectX::BoundingBox> boxes(count);
+		for (auto& box : boxes)
+			box = DirectX::BoundingBox(Vector3(position(random), position(random), position(random)), Vector3(extent(random), extent(random), extent(random)));
+		BoundsSoA bounds = ToSoA(boxes);
+		for (uint32_t planeMask : { Frustum::AllPlanes, Frustum::AllPlanes & ~(1u << Frustum::Near), 0u })
+		{
+			std::vector<uint32_t> visible;
+			CullingStats stats = CullBoxes(frustum, bounds, visible, planeMask);
+			std::vector<uint32_t> expected;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (ScalarIntersects(frustum, boxes[i], planeMask))
+					expected.push_back(i);
+			}
+			CHECK(visible == expected);
+			CHECK(stats.Visible + stats.Culled == count);
+			CHECK(stats.Visible == expected.size());
+		}
+	}
+}
+
+DXPG_TEST(Culling, ResizeKeepsExistingBoxes)
+{
+	BoundsSoA bounds;
+	bounds.Resize(3);
+	bounds.Set(2, Box(1, 2, 3, 4));
+	bounds.Resize(9);
+	CHECK(bounds.Count == 9);
+	CHECK(bounds.CenterX.size() % 4 == 0);
+	CHECK(bounds.Get(2).Center.z == 3.0f && bounds.Get(2).Extents.x == 4.0f);
+	CHECK(bounds.Get(8).Extents.x == 0.0f);
+}
\ No newline at end of file
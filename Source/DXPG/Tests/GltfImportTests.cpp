@@ -0,0 +1,107 @@
+#include "TestFramework.h"
+#include "TestGlb.h"
+
+#include "GltfImport.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace dxpg;
+
+namespace
+{
+
+// A unit quad facing +z, counter clockwise seen from +z, without normals
+std::vector<std::byte> QuadBin()
+{
+	float const positions[] = { 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0 };
+	float const texCoords[] = { 0, 0, 1, 0, 1, 1, 0, 1 };
+	uint16_t const indices[] = { 0, 1, 2, 0, 2, 3 };
+	std::vector<std::byte> bin(sizeof(positions) + sizeof(texCoords) + sizeof(indices));
+	std::memcpy(bin.data(), positions, sizeof(positions));
+	std::memcpy(bin.data() + sizeof(positions), texCoords, sizeof(texCoords));
+	std::memcpy(bin.data() + sizeof(positions) + sizeof(texCoords), indices, sizeof(indices));
+	return bin;
+}
+
+std::string QuadJson(uint32_t nodeCount)
+{
+	// One root with many named children, so the names outlive any growth of the importer's storage
+	std::string nodes = R"({"name":"root","mesh":0,"children":[)";
+	for (uint32_t i = 1; i < nodeCount; ++i)
+		nodes += std::to_string(i) + (i + 1 < nodeCount ? "," : "");
+	nodes += "]}";
+	for (uint32_t i = 1; i < nodeCount; ++i)
+		nodes += R"(,{"name":"child)" + std::to_string(i) + R"(","mesh":0})";
+	return R"({"asset":{"version":"2.0"},"buffers":[{"byteLength":92}],)"
+		R"("bufferViews":[{"buffer":0,"byteLength":48},{"buffer":0,"byteOffset":48,"byteLength":32},{"buffer":0,"byteOffset":80,"byteLength":12}],)"
+		R"("accessors":[{"bufferView":0,"componentType":5126,"count":4,"type":"VEC3"},{"bufferView":1,"componentType":5126,"count":4,"type":"VEC2"},)"
+		R"({"bufferView":2,"componentType":5123,"count":6,"type":"SCALAR"}],)"
+		R"("meshes":[{"name":"quad","primitives":[{"attributes":{"POSITION":0,"TEXCOORD_0":1},"indices":2}]}],)"
+		R"("scene":0,"scenes":[{"nodes":[0]}],"nodes":[)" + nodes + "]}";
+}
+
+// Writes the file to a scratch folder that is removed again when the test ends
+struct GlbFile
+{
+	std::filesystem::path Folder;
+	std::filesystem::path Path;
+
+	GlbFile(char const* name, std::span<std::byte const> glb)
+	{
+		Folder = std::filesystem::temp_directory_path() / name;
+		std::filesystem::remove_all(Folder);
+		std::filesystem::create_directories(Folder);
+		Path = Folder / "model.glb";
+		std::ofstream(Path, std::ios::binary).write(reinterpret_cast<char const*>(glb.data()), glb.size());
+	}
+	~GlbFile()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(Folder, error);
+	}
+};
+
+}
+
+DXPG_TEST(GltfImport, GeneratesMissingNormalsAndFlipsV)
+{
+	auto bin = QuadBin();
+	GlbFile file("dxpg_gltfimport_normals", test::MakeGlb(QuadJson(1), bin));
+	CookedGlb cooked;
+	std::string error;
+	CHECK(CookGlbModel(file.Path, VertexFormat::Full, 2.0f, cooked, error));
+	CHECK(cooked.GeneratedNormals == 1);
+	CHECK(cooked.Model.Shapes.size() == 1);
+	auto vertices = std::span(reinterpret_cast<MeshVertex const*>(cooked.Model.Vertices.data()), cooked.Model.Vertices.size() / sizeof(MeshVertex));
+	CHECK(vertices.size() == 4);
+	for (auto& vertex : vertices)
+	{
+		CHECK_NEAR(vertex.Normal.x, 0.0f, 1e-6f);
+		CHECK_NEAR(vertex.Normal.y, 0.0f, 1e-6f);
+		CHECK_NEAR(vertex.Normal.z, 1.0f, 1e-6f);
+	}
+	// Top left origin in the file, bottom left in the renderer
+	CHECK(vertices[0].TexCoord.x == 0.0f && vertices[0].TexCoord.y == 1.0f);
+	CHECK(vertices[2].TexCoord.x == 1.0f && vertices[2].TexCoord.y == 0.0f);
+	CHECK(vertices[2].Position.x == 2.0f && vertices[2].Position.y == 2.0f);
+}
+
+DXPG_TEST(GltfImport, NodeNamesStayValid)
+{
+	uint32_t const nodeCount = 200;
+	auto bin = QuadBin();
+	GlbFile file("dxpg_gltfimport_nodes", test::MakeGlb(QuadJson(nodeCount), bin));
+	CookedGlb cooked;
+	std::string error;
+	CHECK(CookGlbModel(file.Path, VertexFormat::Full, 1.0f, cooked, error));
+	auto& nodes = cooked.Model.Nodes;
+	CHECK(nodes.size() == nodeCount);
+	CHECK(nodes[0].Name == "root" && nodes[0].Parent == -1 && nodes[0].ShapeCount == 1);
+	for (uint32_t i = 1; i < nodes.size(); ++i)
+	{
+		CHECK(nodes[i].Name == "child" + std::to_string(i));
+		CHECK(nodes[i].Parent == 0);
+	}
+	CHECK(cooked.Model.Materials.size() == 1 && cooked.Model.Materials[0].Name == "Default");
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "TestFramework.h"
+#include "TestGlb.h"
+
+#include "GltfParser.h"
+
+using namespace dxpg;
+
+namespace
+{
+
+bool Parse(std::string const& json, GltfDocument& outDocument, std::string& outError)
+{
+	auto glb = test::MakeGlb(json);
+	return ParseGlb(glb, outDocument, outError);
+}
+
+std::string NodesJson(std::string const& sceneNodes)
+{
+	return R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":)" + sceneNodes + R"(}],)"
+		R"("nodes":[{"name":"root","children":[1,2]},{"name":"a"},{"name":"b"},{"name":"other"}]})";
+}
+
+}
+
+DXPG_TEST(GltfParser, ReadsTheNodeTree)
+{
+	GltfDocument document;
+	std::string error;
+	CHECK(Parse(NodesJson("[0,3]"), document, error));
+	CHECK(document.Nodes.size() == 4);
+	CHECK(document.Nodes[0].Name == "root");
+	CHECK(document.Nodes[0].Parent == -1);
+	CHECK(document.Nodes[1].Parent == 0);
+	CHECK(document.Nodes[2].Parent == 0);
+	CHECK(document.Nodes[3].Parent == -1);
+	CHECK((document.SceneRoots == std::vector<uint32_t>{ 0, 3 }));
+}
+
+DXPG_TEST(GltfParser, RootsDefaultToParentlessNodes)
+{
+	GltfDocument document;
+	std::string error;
+	CHECK(Parse(R"({"asset":{"version":"2.0"},"nodes":[{"children":[2]},{},{}]})", document, error));
+	CHECK((document.SceneRoots == std::vector<uint32_t>{ 0, 1 }));
+}
+
+DXPG_TEST(GltfParser, RejectsInvalidSceneRoots)
+{
+	GltfDocument document;
+	std::string error;
+	// Listed twice, the importer would walk the subtree twice
+	CHECK(!Parse(NodesJson("[0,3,0]"), document, error));
+	CHECK(error.find("listed twice") != std::string::npos);
+	CHECK(document.Nodes.empty() && document.SceneRoots.empty());
+	// A child is not a root
+	CHECK(!Parse(NodesJson("[1]"), document, error));
+	CHECK(!Parse(NodesJson("[4]"), document, error));
+}
+
+DXPG_TEST(GltfParser, RejectsNodesWithTwoParents)
+{
+	GltfDocument document;
+	std::string error;
+	CHECK(!Parse(R"({"asset":{"version":"2.0"},"nodes":[{"children":[2]},{"children":[2]},{}]})", document, error));
+	CHECK(!Parse(R"({"asset":{"version":"2.0"},"nodes":[{"children":[0]}]})", document, error));
+}
+
+DXPG_TEST(GltfParser, ReadsAccessorsFromTheBinaryChunk)
+{
+	float const positions[] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+	uint16_t const indices[] = { 0, 1, 2 };
+	std::vector<std::byte> bin(sizeof(positions) + sizeof(indices));
+	std::memcpy(bin.data(), positions, sizeof(positions));
+	std::memcpy(bin.data() + sizeof(positions), indices, sizeof(indices));
+	std::string json = R"({"asset":{"version":"2.0"},"buffers":[{"byteLength":42}],)"
+		R"("bufferViews":[{"buffer":0,"byteLength":36},{"buffer":0,"byteOffset":36,"byteLength":6}],)"
+		R"("accessors":[{"bufferView":0,"componentType":5126,"count":3,"type":"VEC3"},{"bufferView":1,"componentType":5123,"count":3,"type":"SCALAR"}],)"
+		R"("meshes":[{"primitives":[{"attributes":{"POSITION":0},"indices":1}]}]})";
+	auto glb = test::MakeGlb(json, bin);
+	GltfDocument document;
+	std::string error;
+	CHECK(ParseGlb(glb, document, error));
+	CHECK(document.Meshes.size() == 1 && document.Meshes[0].Primitives.size() == 1);
+	auto& primitive = document.Meshes[0].Primitives[0];
+	CHECK(primitive.Position == 0 && primitive.Indices == 1 && primitive.Normal == -1);
+	float position[3] = {};
+	document.Accessors[0].Read(1, position);
+	CHECK(position[0] == 1.0f && position[1] == 0.0f);
+	CHECK(document.Accessors[1].ReadIndex(2) == 2);
+
+	// A view past the end of the chunk
+	std::string outOfBounds = json;
+	outOfBounds.replace(outOfBounds.find("\"byteLength\":6"), 14, "\"byteLength\":16");
+	auto badGlb = test::MakeGlb(outOfBounds, bin);
+	CHECK(!ParseGlb(badGlb, document, error));
+}
\ No newline at end of file
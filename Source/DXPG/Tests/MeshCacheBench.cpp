@@ -0,0 +1,58 @@
+#include "TestFramework.h"
+
+#include "MeshCache.h"
+#include "MappedFile.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace dxpg;
+
+DXPG_BENCHMARK(MeshCache)
+{
+	// One large shape, what a warm start maps instead of parsing and cooking the source
+	uint32_t const vertexCount = context.Size(1u << 21, 1u << 14);
+	std::vector<MeshVertex> vertices(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; ++i)
+		vertices[i] = { Vector3(float(i % 1024), float(i / 1024), 0.0f), Vector3(0, 0, -1), Vector2(0, 0) };
+	std::vector<uint32_t> indices(size_t(vertexCount) * 3);
+	for (size_t i = 0; i < indices.size(); ++i)
+		indices[i] = uint32_t(i * 7 % vertexCount);
+
+	CookedModel model;
+	model.Format = VertexFormat::Full;
+	model.VertexStride = sizeof(MeshVertex);
+	model.Vertices = std::as_bytes(std::span<MeshVertex const>(vertices));
+	CookedShape shape{ .Name = "shape", .MaterialIndex = -1, .BaseVertex = 0, .VertexCount = vertexCount, .IndexStride = 4, .Indices = std::as_bytes(std::span<uint32_t const>(indices)) };
+	model.Shapes.push_back(shape);
+
+	auto folder = std::filesystem::temp_directory_path() / "dxpg_meshcache_bench";
+	std::filesystem::create_directories(folder);
+	auto source = folder / "model.obj";
+	std::ofstream(source, std::ios::binary | std::ios::trunc) << "o shape\n";
+	MeshCacheKey key;
+	CHECK(MakeMeshCacheKey(source, VertexFormat::Full, key));
+	auto cachePath = MeshCachePath(source);
+
+	double writeTime = test::TimeMilliseconds([&]() { CHECK(WriteMeshCache(cachePath, key, model)); });
+	CookedModel loaded;
+	MappedFile file;
+	double readTime = test::TimeMilliseconds([&]()
+	{
+		CHECK(file.Open(cachePath));
+		CHECK(ReadMeshCache(file.Data(), key, loaded));
+	});
+	// Touching every page, as the upload out of the mapping does
+	uint64_t sum = 0;
+	double touchTime = test::TimeMilliseconds([&]()
+	{
+		for (size_t i = 0; i < loaded.Vertices.size(); i += 4096)
+			sum += uint64_t(loaded.Vertices[i]);
+	});
+	CHECK(loaded.Shapes.size() == 1 && loaded.Shapes[0].Indices.size() == indices.size() * 4);
+	std::cout << (model.Vertices.size() + indices.size() * 4) / (1 << 20) << " MiB: write " << writeTime << " ms, map and validate " << readTime << " ms, touch pages " << touchTime << " ms" << std::endl;
+
+	file.Close();
+	std::error_code error;
+	std::filesystem::remove_all(folder, error);
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "TestFramework.h"
+
+#include "MeshCache.h"
+#include "MappedFile.h"
+
+#include <fstream>
+#include <string>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Owns everything the views of a CookedModel point at
+struct TestModel
+{
+	std::vector<MeshVertex> Vertices;
+	std::vector<uint16_t> Indices;
+	std::vector<MeshLod> Lods;
+	std::vector<Meshlet> Meshlets;
+	std::vector<uint32_t> MeshletVertices;
+	std::vector<uint8_t> MeshletTriangles;
+	std::string MaterialName = "brick";
+	std::string TexturePath = "textures/brick.png";
+	std::string ShapeNames[2] = { "wall", "floor" };
+	CookedModel Model;
+
+	TestModel()
+	{
+		for (uint32_t i = 0; i < 8; ++i)
+			Vertices.push_back({ Vector3(float(i & 1), float(i >> 1 & 1), float(i >> 2)), Vector3(0, 0, 1), Vector2(float(i) / 8.0f, 0.5f) });
+		Indices = { 0, 1, 2, 2, 1, 3, 0, 1, 2, 4, 5, 6, 6, 5, 7 };
+		Lods = { { .FirstIndex = 0, .IndexCount = 6, .Error = 0.0f }, { .FirstIndex = 6, .IndexCount = 3, .Error = 0.25f } };
+		Meshlets.push_back({ .VertexOffset = 0, .TriangleOffset = 0, .VertexCount = 4, .TriangleCount = 2, .Center = Vector3(0.5f, 0.5f, 0), .Radius = 0.8f, .ConeAxis = Vector3(0, 0, 1), .ConeCutoff = 0.0f });
+		MeshletVertices = { 0, 1, 2, 3 };
+		MeshletTriangles = { 0, 1, 2, 2, 1, 3 };
+
+		Model.Format = VertexFormat::Full;
+		Model.VertexStride = sizeof(MeshVertex);
+		Model.Vertices = std::as_bytes(std::span<MeshVertex const>(Vertices));
+		Model.Materials.push_back({ .Name = MaterialName, .DiffuseTexture = TexturePath, .DiffuseTextureData = {}, .DiffuseColor = Vector3(0.8f, 0.4f, 0.2f) });
+		auto indexBytes = std::as_bytes(std::span<uint16_t const>(Indices));
+		CookedShape wall{ .Name = ShapeNames[0], .MaterialIndex = 0, .BaseVertex = 0, .VertexCount = 4, .IndexStride = 2, .Indices = indexBytes.subspan(0, 18), .Lods = Lods,
+			.Meshlets = Meshlets, .MeshletVertices = MeshletVertices, .MeshletTriangles = MeshletTriangles };
+		wall.Bounds = DirectX::BoundingBox(Vector3(0.5f, 0.5f, 0), Vector3(0.5f, 0.5f, 0));
+		wall.BoundingSphere = DirectX::BoundingSphere(Vector3(0.5f, 0.5f, 0), 0.71f);
+		CookedShape floor{ .Name = ShapeNames[1], .MaterialIndex = -1, .BaseVertex = 4, .VertexCount = 4, .IndexStride = 2, .Indices = indexBytes.subspan(18) };
+		floor.Bounds = DirectX::BoundingBox(Vector3(0.5f, 0.5f, 1), Vector3(0.5f, 0.5f, 0));
+		floor.BoundingSphere = DirectX::BoundingSphere(Vector3(0.5f, 0.5f, 1), 0.71f);
+		Model.Shapes = { wall, floor };
+		Model.Stats.UniqueVertices = 8;
+		Model.Stats.Triangles = 4;
+		Model.Stats.Meshlets = 1;
+	}
+};
+
+template<typename T>
+bool SameBytes(std::span<T const> a, std::span<T const> b)
+{
+	auto bytesA = std::as_bytes(a);
+	auto bytesB = std::as_bytes(b);
+	return std::equal(bytesA.begin(), bytesA.end(), bytesB.begin(), bytesB.end());
+}
+
+// Scratch folder with a fake source model, removed again when the test ends
+struct CacheFolder
+{
+	std::filesystem::path Folder;
+	std::filesystem::path Source;
+
+	explicit CacheFolder(char const* name)
+	{
+		Folder = std::filesystem::temp_directory_path() / name;
+		std::filesystem::remove_all(Folder);
+		std::filesystem::create_directories(Folder);
+		Source = Folder / "model.obj";
+		WriteSource("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n");
+	}
+	~CacheFolder()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(Folder, error);
+	}
+
+	void WriteSource(std::string const& text)
+	{
+		std::ofstream(Source, std::ios::binary | std::ios::trunc) << text;
+	}
+};
+
+}
+
+DXPG_TEST(MeshCache, RoundTripsTheCookedModel)
+{
+	CacheFolder folder("dxpg_meshcache_roundtrip");
+	TestModel source;
+	MeshCacheKey key;
+	CHECK(MakeMeshCacheKey(folder.Source, VertexFormat::Full, key));
+	auto cachePath = MeshCachePath(folder.Source);
+	CHECK(cachePath.filename() == "model.obj.meshcache");
+	CHECK(WriteMeshCache(cachePath, key, source.Model));
+	CHECK(!std::filesystem::exists(cachePath.string() + ".tmp"));
+
+	MappedFile file;
+	CHECK(file.Open(cachePath));
+	CookedModel model;
+	CHECK(ReadMeshCache(file.Data(), key, model));
+	CHECK(model.Format == VertexFormat::Full && model.VertexStride == sizeof(MeshVertex));
+	CHECK(SameBytes(model.Vertices, source.Model.Vertices));
+	// Typed views into the mapping need their alignment
+	CHECK(reinterpret_cast<uintptr_t>(model.Vertices.data()) % 16 == 0);
+	CHECK(model.Stats.UniqueVertices == 8 && model.Stats.Triangles == 4 && model.Stats.Meshlets == 1);
+
+	CHECK(model.Materials.size() == 1);
+	CHECK(model.Materials[0].Name == "brick" && model.Materials[0].DiffuseTexture == "textures/brick.png");
+	CHECK(model.Materials[0].DiffuseColor.x == 0.8f && model.Materials[0].DiffuseColor.z == 0.2f);
+
+	CHECK(model.Shapes.size() == 2);
+	for (size_t i = 0; i < model.Shapes.size(); ++i)
+	{
+		auto& shape = model.Shapes[i];
+		auto& expected = source.Model.Shapes[i];
+		CHECK(shape.Name == expected.Name);
+		CHECK(shape.MaterialIndex == expected.MaterialIndex && shape.BaseVertex == expected.BaseVertex && shape.VertexCount == expected.VertexCount);
+		CHECK(shape.IndexStride == 2 && SameBytes(shape.Indices, expected.Indices));
+		CHECK(SameBytes(shape.Lods, expected.Lods) && SameBytes(shape.Meshlets, expected.Meshlets));
+		CHECK(SameBytes(shape.MeshletVertices, expected.MeshletVertices) && SameBytes(shape.MeshletTriangles, expected.MeshletTriangles));
+		CHECK(shape.Bounds.Center.z == expected.Bounds.Center.z && shape.Bounds.Extents.x == expected.Bounds.Extents.x);
+		CHECK(shape.BoundingSphere.Radius == expected.BoundingSphere.Radius);
+	}
+	CHECK(model.Shapes[1].Lods.empty() && model.Shapes[1].Meshlets.empty());
+}
+
+DXPG_TEST(MeshCache, KeyChangesInvalidate)
+{
+	CacheFolder folder("dxpg_meshcache_invalidate");
+	TestModel source;
+	MeshCacheKey key;
+	CHECK(MakeMeshCacheKey(folder.Source, VertexFormat::Full, key));
+	auto cachePath = MeshCachePath(folder.Source);
+	CHECK(WriteMeshCache(cachePath, key, source.Model));
+	MappedFile file;
+	CHECK(file.Open(cachePath));
+	CookedModel model;
+
+	MeshCacheKey otherKey = key;
+	otherKey.Format = VertexFormat::Quantized;
+	CHECK(!ReadMeshCache(file.Data(), otherKey, model));
+	otherKey = key;
+	otherKey.ImporterVersion++;
+	CHECK(!ReadMeshCache(file.Data(), otherKey, model));
+	otherKey = key;
+	otherKey.SourceSize++;
+	CHECK(!ReadMeshCache(file.Data(), otherKey, model));
+
+	// Touched without a change, e.g. by a checkout, the content hash still matches
+	auto writeTime = std::filesystem::last_write_time(folder.Source) + std::chrono::hours(1);
+	std::filesystem::last_write_time(folder.Source, writeTime);
+	CHECK(MakeMeshCacheKey(folder.Source, VertexFormat::Full, otherKey));
+	CHECK(otherKey.SourceWriteTime != key.SourceWriteTime);
+	CHECK(ReadMeshCache(file.Data(), otherKey, model));
+
+	// Same size but different content
+	folder.WriteSource("v 0 0 0\nv 2 0 0\nv 0 1 0\nf 1 2 3\n");
+	std::filesystem::last_write_time(folder.Source, writeTime + std::chrono::hours(1));
+	CHECK(MakeMeshCacheKey(folder.Source, VertexFormat::Full, otherKey));
+	CHECK(otherKey.SourceSize == key.SourceSize);
+	CHECK(!ReadMeshCache(file.Data(), otherKey, model));
+
+	CHECK(!MakeMeshCacheKey(folder.Folder / "missing.obj", VertexFormat::Full, otherKey));
+}
+
+DXPG_TEST(MeshCache, RejectsDamagedFiles)
+{
+	CacheFolder folder("dxpg_meshcache_damaged");
+	TestModel source;
+	MeshCacheKey key;
+	CHECK(MakeMeshCacheKey(folder.Source, VertexFormat::Full, key));
+	auto cachePath = MeshCachePath(folder.Source);
+	CHECK(WriteMeshCache(cachePath, key, source.Model));
+	MappedFile file;
+	CHECK(file.Open(cachePath));
+	std::vector<std::byte> bytes(file.Data().begin(), file.Data().end());
+	file.Close();
+
+	// Cut anywhere, the blob references point past the end
+	CookedModel model;
+	for (size_t size = 0; size < bytes.size(); size += 7)
+		CHECK(!ReadMeshCache(std::span<std::byte const>(bytes.data(), size), key, model));
+
+	auto corrupted = bytes;
+	corrupted[0] ^= std::byte(1);
+	CHECK(!ReadMeshCache(corrupted, key, model));
+	CHECK(ReadMeshCache(bytes, key, model));
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "TestFramework.h"
+
+#include "MeshImport.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+using namespace dxpg;
+
+DXPG_BENCHMARK(MeshBounds)
+{
+	// A noisy box, every vertex can move the bounds so neither loop can skip work
+	size_t const count = context.Size<size_t>(1 << 23, 1 << 19);
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	std::vector<MeshVertex> vertices(count);
+	for (auto& vertex : vertices)
+	{
+		vertex.Position = Vector3(coordinate(random) * 100.0f, coordinate(random) * 50.0f + 20.0f, coordinate(random) * 75.0f);
+		vertex.Normal = Vector3(0.0f, 1.0f, 0.0f);
+		vertex.TexCoord = Vector2(0.0f, 0.0f);
+	}
+
+	// One vertex and one component at a time
+	Vector3 center;
+	float radius = 0.0f;
+	double scalar = test::TimeMilliseconds([&]()
+	{
+		Vector3 minPos = vertices[0].Position;
+		Vector3 maxPos = vertices[0].Position;
+		for (auto& vertex : vertices)
+		{
+			minPos = Vector3(std::min(minPos.x, vertex.Position.x), std::min(minPos.y, vertex.Position.y), std::min(minPos.z, vertex.Position.z));
+			maxPos = Vector3(std::max(maxPos.x, vertex.Position.x), std::max(maxPos.y, vertex.Position.y), std::max(maxPos.z, vertex.Position.z));
+		}
+		center = Vector3((minPos.x + maxPos.x) * 0.5f, (minPos.y + maxPos.y) * 0.5f, (minPos.z + maxPos.z) * 0.5f);
+		float maxDistanceSq = 0.0f;
+		for (auto& vertex : vertices)
+		{
+			float dx = vertex.Position.x - center.x, dy = vertex.Position.y - center.y, dz = vertex.Position.z - center.z;
+			maxDistanceSq = std::max(maxDistanceSq, dx * dx + dy * dy + dz * dz);
+		}
+		radius = std::sqrt(maxDistanceSq);
+	});
+
+	DirectX::BoundingBox bounds;
+	DirectX::BoundingSphere sphere;
+	double simd = test::TimeMilliseconds([&]() { ComputeMeshBounds(vertices, bounds, sphere); });
+	CHECK_NEAR(bounds.Center.x, center.x, 1e-3f);
+	CHECK_NEAR(bounds.Center.y, center.y, 1e-3f);
+	CHECK_NEAR(bounds.Center.z, center.z, 1e-3f);
+	CHECK_NEAR(sphere.Radius, radius, 1e-3f);
+	std::cout << count << " vertices: scalar " << scalar << " ms, SIMD and parallel " << simd << " ms" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "TestFramework.h"
+
+#include "MeshImport.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+std::vector<MeshVertex> RandomVertices(size_t count, uint32_t seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+	std::vector<MeshVertex> vertices(count);
+	for (auto& vertex : vertices)
+		vertex.Position = Vector3(coordinate(random), coordinate(random) * 0.5f + 3.0f, coordinate(random) * 2.0f);
+	return vertices;
+}
+
+// Per component box and the farthest vertex from its center, one vertex at a time
+void CheckBounds(std::span<MeshVertex const> vertices)
+{
+	Vector3 minPos = vertices[0].Position;
+	Vector3 maxPos = vertices[0].Position;
+	for (auto& vertex : vertices)
+	{
+		minPos = Vector3(std::min(minPos.x, vertex.Position.x), std::min(minPos.y, vertex.Position.y), std::min(minPos.z, vertex.Position.z));
+		maxPos = Vector3(std::max(maxPos.x, vertex.Position.x), std::max(maxPos.y, vertex.Position.y), std::max(maxPos.z, vertex.Position.z));
+	}
+	Vector3 center((minPos.x + maxPos.x) * 0.5f, (minPos.y + maxPos.y) * 0.5f, (minPos.z + maxPos.z) * 0.5f);
+	float maxDistanceSq = 0.0f;
+	for (auto& vertex : vertices)
+	{
+		float dx = vertex.Position.x - center.x, dy = vertex.Position.y - center.y, dz = vertex.Position.z - center.z;
+		maxDistanceSq = std::max(maxDistanceSq, dx * dx + dy * dy + dz * dz);
+	}
+
+	DirectX::BoundingBox bounds;
+	DirectX::BoundingSphere sphere;
+	ComputeMeshBounds(vertices, bounds, sphere);
+	CHECK_NEAR(bounds.Center.x, center.x, 1e-5f);
+	CHECK_NEAR(bounds.Center.y, center.y, 1e-5f);
+	CHECK_NEAR(bounds.Center.z, center.z, 1e-5f);
+	CHECK_NEAR(bounds.Extents.x, (maxPos.x - minPos.x) * 0.5f, 1e-5f);
+	CHECK_NEAR(bounds.Extents.y, (maxPos.y - minPos.y) * 0.5f, 1e-5f);
+	CHECK_NEAR(bounds.Extents.z, (maxPos.z - minPos.z) * 0.5f, 1e-5f);
+	CHECK(sphere.Center.x == bounds.Center.x && sphere.Center.y == bounds.Center.y && sphere.Center.z == bounds.Center.z);
+	CHECK_NEAR(sphere.Radius, std::sqrt(maxDistanceSq), 1e-4f);
+}
+
+}
+
+DXPG_TEST(MeshImport, BoundsMatchScalarLoop)
+{
+	// Every remainder of the 4 wide loop, then more than one parallel chunk
+	for (size_t count : { size_t(1), size_t(2), size_t(3), size_t(4), size_t(7), size_t(1001) })
+		CheckBounds(RandomVertices(count, uint32_t(count)));
+	CheckBounds(RandomVertices(BoundsChunkVertices * 2 + 5, 11));
+}
+
+DXPG_TEST(MeshImport, NarrowsIndices)
+{
+	std::vector<uint32_t> indices = { 0, 1, 2, 65535, 7, 65534 };
+	std::vector<uint16_t> narrowed;
+	NarrowIndices(indices, narrowed);
+	CHECK(narrowed.size() == indices.size());
+	CHECK(std::equal(indices.begin(), indices.end(), narrowed.begin()));
+	CHECK(FitsIndex16(1 << 16));
+	CHECK(!FitsIndex16((1 << 16) + 1));
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "TestFramework.h"
+#include "TestMesh.h"
+
+#include "MeshLod.h"
+
+#include <iomanip>
+#include <iostream>
+
+using namespace dxpg;
+
+DXPG_BENCHMARK(MeshLod)
+{
+	uint32_t const rings = context.Size(128u, 32u);
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	test::MakeSphere(rings, rings * 2, vertices, indices);
+	std::vector<MeshLod> lods;
+	double milliseconds = test::TimeMilliseconds([&]() { BuildLodChain(indices, vertices, lods); });
+	CHECK(lods.size() > 1);
+	std::cout << lods[0].IndexCount / 3 << " triangle sphere, " << lods.size() << " levels built in " << milliseconds << " ms:";
+	for (auto& lod : lods)
+		std::cout << " " << lod.IndexCount / 3 << " (" << lod.Error << ")";
+	std::cout << std::endl;
+
+	// What a 1080p camera with a 60 degree vertical field of view draws of the sphere as it moves away
+	LodSettings settings;
+	float const projectionScale = 1.0f / std::tan(XM_PI / 6.0f);
+	uint64_t drawn = 0;
+	uint64_t full = 0;
+	std::cout << std::fixed << std::setprecision(4) << std::setw(10) << "distance" << std::setw(10) << "size" << std::setw(6) << "lod" << std::setw(12) << "triangles" << std::setw(10) << "saved" << std::endl;
+	for (float distance : { 2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f })
+	{
+		float size = ProjectedSphereSize(XMVectorSet(0, 0, distance, 1), 1.0f, XMVectorZero(), projectionScale);
+		uint32_t lod = SelectLod(lods, size, settings);
+		uint32_t triangles = lod == LodCulled ? 0 : lods[lod].IndexCount / 3;
+		drawn += triangles;
+		full += lods[0].IndexCount / 3;
+		std::cout << std::setw(10) << std::setprecision(0) << distance << std::setw(10) << std::setprecision(4) << size << std::setw(6) << (lod == LodCulled ? std::string("-") : std::to_string(lod))
+			<< std::setw(12) << triangles << std::setw(9) << std::setprecision(1) << 100.0 * (1.0 - double(triangles) / (lods[0].IndexCount / 3)) << "%" << std::endl;
+	}
+	std::cout << std::defaultfloat << "Over all distances " << drawn << " of " << full << " triangles drawn" << std::endl;
+}
\ No newline at end of file
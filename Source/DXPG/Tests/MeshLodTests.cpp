@@ -0,0 +1,116 @@
+#include "TestFramework.h"
+#include "TestMesh.h"
+
+#include "MeshLod.h"
+
+using namespace dxpg;
+
+namespace
+{
+
+// Levels follow each other in the index buffer, each one coarser by at least MinLodReduction within MaxLodError more error
+void CheckChain(std::vector<uint32_t> const& indices, std::vector<MeshLod> const& lods, size_t lod0IndexCount)
+{
+	CHECK(!lods.empty() && lods.size() <= MaxMeshLods);
+	CHECK(lods[0].FirstIndex == 0 && lods[0].IndexCount == lod0IndexCount && lods[0].Error == 0.0f);
+	for (size_t level = 1; level < lods.size(); ++level)
+	{
+		CHECK(lods[level].FirstIndex == lods[level - 1].FirstIndex + lods[level - 1].IndexCount);
+		CHECK(lods[level].IndexCount % 3 == 0);
+		CHECK(lods[level].IndexCount <= lods[level - 1].IndexCount * (1.0f - MinLodReduction));
+		// The target is half the previous level, it is never below MinLodTriangles
+		CHECK(lods[level - 1].IndexCount / 3 / 2 >= MinLodTriangles);
+		CHECK(lods[level].Error >= lods[level - 1].Error);
+		CHECK(lods[level].Error - lods[level - 1].Error <= MaxLodError + 1e-4f);
+	}
+	CHECK(indices.size() == lods.back().FirstIndex + lods.back().IndexCount);
+}
+
+}
+
+DXPG_TEST(MeshLod, ChainHalvesUntilTheLevelLimit)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	test::MakeSphere(64, 128, vertices, indices);
+	size_t lod0 = indices.size();
+	std::vector<MeshLod> lods;
+	BuildLodChain(indices, vertices, lods);
+	CheckChain(indices, lods, lod0);
+	CHECK(lods.size() == MaxMeshLods);
+	CHECK(lods.back().IndexCount < lod0 / 8);
+}
+
+DXPG_TEST(MeshLod, ChainStopsAtTheTriangleFloor)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	// 128 triangles halve to 64, 32 and 16, halving those would go below the floor
+	test::MakeGrid(8, vertices, indices);
+	std::vector<MeshLod> lods;
+	BuildLodChain(indices, vertices, lods);
+	CheckChain(indices, lods, 8 * 8 * 6);
+	CHECK(lods.size() == 4);
+	CHECK(lods.back().IndexCount / 3 / 2 < MinLodTriangles);
+
+	// 18 triangles, too few for any level
+	test::MakeGrid(3, vertices, indices);
+	BuildLodChain(indices, vertices, lods);
+	CHECK(lods.size() == 1 && lods[0].IndexCount == 3 * 3 * 6);
+}
+
+DXPG_TEST(MeshLod, ChainStopsWhenALevelBarelyShrinks)
+{
+	// Unwelded like a flat shaded export, every corner shares its position with another vertex and is locked as a seam
+	std::vector<MeshVertex> welded, vertices;
+	std::vector<uint32_t> weldedIndices, indices;
+	test::MakeGrid(16, welded, weldedIndices);
+	for (uint32_t index : weldedIndices)
+	{
+		indices.push_back(uint32_t(vertices.size()));
+		vertices.push_back(welded[index]);
+	}
+	std::vector<MeshLod> lods;
+	BuildLodChain(indices, vertices, lods);
+	CheckChain(indices, lods, 16 * 16 * 6);
+	CHECK(lods.size() == 1);
+	CHECK(indices.size() == 16 * 16 * 6);
+}
+
+DXPG_TEST(MeshLod, ProjectedSizeShrinksWithDistance)
+{
+	Vector4 center = XMVectorSet(0, 0, 10, 1);
+	Vector4 camera = XMVectorSet(0, 0, 0, 1);
+	CHECK_NEAR(ProjectedSphereSize(center, 1.0f, camera, 1.0f), 0.1f, 1e-5f);
+	CHECK_NEAR(ProjectedSphereSize(XMVectorSet(0, 0, 20, 1), 1.0f, camera, 1.0f), 0.05f, 1e-5f);
+	CHECK_NEAR(ProjectedSphereSize(center, 1.0f, camera, 2.0f), 0.2f, 1e-5f);
+	// Inside or right in front of it
+	CHECK(ProjectedSphereSize(center, 10.0f, camera, 1.0f) == 1.0f);
+	CHECK(ProjectedSphereSize(center, 9.0f, camera, 2.0f) == 1.0f);
+}
+
+DXPG_TEST(MeshLod, SelectsCoarserLevelsAsObjectsShrink)
+{
+	MeshLod lods[] = { { 0, 600, 0.0f }, { 600, 300, 0.002f }, { 900, 150, 0.01f }, { 1050, 75, 0.05f } };
+	LodSettings settings;
+	CHECK(SelectLod(lods, 1.0f, settings) == 0);
+	// At 1080 pixels a relative error e is 540 * size * e pixels
+	CHECK(SelectLod(lods, 0.5f, settings) == 1);
+	CHECK(SelectLod(lods, 0.1f, settings) == 2);
+	CHECK(SelectLod(lods, 0.02f, settings) == 3);
+	CHECK(SelectLod(lods, settings.MinScreenSize * 0.5f, settings) == LodCulled);
+
+	uint32_t previous = 0;
+	for (float size = 1.0f; size >= settings.MinScreenSize; size *= 0.9f)
+	{
+		uint32_t lod = SelectLod(lods, size, settings);
+		CHECK(lod >= previous && lod < 4);
+		previous = lod;
+	}
+	CHECK(previous == 3);
+
+	// A single level is always drawn as long as the object is large enough
+	CHECK(SelectLod(std::span(lods, 1), 0.01f, settings) == 0);
+	settings.MaxErrorPixels = 100.0f;
+	CHECK(SelectLod(lods, 1.0f, settings) == 3);
+}
\ No newline at end of file
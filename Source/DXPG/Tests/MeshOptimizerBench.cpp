@@ -0,0 +1,37 @@
+#include "TestFramework.h"
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+using namespace dxpg;
+
+DXPG_BENCHMARK(MeshOptimizer)
+{
+	// Shuffled grid, the order an unoptimized export with no locality ends up in
+	uint32_t const size = context.Size(512u, 128u);
+	std::vector<MeshVertex> vertices;
+	for (uint32_t y = 0; y <= size; ++y)
+		for (uint32_t x = 0; x <= size; ++x)
+			vertices.push_back({ Vector3(float(x), float(y), 0.0f), Vector3(0.0f, 0.0f, -1.0f), Vector2(0.0f, 0.0f) });
+	std::vector<uint32_t> triangles;
+	for (uint32_t y = 0; y < size; ++y)
+		for (uint32_t x = 0; x < size; ++x)
+			triangles.push_back(y * size + x);
+	std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+	std::vector<uint32_t> indices;
+	for (uint32_t quad : triangles)
+	{
+		uint32_t a = quad / size * (size + 1) + quad % size;
+		uint32_t b = a + size + 1;
+		indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+	}
+
+	VertexCacheStats before, after;
+	double milliseconds = test::TimeMilliseconds([&]() { OptimizeMesh(vertices, indices, &before, &after); });
+	CHECK(after.ACMR < before.ACMR);
+	std::cout << indices.size() / 3 << " triangles optimized in " << milliseconds << " ms, ACMR " << before.ACMR << " -> " << after.ACMR
+		<< ", ATVR " << before.ATVR << " -> " << after.ATVR << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "TestFramework.h"
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <tuple>
+
+using namespace dxpg;
+
+namespace
+{
+
+// UV sphere with its triangles shuffled, like a mesh whose triangle order says nothing about locality
+void ShuffledSphere(uint32_t rings, uint32_t segments, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	outVertices.clear();
+	outIndices.clear();
+	for (uint32_t ring = 0; ring <= rings; ++ring)
+	{
+		for (uint32_t segment = 0; segment <= segments; ++segment)
+		{
+			float theta = 3.14159265f * (float(ring) + 0.5f) / float(rings + 1);
+			float phi = 6.28318531f * float(segment) / float(segments + 1);
+			Vector3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			outVertices.push_back({ normal, normal, Vector2(float(segment) / float(segments), float(ring) / float(rings)) });
+		}
+	}
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (uint32_t ring = 0; ring < rings; ++ring)
+	{
+		for (uint32_t segment = 0; segment < segments; ++segment)
+		{
+			uint32_t a = ring * (segments + 1) + segment;
+			uint32_t b = a + segments + 1;
+			triangles.push_back({ a, b, a + 1 });
+			triangles.push_back({ a + 1, b, b + 1 });
+		}
+	}
+	std::shuffle(triangles.begin(), triangles.end(), std::mt19937(5));
+	for (auto& triangle : triangles)
+		outIndices.insert(outIndices.end(), triangle.begin(), triangle.end());
+}
+
+using Corner = std::tuple<float, float, float>;
+using Triangle = std::array<Corner, 3>;
+
+// Triangles by corner positions, rotated to start at the smallest corner so the winding is kept
+std::vector<Triangle> SortedTriangles(std::vector<MeshVertex> const& vertices, std::vector<uint32_t> const& indices)
+{
+	std::vector<Triangle> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		Triangle triangle;
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			auto& position = vertices[indices[i + corner]].Position;
+			triangle[corner] = { position.x, position.y, position.z };
+		}
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+}
+
+DXPG_TEST(MeshOptimizer, CacheStatsOfKnownOrders)
+{
+	// A single triangle transforms three vertices, repeating it transforms nothing new
+	std::vector<uint32_t> indices = { 0, 1, 2, 0, 1, 2 };
+	auto stats = AnalyzeVertexCache(indices, 3);
+	CHECK(stats.TransformedVertices == 3);
+	CHECK_NEAR(stats.ACMR, 1.5f, 1e-6f);
+	CHECK_NEAR(stats.ATVR, 1.0f, 1e-6f);
+
+	// A FIFO cache of 3 has evicted vertex 0 after 3, 4 and 5
+	indices = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+	CHECK(AnalyzeVertexCache(indices, 6, 3).TransformedVertices == 9);
+	CHECK(AnalyzeVertexCache(indices, 6, 6).TransformedVertices == 6);
+	CHECK(AnalyzeVertexCache({}, 0).TransformedVertices == 0);
+}
+
+DXPG_TEST(MeshOptimizer, ReordersForTheVertexCache)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	ShuffledSphere(48, 64, vertices, indices);
+	auto expected = SortedTriangles(vertices, indices);
+
+	VertexCacheStats before, after;
+	OptimizeMesh(vertices, indices, &before, &after);
+	CHECK(before.ACMR > 2.0f);
+	CHECK(after.ACMR < 0.8f);
+	CHECK(after.ATVR < 1.6f);
+	CHECK(after.ACMR < before.ACMR);
+	CHECK(SortedTriangles(vertices, indices) == expected);
+}
+
+DXPG_TEST(MeshOptimizer, IsDeterministic)
+{
+	std::vector<MeshVertex> vertices, otherVertices;
+	std::vector<uint32_t> indices, otherIndices;
+	ShuffledSphere(32, 40, vertices, indices);
+	otherVertices = vertices;
+	otherIndices = indices;
+	OptimizeMesh(vertices, indices);
+	OptimizeMesh(otherVertices, otherIndices);
+	CHECK(indices == otherIndices);
+	CHECK(std::equal(vertices.begin(), vertices.end(), otherVertices.begin(), otherVertices.end(), [](MeshVertex const& a, MeshVertex const& b)
+	{
+		return a.Position.x == b.Position.x && a.Position.y == b.Position.y && a.Position.z == b.Position.z;
+	}));
+}
+
+DXPG_TEST(MeshOptimizer, OverdrawKeepsTheCacheWithinThreshold)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	ShuffledSphere(40, 48, vertices, indices);
+	uint32_t vertexCount = uint32_t(vertices.size());
+	OptimizeVertexCache(indices, vertexCount);
+	float cacheOptimized = AnalyzeVertexCache(indices, vertexCount).ACMR;
+	auto expected = SortedTriangles(vertices, indices);
+
+	OptimizeOverdraw(indices, vertices, 1.05f);
+	CHECK(AnalyzeVertexCache(indices, vertexCount).ACMR <= cacheOptimized * 1.05f + 1e-4f);
+	CHECK(SortedTriangles(vertices, indices) == expected);
+}
+
+DXPG_TEST(MeshOptimizer, FetchOrderFollowsFirstUse)
+{
+	std::vector<MeshVertex> vertices(6);
+	for (uint32_t i = 0; i < vertices.size(); ++i)
+		vertices[i].Position = Vector3(float(i), 0.0f, 0.0f);
+	// Vertex 1 is never used
+	std::vector<uint32_t> indices = { 5, 3, 0, 0, 3, 4, 2, 5, 4 };
+	OptimizeVertexFetch(vertices, indices);
+	CHECK(vertices.size() == 5);
+	CHECK((indices == std::vector<uint32_t>{ 0, 1, 2, 2, 1, 3, 4, 0, 3 }));
+	CHECK(vertices[0].Position.x == 5.0f && vertices[1].Position.x == 3.0f && vertices[2].Position.x == 0.0f);
+	CHECK(vertices[3].Position.x == 4.0f && vertices[4].Position.x == 2.0f);
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "TestFramework.h"
+#include "TestMesh.h"
+
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+float SignedArea(std::vector<MeshVertex> const& vertices, std::span<uint32_t const> indices)
+{
+	float area = 0.0f;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		auto& a = vertices[indices[i]].Position;
+		auto& b = vertices[indices[i + 1]].Position;
+		auto& c = vertices[indices[i + 2]].Position;
+		area += 0.5f * ((c.x - a.x) * (b.y - a.y) - (b.x - a.x) * (c.y - a.y));
+	}
+	return area;
+}
+
+bool IsReferenced(std::span<uint32_t const> indices, uint32_t vertex)
+{
+	return std::find(indices.begin(), indices.end(), vertex) != indices.end();
+}
+
+// Triangles of the result are valid and no longer than the input
+void CheckIndices(std::span<uint32_t const> indices, size_t vertexCount, size_t maxIndexCount)
+{
+	CHECK(indices.size() % 3 == 0 && indices.size() <= maxIndexCount);
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		CHECK(indices[i] < vertexCount && indices[i + 1] < vertexCount && indices[i + 2] < vertexCount);
+		CHECK(indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i] != indices[i + 2]);
+	}
+}
+
+}
+
+DXPG_TEST(MeshSimplifier, ReachesTheTargetOnACurvedMesh)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	test::MakeSphere(32, 64, vertices, indices);
+	std::vector<uint32_t> simplified;
+	float error = SimplifyMesh(indices, vertices, indices.size() / 4, 0.5f, simplified);
+	CheckIndices(simplified, vertices.size(), indices.size() / 4);
+	CHECK(simplified.size() >= indices.size() / 8);
+	CHECK(error > 0.0f && error <= 0.5f);
+
+	// The seam column is never moved, every one of its vertices is still used
+	for (uint32_t ring = 1; ring < 32; ++ring)
+	{
+		uint32_t first = 1 + (ring - 1) * 65;
+		CHECK(IsReferenced(simplified, first) && IsReferenced(simplified, first + 64));
+	}
+
+	// A tighter error bound stops early
+	std::vector<uint32_t> bounded;
+	float boundedError = SimplifyMesh(indices, vertices, indices.size() / 4, 0.001f, bounded);
+	CHECK(bounded.size() > simplified.size());
+	CHECK(boundedError <= 0.001f);
+}
+
+DXPG_TEST(MeshSimplifier, FlatGridKeepsItsOutlineAndSeam)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	test::MakeGrid(32, vertices, indices, {}, 12);
+	std::vector<uint32_t> simplified;
+	float error = SimplifyMesh(indices, vertices, 0, 0.01f, simplified);
+	CheckIndices(simplified, vertices.size(), indices.size());
+	CHECK(simplified.size() < indices.size() / 8);
+	CHECK(error < 1e-3f);
+	// Borders only slide along themselves, so the covered area stays the same
+	CHECK_NEAR(SignedArea(vertices, simplified), SignedArea(vertices, indices), 1e-2);
+	for (uint32_t corner : { 0u, 32u, 33u * 32u, 33u * 33u - 1u })
+		CHECK(IsReferenced(simplified, corner));
+	// Both wedges of the seam stay in place
+	for (uint32_t y = 0; y <= 32; ++y)
+		CHECK(IsReferenced(simplified, y * 33 + 12) && IsReferenced(simplified, 33 * 33 + y));
+}
+
+DXPG_TEST(MeshSimplifier, LeavesRoughMeshesAloneWithinTheError)
+{
+	// Heights jumping by a whole unit between neighbours, every collapse moves the surface by about that much
+	std::vector<float> heights(17 * 17);
+	std::mt19937 random(10);
+	for (auto& height : heights)
+		height = float(random() % 2);
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	test::MakeGrid(16, vertices, indices, heights);
+	std::vector<uint32_t> simplified;
+	float error = SimplifyMesh(indices, vertices, indices.size() / 2, 0.05f, simplified);
+	CheckIndices(simplified, vertices.size(), indices.size());
+	CHECK(simplified.size() > indices.size() * 3 / 4);
+	CHECK(error <= 0.05f);
+
+	// Nothing to do when the target is met already
+	CHECK(SimplifyMesh(indices, vertices, indices.size(), 1.0f, simplified) == 0.0f);
+	CHECK(simplified == indices);
+}
\ No newline at end of file
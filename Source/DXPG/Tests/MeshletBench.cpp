@@ -0,0 +1,62 @@
+#include "TestFramework.h"
+#include "TestMesh.h"
+
+#include "Meshlet.h"
+#include "MeshOptimizer.h"
+
+#include <iomanip>
+#include <iostream>
+
+using namespace dxpg;
+
+DXPG_BENCHMARK(Meshlet)
+{
+	uint32_t const rings = context.Size(128u, 32u);
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	test::MakeSphere(rings, rings * 2, vertices, indices);
+	OptimizeMesh(vertices, indices);
+	MeshletData meshlets;
+	BuildMeshlets(indices, vertices, meshlets);
+	std::cout << indices.size() / 3 << " triangle sphere, " << meshlets.Meshlets.size() << " meshlets" << std::endl;
+
+	// Draw calls of the sphere seen by a 16:9 camera with a 60 degree vertical field of view, from far away down to skimming its surface
+	struct View
+	{
+		char const* Name;
+		Vector4 Eye;
+		Vector4 Target;
+	};
+	View const views[] = {
+		{ "distance 50", XMVectorSet(0, 0, -50, 1), XMVectorSet(0, 0, 0, 1) },
+		{ "distance 10", XMVectorSet(0, 0, -10, 1), XMVectorSet(0, 0, 0, 1) },
+		{ "distance 3", XMVectorSet(0, 0, -3, 1), XMVectorSet(0, 0, 0, 1) },
+		{ "distance 1.5", XMVectorSet(0, 0, -1.5f, 1), XMVectorSet(0, 0, 0, 1) },
+		{ "close up", XMVectorSet(0, 0, -1.2f, 1), XMVectorSet(0.6f, 0, -1, 1) },
+		{ "skimming", XMVectorSet(0, 1.05f, -0.2f, 1), XMVectorSet(0, 1.05f, 1, 1) },
+	};
+	Matrix4x4 const projection = XMMatrixPerspectiveFovLH(XM_PI / 3.0f, 16.0f / 9.0f, 0.01f, 100.0f);
+	ClusterDrawSettings settings;
+	uint32_t const indexCount = uint32_t(indices.size());
+	std::vector<IndexRange> ranges;
+	uint32_t splitDraws = 0;
+	uint32_t settingsDraws = 0;
+	std::cout << std::fixed << std::setprecision(1) << std::setw(14) << "view" << std::setw(9) << "visible" << std::setw(8) << "culled" << std::setw(9) << "skipped"
+		<< std::setw(8) << "ranges" << std::setw(7) << "draws" << std::endl;
+	for (auto& view : views)
+	{
+		Frustum frustum = Frustum::FromViewProjection(XMMatrixMultiply(XMMatrixLookAtLH(view.Eye, view.Target, XMVectorSet(0, 1, 0, 0)), projection));
+		ranges.clear();
+		CullingStats stats = CullMeshlets(meshlets.Meshlets, XMMatrixIdentity(), frustum, view.Eye, ranges);
+		uint32_t visibleIndices = 0;
+		for (auto& range : ranges)
+			visibleIndices += range.IndexCount;
+		uint32_t draws = SplitClusterDraws(ranges, indexCount, settings) ? uint32_t(ranges.size()) : 1;
+		CHECK(draws <= settings.MaxDraws);
+		splitDraws += uint32_t(ranges.size());
+		settingsDraws += draws;
+		std::cout << std::setw(14) << view.Name << std::setw(9) << stats.Visible << std::setw(8) << stats.Culled << std::setw(8) << 100.0 * (1.0 - double(visibleIndices) / indexCount) << "%"
+			<< std::setw(8) << ranges.size() << std::setw(7) << draws << std::endl;
+	}
+	std::cout << std::defaultfloat << "Over all views " << splitDraws << " draws splitting every time, " << settingsDraws << " with the default settings, " << std::size(views) << " without cluster culling" << std::endl;
+}
\ No newline at end of file
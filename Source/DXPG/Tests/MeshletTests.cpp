@@ -0,0 +1,201 @@
+#include "TestFramework.h"
+
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+void Sphere(uint32_t rings, uint32_t segments, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	for (uint32_t ring = 0; ring <= rings; ++ring)
+	{
+		for (uint32_t segment = 0; segment <= segments; ++segment)
+		{
+			float theta = 3.14159265f * (float(ring) + 0.5f) / float(rings + 1);
+			float phi = 6.28318531f * float(segment) / float(segments);
+			Vector3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			outVertices.push_back({ normal, normal, Vector2(0.0f, 0.0f) });
+		}
+	}
+	// Wound so the face normals point outwards, in 4x4 quad tiles so every meshlet covers a small patch
+	constexpr uint32_t Tile = 4;
+	for (uint32_t tileRing = 0; tileRing < rings; tileRing += Tile)
+	{
+		for (uint32_t tileSegment = 0; tileSegment < segments; tileSegment += Tile)
+		{
+			for (uint32_t ring = tileRing; ring < std::min(tileRing + Tile, rings); ++ring)
+			{
+				for (uint32_t segment = tileSegment; segment < std::min(tileSegment + Tile, segments); ++segment)
+				{
+					uint32_t a = ring * (segments + 1) + segment;
+					uint32_t b = a + segments + 1;
+					outIndices.insert(outIndices.end(), { a, a + 1, b, a + 1, b + 1, b });
+				}
+			}
+		}
+	}
+}
+
+Vector4 WorldPosition(std::vector<MeshVertex> const& vertices, uint32_t index, Matrix4x4 const& world)
+{
+	return XMVector3Transform(XMLoadFloat3(&vertices[index].Position), world);
+}
+
+// Culling may keep too much but must never drop a meshlet with a front facing triangle corner inside the frustum
+bool DropsVisibleTriangles(MeshletData const& meshlets, std::vector<MeshVertex> const& vertices, std::vector<uint32_t> const& indices, Matrix4x4 const& world, Frustum const& frustum, Vector4 camera, uint32_t& outCulled)
+{
+	std::vector<IndexRange> ranges;
+	std::vector<bool> drawn(indices.size() / 3, false);
+	outCulled = CullMeshlets(meshlets.Meshlets, world, frustum, camera, ranges).Culled;
+	for (auto& range : ranges)
+		for (uint32_t t = range.FirstIndex / 3; t < (range.FirstIndex + range.IndexCount) / 3; ++t)
+			drawn[t] = true;
+
+	for (uint32_t t = 0; t < drawn.size(); ++t)
+	{
+		Vector4 p0 = WorldPosition(vertices, indices[3 * t], world);
+		Vector4 p1 = WorldPosition(vertices, indices[3 * t + 1], world);
+		Vector4 p2 = WorldPosition(vertices, indices[3 * t + 2], world);
+		Vector4 normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+		if (drawn[t] || XMVectorGetX(XMVector3Dot(XMVectorSubtract(p0, camera), normal)) >= 0.0f)
+			continue;
+		for (Vector4 corner : { p0, p1, p2 })
+		{
+			bool inside = true;
+			for (auto& plane : frustum.Planes)
+				inside = inside && XMVectorGetX(XMVector4Dot(plane, XMVectorSetW(corner, 1.0f))) >= 0.0f;
+			if (inside)
+				return true;
+		}
+	}
+	return false;
+}
+
+}
+
+DXPG_TEST(Meshlet, BuildRespectsLimitsAndCoversTheMesh)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	Sphere(40, 64, vertices, indices);
+	MeshletData meshlets;
+	BuildMeshlets(indices, vertices, meshlets);
+
+	uint32_t nextTriangle = 0;
+	for (auto& meshlet : meshlets.Meshlets)
+	{
+		CHECK(meshlet.VertexCount <= MeshletMaxVertices);
+		CHECK(meshlet.TriangleCount > 0 && meshlet.TriangleCount <= MeshletMaxTriangles);
+		CHECK(meshlet.TriangleOffset == nextTriangle);
+		nextTriangle += meshlet.TriangleCount;
+		for (uint32_t t = 0; t < meshlet.TriangleCount; ++t)
+		{
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t local = meshlets.Triangles[3 * (meshlet.TriangleOffset + t) + corner];
+				CHECK(local < meshlet.VertexCount);
+				uint32_t vertex = meshlets.Vertices[meshlet.VertexOffset + local];
+				CHECK(vertex == indices[3 * (meshlet.TriangleOffset + t) + corner]);
+				float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&vertices[vertex].Position), XMLoadFloat3(&meshlet.Center))));
+				CHECK(distance <= meshlet.Radius + 1e-5f);
+			}
+		}
+	}
+	CHECK(nextTriangle == indices.size() / 3);
+	CHECK(meshlets.Triangles.size() == indices.size());
+}
+
+DXPG_TEST(Meshlet, MergesAdjacentVisibleRanges)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	Sphere(40, 64, vertices, indices);
+	MeshletData meshlets;
+	BuildMeshlets(indices, vertices, meshlets);
+
+	// Everything in view from far away, cones still reject the back half
+	Matrix4x4 view = XMMatrixLookAtLH(XMVectorSet(0, 0, -50, 1), XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0));
+	Frustum frustum = Frustum::FromViewProjection(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.0f, 1.0f, 100.0f)));
+	std::vector<IndexRange> ranges;
+	auto stats = CullMeshlets(meshlets.Meshlets, XMMatrixIdentity(), frustum, XMVectorSet(0, 0, -50, 1), ranges);
+	CHECK(stats.Visible + stats.Culled == meshlets.Meshlets.size());
+	CHECK(stats.Culled > 0 && stats.Visible > 0);
+	CHECK(ranges.size() < stats.Visible);
+	uint32_t indexCount = 0;
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		indexCount += ranges[i].IndexCount;
+		if (i > 0)
+			CHECK(ranges[i].FirstIndex > ranges[i - 1].FirstIndex + ranges[i - 1].IndexCount);
+	}
+	uint32_t visibleIndices = 0;
+	for (auto& meshlet : meshlets.Meshlets)
+		visibleIndices += 3 * meshlet.TriangleCount;
+	CHECK(indexCount < visibleIndices);
+}
+
+DXPG_TEST(Meshlet, CullingIsConservativeUnderAnyScale)
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	Sphere(32, 48, vertices, indices);
+	MeshletData meshlets;
+	BuildMeshlets(indices, vertices, meshlets);
+
+	Matrix4x4 rotation = XMMatrixRotationRollPitchYaw(0.3f, 1.1f, -0.4f);
+	Matrix4x4 translation = XMMatrixTranslation(1.0f, -2.0f, 3.0f);
+	struct Case
+	{
+		Matrix4x4 World;
+		bool ConesTested;
+	};
+	Case cases[] = {
+		{ XMMatrixIdentity(), true },
+		{ XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(2.5f, 2.5f, 2.5f), rotation), translation), true },
+		{ XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(6.0f, 0.3f, 1.0f), rotation), translation), false },
+		{ XMMatrixMultiply(XMMatrixScaling(0.2f, 1.0f, 5.0f), rotation), false },
+		{ XMMatrixMultiply(XMMatrixScaling(-2.0f, 2.0f, 2.0f), translation), false },
+	};
+
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+	for (auto& test : cases)
+	{
+		uint32_t culledTotal = 0;
+		for (uint32_t i = 0; i < 24; ++i)
+		{
+			Vector4 eye = XMVectorScale(XMVector3Normalize(XMVectorSet(direction(random), direction(random), direction(random), 0.0f)), 4.0f + 8.0f * float(i % 3));
+			eye = XMVectorSetW(XMVectorAdd(eye, test.World.r[3]), 1.0f);
+			Matrix4x4 view = XMMatrixLookAtLH(eye, XMVectorSetW(test.World.r[3], 1.0f), XMVectorSet(0, 1, 0, 0));
+			Frustum frustum = Frustum::FromViewProjection(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.0f, 0.1f, 100.0f)));
+			uint32_t culled = 0;
+			CHECK(!DropsVisibleTriangles(meshlets, vertices, indices, test.World, frustum, eye, culled));
+			culledTotal += culled;
+		}
+		// The whole mesh is in view, only the cones can reject meshlets
+		CHECK((culledTotal > 0) == test.ConesTested);
+	}
+}
+
+DXPG_TEST(Meshlet, SplitsDrawsOnlyWhenEnoughIsCulled)
+{
+	ClusterDrawSettings settings{ .MinCulledFraction = 0.5f, .MaxDraws = 2 };
+	std::vector<IndexRange> ranges = { { .FirstIndex = 0, .IndexCount = 60 } };
+	CHECK(!SplitClusterDraws(ranges, 100, settings));
+	ranges[0].IndexCount = 50;
+	CHECK(SplitClusterDraws(ranges, 100, settings));
+	ranges[0].IndexCount = 30;
+	ranges.push_back({ .FirstIndex = 60, .IndexCount = 20 });
+	CHECK(SplitClusterDraws(ranges, 100, settings));
+	ranges.push_back({ .FirstIndex = 90, .IndexCount = 3 });
+	// Culled enough but one draw too many
+	CHECK(!SplitClusterDraws(ranges, 300, settings));
+	// Nothing visible draws nothing
+	CHECK(SplitClusterDraws({}, 100, settings));
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "TestFramework.h"
+
+#include "ObjParser.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace dxpg;
+
+DXPG_BENCHMARK(ObjParser)
+{
+	// Grid patches like a scanned or subdivided model, vertices with normals and UVs and quad faces
+	size_t const targetBytes = context.Size(size_t(256) << 20, size_t(4) << 20);
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+	std::string text;
+	text.reserve(targetBytes + 4096);
+	constexpr uint32_t Grid = 32;
+	uint32_t positions = 0;
+	for (uint32_t object = 0; text.size() < targetBytes; ++object)
+	{
+		text += "o patch" + std::to_string(object) + "\n";
+		for (uint32_t i = 0; i < Grid * Grid; ++i)
+		{
+			text += "v " + std::to_string(coordinate(random)) + " " + std::to_string(coordinate(random)) + " " + std::to_string(coordinate(random)) + "\n";
+			text += "vn 0 0 1\nvt " + std::to_string(float(i % Grid) / Grid) + " " + std::to_string(float(i / Grid) / Grid) + "\n";
+		}
+		for (uint32_t y = 0; y + 1 < Grid; ++y)
+		{
+			for (uint32_t x = 0; x + 1 < Grid; ++x)
+			{
+				uint32_t a = positions + y * Grid + x + 1;
+				std::string corners[4] = { std::to_string(a), std::to_string(a + 1), std::to_string(a + Grid + 1), std::to_string(a + Grid) };
+				text += "f";
+				for (auto& corner : corners)
+					text += " " + corner + "/" + corner + "/" + corner;
+				text += "\n";
+			}
+		}
+		positions += Grid * Grid;
+	}
+
+	size_t const hardwareThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	double serialTime = 0.0;
+	for (size_t threads = 1;; threads = std::min(threads * 2, hardwareThreads))
+	{
+		ObjParseResult result;
+		double milliseconds = test::TimeMilliseconds([&]()
+		{
+			CHECK(ParseObj({ text.data(), text.size() }, {}, result, { .MinChunkBytes = size_t(1) << 20, .ThreadCount = threads }));
+		});
+		serialTime = threads == 1 ? milliseconds : serialTime;
+		std::cout << text.size() / (1 << 20) << " MiB, " << threads << " threads: " << milliseconds << " ms, " << double(text.size()) / (1 << 20) / (milliseconds / 1000.0)
+			<< " MiB/s, " << serialTime / milliseconds << "x, " << result.Shapes.size() << " shapes" << std::endl;
+		if (threads == hardwareThreads)
+			break;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "TestFramework.h"
+
+#include "ObjParser.h"
+
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+
+using namespace dxpg;
+
+namespace
+{
+
+std::span<char const> Text(std::string const& text)
+{
+	return { text.data(), text.size() };
+}
+
+bool SameIndex(tinyobj::index_t const& a, tinyobj::index_t const& b)
+{
+	return a.vertex_index == b.vertex_index && a.normal_index == b.normal_index && a.texcoord_index == b.texcoord_index;
+}
+
+// Bit exact, the chunked parse has to reproduce the serial one including the floats
+bool SameResult(ObjParseResult const& a, ObjParseResult const& b)
+{
+	auto sameFloats = [](std::vector<float> const& x, std::vector<float> const& y)
+	{
+		return x.size() == y.size() && (x.empty() || std::memcmp(x.data(), y.data(), x.size() * sizeof(float)) == 0);
+	};
+	if (!sameFloats(a.Attrib.vertices, b.Attrib.vertices) || !sameFloats(a.Attrib.colors, b.Attrib.colors)
+		|| !sameFloats(a.Attrib.normals, b.Attrib.normals) || !sameFloats(a.Attrib.texcoords, b.Attrib.texcoords))
+		return false;
+	if (a.Shapes.size() != b.Shapes.size() || a.Materials.size() != b.Materials.size() || a.Warning != b.Warning || a.Error != b.Error)
+		return false;
+	for (size_t i = 0; i < a.Shapes.size(); ++i)
+	{
+		auto& meshA = a.Shapes[i].mesh;
+		auto& meshB = b.Shapes[i].mesh;
+		if (a.Shapes[i].name != b.Shapes[i].name || meshA.num_face_vertices != meshB.num_face_vertices
+			|| meshA.material_ids != meshB.material_ids || meshA.smoothing_group_ids != meshB.smoothing_group_ids)
+			return false;
+		if (!std::equal(meshA.indices.begin(), meshA.indices.end(), meshB.indices.begin(), meshB.indices.end(), SameIndex))
+			return false;
+	}
+	for (size_t i = 0; i < a.Materials.size(); ++i)
+		if (a.Materials[i].name != b.Materials[i].name || a.Materials[i].diffuse_texname != b.Materials[i].diffuse_texname || std::memcmp(a.Materials[i].diffuse, b.Materials[i].diffuse, sizeof(float) * 3) != 0)
+			return false;
+	return true;
+}
+
+// Every statement the parser knows, in an order where chunk boundaries land inside objects, groups and material runs
+std::string SyntheticObj(uint32_t objectCount, uint32_t seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+	std::string text = "# generated\nmtllib test.mtl\n";
+	uint32_t positions = 0;
+	for (uint32_t object = 0; object < objectCount; ++object)
+	{
+		text += (object % 3 == 0 ? "g group" : "o object") + std::to_string(object) + "\n";
+		if (object % 4 == 1)
+			text += "usemtl " + std::string(object % 8 == 1 ? "red" : "blue") + "\n";
+		if (object % 5 == 2)
+			text += object % 2 ? "s 1\n" : "s off\n";
+		uint32_t grid = 3 + random() % 5;
+		uint32_t first = positions;
+		for (uint32_t i = 0; i < grid * grid; ++i)
+		{
+			text += "v " + std::to_string(coordinate(random)) + " " + std::to_string(coordinate(random)) + " " + std::to_string(coordinate(random));
+			text += i % 7 == 0 ? " 0.5 0.25 1\n" : "\n";
+			text += "vn 0 " + std::to_string(coordinate(random) / 100.0f) + " 1e-1\n";
+			text += "vt " + std::to_string(float(i) / float(grid * grid)) + " .5\n";
+		}
+		positions += grid * grid;
+		for (uint32_t y = 0; y + 1 < grid; ++y)
+		{
+			for (uint32_t x = 0; x + 1 < grid; ++x)
+			{
+				uint32_t a = first + y * grid + x + 1;
+				uint32_t b = a + grid;
+				if ((x + y) % 3 == 0)
+				{
+					// Negative indices are relative to the vertices read so far
+					auto relative = [&](uint32_t index) { return std::to_string(int(index) - int(positions) - 1); };
+					text += "f " + relative(a) + "/" + relative(a) + "/" + relative(a) + " " + relative(a + 1) + "/" + relative(a + 1) + "/" + relative(a + 1) + " " + relative(b) + "/" + relative(b) + "/" + relative(b) + "\n";
+				}
+				else if ((x + y) % 3 == 1)
+					text += "f " + std::to_string(a) + "//" + std::to_string(a) + " " + std::to_string(a + 1) + "//" + std::to_string(a + 1) + " " + std::to_string(b + 1) + "//" + std::to_string(b + 1) + " " + std::to_string(b) + "//" + std::to_string(b) + "\r\n";
+				else
+					text += "f\t" + std::to_string(a) + "/" + std::to_string(a) + "  " + std::to_string(a + 1) + "/" + std::to_string(a + 1) + " " + std::to_string(b + 1) + " " + std::to_string(b) + "/" + std::to_string(b) + "\n";
+			}
+		}
+		if (object % 6 == 5)
+		{
+			// Pentagon, ear clipped
+			text += "f " + std::to_string(first + 1) + " " + std::to_string(first + 2) + " " + std::to_string(first + 3) + " " + std::to_string(first + grid + 3) + " " + std::to_string(first + grid + 1) + "\n";
+		}
+	}
+	return text;
+}
+
+// Scratch folder for material libraries, removed again when the test ends
+struct MaterialFolder
+{
+	std::filesystem::path Folder;
+
+	explicit MaterialFolder(char const* name)
+	{
+		Folder = std::filesystem::temp_directory_path() / name;
+		std::filesystem::create_directories(Folder);
+		std::ofstream(Folder / "test.mtl") << "newmtl red\nKd 1 0 0\nmap_Kd red.png\n\nnewmtl blue\nKd 0 0 1\n";
+	}
+	~MaterialFolder()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(Folder, error);
+	}
+};
+
+}
+
+DXPG_TEST(ObjParser, ParsesStatements)
+{
+	MaterialFolder folder("dxpg_objparser_statements");
+	std::string text =
+		"mtllib test.mtl\n"
+		"v 0 0 0\nv 1 0 0 0.5 0.5 0.5\nv 1 1 0\nv 0 1 0\n"
+		"vn 0 0 1\nvt 0 0\nvt 1 1\n"
+		"o first\n"
+		"usemtl blue\n"
+		"f 1/1/1 2/2/1 3/2/1\n"
+		"usemtl red\n"
+		"s 2\n"
+		"f 1 3 4\n"
+		"g second\n"
+		"f -4 -3 -2 -1\n";
+	ObjParseResult result;
+	CHECK(ParseObj(Text(text), folder.Folder, result, { .MinChunkBytes = 1 << 20, .ThreadCount = 1 }));
+	CHECK(result.Error.empty() && result.Warning.empty());
+
+	CHECK(result.Attrib.vertices.size() == 12 && result.Attrib.vertices[3] == 1.0f);
+	// Vertex colors default to white
+	CHECK(result.Attrib.colors.size() == 12 && result.Attrib.colors[0] == 1.0f && result.Attrib.colors[3] == 0.5f);
+	CHECK(result.Attrib.normals.size() == 3 && result.Attrib.texcoords.size() == 4);
+
+	CHECK(result.Materials.size() == 2);
+	CHECK(result.Materials[0].name == "red" && result.Materials[0].diffuse[0] == 1.0f && result.Materials[0].diffuse_texname == "red.png");
+	CHECK(result.Materials[1].name == "blue" && result.Materials[1].diffuse[2] == 1.0f);
+
+	CHECK(result.Shapes.size() == 2);
+	auto& first = result.Shapes[0].mesh;
+	CHECK(result.Shapes[0].name == "first");
+	CHECK(first.num_face_vertices.size() == 2 && first.material_ids[0] == 1 && first.material_ids[1] == 0);
+	CHECK(first.smoothing_group_ids[0] == 0 && first.smoothing_group_ids[1] == 2);
+	CHECK(SameIndex(first.indices[1], { 1, 0, 1 }) && SameIndex(first.indices[3], { 0, -1, -1 }));
+
+	// The quad is split into two triangles
+	auto& second = result.Shapes[1].mesh;
+	CHECK(result.Shapes[1].name == "second");
+	CHECK(second.num_face_vertices.size() == 2 && second.indices.size() == 6);
+	CHECK(second.num_face_vertices[0] == 3 && second.material_ids[0] == 0);
+}
+
+DXPG_TEST(ObjParser, RejectsZeroIndices)
+{
+	std::string text = "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 0 1 2\n";
+	ObjParseResult result;
+	CHECK(!ParseObj(Text(text), {}, result));
+	CHECK(!result.Error.empty());
+}
+
+DXPG_TEST(ObjParser, ParsesTheCubeAsset)
+{
+	ObjParseResult result;
+	CHECK(ParseObj(std::filesystem::path(DXPG_TEST_ASSETS_DIR) / "cube.obj", result));
+	CHECK(result.Attrib.vertices.size() == 8 * 3 && result.Attrib.normals.size() == 6 * 3 && result.Attrib.texcoords.size() == 14 * 2);
+	CHECK(result.Shapes.size() == 1 && result.Shapes[0].name == "Cube");
+	CHECK(result.Shapes[0].mesh.indices.size() == 12 * 3);
+}
+
+DXPG_TEST(ObjParser, ChunkedParseMatchesSerial)
+{
+	MaterialFolder folder("dxpg_objparser_chunks");
+	std::string text = SyntheticObj(120, 7);
+	ObjParseResult serial;
+	CHECK(ParseObj(Text(text), folder.Folder, serial, { .MinChunkBytes = text.size() + 1, .ThreadCount = 1 }));
+	CHECK(serial.Chunks == 1);
+	CHECK(serial.Materials.size() == 2 && serial.Shapes.size() == 120);
+
+	// Chunk sizes down to a few lines, so boundaries fall between every kind of statement
+	for (size_t chunkBytes : { size_t(97), size_t(1000), size_t(4096), size_t(65536) })
+	{
+		for (size_t threads : { size_t(1), size_t(3), size_t(8) })
+		{
+			ObjParseResult parallel;
+			CHECK(ParseObj(Text(text), folder.Folder, parallel, { .MinChunkBytes = chunkBytes, .ThreadCount = threads }));
+			CHECK(parallel.Chunks > 1);
+			CHECK(SameResult(serial, parallel));
+		}
+	}
+}
\ No newline at end of file
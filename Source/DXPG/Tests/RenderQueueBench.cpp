@@ -0,0 +1,48 @@
+#include "TestFramework.h"
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+uint64_t KeyMaterialMajor(uint32_t pipeline, uint32_t material, uint32_t vertexBuffer, uint32_t indexBuffer, float depth)
+{
+	uint64_t key = 0;
+	CHECK(SortKey::MaterialMajor(pipeline, material, vertexBuffer, indexBuffer, depth, key));
+	return key;
+}
+}
+
+DXPG_BENCHMARK(RenderQueueSort)
+{
+	std::vector<size_t> counts = context.Quick ? std::vector<size_t>{ 100000 } : std::vector<size_t>{ 100000, 1000000 };
+	for (size_t count : counts)
+	{
+		std::mt19937_64 random(count);
+		std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+		std::vector<DrawPacket> packets(count);
+		for (uint32_t i = 0; i < count; ++i)
+			packets[i] = { KeyMaterialMajor(uint32_t(random() % 2), uint32_t(random() % 500), uint32_t(random() % 8), uint32_t(random() % 4000), depth(random)), i };
+
+		std::vector<DrawPacket> sorted = packets;
+		std::vector<DrawPacket> scratch;
+		scratch.reserve(count);
+		double radix = test::TimeMilliseconds([&]() { RadixSort(sorted, scratch); });
+
+		std::vector<DrawPacket> reference = packets;
+		double comparison = test::TimeMilliseconds([&]()
+		{
+			std::stable_sort(reference.begin(), reference.end(), [](DrawPacket const& a, DrawPacket const& b) { return a.Key < b.Key; });
+		});
+		CHECK(std::equal(sorted.begin(), sorted.end(), reference.begin(), [](DrawPacket const& a, DrawPacket const& b) { return a.RenderableIndex == b.RenderableIndex; }));
+
+		std::vector<InstanceBatch> batches;
+		double batching = test::TimeMilliseconds([&]() { BuildInstanceBatches(sorted, SortKey::InstanceGroupMask, batches); });
+		std::cout << count << " packets: radix sort " << radix << " ms, std::stable_sort " << comparison << " ms, " << batches.size() << " batches built in " << batching << " ms" << std::endl;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "TestFramework.h"
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+uint64_t KeyMaterialMajor(uint32_t pipeline, uint32_t material, uint32_t vertexBuffer, uint32_t indexBuffer, float depth)
+{
+	uint64_t key = 0;
+	CHECK(SortKey::MaterialMajor(pipeline, material, vertexBuffer, indexBuffer, depth, key));
+	return key;
+}
+
+uint64_t KeyGeometryMajor(uint32_t pipeline, uint32_t vertexBuffer, uint32_t indexBuffer, float depth)
+{
+	uint64_t key = 0;
+	CHECK(SortKey::GeometryMajor(pipeline, vertexBuffer, indexBuffer, depth, key));
+	return key;
+}
+}
+
+DXPG_TEST(RenderQueue, QuantizedDepthIsMonotonic)
+{
+	CHECK(SortKey::QuantizeDepth(-5.0f) == SortKey::QuantizeDepth(0.0f));
+	CHECK(SortKey::QuantizeDepth(0.0f) == 0);
+	CHECK(SortKey::QuantizeDepth(1e30f) < (1u << SortKey::DepthBits));
+	float previous = 0.0f;
+	for (float depth = 0.001f; depth < 1e6f; depth *= 1.37f)
+	{
+		CHECK(SortKey::QuantizeDepth(previous) <= SortKey::QuantizeDepth(depth));
+		previous = depth;
+	}
+	// Relative precision, nearby depths still sort apart
+	CHECK(SortKey::QuantizeDepth(10.0f) < SortKey::QuantizeDepth(10.1f));
+	CHECK(SortKey::QuantizeDepth(1000.0f) < SortKey::QuantizeDepth(1010.0f));
+}
+
+DXPG_TEST(RenderQueue, KeyFieldsSortMostSignificantFirst)
+{
+	uint64_t base = KeyMaterialMajor(1, 5, 3, 7, 10.0f);
+	// Any change in a higher field outweighs every lower field
+	CHECK(KeyMaterialMajor(2, 0, 0, 0, 0.0f) > KeyMaterialMajor(1, (1u << SortKey::MaterialBits) - 1, 1023, 65535, 1e30f));
+	CHECK(KeyMaterialMajor(1, 6, 0, 0, 0.0f) > base);
+	CHECK(KeyMaterialMajor(1, 5, 4, 0, 0.0f) > base);
+	CHECK(KeyMaterialMajor(1, 5, 3, 8, 0.0f) > base);
+	CHECK(KeyMaterialMajor(1, 5, 3, 7, 20.0f) > base);
+	// Depth is the only field below the instance group mask
+	CHECK(((base ^ KeyMaterialMajor(1, 5, 3, 7, 500.0f)) & SortKey::InstanceGroupMask) == 0);
+	CHECK(((base ^ KeyMaterialMajor(1, 5, 3, 8, 10.0f)) & SortKey::InstanceGroupMask) != 0);
+
+	// The depth only key skips the material but keeps depth below the instance group mask
+	CHECK(((KeyGeometryMajor(1, 3, 7, 10.0f) ^ KeyGeometryMajor(1, 3, 7, 90.0f)) & SortKey::InstanceGroupMask) == 0);
+	CHECK(KeyGeometryMajor(1, 4, 0, 0.0f) > KeyGeometryMajor(1, 3, 65535, 1e30f));
+}
+
+DXPG_TEST(RenderQueue, RadixSortMatchesStableSort)
+{
+	std::mt19937_64 random(11);
+	for (size_t count : { size_t(0), size_t(1), size_t(2), size_t(17), size_t(1000), size_t(100000) })
+	{
+		std::vector<DrawPacket> packets(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			// Few distinct high fields and many duplicate keys, like a real frame
+			uint64_t key = KeyMaterialMajor(uint32_t(random() % 2), uint32_t(random() % 40), uint32_t(random() % 3), uint32_t(random() % 200), float(random() % 8));
+			packets[i] = { key, i };
+		}
+		std::vector<DrawPacket> expected = packets;
+		std::stable_sort(expected.begin(), expected.end(), [](DrawPacket const& a, DrawPacket const& b) { return a.Key < b.Key; });
+		std::vector<DrawPacket> scratch;
+		RadixSort(packets, scratch);
+		CHECK(packets.size() == expected.size());
+		CHECK(std::equal(packets.begin(), packets.end(), expected.begin(), [](DrawPacket const& a, DrawPacket const& b) { return a.Key == b.Key && a.RenderableIndex == b.RenderableIndex; }));
+	}
+}
+
+DXPG_TEST(RenderQueue, RadixSortHandlesSharedDigits)
+{
+	// Every pass but one skipped, and all passes skipped
+	std::vector<DrawPacket> packets = { { 0x0100, 0 }, { 0x0000, 1 }, { 0x0100, 2 }, { 0x0000, 3 } };
+	std::vector<DrawPacket> scratch;
+	RadixSort(packets, scratch);
+	CHECK(packets[0].RenderableIndex == 1 && packets[1].RenderableIndex == 3 && packets[2].RenderableIndex == 0 && packets[3].RenderableIndex == 2);
+	std::vector<DrawPacket> same = { { 42, 0 }, { 42, 1 }, { 42, 2 } };
+	RadixSort(same, scratch);
+	CHECK(same[0].RenderableIndex == 0 && same[1].RenderableIndex == 1 && same[2].RenderableIndex == 2);
+}
+
+DXPG_TEST(RenderQueue, InstanceBatchesMergeEqualGeometry)
+{
+	RenderQueue queue;
+	queue.Push(KeyMaterialMajor(0, 1, 0, 2, 30.0f), 0);
+	queue.Push(KeyMaterialMajor(0, 1, 0, 2, 10.0f), 1);
+	queue.Push(KeyMaterialMajor(0, 2, 0, 2, 10.0f), 2);
+	queue.Push(KeyMaterialMajor(0, 1, 0, 3, 10.0f), 3);
+	queue.Push(KeyMaterialMajor(0, 1, 0, 2, 20.0f), 4);
+	queue.Sort();
+
+	auto packets = queue.GetPackets();
+	auto batches = queue.GetBatches();
+	CHECK(batches.size() == 3);
+	// Material 1, index buffer 2, front to back
+	CHECK(batches[0].FirstPacket == 0 && batches[0].InstanceCount == 3);
+	CHECK(packets[0].RenderableIndex == 1 && packets[1].RenderableIndex == 4 && packets[2].RenderableIndex == 0);
+	CHECK(batches[1].FirstPacket == 3 && batches[1].InstanceCount == 1 && packets[3].RenderableIndex == 3);
+	CHECK(batches[2].FirstPacket == 4 && batches[2].InstanceCount == 1 && packets[4].RenderableIndex == 2);
+
+	queue.Clear();
+	queue.Sort();
+	CHECK(queue.GetPackets().empty() && queue.GetBatches().empty());
+}
+
+DXPG_TEST(RenderQueue, KeyFieldsRejectOutOfRangeIds)
+{
+	uint64_t key;
+	CHECK(SortKey::MaterialMajor((1u << SortKey::PipelineBits) - 1, (1u << SortKey::MaterialBits) - 1, (1u << SortKey::VertexBufferBits) - 1, (1u << SortKey::IndexBufferBits) - 1, 1.0f, key));
+	CHECK(!SortKey::MaterialMajor(1u << SortKey::PipelineBits, 0, 0, 0, 1.0f, key));
+	CHECK(!SortKey::MaterialMajor(0, 1u << SortKey::MaterialBits, 0, 0, 1.0f, key));
+	CHECK(!SortKey::MaterialMajor(0, 0, 1u << SortKey::VertexBufferBits, 0, 1.0f, key));
+	CHECK(!SortKey::MaterialMajor(0, 0, 0, 1u << SortKey::IndexBufferBits, 1.0f, key));
+	CHECK(SortKey::GeometryMajor(0, (1u << SortKey::VertexBufferBits) - 1, (1u << SortKey::IndexBufferBits) - 1, 1.0f, key));
+	CHECK(!SortKey::GeometryMajor(0, 1u << SortKey::VertexBufferBits, 0, 1.0f, key));
+	CHECK(!SortKey::GeometryMajor(0, 0, 1u << SortKey::IndexBufferBits, 1.0f, key));
+}
+
+DXPG_TEST(RenderQueue, DenseIdsRunOut)
+{
+	DenseKeyIds ids(2);
+	uint32_t ordinal;
+	CHECK(ids.Map(1ull << 40, ordinal) && ordinal == 0);
+	CHECK(ids.Map(7, ordinal) && ordinal == 1);
+	CHECK(ids.Map(1ull << 40, ordinal) && ordinal == 0);
+	CHECK(ids.Map(100000, ordinal) && ordinal == 2);
+	CHECK(ids.Map(3, ordinal) && ordinal == 3);
+	CHECK(!ids.Map(4, ordinal));
+	CHECK(ids.Map(7, ordinal) && ordinal == 1);
+	ids.Clear();
+	CHECK(ids.Map(4, ordinal) && ordinal == 0);
+}
+
+DXPG_TEST(RenderQueue, IdsPastTheKeyFieldNeverAlias)
+{
+	// Ids far past the field widths still batch while few are drawn in a frame
+	RenderQueue queue;
+	uint64_t const farMaterial = 1u << 20;
+	queue.PushMaterialMajor(0, farMaterial, 5000, 1ull << 33, 1.0f, 0);
+	queue.PushMaterialMajor(0, farMaterial, 5000, 1ull << 33, 2.0f, 1);
+	queue.PushMaterialMajor(0, farMaterial + (1u << SortKey::MaterialBits), 5000, 1ull << 33, 1.5f, 2);
+	queue.PushMaterialMajor(0, farMaterial, 5000 + (1u << SortKey::VertexBufferBits), 1ull << 33, 1.5f, 3);
+	queue.PushMaterialMajor(0, farMaterial, 5000, (1ull << 33) + (1u << SortKey::IndexBufferBits), 1.5f, 4);
+	queue.Sort();
+	CHECK(queue.Stats.Unbatched == 0);
+	auto batches = queue.GetBatches();
+	CHECK(batches.size() == 4);
+	uint32_t instanced = 0;
+	for (auto& batch : batches)
+		instanced = batch.InstanceCount == 2 ? batch.FirstPacket : instanced;
+	CHECK(queue.GetPackets()[instanced].RenderableIndex == 0 && queue.GetPackets()[instanced + 1].RenderableIndex == 1);
+
+	// Once a frame draws more distinct ids than the field holds the rest draw on their own
+	queue.Clear();
+	uint32_t const count = (1u << SortKey::VertexBufferBits) + 3;
+	for (uint32_t i = 0; i < count; ++i)
+		queue.PushGeometryMajor(0, i, 0, 1.0f, i);
+	queue.PushGeometryMajor(0, count - 1, 0, 1.0f, count);
+	queue.Sort();
+	CHECK(queue.Stats.Unbatched == 4);
+	CHECK(queue.GetPackets().size() == count + 1);
+	CHECK(queue.GetBatches().size() == count + 1);
+	for (auto& batch : queue.GetBatches())
+		CHECK(batch.InstanceCount == 1);
+	CHECK(queue.GetPackets().back().RenderableIndex == count);
+}
+
+DXPG_TEST(RenderQueue, LodIndexBuffersPastSixteenBitsStaySeparate)
+{
+	// Index buffer id * level count packed into 16 bits used to wrap around after 13107 meshes
+	constexpr uint64_t LevelCount = 5;
+	uint64_t const first = 2 * LevelCount + 1;
+	uint64_t const wrapped = first + (1u << SortKey::IndexBufferBits) * LevelCount;
+	RenderQueue queue;
+	queue.PushGeometryMajor(0, 0, first, 1.0f, 0);
+	queue.PushGeometryMajor(0, 0, wrapped, 1.0f, 1);
+	queue.PushGeometryMajor(0, 0, wrapped, 2.0f, 2);
+	queue.Sort();
+	CHECK(queue.Stats.Unbatched == 0);
+	CHECK(queue.GetBatches().size() == 2);
+	CHECK(queue.GetBatches()[0].InstanceCount == 1 && queue.GetPackets()[0].RenderableIndex == 0);
+	CHECK(queue.GetBatches()[1].InstanceCount == 2);
+}
\ No newline at end of file
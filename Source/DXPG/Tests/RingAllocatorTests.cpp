@@ -0,0 +1,160 @@
+#include "TestFramework.h"
+
+#include "RingAllocator.h"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Stands in for the GPU, submits complete a fixed number of frames after they were made
+struct FakeFence
+{
+	uint64_t Submitted = 0;
+	uint64_t Completed = 0;
+
+	uint64_t Submit() { return ++Submitted; }
+	void CompleteUpTo(uint64_t value) { Completed = std::max(Completed, std::min(value, Submitted)); }
+};
+
+struct LiveRange
+{
+	uint32_t Page;
+	uint64_t Offset;
+	uint64_t Size;
+	uint64_t Fence;
+};
+
+bool Overlaps(LiveRange const& a, RingAllocation const& b, uint64_t size)
+{
+	return a.Page == b.Page && a.Offset < b.Offset + size && b.Offset < a.Offset + a.Size;
+}
+
+}
+
+DXPG_TEST(RingAllocator, AlignsAndSkipsThePageEnd)
+{
+	RingAllocator ring;
+	ring.Init(1024, 1);
+	RingAllocation allocation;
+	CHECK(ring.Allocate(10, 1, allocation) && allocation.Offset == 0);
+	CHECK(ring.Allocate(16, 256, allocation) && allocation.Offset == 256);
+	CHECK(ring.Allocate(500, 4, allocation) && allocation.Offset == 272);
+	CHECK(ring.GetUsedBytes() == 772);
+	// Does not fit before the end and the start is still in flight
+	CHECK(!ring.Allocate(300, 4, allocation));
+	CHECK(ring.GetUsedBytes() == 772);
+
+	FakeFence fence;
+	ring.Close(fence.Submit());
+	fence.CompleteUpTo(1);
+	ring.Reclaim(fence.Completed);
+	CHECK(ring.GetUsedBytes() == 0);
+	// An idle page starts over instead of skipping its end
+	CHECK(ring.Allocate(300, 4, allocation) && allocation.Offset == 0);
+	CHECK(ring.Allocate(600, 4, allocation) && allocation.Offset == 300);
+	CHECK(!ring.Allocate(200, 4, allocation));
+}
+
+DXPG_TEST(RingAllocator, ReclaimsOnlyCompletedBatches)
+{
+	RingAllocator ring;
+	ring.Init(1024, 1);
+	FakeFence fence;
+	RingAllocation allocation;
+	CHECK(ring.Allocate(400, 16, allocation));
+	uint64_t first = fence.Submit();
+	ring.Close(first);
+	CHECK(ring.Allocate(400, 16, allocation) && allocation.Offset == 400);
+	uint64_t second = fence.Submit();
+	ring.Close(second);
+	CHECK(!ring.Allocate(400, 16, allocation));
+
+	// Nothing completed yet
+	ring.Reclaim(fence.Completed);
+	CHECK(!ring.Allocate(400, 16, allocation));
+	// The first batch frees the start, the tail end of the page is skipped
+	fence.CompleteUpTo(first);
+	ring.Reclaim(fence.Completed);
+	CHECK(ring.GetUsedBytes() == 400);
+	CHECK(ring.Allocate(400, 16, allocation) && allocation.Offset == 0);
+	// The skipped end of the page counts as used until the batch wrapping past it completes
+	CHECK(ring.GetUsedBytes() == 1024);
+	// Closing without new ranges adds no empty batch
+	ring.Close(fence.Submit());
+	ring.Close(fence.Submit());
+	fence.CompleteUpTo(fence.Submitted);
+	ring.Reclaim(fence.Completed);
+	CHECK(ring.GetUsedBytes() == 0);
+}
+
+DXPG_TEST(RingAllocator, GrowsPagesUpToTheLimit)
+{
+	RingAllocator ring;
+	ring.Init(256, 3);
+	RingAllocation allocation;
+	CHECK(ring.GetPageCount() == 0);
+	CHECK(!ring.Allocate(0, 1, allocation));
+	CHECK(!ring.Allocate(257, 1, allocation));
+	for (uint32_t page = 0; page < 3; ++page)
+	{
+		CHECK(ring.Allocate(256, 256, allocation));
+		CHECK(allocation.Page == page && allocation.Offset == 0);
+	}
+	CHECK(ring.GetPageCount() == 3);
+	// Oversized for what is left, the caller falls back to a buffer of its own
+	CHECK(!ring.Allocate(1, 1, allocation));
+
+	FakeFence fence;
+	ring.Close(fence.Submit());
+	fence.CompleteUpTo(1);
+	ring.Reclaim(fence.Completed);
+	CHECK(ring.Allocate(64, 64, allocation) && allocation.Page == 2);
+	CHECK(ring.GetPageCount() == 3);
+}
+
+DXPG_TEST(RingAllocator, LiveRangesNeverOverlap)
+{
+	// Frames of random uploads, the fake GPU finishes each frame two frames after it was submitted
+	RingAllocator ring;
+	ring.Init(64 * 1024, 4);
+	FakeFence fence;
+	std::mt19937 random(23);
+	std::deque<LiveRange> live;
+	uint64_t allocations = 0;
+	for (uint32_t frame = 0; frame < 2000; ++frame)
+	{
+		uint64_t fenceValue = fence.Submitted + 1;
+		uint32_t count = random() % 24;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			uint64_t size = random() % 8 == 0 ? 16 * 1024 + random() % (32 * 1024) : 1 + random() % 2048;
+			uint64_t alignment = uint64_t(1) << (random() % 10);
+			RingAllocation allocation;
+			if (!ring.Allocate(size, alignment, allocation))
+				continue;
+			allocations++;
+			CHECK(allocation.Offset % alignment == 0);
+			CHECK(allocation.Offset + size <= ring.GetPageSize());
+			for (auto& range : live)
+				CHECK(!Overlaps(range, allocation, size));
+			live.push_back({ allocation.Page, allocation.Offset, size, fenceValue });
+		}
+		ring.Close(fence.Submit());
+		if (fence.Submitted > 2)
+			fence.CompleteUpTo(fence.Submitted - 2);
+		ring.Reclaim(fence.Completed);
+		while (!live.empty() && live.front().Fence <= fence.Completed)
+			live.pop_front();
+	}
+	CHECK(allocations > 10000);
+	CHECK(ring.GetPageCount() <= 4);
+
+	fence.CompleteUpTo(fence.Submitted);
+	ring.Reclaim(fence.Completed);
+	CHECK(ring.GetUsedBytes() == 0);
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "TestFramework.h"
+
+#include "Culling.h"
+
+using namespace dxpg;
+
+namespace
+{
+
+// Light above the origin looking straight down, its volume is 20 units wide and reaches from y = 50 down to y = -50
+Matrix4x4 LightViewProjection()
+{
+	Matrix4x4 view = XMMatrixLookToLH(XMVectorSet(0, 50, 0, 1), XMVectorSet(0, -1, 0, 0), XMVectorSet(0, 0, 1, 0));
+	return XMMatrixMultiply(view, XMMatrixOrthographicLH(20.0f, 20.0f, 0.0f, 100.0f));
+}
+
+DirectX::BoundingBox Box(float x, float y, float z, float extent)
+{
+	return DirectX::BoundingBox(Vector3(x, y, z), Vector3(extent, extent, extent));
+}
+
+std::vector<uint32_t> Casters(std::vector<DirectX::BoundingBox> const& boxes, CullingStats* outStats = nullptr)
+{
+	BoundsSoA bounds;
+	bounds.Resize(boxes.size());
+	for (size_t i = 0; i < boxes.size(); ++i)
+		bounds.Set(i, boxes[i]);
+	std::vector<uint32_t> casters;
+	CullingStats stats = CullShadowCasters(LightViewProjection(), bounds, casters);
+	if (outStats)
+		*outStats = stats;
+	return casters;
+}
+
+}
+
+DXPG_TEST(ShadowCulling, CastersInsideTheLightVolume)
+{
+	CullingStats stats;
+	auto casters = Casters({ Box(0, 0, 0, 1), Box(9, -40, -9, 0.5f), Box(-10.5f, 10, 0, 1) }, &stats);
+	CHECK((casters == std::vector<uint32_t>{ 0, 1, 2 }));
+	CHECK(stats.Visible == 3 && stats.Culled == 0);
+}
+
+DXPG_TEST(ShadowCulling, OccludersTowardsTheLightStillCast)
+{
+	// Above the light's near plane but inside its footprint, e.g. a tall tower outside the fitted volume
+	auto casters = Casters({ Box(0, 80, 0, 1), Box(5, 500, 5, 2) });
+	CHECK((casters == std::vector<uint32_t>{ 0, 1 }));
+}
+
+DXPG_TEST(ShadowCulling, BoxesBesideOrBeyondTheVolumeAreCulled)
+{
+	CullingStats stats;
+	auto casters = Casters({ Box(30, 0, 0, 1), Box(0, 0, -30, 1), Box(0, -60, 0, 1), Box(0, 80, 30, 1), Box(0, 0, 0, 1) }, &stats);
+	CHECK((casters == std::vector<uint32_t>{ 4 }));
+	CHECK(stats.Visible == 1 && stats.Culled == 4);
+}
+
+DXPG_TEST(ShadowCulling, CameraCullingKeepsTheNearPlane)
+{
+	// The same box is dropped by a regular frustum test, only the caster test extends the volume
+	BoundsSoA bounds;
+	bounds.Resize(1);
+	bounds.Set(0, Box(0, 80, 0, 1));
+	std::vector<uint32_t> visible;
+	CullBoxes(Frustum::FromViewProjection(LightViewProjection()), bounds, visible);
+	CHECK(visible.empty());
+}
\ No newline at end of file
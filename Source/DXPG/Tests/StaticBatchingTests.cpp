@@ -0,0 +1,209 @@
+#include "TestFramework.h"
+
+#include "StaticBatching.h"
+#include "TransformHierarchy.h"
+
+#include <cstring>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Two unit quads facing +z, the first with material 0 and the second with material 1
+struct TestModel
+{
+	std::vector<MeshVertex> Vertices;
+	std::vector<uint16_t> Indices = { 0, 1, 2, 2, 1, 3 };
+	std::string MaterialNames[2] = { "brick", "stone" };
+	CookedModel Model;
+
+	TestModel()
+	{
+		for (uint32_t shape = 0; shape < 2; ++shape)
+		{
+			for (uint32_t i = 0; i < 4; ++i)
+				Vertices.push_back({ Vector3(float(i & 1), float(i >> 1), 0), Vector3(0, 0, 1), Vector2(float(i & 1), float(i >> 1)) });
+		}
+		Model.Format = VertexFormat::Full;
+		Model.VertexStride = sizeof(MeshVertex);
+		Model.Vertices = std::as_bytes(std::span<MeshVertex const>(Vertices));
+		for (auto& name : MaterialNames)
+			Model.Materials.push_back({ .Name = name, .DiffuseTexture = {}, .DiffuseTextureData = {}, .DiffuseColor = Vector3(1, 1, 1) });
+		for (uint32_t shape = 0; shape < 2; ++shape)
+		{
+			CookedShape cooked{ .Name = MaterialNames[shape], .MaterialIndex = int32_t(shape), .BaseVertex = shape * 4, .VertexCount = 4, .IndexStride = 2,
+				.Indices = std::as_bytes(std::span<uint16_t const>(Indices)) };
+			cooked.Bounds = DirectX::BoundingBox(Vector3(0.5f, 0.5f, 0), Vector3(0.5f, 0.5f, 0));
+			cooked.BoundingSphere = DirectX::BoundingSphere(Vector3(0.5f, 0.5f, 0), 0.71f);
+			Model.Shapes.push_back(cooked);
+		}
+	}
+};
+
+MeshVertex BatchVertex(StaticBatches const& batches, CookedShape const& shape, uint32_t index)
+{
+	MeshVertex vertex;
+	std::memcpy(&vertex, batches.Model.Vertices.data() + (size_t(shape.BaseVertex) + index) * batches.Model.VertexStride, sizeof(vertex));
+	return vertex;
+}
+
+uint32_t BatchIndex(CookedShape const& shape, uint32_t i)
+{
+	uint32_t index = 0;
+	std::memcpy(&index, shape.Indices.data() + size_t(i) * shape.IndexStride, shape.IndexStride);
+	return index;
+}
+
+bool Near(Vector3 const& a, Vector4 b)
+{
+	return XMVector3NearEqual(XMLoadFloat3(&a), b, XMVectorReplicate(1e-4f));
+}
+
+bool MatricesNear(Matrix4x4 const& a, Matrix4x4 const& b)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		if (!XMVector4NearEqual(a.r[row], b.r[row], XMVectorReplicate(1e-4f)))
+			return false;
+	}
+	return true;
+}
+
+}
+
+DXPG_TEST(StaticBatching, BakesTransformsIntoTheVertices)
+{
+	TestModel model;
+	Matrix4x4 transforms[] = {
+		XMMatrixTranslation(2, 0, 0),
+		// Non-uniform scale, the normal has to go through the inverse transpose
+		XMMatrixMultiply(XMMatrixScaling(1, 3, 1), XMMatrixMultiply(XMMatrixRotationY(0.7f), XMMatrixTranslation(0, 1, 2))),
+	};
+	std::vector<StaticBatchInstance> instances = { { 0, transforms[0] }, { 0, transforms[1] } };
+	StaticBatches batches;
+	BuildStaticBatches(model.Model, instances, StaticBatchSettings{ .CellSize = 100.0f }, batches);
+	CHECK(batches.Model.Shapes.size() == 1);
+	CHECK(batches.Model.Nodes.empty());
+	auto& shape = batches.Model.Shapes[0];
+	CHECK(shape.VertexCount == 8 && shape.MaterialIndex == 0);
+	CHECK(shape.Lods.size() >= 1 && shape.Lods[0].IndexCount == 12);
+
+	for (uint32_t instance = 0; instance < 2; ++instance)
+	{
+		Matrix4x4 normalMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, transforms[instance]));
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			auto& source = model.Vertices[i];
+			MeshVertex merged = BatchVertex(batches, shape, instance * 4 + i);
+			CHECK(Near(merged.Position, XMVector3TransformCoord(XMLoadFloat3(&source.Position), transforms[instance])));
+			CHECK(Near(merged.Normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&source.Normal), normalMatrix))));
+			CHECK(merged.TexCoord.x == source.TexCoord.x && merged.TexCoord.y == source.TexCoord.y);
+		}
+		for (uint32_t i = 0; i < 6; ++i)
+			CHECK(BatchIndex(shape, instance * 6 + i) == instance * 4 + model.Indices[i]);
+	}
+	CHECK(batches.Model.Stats.Triangles == 4 && batches.Model.Stats.UniqueVertices == 8);
+}
+
+DXPG_TEST(StaticBatching, MirroredInstancesFlipTheirWinding)
+{
+	TestModel model;
+	// Mirrored about x = 0.5, so both copies fall into the same cell
+	std::vector<StaticBatchInstance> instances = { { 0, XMMatrixIdentity() }, { 0, XMMatrixMultiply(XMMatrixScaling(-1, 1, 1), XMMatrixTranslation(1, 0, 0)) } };
+	StaticBatches batches;
+	BuildStaticBatches(model.Model, instances, StaticBatchSettings{ .CellSize = 100.0f }, batches);
+	CHECK(batches.Model.Shapes.size() == 1);
+	auto& shape = batches.Model.Shapes[0];
+	for (uint32_t triangle = 0; triangle < 2; ++triangle)
+	{
+		uint16_t const* source = &model.Indices[triangle * 3];
+		CHECK(BatchIndex(shape, triangle * 3) == source[0]);
+		CHECK(BatchIndex(shape, triangle * 3 + 1) == source[1]);
+		CHECK(BatchIndex(shape, triangle * 3 + 2) == source[2]);
+		// The mirrored copy swaps the last two corners
+		CHECK(BatchIndex(shape, 6 + triangle * 3) == 4 + source[0]);
+		CHECK(BatchIndex(shape, 6 + triangle * 3 + 1) == 4 + source[2]);
+		CHECK(BatchIndex(shape, 6 + triangle * 3 + 2) == 4 + source[1]);
+	}
+
+	// Both copies keep their front faces on the side their vertex normals point to
+	for (uint32_t instance = 0; instance < 2; ++instance)
+	{
+		Vector4 corners[3];
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			MeshVertex vertex = BatchVertex(batches, shape, BatchIndex(shape, instance * 6 + corner));
+			corners[corner] = XMLoadFloat3(&vertex.Position);
+		}
+		MeshVertex vertex = BatchVertex(batches, shape, BatchIndex(shape, instance * 6));
+		Vector4 faceNormal = XMVector3Cross(XMVectorSubtract(corners[1], corners[0]), XMVectorSubtract(corners[2], corners[0]));
+		Vector4 referenceNormal = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&model.Vertices[1].Position), XMLoadFloat3(&model.Vertices[0].Position)),
+			XMVectorSubtract(XMLoadFloat3(&model.Vertices[2].Position), XMLoadFloat3(&model.Vertices[0].Position)));
+		float sourceSide = XMVectorGetX(XMVector3Dot(referenceNormal, XMLoadFloat3(&model.Vertices[0].Normal)));
+		float batchSide = XMVectorGetX(XMVector3Dot(faceNormal, XMLoadFloat3(&vertex.Normal)));
+		CHECK(sourceSide * batchSide > 0.0f);
+	}
+}
+
+DXPG_TEST(StaticBatching, SplitsByMaterialAndCell)
+{
+	TestModel model;
+	std::vector<StaticBatchInstance> instances = {
+		{ 0, XMMatrixTranslation(0, 0, 0) },
+		{ 1, XMMatrixTranslation(1, 0, 0) },
+		{ 0, XMMatrixTranslation(20, 0, 0) },
+		{ 0, XMMatrixTranslation(2, 0, 0) },
+	};
+	StaticBatches batches;
+	BuildStaticBatches(model.Model, instances, StaticBatchSettings{ .CellSize = 8.0f }, batches);
+	CHECK(batches.Batches.size() == 3);
+	CHECK(batches.Batches[0].MaterialIndex == 0 && batches.Batches[0].Instances == std::vector<uint32_t>({ 0, 3 }));
+	CHECK(batches.Batches[1].MaterialIndex == 0 && batches.Batches[1].Instances == std::vector<uint32_t>({ 2 }));
+	CHECK(batches.Batches[2].MaterialIndex == 1 && batches.Batches[2].Instances == std::vector<uint32_t>({ 1 }));
+	CHECK(batches.Model.Shapes.size() == 3);
+	CHECK(batches.Model.Shapes[0].Name == "brick_Batch0" && batches.Model.Shapes[1].Name == "brick_Batch1" && batches.Model.Shapes[2].Name == "stone_Batch0");
+	// Every cell keeps its own bounds
+	CHECK(batches.Model.Shapes[1].Bounds.Center.x > 19.0f);
+	CHECK(batches.Model.Shapes[0].Bounds.Center.x < 3.0f);
+
+	// Full batches are closed even within a cell
+	StaticBatches small;
+	BuildStaticBatches(model.Model, instances, StaticBatchSettings{ .CellSize = 8.0f, .MaxVertices = 4 }, small);
+	CHECK(small.Batches.size() == 4);
+}
+
+DXPG_TEST(StaticBatching, NestedNodesComposeLikeTheHierarchy)
+{
+	// Root at (5, 0, 0), turned a quarter about y and scaled by 2, with a child one unit along its x drawing shape 0
+	TestModel model;
+	Vector4 quarterTurn = XMQuaternionRotationAxis(XMVectorSet(0, 1, 0, 0), XM_PIDIV2);
+	CookedNode root{ .Name = "root", .Parent = -1, .Translation = Vector3(5, 0, 0), .Rotation = quarterTurn, .Scale = Vector3(2, 2, 2), .FirstShape = 0, .ShapeCount = 0 };
+	CookedNode child{ .Name = "child", .Parent = 0, .Translation = Vector3(1, 0, 0), .Rotation = XMQuaternionIdentity(), .Scale = Vector3(1, 1, 1), .FirstShape = 0, .ShapeCount = 1 };
+	model.Model.Nodes = { root, child };
+
+	std::vector<StaticBatchInstance> instances;
+	GatherStaticInstances(model.Model, instances);
+	CHECK(instances.size() == 1 && instances[0].Shape == 0);
+	Vector4 childOrigin = XMVector3Transform(XMVectorZero(), instances[0].Transform);
+	CHECK(XMVector3NearEqual(childOrigin, XMVectorSet(5, 0, -2, 0), XMVectorReplicate(1e-4f)));
+
+	// The scene places the same nodes through the transform hierarchy
+	TransformHierarchy hierarchy;
+	TransformHierarchy::NodeId nodes[2];
+	for (size_t i = 0; i < 2; ++i)
+	{
+		auto& node = model.Model.Nodes[i];
+		Vector4 position, rotation, scale;
+		LocalTransformFromQuaternion(XMLoadFloat3(&node.Translation), node.Rotation, XMLoadFloat3(&node.Scale), position, rotation, scale);
+		nodes[i] = hierarchy.AddNode(node.Parent < 0 ? TransformHierarchy::InvalidNode : nodes[node.Parent], position, rotation, scale);
+	}
+	hierarchy.Update();
+	CHECK(MatricesNear(hierarchy.GetWorldMatrix(nodes[1]), instances[0].Transform));
+
+	StaticBatches batches;
+	BuildStaticBatches(model.Model, instances, StaticBatchSettings{}, batches);
+	MeshVertex corner = BatchVertex(batches, batches.Model.Shapes[0], 1);
+	// (1, 0, 0) of the quad lands two more units along -z
+	CHECK(Near(corner.Position, XMVectorSet(5, 0, -4, 0)));
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "TestFramework.h"
+
+#include "TaskScheduler.h"
+
+#include <functional>
+#include <thread>
+
+using namespace dxpg;
+
+namespace
+{
+
+struct FakeFence : FenceTimeline
+{
+	std::atomic<uint64_t> Completed = 0;
+	uint64_t CompletedValue() override { return Completed; }
+};
+
+Task<int> Square(TaskScheduler& scheduler, int value)
+{
+	co_await scheduler.ResumeOnWorker();
+	int result = value * value;
+	co_await scheduler.ResumeOnMainThread();
+	co_return result;
+}
+
+// Completes its callback once something else runs it, like a texture request waiting for its decode
+struct PendingRequests
+{
+	std::vector<std::function<void(bool)>> Callbacks;
+};
+
+Task<void> CompleteRequests(TaskScheduler& scheduler, PendingRequests& pending)
+{
+	// Stands in for work that never finishes on its own, a device that stopped or a file that never arrives
+	while (!scheduler.Cancelled())
+		co_await scheduler.ResumeOnMainThread();
+	for (auto& callback : pending.Callbacks)
+		callback(false);
+	pending.Callbacks.clear();
+}
+
+}
+
+DXPG_TEST(TaskScheduler, TasksHopBetweenThreads)
+{
+	TaskScheduler scheduler;
+	scheduler.Init(2);
+	int sum = 0;
+	std::thread::id mainThread = std::this_thread::get_id();
+	bool resumedOnMain = true;
+	for (int i = 1; i <= 10; ++i)
+	{
+		scheduler.Spawn([](TaskScheduler& scheduler, int value, int& sum, std::thread::id mainThread, bool& resumedOnMain) -> Task<void>
+		{
+			int squared = co_await Square(scheduler, value);
+			resumedOnMain = resumedOnMain && std::this_thread::get_id() == mainThread;
+			sum += squared;
+		}(scheduler, i, sum, mainThread, resumedOnMain));
+	}
+	scheduler.RunUntilIdle();
+	CHECK(scheduler.ActiveTasks() == 0);
+	CHECK(sum == 385);
+	CHECK(resumedOnMain);
+	scheduler.Shutdown();
+}
+
+DXPG_TEST(TaskScheduler, FenceWaitsResumeOnceReached)
+{
+	TaskScheduler scheduler;
+	scheduler.Init(1);
+	FakeFence fence;
+	int resumed = 0;
+	scheduler.Spawn([](TaskScheduler& scheduler, FakeFence& fence, int& resumed) -> Task<void>
+	{
+		co_await scheduler.WaitForFence(fence, 3);
+		resumed++;
+	}(scheduler, fence, resumed));
+	for (uint64_t value = 0; value < 3; ++value)
+	{
+		fence.Completed = value;
+		scheduler.Pump();
+		CHECK(resumed == 0);
+	}
+	fence.Completed = 3;
+	scheduler.Pump();
+	CHECK(resumed == 1 && scheduler.ActiveTasks() == 0);
+	scheduler.Shutdown();
+}
+
+DXPG_TEST(TaskScheduler, CancelDrainsWaitingTasks)
+{
+	TaskScheduler scheduler;
+	scheduler.Init(1);
+	PendingRequests pending;
+	int completed = 0;
+	bool loadFinished = false;
+	for (int i = 0; i < 3; ++i)
+		pending.Callbacks.push_back([&](bool loaded) { completed += loaded ? 0 : 1; });
+	scheduler.Spawn(CompleteRequests(scheduler, pending));
+	// A load that waits for its requests, which only return because the cancel completes them
+	scheduler.Spawn([](TaskScheduler& scheduler, int& completed, bool& loadFinished) -> Task<void>
+	{
+		while (completed < 3)
+			co_await scheduler.ResumeOnMainThread();
+		loadFinished = scheduler.Cancelled();
+	}(scheduler, completed, loadFinished));
+
+	for (int frame = 0; frame < 5; ++frame)
+		scheduler.Pump();
+	CHECK(scheduler.ActiveTasks() == 2 && completed == 0);
+	scheduler.Cancel();
+	scheduler.RunUntilIdle();
+	CHECK(completed == 3 && loadFinished);
+	scheduler.Shutdown();
+
+	// Init starts over uncancelled
+	scheduler.Init(1);
+	CHECK(!scheduler.Cancelled());
+	scheduler.Shutdown();
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "TestFramework.h"
+
+#include <iostream>
+
+namespace dxpg::test
+{
+
+static uint32_t Failures = 0;
+
+std::vector<TestCase>& Tests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+std::vector<Benchmark>& Benchmarks()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+void Fail(char const* file, int line, char const* expression)
+{
+	std::cout << file << "(" << line << "): CHECK(" << expression << ") failed" << std::endl;
+	Failures++;
+}
+
+uint32_t FailedChecks()
+{
+	return Failures;
+}
+}
\ No newline at end of file
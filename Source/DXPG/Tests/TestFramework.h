@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Minimal self registering test and benchmark cases, the repository has no third party test framework
+namespace dxpg::test
+{
+
+struct TestCase
+{
+	char const* Suite;
+	char const* Name;
+	void (*Run)();
+};
+
+struct BenchmarkContext
+{
+	// Set when running under CTest, problem sizes should then be small enough to finish in seconds
+	bool Quick = false;
+
+	template<typename T>
+	T Size(T full, T quick) const { return Quick ? quick : full; }
+};
+
+struct Benchmark
+{
+	char const* Name;
+	void (*Run)(BenchmarkContext const& context);
+};
+
+std::vector<TestCase>& Tests();
+std::vector<Benchmark>& Benchmarks();
+
+// Records a failed check
+void Fail(char const* file, int line, char const* expression);
+uint32_t FailedChecks();
+
+struct TestRegistrar
+{
+	TestRegistrar(char const* suite, char const* name, void (*run)()) { Tests().push_back({ suite, name, run }); }
+};
+
+struct BenchmarkRegistrar
+{
+	BenchmarkRegistrar(char const* name, void (*run)(BenchmarkContext const&)) { Benchmarks().push_back({ name, run }); }
+};
+
+// Milliseconds spent in func
+template<typename Func>
+double TimeMilliseconds(Func&& func)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	func();
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+}
+
+#define DXPG_TEST(suite, name) \
+	static void suite##_##name(); \
+	static dxpg::test::TestRegistrar suite##_##name##_Registrar(#suite, #name, suite##_##name); \
+	static void suite##_##name()
+
+#define DXPG_BENCHMARK(name) \
+	static void name##_Benchmark(dxpg::test::BenchmarkContext const& context); \
+	static dxpg::test::BenchmarkRegistrar name##_Registrar(#name, name##_Benchmark); \
+	static void name##_Benchmark(dxpg::test::BenchmarkContext const& context)
+
+#define CHECK(expression) \
+	do { if (!(expression)) dxpg::test::Fail(__FILE__, __LINE__, #expression); } while (0)
+
+#define CHECK_NEAR(a, b, epsilon) CHECK(std::abs(double(a) - double(b)) <= double(epsilon))
\ No newline at end of file
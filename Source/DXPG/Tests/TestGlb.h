@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace dxpg::test
+{
+
+// Wraps a JSON document and an optional binary chunk into a GLB file in memory
+inline std::vector<std::byte> MakeGlb(std::string json, std::span<std::byte const> bin = {})
+{
+	while (json.size() % 4 != 0)
+		json += ' ';
+	size_t binLength = (bin.size() + 3) & ~size_t(3);
+	std::vector<std::byte> glb;
+	auto append = [&](void const* data, size_t size)
+	{
+		auto bytes = static_cast<std::byte const*>(data);
+		glb.insert(glb.end(), bytes, bytes + size);
+	};
+	auto appendU32 = [&](uint32_t value)
+	{
+		append(&value, sizeof(value));
+	};
+	appendU32(0x46546C67u);
+	appendU32(2);
+	appendU32(static_cast<uint32_t>(12 + 8 + json.size() + (bin.empty() ? 0 : 8 + binLength)));
+	appendU32(static_cast<uint32_t>(json.size()));
+	appendU32(0x4E4F534Au);
+	append(json.data(), json.size());
+	if (!bin.empty())
+	{
+		appendU32(static_cast<uint32_t>(binLength));
+		appendU32(0x004E4942u);
+		append(bin.data(), bin.size());
+		glb.resize(glb.size() + binLength - bin.size());
+	}
+	return glb;
+}
+
+}
\ No newline at end of file
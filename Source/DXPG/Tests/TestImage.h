@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace dxpg::test
+{
+
+// Smooth gradients with a little noise and a few hard edges, closer to a photo texture than pure noise.
+// Alpha is opaque unless a pattern is asked for: binary cuts holes, blended ramps across the image
+enum class TestAlpha
+{
+	Opaque,
+	Binary,
+	Blended
+};
+
+inline std::vector<uint8_t> MakeTestImage(uint32_t width, uint32_t height, uint32_t components, uint32_t seed, TestAlpha alpha = TestAlpha::Opaque)
+{
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> noise(-6, 6);
+	std::vector<uint8_t> pixels(size_t(width) * height * components);
+	auto clamp = [](float value) { return uint8_t(std::fmin(std::fmax(value, 0.0f), 255.0f)); };
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			float u = float(x) / float(width);
+			float v = float(y) / float(height);
+			float edge = ((x / 16) + (y / 16)) % 5 == 0 ? 60.0f : 0.0f;
+			uint8_t* texel = pixels.data() + (size_t(y) * width + x) * components;
+			texel[0] = clamp(40.0f + 160.0f * u + edge + float(noise(random)));
+			if (components == 1)
+				continue;
+			texel[1] = clamp(90.0f + 100.0f * v * v + edge * 0.5f + float(noise(random)));
+			texel[2] = clamp(200.0f - 120.0f * u * v + float(noise(random)));
+			texel[3] = alpha == TestAlpha::Blended ? uint8_t(255.0f * u) : alpha == TestAlpha::Binary && (x / 8 + y / 8) % 3 == 0 ? 0 : 255;
+		}
+	}
+	return pixels;
+}
+
+// 32 bit TGA of RGBA pixels stored top row first, runLength packs repeated texels into runs
+inline std::vector<std::byte> EncodeTga(std::span<uint8_t const> pixels, uint32_t width, uint32_t height, bool runLength)
+{
+	std::vector<std::byte> tga(18, std::byte(0));
+	tga[2] = std::byte(runLength ? 10 : 2);
+	tga[12] = std::byte(width & 0xFF);
+	tga[13] = std::byte(width >> 8);
+	tga[14] = std::byte(height & 0xFF);
+	tga[15] = std::byte(height >> 8);
+	tga[16] = std::byte(32);
+	tga[17] = std::byte(0x28);
+	auto appendTexel = [&](size_t texel)
+	{
+		uint8_t const* rgba = pixels.data() + texel * 4;
+		tga.insert(tga.end(), { std::byte(rgba[2]), std::byte(rgba[1]), std::byte(rgba[0]), std::byte(rgba[3]) });
+	};
+	size_t const count = size_t(width) * height;
+	auto same = [&](size_t a, size_t b) { return std::memcmp(pixels.data() + a * 4, pixels.data() + b * 4, 4) == 0; };
+	for (size_t texel = 0; texel < count;)
+	{
+		if (!runLength)
+		{
+			appendTexel(texel++);
+			continue;
+		}
+		// Packets hold up to 128 texels, a run of repeats or a stretch of raw ones
+		size_t end = texel + 1;
+		if (end < count && same(texel, end))
+		{
+			while (end < count && end - texel < 128 && same(texel, end))
+				++end;
+			tga.push_back(std::byte(0x80 | (end - texel - 1)));
+			appendTexel(texel);
+		}
+		else
+		{
+			while (end < count && end - texel < 128 && (end + 1 >= count || !same(end, end + 1)))
+				++end;
+			tga.push_back(std::byte(end - texel - 1));
+			for (size_t raw = texel; raw < end; ++raw)
+				appendTexel(raw);
+		}
+		texel = end;
+	}
+	return tga;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "TestFramework.h"
+
+#include <cstring>
+#include <iostream>
+
+// DXPGTests [suite], runs every test or only the ones of one suite
+int main(int argc, char** argv)
+{
+	using namespace dxpg::test;
+	char const* suite = argc > 1 ? argv[1] : nullptr;
+	uint32_t run = 0;
+	uint32_t failed = 0;
+	for (auto& test : Tests())
+	{
+		if (suite && std::strcmp(suite, test.Suite) != 0)
+			continue;
+		uint32_t failedBefore = FailedChecks();
+		test.Run();
+		bool passed = FailedChecks() == failedBefore;
+		std::cout << (passed ? "[ OK ] " : "[FAIL] ") << test.Suite << "." << test.Name << std::endl;
+		run++;
+		failed += passed ? 0 : 1;
+	}
+	std::cout << run - failed << " of " << run << " tests passed" << std::endl;
+	return (suite && run == 0) || failed > 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "MeshImport.h"
+
+namespace dxpg::test
+{
+
+// Closed unit sphere with single vertex poles. The first and last column share their positions with different UVs, a seam like exporters write
+inline void MakeSphere(uint32_t rings, uint32_t segments, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	outVertices.clear();
+	outIndices.clear();
+	outVertices.push_back({ Vector3(0, 1, 0), Vector3(0, 1, 0), Vector2(0.5f, 0) });
+	for (uint32_t ring = 1; ring < rings; ++ring)
+	{
+		for (uint32_t segment = 0; segment <= segments; ++segment)
+		{
+			float theta = 3.14159265f * float(ring) / float(rings);
+			// The last column is the first one again, computed from the same angle so the positions match bit for bit
+			float phi = 6.28318531f * float(segment % segments) / float(segments);
+			Vector3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			outVertices.push_back({ normal, normal, Vector2(float(segment) / float(segments), float(ring) / float(rings)) });
+		}
+	}
+	uint32_t const south = uint32_t(outVertices.size());
+	outVertices.push_back({ Vector3(0, -1, 0), Vector3(0, -1, 0), Vector2(0.5f, 1) });
+
+	// Wound so the face normals point outwards
+	auto vertex = [&](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * (segments + 1) + segment; };
+	for (uint32_t segment = 0; segment < segments; ++segment)
+	{
+		outIndices.insert(outIndices.end(), { 0, vertex(1, segment + 1), vertex(1, segment) });
+		outIndices.insert(outIndices.end(), { south, vertex(rings - 1, segment), vertex(rings - 1, segment + 1) });
+	}
+	for (uint32_t ring = 1; ring + 1 < rings; ++ring)
+	{
+		for (uint32_t segment = 0; segment < segments; ++segment)
+		{
+			uint32_t a = vertex(ring, segment);
+			uint32_t b = vertex(ring + 1, segment);
+			outIndices.insert(outIndices.end(), { a, a + 1, b, a + 1, b + 1, b });
+		}
+	}
+}
+
+// Open size by size quad grid in the xy plane facing -z, heights move the vertices along z. seamColumn, when inside the
+// grid, splits the vertices of that column into two wedges with different UVs
+inline void MakeGrid(uint32_t size, std::vector<MeshVertex>& outVertices, std::vector<uint32_t>& outIndices, std::vector<float> const& heights = {}, uint32_t seamColumn = 0)
+{
+	outVertices.clear();
+	outIndices.clear();
+	auto position = [&](uint32_t x, uint32_t y)
+	{
+		float z = heights.empty() ? 0.0f : heights[size_t(y) * (size + 1) + x];
+		return Vector3(float(x), float(y), z);
+	};
+	// Column x of the left wedge, the right wedge of the seam is appended behind the grid
+	for (uint32_t y = 0; y <= size; ++y)
+		for (uint32_t x = 0; x <= size; ++x)
+			outVertices.push_back({ position(x, y), Vector3(0, 0, -1), Vector2(float(x) / float(size), float(y) / float(size)) });
+	bool const seam = seamColumn > 0 && seamColumn < size;
+	uint32_t const seamStart = uint32_t(outVertices.size());
+	if (seam)
+	{
+		for (uint32_t y = 0; y <= size; ++y)
+			outVertices.push_back({ position(seamColumn, y), Vector3(0, 0, -1), Vector2(1.0f, float(y) / float(size)) });
+	}
+
+	auto vertex = [&](uint32_t x, uint32_t y, bool right) { return right && seam && x == seamColumn ? seamStart + y : y * (size + 1) + x; };
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			// Quads right of the seam use its second wedge
+			bool right = x >= seamColumn;
+			uint32_t a = vertex(x, y, right);
+			uint32_t b = vertex(x + 1, y, right);
+			uint32_t c = vertex(x, y + 1, right);
+			uint32_t d = vertex(x + 1, y + 1, right);
+			outIndices.insert(outIndices.end(), { a, c, b, b, c, d });
+		}
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "TestFramework.h"
+#include "TestImage.h"
+
+#include "TextureCache.h"
+#include "TextureSharing.h"
+#include "MappedFile.h"
+
+#include <fstream>
+#include <string>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Scratch folder with a fake source image, removed again when the test ends
+struct CacheFolder
+{
+	std::filesystem::path Folder;
+	std::filesystem::path Source;
+
+	explicit CacheFolder(char const* name)
+	{
+		Folder = std::filesystem::temp_directory_path() / name;
+		std::filesystem::remove_all(Folder);
+		std::filesystem::create_directories(Folder);
+		Source = Folder / "brick.png";
+		WriteSource("not really a png");
+	}
+	~CacheFolder()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(Folder, error);
+	}
+
+	void WriteSource(std::string const& text)
+	{
+		std::ofstream(Source, std::ios::binary | std::ios::trunc) << text;
+	}
+};
+
+// Owns the storage the payload of Texture points into
+struct TestTexture
+{
+	CompressedTexture Compressed;
+	std::vector<std::byte> Storage;
+	CookedTexture Texture;
+
+	explicit TestTexture(uint32_t seed = 9)
+	{
+		auto pixels = test::MakeTestImage(64, 32, 4, seed);
+		CompressTexture(pixels, 64, 32, 4, true, true, TextureCompression::Fast, Compressed);
+		CookTexture(Compressed, Storage, Texture);
+	}
+};
+
+// Levels are aligned, rows are pitched and nothing overlaps
+void CheckFootprints(std::vector<TextureFootprint> const& footprints, uint64_t size)
+{
+	uint64_t end = 0;
+	for (auto& footprint : footprints)
+	{
+		CHECK(footprint.Offset % TexturePlacementAlignment == 0);
+		CHECK(footprint.RowPitch % TextureRowPitchAlignment == 0);
+		CHECK(footprint.RowPitch >= footprint.RowBytes);
+		CHECK(footprint.Offset >= end);
+		end = footprint.Offset + uint64_t(footprint.RowPitch) * (footprint.RowCount - 1) + footprint.RowBytes;
+	}
+	CHECK(end == size);
+}
+
+}
+
+DXPG_TEST(TextureCache, FootprintsMatchTheCopyLayout)
+{
+	std::vector<TextureFootprint> footprints;
+	uint64_t size = ComputeTextureFootprints(TexelFormat::RGBA8, 300, 200, 9, footprints);
+	CHECK(footprints.size() == 9);
+	CheckFootprints(footprints, size);
+	CHECK(footprints[0].Offset == 0 && footprints[0].RowBytes == 1200 && footprints[0].RowPitch == 1280 && footprints[0].RowCount == 200);
+	CHECK(footprints[1].Width == 150 && footprints[1].Height == 100 && footprints[1].RowBytes == 600 && footprints[1].RowPitch == 768);
+	CHECK(footprints[1].Offset == (1280ull * 199 + 1200 + 511) / 512 * 512);
+	CHECK(footprints[8].Width == 1 && footprints[8].Height == 1 && footprints[8].RowBytes == 4);
+
+	// Block rows, levels below 4x4 still take a whole block
+	size = ComputeTextureFootprints(TexelFormat::BC1, 64, 32, 7, footprints);
+	CheckFootprints(footprints, size);
+	CHECK(footprints[0].RowBytes == 16 * 8 && footprints[0].RowPitch == 256 && footprints[0].RowCount == 8);
+	CHECK(footprints[4].Width == 4 && footprints[4].Height == 2 && footprints[4].RowBytes == 8 && footprints[4].RowCount == 1);
+	CHECK(footprints[6].Width == 1 && footprints[6].Height == 1 && footprints[6].RowBytes == 8 && footprints[6].RowCount == 1);
+	ComputeTextureFootprints(TexelFormat::BC7, 64, 64, 1, footprints);
+	CHECK(footprints[0].RowBytes == 16 * 16);
+	ComputeTextureFootprints(TexelFormat::R8, 5, 3, 1, footprints);
+	CHECK(footprints[0].RowBytes == 5 && footprints[0].RowPitch == 256 && footprints[0].RowCount == 3);
+}
+
+DXPG_TEST(TextureCache, CookCopiesRowsIntoTheLayout)
+{
+	std::vector<uint8_t> top(5 * 3), mip(2 * 1);
+	for (size_t i = 0; i < top.size(); ++i)
+		top[i] = uint8_t(i + 1);
+	mip = { 100, 101 };
+	std::span<uint8_t const> levels[] = { top, mip };
+	std::vector<std::byte> storage;
+	CookedTexture texture;
+	CookTexture(TexelFormat::R8, 5, 3, levels, storage, texture);
+	CHECK(texture.Width() == 5 && texture.Height() == 3 && texture.Footprints.size() == 2);
+	CHECK(texture.Payload.data() == storage.data());
+	CHECK(texture.TexelBytes() == 5 * 3 + 2);
+	for (uint32_t row = 0; row < 3; ++row)
+	{
+		for (uint32_t x = 0; x < 5; ++x)
+			CHECK(uint8_t(texture.Payload[row * 256 + x]) == top[row * 5 + x]);
+		// Row padding stays zero, the last row has none
+		if (row < 2)
+			CHECK(uint8_t(texture.Payload[row * 256 + 5]) == 0);
+	}
+	auto& level1 = texture.Footprints[1];
+	CHECK(level1.Offset == 1024);
+	CHECK(uint8_t(texture.Payload[level1.Offset]) == 100 && uint8_t(texture.Payload[level1.Offset + 1]) == 101);
+	CHECK(texture.Payload.size() == 1024 + 2);
+
+	TestTexture compressed;
+	CHECK(compressed.Texture.Format == TexelFormat::BC1);
+	CHECK(compressed.Texture.Footprints.size() == compressed.Compressed.Mips.size());
+	CHECK(compressed.Texture.TexelBytes() == compressed.Compressed.Bytes());
+	CHECK(compressed.Texture.SquaredError == compressed.Compressed.SquaredError && compressed.Texture.Samples == compressed.Compressed.Samples);
+	CHECK(compressed.Texture.UncompressedBytes == compressed.Compressed.UncompressedBytes);
+}
+
+DXPG_TEST(TextureCache, RoundTripsTheCookedTexture)
+{
+	CacheFolder folder("dxpg_texturecache_roundtrip");
+	TestTexture source;
+	TextureCacheKey key;
+	CHECK(MakeTextureCacheKey(folder.Source, TextureCompression::Fast, false, true, key));
+	auto cachePath = TextureCachePath(folder.Source);
+	CHECK(cachePath.filename() == "brick.png.texcache");
+	CHECK(WriteTextureCache(cachePath, key, source.Texture));
+	CHECK(!std::filesystem::exists(cachePath.string() + ".tmp"));
+
+	MappedFile file;
+	CHECK(file.Open(cachePath));
+	CookedTexture texture;
+	CHECK(ReadTextureCache(file.Data(), key, texture));
+	CHECK(texture.Format == source.Texture.Format);
+	CHECK(texture.Footprints.size() == source.Texture.Footprints.size());
+	for (size_t level = 0; level < texture.Footprints.size(); ++level)
+	{
+		auto& a = texture.Footprints[level];
+		auto& b = source.Texture.Footprints[level];
+		CHECK(a.Offset == b.Offset && a.Width == b.Width && a.Height == b.Height && a.RowPitch == b.RowPitch && a.RowCount == b.RowCount && a.RowBytes == b.RowBytes);
+	}
+	CHECK(std::equal(texture.Payload.begin(), texture.Payload.end(), source.Texture.Payload.begin(), source.Texture.Payload.end()));
+	// Copies straight out of the mapping need the placement alignment
+	CHECK(reinterpret_cast<uintptr_t>(texture.Payload.data()) % TexturePlacementAlignment == 0);
+	CHECK(texture.SquaredError == source.Texture.SquaredError && texture.Samples == source.Texture.Samples);
+	CHECK(texture.UncompressedBytes == source.Texture.UncompressedBytes);
+	CHECK(texture.ContentHash == source.Texture.ContentHash);
+}
+
+DXPG_TEST(TextureCache, IdenticalContentSharesOneTexture)
+{
+	CacheFolder folder("dxpg_texturecache_shared");
+	auto copyPath = folder.Folder / "brick_copy.png";
+	auto otherPath = folder.Folder / "stone.png";
+	std::ofstream(copyPath, std::ios::binary) << "another file, same image";
+	std::ofstream(otherPath, std::ios::binary) << "a different image";
+	TestTexture brick, brickCopy, stone(10);
+	CHECK(brick.Texture.ContentHash != 0);
+	CHECK(brick.Texture.ContentHash == brickCopy.Texture.ContentHash);
+	CHECK(brick.Texture.ContentHash != stone.Texture.ContentHash);
+
+	// Warm loads take the hash from the cache
+	std::filesystem::path paths[] = { folder.Source, copyPath, otherPath };
+	CookedTexture const* cooked[] = { &brick.Texture, &brickCopy.Texture, &stone.Texture };
+	uint64_t hashes[3];
+	for (size_t i = 0; i < 3; ++i)
+	{
+		TextureCacheKey key;
+		CHECK(MakeTextureCacheKey(paths[i], TextureCompression::Fast, false, true, key));
+		CHECK(WriteTextureCache(TextureCachePath(paths[i]), key, *cooked[i]));
+		MappedFile file;
+		CookedTexture texture;
+		CHECK(file.Open(TextureCachePath(paths[i])) && ReadTextureCache(file.Data(), key, texture));
+		hashes[i] = texture.ContentHash;
+		CHECK(hashes[i] == cooked[i]->ContentHash);
+	}
+
+	TextureContentTable table;
+	TextureContentTable::Match match;
+	CHECK(!table.Claim(hashes[0], paths[0], match));
+	table.Publish(hashes[0], 1);
+	CHECK(table.Claim(hashes[1], paths[1], match) && match.Texture == 1);
+	CHECK(!table.Claim(hashes[2], paths[2], match));
+}
+
+DXPG_TEST(TextureCache, KeyChangesInvalidate)
+{
+	CacheFolder folder("dxpg_texturecache_invalidate");
+	TestTexture source;
+	TextureCacheKey key;
+	CHECK(MakeTextureCacheKey(folder.Source, TextureCompression::Fast, false, true, key));
+	auto cachePath = TextureCachePath(folder.Source);
+	CHECK(WriteTextureCache(cachePath, key, source.Texture));
+	MappedFile file;
+	CHECK(file.Open(cachePath));
+	CookedTexture texture;
+
+	TextureCacheKey otherKey = key;
+	otherKey.Compression = TextureCompression::HighQuality;
+	CHECK(!ReadTextureCache(file.Data(), otherKey, texture));
+	otherKey = key;
+	otherKey.AlphaOnly = true;
+	CHECK(!ReadTextureCache(file.Data(), otherKey, texture));
+	otherKey = key;
+	otherKey.GenerateMips = false;
+	CHECK(!ReadTextureCache(file.Data(), otherKey, texture));
+	otherKey = key;
+	otherKey.ImporterVersion++;
+	CHECK(!ReadTextureCache(file.Data(), otherKey, texture));
+	otherKey = key;
+	otherKey.SourceSize++;
+	CHECK(!ReadTextureCache(file.Data(), otherKey, texture));
+
+	// Touched without a change, e.g. by a checkout, the content hash still matches
+	auto writeTime = std::filesystem::last_write_time(folder.Source) + std::chrono::hours(1);
+	std::filesystem::last_write_time(folder.Source, writeTime);
+	CHECK(MakeTextureCacheKey(folder.Source, TextureCompression::Fast, false, true, otherKey));
+	CHECK(otherKey.SourceWriteTime != key.SourceWriteTime);
+	CHECK(ReadTextureCache(file.Data(), otherKey, texture));
+
+	// Same size but different content
+	folder.WriteSource("not really a jpg");
+	std::filesystem::last_write_time(folder.Source, writeTime + std::chrono::hours(1));
+	CHECK(MakeTextureCacheKey(folder.Source, TextureCompression::Fast, false, true, otherKey));
+	CHECK(otherKey.SourceSize == key.SourceSize);
+	CHECK(!ReadTextureCache(file.Data(), otherKey, texture));
+
+	CHECK(!MakeTextureCacheKey(folder.Folder / "missing.png", TextureCompression::Fast, false, true, otherKey));
+}
+
+DXPG_TEST(TextureCache, RejectsDamagedFiles)
+{
+	CacheFolder folder("dxpg_texturecache_damaged");
+	TestTexture source;
+	TextureCacheKey key;
+	CHECK(MakeTextureCacheKey(folder.Source, TextureCompression::Fast, false, true, key));
+	auto cachePath = TextureCachePath(folder.Source);
+	CHECK(WriteTextureCache(cachePath, key, source.Texture));
+	MappedFile file;
+	CHECK(file.Open(cachePath));
+	std::vector<std::byte> bytes(file.Data().begin(), file.Data().end());
+	file.Close();
+
+	// Cut anywhere, the payload no longer fits
+	CookedTexture texture;
+	for (size_t size = 0; size < bytes.size(); size += 13)
+		CHECK(!ReadTextureCache(std::span<std::byte const>(bytes.data(), size), key, texture));
+
+	auto corrupted = bytes;
+	corrupted[0] ^= std::byte(1);
+	CHECK(!ReadTextureCache(corrupted, key, texture));
+	CHECK(ReadTextureCache(bytes, key, texture));
+}
\ No newline at end of file
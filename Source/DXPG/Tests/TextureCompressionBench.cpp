@@ -0,0 +1,44 @@
+#include "TestFramework.h"
+#include "TestImage.h"
+
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+using namespace dxpg;
+
+// Compresses the same images with their mips once per thread count, powers of two up to the hardware thread count
+DXPG_BENCHMARK(TextureCompression)
+{
+	uint32_t const imageCount = context.Size(8u, 2u);
+	uint32_t const size = context.Size(1024u, 128u);
+	std::vector<std::vector<uint8_t>> images(imageCount);
+	for (uint32_t i = 0; i < imageCount; ++i)
+		images[i] = test::MakeTestImage(size, size, 4, i, i % 2 == 0 ? test::TestAlpha::Opaque : test::TestAlpha::Blended);
+
+	uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (TextureCompression compression : { TextureCompression::Fast, TextureCompression::HighQuality })
+	{
+		for (uint32_t threads = 1; ; threads = std::min(threads * 2, maxThreads))
+		{
+			TextureCompressionStats stats;
+			double milliseconds = test::TimeMilliseconds([&]()
+			{
+				for (auto& image : images)
+				{
+					CompressedTexture compressed;
+					if (CompressTexture(image, size, size, 4, true, true, compression, compressed, threads))
+						stats.Add(compressed);
+				}
+			});
+			CHECK(stats.Psnr() > 30.0);
+			std::cout << TextureCompressionName(compression) << ", " << imageCount << " images on " << threads << " threads: " << milliseconds << " ms, "
+				<< double(stats.Texels) / 1e6 / (std::max(milliseconds, 1e-3) / 1000.0) << " Mtexels/s, " << stats.Psnr() << " dB PSNR, "
+				<< double(stats.UncompressedBytes) / double(stats.CompressedBytes) << "x smaller" << std::endl;
+			if (threads == maxThreads)
+				break;
+		}
+	}
+}
\ No newline at end of file
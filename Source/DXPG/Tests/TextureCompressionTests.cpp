@@ -0,0 +1,159 @@
+#include "TestFramework.h"
+#include "TestImage.h"
+
+#include "TextureCompression.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace dxpg;
+
+namespace
+{
+
+// PSNR of the top level from decoding every block again, independent of what CompressTexture reports
+double DecodedPsnr(std::vector<uint8_t> const& pixels, uint32_t width, uint32_t components, CompressedTexture const& texture)
+{
+	auto& mip = texture.Mips[0];
+	double squaredError = 0.0;
+	uint64_t samples = 0;
+	uint8_t decoded[64];
+	for (uint32_t blockY = 0; blockY < mip.BlocksHigh; ++blockY)
+	{
+		for (uint32_t blockX = 0; blockX < mip.BlocksWide; ++blockX)
+		{
+			DecodeBlock(texture.Format, mip.Blocks.data() + (size_t(blockY) * mip.BlocksWide + blockX) * BlockBytes(texture.Format), decoded);
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				uint8_t const* texel = pixels.data() + ((size_t(blockY) * 4 + i / 4) * width + blockX * 4 + i % 4) * components;
+				for (uint32_t c = 0; c < components; ++c)
+				{
+					double difference = double(texel[c]) - double(decoded[i * 4 + c]);
+					squaredError += difference * difference;
+					samples++;
+				}
+			}
+		}
+	}
+	return PsnrFromSquaredError(squaredError, samples);
+}
+
+}
+
+DXPG_TEST(TextureCompression, ChoosesFormatByAlpha)
+{
+	auto opaque = test::MakeTestImage(16, 16, 4, 1);
+	auto binary = test::MakeTestImage(16, 16, 4, 1, test::TestAlpha::Binary);
+	auto blended = test::MakeTestImage(16, 16, 4, 1, test::TestAlpha::Blended);
+	CHECK(ClassifyAlpha(opaque) == AlphaUsage::Opaque);
+	CHECK(ClassifyAlpha(binary) == AlphaUsage::Binary);
+	CHECK(ClassifyAlpha(blended) == AlphaUsage::Blended);
+	CHECK(ChooseBlockFormat(opaque, 4, TextureCompression::Fast) == BlockFormat::BC1);
+	CHECK(ChooseBlockFormat(binary, 4, TextureCompression::Fast) == BlockFormat::BC1);
+	CHECK(ChooseBlockFormat(blended, 4, TextureCompression::Fast) == BlockFormat::BC3);
+	CHECK(ChooseBlockFormat(opaque, 4, TextureCompression::HighQuality) == BlockFormat::BC7);
+	CHECK(ChooseBlockFormat(test::MakeTestImage(16, 16, 1, 1), 1, TextureCompression::HighQuality) == BlockFormat::BC4);
+}
+
+DXPG_TEST(TextureCompression, SolidBlocksRoundTrip)
+{
+	uint8_t const colors[][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 200, 100, 50, 255 }, { 17, 201, 99, 128 } };
+	for (auto& color : colors)
+	{
+		uint8_t texels[64];
+		for (uint32_t i = 0; i < 16; ++i)
+			std::copy_n(color, 4, texels + i * 4);
+		for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC7 })
+		{
+			uint8_t block[16];
+			uint8_t decoded[64];
+			EncodeBlock(format, texels, block);
+			DecodeBlock(format, block, decoded);
+			uint32_t channels = format == BlockFormat::BC4 ? 1 : format == BlockFormat::BC1 ? 3 : 4;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					// 5:6:5 colors are off by a few steps at most, BC4 channels are exact and BC7 keeps nearly 8 bits
+					int tolerance = format == BlockFormat::BC7 ? 1 : c < 3 && format != BlockFormat::BC4 ? 4 : 0;
+					CHECK(std::abs(int(decoded[i * 4 + c]) - int(color[c])) <= tolerance);
+				}
+			}
+		}
+	}
+}
+
+DXPG_TEST(TextureCompression, MeetsQualityTargets)
+{
+	uint32_t const size = 64;
+	struct Case
+	{
+		uint32_t Components;
+		test::TestAlpha Alpha;
+		TextureCompression Compression;
+		BlockFormat Format;
+		double MinPsnr;
+	};
+	Case const cases[] = {
+		{ 4, test::TestAlpha::Opaque, TextureCompression::Fast, BlockFormat::BC1, 34.0 },
+		{ 4, test::TestAlpha::Blended, TextureCompression::Fast, BlockFormat::BC3, 34.0 },
+		{ 4, test::TestAlpha::Opaque, TextureCompression::HighQuality, BlockFormat::BC7, 38.0 },
+		{ 1, test::TestAlpha::Opaque, TextureCompression::Fast, BlockFormat::BC4, 38.0 },
+	};
+	for (auto& c : cases)
+	{
+		auto pixels = test::MakeTestImage(size, size, c.Components, 7, c.Alpha);
+		CompressedTexture texture;
+		CHECK(CompressTexture(pixels, size, size, c.Components, true, false, c.Compression, texture));
+		CHECK(texture.Format == c.Format);
+		CHECK(texture.Mips.size() == 1);
+		double psnr = DecodedPsnr(pixels, size, c.Components, texture);
+		CHECK(psnr >= c.MinPsnr);
+		CHECK_NEAR(PsnrFromSquaredError(texture.SquaredError, texture.Samples), psnr, 1e-9);
+		CHECK(texture.Bytes() == size_t(size / 4) * (size / 4) * BlockBytes(c.Format));
+	}
+}
+
+DXPG_TEST(TextureCompression, BuildsEveryLevel)
+{
+	auto pixels = test::MakeTestImage(64, 32, 4, 3);
+	CompressedTexture texture;
+	CHECK(CompressTexture(pixels, 64, 32, 4, true, true, TextureCompression::Fast, texture));
+	CHECK(texture.Mips.size() == 7);
+	uint64_t texels = 0;
+	for (uint32_t level = 0; level < texture.Mips.size(); ++level)
+	{
+		auto& mip = texture.Mips[level];
+		CHECK(mip.Width == std::max(64u >> level, 1u) && mip.Height == std::max(32u >> level, 1u));
+		CHECK(mip.Blocks.size() == size_t((mip.Width + 3) / 4) * ((mip.Height + 3) / 4) * BlockBytes(texture.Format));
+		texels += uint64_t(mip.Width) * mip.Height;
+	}
+	CHECK(texture.Texels == texels);
+	CHECK(texture.UncompressedBytes == texels * 4);
+	// Levels below 4x4 still take a whole block
+	CHECK(texture.Bytes() * 8 >= texture.UncompressedBytes);
+}
+
+DXPG_TEST(TextureCompression, ThreadCountDoesNotChangeBlocks)
+{
+	auto pixels = test::MakeTestImage(128, 128, 4, 5);
+	CompressedTexture single;
+	CompressedTexture parallel;
+	CHECK(CompressTexture(pixels, 128, 128, 4, true, true, TextureCompression::HighQuality, single, 1));
+	CHECK(CompressTexture(pixels, 128, 128, 4, true, true, TextureCompression::HighQuality, parallel, 4));
+	CHECK(single.Mips.size() == parallel.Mips.size());
+	for (size_t level = 0; level < single.Mips.size(); ++level)
+		CHECK(single.Mips[level].Blocks == parallel.Mips[level].Blocks);
+	CHECK(single.SquaredError == parallel.SquaredError);
+}
+
+DXPG_TEST(TextureCompression, RejectsUnsupportedImages)
+{
+	auto pixels = test::MakeTestImage(6, 8, 4, 1);
+	CompressedTexture texture;
+	CHECK(!CompressTexture(pixels, 6, 8, 4, true, true, TextureCompression::Fast, texture));
+	auto aligned = test::MakeTestImage(8, 8, 4, 1);
+	CHECK(!CompressTexture(aligned, 8, 8, 4, true, true, TextureCompression::None, texture));
+	CHECK(PsnrFromSquaredError(0.0, 0) == 0.0);
+	CHECK(std::isinf(PsnrFromSquaredError(0.0, 16)));
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "TestFramework.h"
+
+#include "Parallel.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Run length encoded 32 bit TGA with short runs between noisy texels, so decoding is neither a memcpy nor a fill
+std::vector<std::byte> MakeTga(uint32_t width, uint32_t height, uint32_t seed)
+{
+	std::vector<std::byte> tga(18, std::byte(0));
+	tga[2] = std::byte(10);
+	tga[12] = std::byte(width & 0xFF);
+	tga[13] = std::byte(width >> 8);
+	tga[14] = std::byte(height & 0xFF);
+	tga[15] = std::byte(height >> 8);
+	tga[16] = std::byte(32);
+	tga[17] = std::byte(0x28);
+	std::mt19937 random(seed);
+	auto appendTexel = [&]()
+	{
+		uint32_t texel = uint32_t(random());
+		for (uint32_t c = 0; c < 4; ++c)
+			tga.push_back(std::byte(texel >> (c * 8)));
+	};
+	for (uint32_t remaining = width * height; remaining > 0;)
+	{
+		uint32_t count = std::min(remaining, uint32_t(random() % 16 + 1));
+		bool run = random() % 2 == 0;
+		tga.push_back(std::byte((run ? 0x80 : 0) | (count - 1)));
+		for (uint32_t i = 0; i < (run ? 1 : count); ++i)
+			appendTexel();
+		remaining -= count;
+	}
+	return tga;
+}
+
+}
+
+// Decodes the same images once per thread count, the way texture loads decode on the scheduler's workers
+DXPG_BENCHMARK(TextureDecode)
+{
+	uint32_t const imageCount = context.Size(64u, 8u);
+	uint32_t const size = context.Size(1024u, 256u);
+	std::vector<std::vector<std::byte>> images(imageCount);
+	for (uint32_t i = 0; i < imageCount; ++i)
+		images[i] = MakeTga(size, size, i);
+
+	uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (uint32_t threads = 1; ; threads = std::min(threads * 2, maxThreads))
+	{
+		std::vector<uint64_t> decodedBytes(images.size(), 0);
+		double milliseconds = test::TimeMilliseconds([&]()
+		{
+			ParallelFor(images.size(), [&](size_t i)
+			{
+				int width, height, comp;
+				stbi_set_flip_vertically_on_load_thread(true);
+				std::unique_ptr<stbi_uc, void (*)(void*)> pixels(stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(images[i].data()), int(images[i].size()),
+					&width, &height, &comp, STBI_rgb_alpha), stbi_image_free);
+				if (pixels)
+					decodedBytes[i] = uint64_t(width) * height * 4;
+			}, threads);
+		});
+		uint64_t totalBytes = 0;
+		for (uint64_t bytes : decodedBytes)
+			totalBytes += bytes;
+		CHECK(totalBytes == uint64_t(imageCount) * size * size * 4);
+		double seconds = std::max(milliseconds, 1e-3) / 1000.0;
+		std::cout << imageCount << " images on " << threads << " threads: " << milliseconds << " ms, " << double(totalBytes) / (1 << 20) / seconds << " MiB/s, "
+			<< double(imageCount) / seconds << " images/s" << std::endl;
+		if (threads == maxThreads)
+			break;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "TestFramework.h"
+#include "TestImage.h"
+
+#include "TaskScheduler.h"
+#include "TextureDecode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Test image with a solid band, so run length encoding has runs to pack
+std::vector<uint8_t> MakeImage(uint32_t width, uint32_t height, uint32_t seed)
+{
+	auto pixels = test::MakeTestImage(width, height, 4, seed);
+	std::fill(pixels.begin(), pixels.begin() + size_t(width) * 4 * (height / 4), uint8_t(seed * 40));
+	return pixels;
+}
+
+// Decoded rows come out bottom row first
+bool MatchesFlipped(DecodedPixels const& decoded, std::vector<uint8_t> const& pixels, uint32_t width, uint32_t height)
+{
+	if (!decoded.Pixels || decoded.Width != int(width) || decoded.Height != int(height) || decoded.Components != 4)
+		return false;
+	size_t const row = size_t(width) * 4;
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		if (std::memcmp(decoded.Pixels.get() + y * row, pixels.data() + (height - 1 - y) * row, row) != 0)
+			return false;
+	}
+	return true;
+}
+
+struct WorkerDecode
+{
+	DecodedPixels Pixels;
+	bool Decoded = false;
+	bool OnWorker = false;
+};
+
+// What a texture load does with an embedded image before it hops back to create the texture
+Task<void> DecodeOnWorker(TaskScheduler& scheduler, std::span<std::byte const> encoded, WorkerDecode& outDecode)
+{
+	std::thread::id mainThread = std::this_thread::get_id();
+	co_await scheduler.ResumeOnWorker();
+	outDecode.OnWorker = std::this_thread::get_id() != mainThread;
+	outDecode.Decoded = DecodePixels("embedded", encoded, false, outDecode.Pixels);
+	co_await scheduler.ResumeOnMainThread();
+}
+
+}
+
+DXPG_TEST(TextureDecode, DecodesFlippedRgba)
+{
+	uint32_t const width = 37;
+	uint32_t const height = 20;
+	auto pixels = MakeImage(width, height, 1);
+	for (bool runLength : { false, true })
+	{
+		auto tga = test::EncodeTga(pixels, width, height, runLength);
+		DecodedPixels decoded;
+		CHECK(DecodePixels("embedded", tga, false, decoded));
+		CHECK(MatchesFlipped(decoded, pixels, width, height));
+		CHECK(decoded.Size() == pixels.size());
+	}
+
+	DecodedPixels alpha;
+	CHECK(DecodePixels("embedded", test::EncodeTga(pixels, width, height, true), true, alpha));
+	CHECK(alpha.Components == 1 && alpha.Size() == size_t(width) * height);
+}
+
+DXPG_TEST(TextureDecode, WorkersDecodeLikeTheMainThread)
+{
+	uint32_t const imageCount = 16;
+	std::vector<std::vector<uint8_t>> pixels;
+	std::vector<std::vector<std::byte>> encoded;
+	for (uint32_t i = 0; i < imageCount; ++i)
+	{
+		uint32_t width = 64 + i * 5;
+		uint32_t height = 48 - i;
+		pixels.push_back(MakeImage(width, height, i));
+		encoded.push_back(test::EncodeTga(pixels.back(), width, height, i % 2 == 0));
+	}
+	// Cut short, every worker decoding it has to report its own failure
+	std::vector<std::byte> truncated(encoded[0].begin(), encoded[0].begin() + encoded[0].size() / 2);
+	encoded.push_back(truncated);
+
+	TaskScheduler scheduler;
+	scheduler.Init(4);
+	std::vector<WorkerDecode> decoded(encoded.size());
+	for (size_t i = 0; i < encoded.size(); ++i)
+		scheduler.Spawn(DecodeOnWorker(scheduler, encoded[i], decoded[i]));
+	scheduler.RunUntilIdle();
+	scheduler.Shutdown();
+
+	for (uint32_t i = 0; i < imageCount; ++i)
+	{
+		CHECK(decoded[i].OnWorker && decoded[i].Decoded);
+		CHECK(MatchesFlipped(decoded[i].Pixels, pixels[i], 64 + i * 5, 48 - i));
+		// The same bytes the main thread decodes
+		DecodedPixels serial;
+		CHECK(DecodePixels("embedded", encoded[i], false, serial));
+		CHECK(serial.Size() == decoded[i].Pixels.Size() && std::memcmp(serial.Pixels.get(), decoded[i].Pixels.Pixels.get(), serial.Size()) == 0);
+	}
+	CHECK(!decoded[imageCount].Decoded && !decoded[imageCount].Pixels.Pixels);
+	CHECK(!decoded[imageCount].Pixels.Error.empty());
+}
\ No newline at end of file
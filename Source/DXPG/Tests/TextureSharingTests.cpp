@@ -0,0 +1,36 @@
+#include "TestFramework.h"
+
+#include "TextureSharing.h"
+
+using namespace dxpg;
+
+DXPG_TEST(TextureSharing, FirstImageOwnsItsContent)
+{
+	TextureContentTable table;
+	TextureContentTable::Match match;
+	CHECK(!table.Find(7, match));
+	CHECK(!table.Claim(7, "a.png", match));
+	// Still uploading, the duplicate has to wait for a.png instead of getting the texture
+	CHECK(table.Claim(7, "b.png", match));
+	CHECK(match.Texture == 0 && match.Owner == "a.png");
+	CHECK(table.Find(7, match) && match.Texture == 0);
+	// Other content is not shared
+	CHECK(!table.Claim(8, "c.png", match));
+
+	table.Publish(7, 3);
+	CHECK(table.Claim(7, "d.png", match));
+	CHECK(match.Texture == 3 && match.Owner == "a.png");
+	CHECK(table.Find(8, match) && match.Texture == 0 && match.Owner == "c.png");
+}
+
+DXPG_TEST(TextureSharing, ReleasedContentLoadsAgain)
+{
+	TextureContentTable table;
+	TextureContentTable::Match match;
+	CHECK(!table.Claim(7, "a.png", match));
+	table.Release(7);
+	CHECK(!table.Find(7, match));
+	CHECK(!table.Claim(7, "b.png", match));
+	table.Publish(7, 5);
+	CHECK(table.Claim(7, "a.png", match) && match.Texture == 5 && match.Owner == "b.png");
+}
\ No newline at end of file
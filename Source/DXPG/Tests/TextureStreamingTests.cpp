@@ -0,0 +1,165 @@
+#include "TestFramework.h"
+
+#include "TextureStreaming.h"
+
+#include <numeric>
+
+using namespace dxpg;
+
+namespace
+{
+
+// RGBA8 levels of a square texture, finest first
+std::vector<uint64_t> SquareLevels(uint32_t size)
+{
+	std::vector<uint64_t> levels;
+	for (uint32_t level = size; level > 0; level /= 2)
+		levels.push_back(uint64_t(level) * level * 4);
+	return levels;
+}
+
+uint64_t Sum(std::vector<uint64_t> const& levels, uint32_t begin, uint32_t end)
+{
+	return std::accumulate(levels.begin() + begin, levels.begin() + end, uint64_t(0));
+}
+
+TextureStreamingAction const* FindAction(std::vector<TextureStreamingAction> const& actions, uint32_t texture)
+{
+	for (auto& action : actions)
+	{
+		if (action.Texture == texture)
+			return &action;
+	}
+	return nullptr;
+}
+
+}
+
+DXPG_TEST(TextureStreaming, MapsScreenSizeToLevels)
+{
+	CHECK(DesiredMipLevel(1024, 512, 11, 1024.0f, 0.0f) == 0);
+	CHECK(DesiredMipLevel(1024, 512, 11, 256.0f, 0.0f) == 2);
+	CHECK(DesiredMipLevel(1024, 512, 11, 100.0f, 0.0f) == 3);
+	// The bias asks for a finer level
+	CHECK(DesiredMipLevel(1024, 512, 11, 100.0f, -1.0f) == 2);
+	// Off screen takes the coarsest, magnified the finest
+	CHECK(DesiredMipLevel(1024, 512, 11, 0.0f, 0.0f) == 10);
+	CHECK(DesiredMipLevel(1024, 512, 11, 1.0f, 0.0f) == 10);
+	CHECK(DesiredMipLevel(1024, 512, 11, 8192.0f, -1.0f) == 0);
+
+	CHECK(ResidentMipLevel(1024, 512, 11, 64) == 4);
+	CHECK(ResidentMipLevel(512, 1024, 11, 64) == 4);
+	CHECK(ResidentMipLevel(64, 64, 7, 64) == 0);
+	CHECK(ResidentMipLevel(1024, 1024, 11, 0) == 10);
+	// A chain cut short keeps its last level
+	CHECK(ResidentMipLevel(1024, 1024, 3, 64) == 2);
+}
+
+DXPG_TEST(TextureStreaming, UploadsCoarsestFirstWithinTheFrameAllowance)
+{
+	auto levels = SquareLevels(1024);
+	TextureStreamer streamer;
+	streamer.Settings.MipBias = 0.0f;
+	streamer.Settings.UploadBytesPerFrame = levels[3] + levels[2];
+	uint32_t texture = streamer.Add(1024, 1024, levels);
+	CHECK(streamer.GetAllocatedTop(texture) == 4 && streamer.GetResidentTop(texture) == 4);
+
+	std::vector<TextureStreamingAction> actions;
+	streamer.Request(texture, 1024.0f);
+	streamer.Update(actions);
+	CHECK(actions.size() == 1);
+	CHECK(actions[0].OldTop == 4 && actions[0].NewTop == 0);
+	CHECK(actions[0].UploadBegin == 2 && actions[0].UploadEnd == 4 && actions[0].ResidentTop == 2);
+	CHECK(streamer.GetAllocatedTop(texture) == 0 && streamer.GetResidentTop(texture) == 2);
+
+	// Larger than the allowance, the first level of a frame still goes through
+	streamer.Request(texture, 1024.0f);
+	streamer.Update(actions);
+	CHECK(actions.size() == 1);
+	CHECK(actions[0].OldTop == 0 && actions[0].NewTop == 0);
+	CHECK(actions[0].UploadBegin == 1 && actions[0].UploadEnd == 2);
+	streamer.Request(texture, 1024.0f);
+	streamer.Update(actions);
+	CHECK(actions.size() == 1 && actions[0].UploadBegin == 0 && actions[0].ResidentTop == 0);
+	streamer.Request(texture, 1024.0f);
+	streamer.Update(actions);
+	CHECK(actions.empty());
+	CHECK(streamer.GetStats().UploadedBytes == Sum(levels, 0, 4));
+	CHECK(streamer.GetStats().Grown == 1);
+}
+
+DXPG_TEST(TextureStreaming, EvictsTheLeastRecentlyUsedLevels)
+{
+	auto levels = SquareLevels(256);
+	uint64_t base = Sum(levels, 2, uint32_t(levels.size()));
+	uint64_t grown = levels[0] + levels[1];
+	TextureStreamer streamer;
+	streamer.Settings.MipBias = 0.0f;
+	streamer.Settings.UploadBytesPerFrame = uint64_t(1) << 30;
+	streamer.Settings.BudgetBytes = 3 * base + 2 * grown;
+	uint32_t a = streamer.Add(256, 256, levels);
+	uint32_t b = streamer.Add(256, 256, levels);
+	uint32_t c = streamer.Add(256, 256, levels);
+	CHECK(streamer.GetAllocatedTop(a) == 2);
+
+	std::vector<TextureStreamingAction> actions;
+	streamer.Request(a, 256.0f);
+	streamer.Update(actions);
+	streamer.Request(b, 256.0f);
+	streamer.Update(actions);
+	CHECK(streamer.GetAllocatedTop(a) == 0 && streamer.GetAllocatedTop(b) == 0);
+	CHECK(streamer.GetStats().AllocatedBytes == streamer.Settings.BudgetBytes);
+
+	// Full, a was used longest ago and gives its levels to c
+	streamer.Request(c, 256.0f);
+	streamer.Update(actions);
+	CHECK(streamer.GetAllocatedTop(a) == 2 && streamer.GetResidentTop(a) == 2);
+	CHECK(streamer.GetAllocatedTop(b) == 0);
+	CHECK(streamer.GetAllocatedTop(c) == 0);
+	auto* evicted = FindAction(actions, a);
+	CHECK(evicted && evicted->OldTop == 0 && evicted->NewTop == 2 && evicted->CopyBegin == 2 && evicted->UploadBegin == evicted->UploadEnd);
+	CHECK(!FindAction(actions, b));
+	CHECK(streamer.GetStats().Evicted == 1);
+	CHECK(streamer.GetStats().AllocatedBytes <= streamer.Settings.BudgetBytes);
+
+	// Textures used this frame keep what they asked for, b goes although it is newer than c
+	streamer.Request(a, 256.0f);
+	streamer.Request(c, 256.0f);
+	streamer.Update(actions);
+	CHECK(streamer.GetAllocatedTop(a) == 0 && streamer.GetAllocatedTop(c) == 0);
+	CHECK(streamer.GetAllocatedTop(b) == 2);
+
+	// A shrunk budget evicts as well, without anything asking to grow
+	streamer.Settings.BudgetBytes = 3 * base + grown;
+	streamer.Update(actions);
+	CHECK(streamer.GetAllocatedTop(a) == 2 && streamer.GetAllocatedTop(c) == 0);
+	CHECK(streamer.GetStats().AllocatedBytes <= streamer.Settings.BudgetBytes);
+}
+
+DXPG_TEST(TextureStreaming, SettlesForACoarserLevelThatFits)
+{
+	auto levels = SquareLevels(256);
+	uint64_t base = Sum(levels, 2, uint32_t(levels.size()));
+	TextureStreamer streamer;
+	streamer.Settings.MipBias = 0.0f;
+	streamer.Settings.UploadBytesPerFrame = uint64_t(1) << 30;
+	// Level 1 fits, level 0 on top of it does not
+	streamer.Settings.BudgetBytes = base + levels[1] + levels[0] / 2;
+	uint32_t texture = streamer.Add(256, 256, levels);
+
+	std::vector<TextureStreamingAction> actions;
+	streamer.Request(texture, 256.0f);
+	streamer.Update(actions);
+	CHECK(actions.size() == 1 && actions[0].NewTop == 1 && actions[0].ResidentTop == 1);
+	CHECK(streamer.GetAllocatedTop(texture) == 1);
+
+	// Nothing fits, the texture stays at its base levels
+	TextureStreamer full;
+	full.Settings = streamer.Settings;
+	full.Settings.BudgetBytes = base;
+	texture = full.Add(256, 256, levels);
+	full.Request(texture, 256.0f);
+	full.Update(actions);
+	CHECK(actions.empty() && full.GetAllocatedTop(texture) == 2);
+	CHECK(full.GetStats().WantedBytes == Sum(levels, 0, uint32_t(levels.size())));
+}
\ No newline at end of file
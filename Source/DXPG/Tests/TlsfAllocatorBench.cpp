@@ -0,0 +1,59 @@
+#include "TestFramework.h"
+
+#include "TlsfAllocator.h"
+
+#include <iostream>
+#include <random>
+
+using namespace dxpg;
+
+DXPG_BENCHMARK(TlsfAllocator)
+{
+	// Shape sized allocations in a pool that stays about half full, like geometry streaming in and out
+	uint32_t const operations = context.Size(10000000u, 200000u);
+	TlsfAllocator allocator(1u << 28);
+	std::vector<TlsfAllocator::Allocation> live;
+	std::vector<uint32_t> sizes(1 << 16);
+	std::vector<uint32_t> choices(1 << 16);
+	std::mt19937 random(3);
+	std::lognormal_distribution<float> size(9.0f, 1.5f);
+	for (size_t i = 0; i < sizes.size(); ++i)
+	{
+		sizes[i] = std::max(1u, std::min(uint32_t(size(random)), 1u << 22));
+		choices[i] = random();
+	}
+
+	uint32_t failed = 0;
+	uint64_t usedUnits = 0;
+	double milliseconds = test::TimeMilliseconds([&]()
+	{
+		for (uint32_t i = 0; i < operations; ++i)
+		{
+			uint32_t choice = choices[i & 0xFFFF];
+			if (live.empty() || usedUnits < allocator.Size() / 2 ? choice % 4 != 0 : choice % 4 == 0)
+			{
+				uint32_t allocationSize = sizes[(i * 7) & 0xFFFF];
+				auto allocation = allocator.Allocate(allocationSize);
+				if (allocation.IsValid())
+				{
+					live.push_back(allocation);
+					usedUnits += allocationSize;
+				}
+				else
+					failed++;
+			}
+			else
+			{
+				size_t index = choice % live.size();
+				usedUnits -= allocator.AllocationSize(live[index]);
+				allocator.Free(live[index]);
+				live[index] = live.back();
+				live.pop_back();
+			}
+		}
+	});
+	auto stats = allocator.GetStats();
+	CHECK(stats.Allocations == live.size());
+	std::cout << operations << " operations in " << milliseconds << " ms, " << milliseconds * 1e6 / operations << " ns each, " << live.size() << " live, "
+		<< failed << " failed, " << stats.FreeRegions << " free regions, fragmentation " << stats.Fragmentation() << std::endl;
+}
\ No newline at end of file
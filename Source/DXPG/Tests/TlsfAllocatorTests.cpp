@@ -0,0 +1,137 @@
+#include "TestFramework.h"
+
+#include "TlsfAllocator.h"
+
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Free units, regions and the largest region straight from an occupancy map
+TlsfAllocator::Stats ReferenceStats(std::vector<bool> const& used)
+{
+	TlsfAllocator::Stats stats;
+	stats.Size = uint32_t(used.size());
+	uint32_t run = 0;
+	for (size_t i = 0; i <= used.size(); ++i)
+	{
+		if (i < used.size() && !used[i])
+		{
+			run++;
+			continue;
+		}
+		if (run)
+		{
+			stats.FreeUnits += run;
+			stats.FreeRegions++;
+			stats.LargestFreeRegion = std::max(stats.LargestFreeRegion, run);
+		}
+		run = 0;
+	}
+	return stats;
+}
+
+}
+
+DXPG_TEST(TlsfAllocator, AllocatesTheWholeRange)
+{
+	TlsfAllocator allocator(1000);
+	CHECK(!allocator.Allocate(0).IsValid());
+	CHECK(!allocator.Allocate(1001).IsValid());
+	auto all = allocator.Allocate(1000);
+	CHECK(all.IsValid() && all.Offset == 0 && allocator.AllocationSize(all) == 1000);
+	CHECK(!allocator.Allocate(1).IsValid());
+	auto stats = allocator.GetStats();
+	CHECK(stats.FreeUnits == 0 && stats.FreeRegions == 0 && stats.Allocations == 1 && stats.Fragmentation() == 0.0f);
+
+	allocator.Free(all);
+	stats = allocator.GetStats();
+	CHECK(stats.FreeUnits == 1000 && stats.FreeRegions == 1 && stats.LargestFreeRegion == 1000 && stats.Allocations == 0);
+	CHECK(allocator.Allocate(1000).IsValid());
+
+	allocator.Reset(64);
+	CHECK(allocator.Size() == 64 && allocator.GetStats().FreeUnits == 64);
+}
+
+DXPG_TEST(TlsfAllocator, FreedNeighboursMerge)
+{
+	TlsfAllocator allocator(300);
+	auto a = allocator.Allocate(100);
+	auto b = allocator.Allocate(100);
+	auto c = allocator.Allocate(100);
+	CHECK(a.Offset == 0 && b.Offset == 100 && c.Offset == 200);
+
+	allocator.Free(a);
+	allocator.Free(c);
+	auto stats = allocator.GetStats();
+	CHECK(stats.FreeRegions == 2 && stats.LargestFreeRegion == 100 && stats.FreeUnits == 200);
+	CHECK_NEAR(stats.Fragmentation(), 0.5f, 1e-6f);
+	// 150 free units, but no region holds them
+	CHECK(!allocator.Allocate(150).IsValid());
+
+	allocator.Free(b);
+	stats = allocator.GetStats();
+	CHECK(stats.FreeRegions == 1 && stats.LargestFreeRegion == 300);
+	auto whole = allocator.Allocate(300);
+	CHECK(whole.IsValid() && whole.Offset == 0);
+}
+
+DXPG_TEST(TlsfAllocator, RandomChurnMatchesAnOccupancyMap)
+{
+	constexpr uint32_t Size = 1 << 16;
+	TlsfAllocator allocator(Size);
+	std::vector<bool> used(Size, false);
+	std::vector<TlsfAllocator::Allocation> live;
+	std::mt19937 random(21);
+	std::geometric_distribution<uint32_t> smallSize(0.01);
+
+	for (uint32_t step = 0; step < 20000; ++step)
+	{
+		bool allocate = live.empty() || random() % 100 < 55;
+		if (allocate)
+		{
+			uint32_t size = 1 + (random() % 16 == 0 ? random() % 8192 : smallSize(random));
+			uint32_t largest = allocator.GetStats().LargestFreeRegion;
+			auto allocation = allocator.Allocate(size);
+			// Good fit: every size up to the largest free region has to succeed
+			CHECK(allocation.IsValid() == (size <= largest));
+			if (!allocation.IsValid())
+				continue;
+			CHECK(allocator.AllocationSize(allocation) == size);
+			CHECK(allocation.Offset + size <= Size);
+			for (uint32_t i = allocation.Offset; i < allocation.Offset + size; ++i)
+			{
+				CHECK(!used[i]);
+				used[i] = true;
+			}
+			live.push_back(allocation);
+		}
+		else
+		{
+			size_t index = random() % live.size();
+			auto allocation = live[index];
+			for (uint32_t i = allocation.Offset; i < allocation.Offset + allocator.AllocationSize(allocation); ++i)
+				used[i] = false;
+			allocator.Free(allocation);
+			live[index] = live.back();
+			live.pop_back();
+		}
+
+		if (step % 500 == 0)
+		{
+			auto stats = allocator.GetStats();
+			auto expected = ReferenceStats(used);
+			CHECK(stats.FreeUnits == expected.FreeUnits);
+			CHECK(stats.FreeRegions == expected.FreeRegions);
+			CHECK(stats.LargestFreeRegion == expected.LargestFreeRegion);
+			CHECK(stats.Allocations == live.size());
+		}
+	}
+
+	for (auto& allocation : live)
+		allocator.Free(allocation);
+	auto stats = allocator.GetStats();
+	CHECK(stats.FreeRegions == 1 && stats.FreeUnits == Size && stats.Fragmentation() == 0.0f);
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "TestFramework.h"
+
+#include "TransformHierarchy.h"
+
+#include <iostream>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Random tree in topological order, every node hangs below one of the nodes added before it
+void BuildHierarchy(TransformHierarchy& hierarchy, uint32_t nodeCount, std::mt19937& random)
+{
+	std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	hierarchy.AddNode(TransformHierarchy::InvalidNode, XMVectorSet(0, 0, 0, 1), XMVectorZero(), XMVectorSet(1, 1, 1, 0));
+	for (uint32_t i = 1; i < nodeCount; ++i)
+	{
+		// Shallow and wide like a loaded level, parents are picked among the first sixteenth of the nodes
+		uint32_t parent = std::uniform_int_distribution<uint32_t>(0, (i - 1) / 16)(random);
+		hierarchy.AddNode(parent, XMVectorSet(offset(random), offset(random), offset(random), 1), XMVectorSet(angle(random), angle(random), 0, 0), XMVectorSet(1, 1, 1, 0));
+	}
+}
+
+// What the scene walk did every frame before the hierarchy: compose every local matrix and multiply it with its parent
+double FullRecompute(TransformHierarchy& hierarchy)
+{
+	return test::TimeMilliseconds([&]()
+	{
+		for (size_t node = 0; node < hierarchy.Size(); ++node)
+		{
+			Matrix4x4 local = ComposeLocalMatrix(hierarchy.Positions[node], hierarchy.Rotations[node], hierarchy.Scales[node]);
+			auto parent = hierarchy.Parents[node];
+			hierarchy.WorldMatrices[node] = parent == TransformHierarchy::InvalidNode ? local : XMMatrixMultiply(hierarchy.WorldMatrices[parent], local);
+		}
+	});
+}
+
+}
+
+DXPG_BENCHMARK(TransformHierarchy)
+{
+	std::vector<uint32_t> sizes = context.Quick ? std::vector<uint32_t>{ 10000 } : std::vector<uint32_t>{ 10000, 100000, 1000000 };
+	for (uint32_t nodeCount : sizes)
+	{
+		std::mt19937 random(nodeCount);
+		TransformHierarchy hierarchy;
+		BuildHierarchy(hierarchy, nodeCount, random);
+		double first = test::TimeMilliseconds([&]() { hierarchy.Update(); });
+		double full = FullRecompute(hierarchy);
+		double clean = test::TimeMilliseconds([&]() { CHECK(hierarchy.Update().empty()); });
+
+		hierarchy.MarkDirty(nodeCount - 1);
+		double leaf = test::TimeMilliseconds([&]() { CHECK(hierarchy.Update().size() == 1); });
+
+		// One percent of the nodes animated, scattered over the whole tree
+		std::uniform_int_distribution<uint32_t> anyNode(0, nodeCount - 1);
+		for (uint32_t i = 0; i < nodeCount / 100; ++i)
+			hierarchy.MarkDirty(anyNode(random));
+		size_t changed = 0;
+		double scattered = test::TimeMilliseconds([&]() { changed = hierarchy.Update().size(); });
+
+		std::cout << nodeCount << " nodes: full walk " << full << " ms, first update " << first << " ms, static " << clean << " ms, one leaf " << leaf
+			<< " ms, 1% dirty " << scattered << " ms (" << changed << " recomputed)" << std::endl;
+	}
+}
+
+// Progressive loading appends a few nodes per frame, only the new nodes may be recomputed
+DXPG_BENCHMARK(TransformHierarchyAppend)
+{
+	uint32_t const nodeCount = context.Size(100000u, 10000u);
+	uint32_t const nodesPerFrame = 16;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+
+	TransformHierarchy hierarchy;
+	auto root = hierarchy.AddNode(TransformHierarchy::InvalidNode, XMVectorSet(0, 0, 0, 1), XMVectorZero(), XMVectorSet(1, 1, 1, 0));
+	size_t recomputed = 0;
+	double incremental = test::TimeMilliseconds([&]()
+	{
+		while (hierarchy.Size() < nodeCount)
+		{
+			for (uint32_t i = 0; i < nodesPerFrame; ++i)
+				hierarchy.AddNode(root, XMVectorSet(offset(random), offset(random), offset(random), 1), XMVectorZero(), XMVectorSet(1, 1, 1, 0));
+			recomputed += hierarchy.Update().size();
+		}
+	});
+	CHECK(recomputed == hierarchy.Size());
+
+	// Recomputing everything whenever the structure changes walks half of the final hierarchy per frame on average
+	uint32_t frames = (nodeCount + nodesPerFrame - 1) / nodesPerFrame;
+	double rebuild = FullRecompute(hierarchy) * frames / 2;
+
+	std::cout << nodeCount << " nodes in frames of " << nodesPerFrame << ": incremental " << incremental << " ms, rebuilding every frame ~" << rebuild << " ms" << std::endl;
+}
\ No newline at end of file
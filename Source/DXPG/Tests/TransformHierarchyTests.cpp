@@ -0,0 +1,168 @@
+#include "TestFramework.h"
+
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+
+using namespace dxpg;
+
+namespace
+{
+
+bool MatricesNear(Matrix4x4 const& a, Matrix4x4 const& b, float epsilon = 1e-4f)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		if (!XMVector4NearEqual(a.r[row], b.r[row], XMVectorReplicate(epsilon)))
+			return false;
+	}
+	return true;
+}
+
+Vector4 Translation(float x, float y, float z)
+{
+	return XMVectorSet(x, y, z, 1);
+}
+
+Vector4 const NoRotation = XMVectorZero();
+Vector4 const UnitScale = XMVectorSet(1, 1, 1, 0);
+
+bool Contains(std::span<TransformHierarchy::NodeId const> nodes, TransformHierarchy::NodeId node)
+{
+	return std::find(nodes.begin(), nodes.end(), node) != nodes.end();
+}
+
+}
+
+DXPG_TEST(TransformHierarchy, WorldMatricesComposeLocalThenParent)
+{
+	TransformHierarchy hierarchy;
+	auto root = hierarchy.AddNode(TransformHierarchy::InvalidNode, Translation(1, 0, 0), NoRotation, UnitScale);
+	auto child = hierarchy.AddNode(root, Translation(0, 2, 0), XMVectorSet(0.3f, 1.1f, -0.4f, 0), XMVectorSet(2, 2, 2, 0));
+	auto grandChild = hierarchy.AddNode(child, Translation(0, 0, 3), NoRotation, UnitScale);
+	auto changed = hierarchy.Update();
+	CHECK(changed.size() == 3);
+
+	Matrix4x4 rootLocal = ComposeLocalMatrix(hierarchy.Positions[root], hierarchy.Rotations[root], hierarchy.Scales[root]);
+	Matrix4x4 childLocal = ComposeLocalMatrix(hierarchy.Positions[child], hierarchy.Rotations[child], hierarchy.Scales[child]);
+	Matrix4x4 grandChildLocal = ComposeLocalMatrix(hierarchy.Positions[grandChild], hierarchy.Rotations[grandChild], hierarchy.Scales[grandChild]);
+	CHECK(MatricesNear(hierarchy.GetWorldMatrix(root), rootLocal));
+	// Row vectors, the child's local transform applies first
+	CHECK(MatricesNear(hierarchy.GetWorldMatrix(child), XMMatrixMultiply(childLocal, rootLocal)));
+	CHECK(MatricesNear(hierarchy.GetWorldMatrix(grandChild), XMMatrixMultiply(grandChildLocal, XMMatrixMultiply(childLocal, rootLocal))));
+	CHECK(!hierarchy.HasDirtyNodes());
+}
+
+DXPG_TEST(TransformHierarchy, ParentRotatesAndScalesChildOffsets)
+{
+	// Parent at (5, 0, 0), turned a quarter about y and scaled by 2, child one unit along its parent's x
+	Vector4 position, rotation, scale;
+	Vector4 quarterTurn = XMQuaternionRotationAxis(XMVectorSet(0, 1, 0, 0), XM_PIDIV2);
+	LocalTransformFromQuaternion(XMVectorSet(5, 0, 0, 0), quarterTurn, XMVectorSet(2, 2, 2, 0), position, rotation, scale);
+	TransformHierarchy hierarchy;
+	auto parent = hierarchy.AddNode(TransformHierarchy::InvalidNode, position, rotation, scale);
+	auto child = hierarchy.AddNode(parent, Translation(1, 0, 0), NoRotation, UnitScale);
+	hierarchy.Update();
+
+	// A quarter turn about y takes x to -z in a left handed frame
+	Vector4 expected = XMVectorSet(5, 0, -2, 1);
+	Vector4 childOrigin = XMVector3Transform(XMVectorZero(), hierarchy.GetWorldMatrix(child));
+	CHECK(XMVector4NearEqual(childOrigin, expected, XMVectorReplicate(1e-4f)));
+	Vector4 rotatedOffset = XMVectorAdd(XMVectorSet(5, 0, 0, 1), XMVector3Rotate(XMVectorSet(2, 0, 0, 0), quarterTurn));
+	CHECK(XMVector4NearEqual(childOrigin, rotatedOffset, XMVectorReplicate(1e-4f)));
+}
+
+DXPG_TEST(TransformHierarchy, CleanUpdateChangesNothing)
+{
+	TransformHierarchy hierarchy;
+	auto root = hierarchy.AddNode(TransformHierarchy::InvalidNode, Translation(0, 0, 0), NoRotation, UnitScale);
+	hierarchy.AddNode(root, Translation(1, 0, 0), NoRotation, UnitScale);
+	hierarchy.Update();
+	CHECK(hierarchy.Update().empty());
+}
+
+DXPG_TEST(TransformHierarchy, DirtyNodeUpdatesOnlyItsSubtree)
+{
+	//        0
+	//      /   \
+	//     1     4
+	//    / \     \
+	//   2   3     5
+	TransformHierarchy hierarchy;
+	auto n0 = hierarchy.AddNode(TransformHierarchy::InvalidNode, Translation(0, 0, 0), NoRotation, UnitScale);
+	auto n1 = hierarchy.AddNode(n0, Translation(1, 0, 0), NoRotation, UnitScale);
+	auto n2 = hierarchy.AddNode(n1, Translation(0, 1, 0), NoRotation, UnitScale);
+	auto n3 = hierarchy.AddNode(n1, Translation(0, 0, 1), NoRotation, UnitScale);
+	auto n4 = hierarchy.AddNode(n0, Translation(-1, 0, 0), NoRotation, UnitScale);
+	auto n5 = hierarchy.AddNode(n4, Translation(0, -1, 0), NoRotation, UnitScale);
+	hierarchy.Update();
+	Matrix4x4 before5 = hierarchy.GetWorldMatrix(n5);
+
+	hierarchy.SetLocalTransform(n1, Translation(5, 0, 0), NoRotation, UnitScale);
+	CHECK(hierarchy.HasDirtyNodes());
+	auto changed = hierarchy.Update();
+	CHECK(changed.size() == 3);
+	CHECK(Contains(changed, n1) && Contains(changed, n2) && Contains(changed, n3));
+	CHECK(!Contains(changed, n0) && !Contains(changed, n4) && !Contains(changed, n5));
+	CHECK(MatricesNear(hierarchy.GetWorldMatrix(n5), before5));
+	CHECK_NEAR(XMVectorGetX(hierarchy.GetWorldMatrix(n2).r[3]), 5.0f, 1e-5f);
+	CHECK_NEAR(XMVectorGetY(hierarchy.GetWorldMatrix(n2).r[3]), 1.0f, 1e-5f);
+	CHECK_NEAR(XMVectorGetZ(hierarchy.GetWorldMatrix(n3).r[3]), 1.0f, 1e-5f);
+
+	// Moving the root reaches every node
+	hierarchy.SetLocalTransform(n0, Translation(0, 10, 0), NoRotation, UnitScale);
+	CHECK(hierarchy.Update().size() == 6);
+	CHECK_NEAR(XMVectorGetY(hierarchy.GetWorldMatrix(n5).r[3]), 9.0f, 1e-5f);
+
+	// A leaf only changes itself
+	hierarchy.MarkDirty(n5);
+	changed = hierarchy.Update();
+	CHECK(changed.size() == 1 && changed[0] == n5);
+}
+
+DXPG_TEST(TransformHierarchy, AppendedNodesDoNotTouchExistingOnes)
+{
+	TransformHierarchy hierarchy;
+	auto root = hierarchy.AddNode(TransformHierarchy::InvalidNode, Translation(0, 0, 0), NoRotation, UnitScale);
+	for (int i = 0; i < 100; ++i)
+		hierarchy.AddNode(root, Translation(float(i), 0, 0), NoRotation, UnitScale);
+	hierarchy.Update();
+
+	auto added = hierarchy.AddNode(root, Translation(0, 0, 7), NoRotation, UnitScale);
+	auto addedChild = hierarchy.AddNode(added, Translation(0, 0, 1), NoRotation, UnitScale);
+	auto changed = hierarchy.Update();
+	CHECK(changed.size() == 2);
+	CHECK(Contains(changed, added) && Contains(changed, addedChild));
+	CHECK_NEAR(XMVectorGetZ(hierarchy.GetWorldMatrix(addedChild).r[3]), 8.0f, 1e-5f);
+}
+
+DXPG_TEST(TransformHierarchy, ClearRemovesEveryNode)
+{
+	TransformHierarchy hierarchy;
+	auto root = hierarchy.AddNode(TransformHierarchy::InvalidNode, Translation(0, 0, 0), NoRotation, UnitScale);
+	hierarchy.AddNode(root, Translation(1, 0, 0), NoRotation, UnitScale);
+	hierarchy.Clear();
+	CHECK(hierarchy.Size() == 0);
+	CHECK(!hierarchy.HasDirtyNodes());
+	CHECK(hierarchy.Update().empty());
+}
+
+DXPG_TEST(TransformHierarchy, LocalTransformFromQuaternionMatchesAffineTransform)
+{
+	Vector4 rotations[] = {
+		XMQuaternionIdentity(),
+		XMQuaternionRotationRollPitchYaw(0.2f, -1.3f, 0.7f),
+		XMQuaternionRotationAxis(XMVectorSet(1, 1, 0, 0), 2.5f),
+		// Gimbal lock, pitch of 90 degrees
+		XMQuaternionRotationRollPitchYaw(XM_PIDIV2, 0.4f, 0.0f),
+	};
+	Vector4 translation = XMVectorSet(3, -2, 5, 0);
+	Vector4 scale = XMVectorSet(2, 0.5f, 1.5f, 0);
+	for (Vector4 rotation : rotations)
+	{
+		Vector4 position, eulerAngles, outScale;
+		LocalTransformFromQuaternion(translation, rotation, scale, position, eulerAngles, outScale);
+		Matrix4x4 expected = XMMatrixAffineTransformation(scale, XMVectorZero(), rotation, translation);
+		CHECK(MatricesNear(ComposeLocalMatrix(position, eulerAngles, outScale), expected, 1e-3f));
+	}
+}
\ No newline at end of file
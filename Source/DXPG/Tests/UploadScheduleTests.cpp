@@ -0,0 +1,119 @@
+#include "TestFramework.h"
+
+#include "UploadSchedule.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+// Stands in for a copy queue and its fence: executed batches complete in order whenever the test lets them
+struct MockQueue
+{
+	uint64_t Signaled = 0;
+	uint64_t Completed = 0;
+
+	void Execute(uint64_t value)
+	{
+		CHECK(value == Signaled + 1);
+		Signaled = value;
+	}
+	void Advance(uint64_t count) { Completed = std::min(Signaled, Completed + count); }
+};
+
+// A consuming queue, it records the highest value it was told to wait for
+struct MockConsumer
+{
+	uint64_t Waited = 0;
+
+	void Wait(MockQueue const& producer, uint64_t value)
+	{
+		// Waiting for a signal that was never enqueued would hang the GPU
+		CHECK(value <= producer.Signaled);
+		Waited = std::max(Waited, value);
+	}
+};
+
+}
+
+DXPG_TEST(UploadSchedule, AcquiresFreeContextsThenTheOldest)
+{
+	UploadSchedule schedule;
+	schedule.Init(2);
+	uint64_t waitValue = 99;
+	CHECK(schedule.Acquire(waitValue) == 0 && waitValue == 0);
+	CHECK(schedule.Submit(0) == 1);
+	CHECK(schedule.Acquire(waitValue) == 1 && waitValue == 0);
+	CHECK(schedule.Submit(1) == 2);
+	// Both in flight, the first one submitted is reused once it completed
+	CHECK(schedule.Acquire(waitValue) == 0 && waitValue == 1);
+	CHECK(!schedule.Retire(0, 0));
+	CHECK(!schedule.Retire(1, 1));
+	CHECK(schedule.Retire(0, 1));
+	CHECK(!schedule.Retire(0, 1));
+	CHECK(schedule.Acquire(waitValue) == 0 && waitValue == 0);
+	CHECK(schedule.Submit(0) == 3);
+	CHECK(schedule.Acquire(waitValue) == 1 && waitValue == 2);
+	CHECK(schedule.LastSubmitted() == 3);
+}
+
+DXPG_TEST(UploadSchedule, ConsumerWaitsOnlyWhenNeeded)
+{
+	UploadSchedule schedule;
+	schedule.Init(2);
+	schedule.Submit(0);
+	schedule.Submit(1);
+	CHECK(!schedule.IsPending(2) && schedule.IsPending(3));
+	// Nothing uploaded needs no wait
+	CHECK(schedule.ConsumerWait(0, 0) == 0);
+	CHECK(schedule.ConsumerWait(1, 0) == 1);
+	// Covered by the wait enqueued before
+	CHECK(schedule.ConsumerWait(1, 0) == 0);
+	CHECK(schedule.ConsumerWait(2, 0) == 2);
+	CHECK(schedule.LastWaited() == 2);
+	CHECK(schedule.Retire(0, 2) && schedule.Retire(1, 2));
+	schedule.Submit(0);
+	// Completed already, no GPU wait at all
+	CHECK(schedule.ConsumerWait(3, 3) == 0);
+	CHECK(schedule.LastWaited() == 3);
+}
+
+DXPG_TEST(UploadSchedule, FramesNeverDrawUnfinishedUploads)
+{
+	// Loaders submit batches at random, the mock copy queue finishes them late, every frame draws a random earlier batch.
+	// The frame's work runs once its waits and the copies it needs completed, so the check is the wait covering the batch
+	UploadSchedule schedule;
+	schedule.Init(3);
+	MockQueue copies;
+	MockConsumer graphics;
+	std::mt19937 random(24);
+	uint32_t gpuWaits = 0;
+	for (uint32_t frame = 0; frame < 5000; ++frame)
+	{
+		for (uint32_t context = 0; context < 3; ++context)
+			schedule.Retire(context, copies.Completed);
+		if (random() % 3 != 0)
+		{
+			uint64_t waitValue = 0;
+			uint32_t context = schedule.Acquire(waitValue);
+			// The loader waits instead of blocking the frame loop when every context is busy
+			if (waitValue == 0)
+				copies.Execute(schedule.Submit(context));
+		}
+
+		uint64_t drawn = schedule.LastSubmitted() == 0 ? 0 : random() % (schedule.LastSubmitted() + 1);
+		CHECK(!schedule.IsPending(drawn));
+		if (uint64_t wait = schedule.ConsumerWait(drawn, copies.Completed))
+		{
+			graphics.Wait(copies, wait);
+			gpuWaits++;
+		}
+		CHECK(drawn <= copies.Completed || drawn <= graphics.Waited);
+		copies.Advance(random() % 2);
+	}
+	CHECK(gpuWaits > 0);
+	CHECK(schedule.LastSubmitted() > 1000);
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "TestFramework.h"
+
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace dxpg;
+
+namespace
+{
+
+// atan2 keeps its precision for tiny angles where acos of the dot product does not
+float AngleDegrees(Vector3 const& a, Vector3 const& b)
+{
+	Vector4 va = XMLoadFloat3(&a), vb = XMLoadFloat3(&b);
+	float sine = XMVectorGetX(XMVector3Length(XMVector3Cross(va, vb)));
+	return XMConvertToDegrees(std::atan2(sine, XMVectorGetX(XMVector3Dot(va, vb))));
+}
+
+Vector3 RandomUnit(std::mt19937& random)
+{
+	std::normal_distribution<float> gaussian;
+	Vector3 normal;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(gaussian(random), gaussian(random), gaussian(random), 0.0f)));
+	return normal;
+}
+
+}
+
+DXPG_TEST(VertexQuantization, NormalizedIntegersRoundTrip)
+{
+	for (uint32_t value = 0; value <= 0xFFFF; ++value)
+	{
+		CHECK(QuantizeUnorm16(DequantizeUnorm16(uint16_t(value))) == value);
+		int16_t snorm = int16_t(int32_t(value) - 32768);
+		if (snorm != -32768)
+			CHECK(QuantizeSnorm16(DequantizeSnorm16(snorm)) == snorm);
+	}
+	CHECK(QuantizeUnorm16(-1.0f) == 0 && QuantizeUnorm16(2.0f) == 0xFFFF);
+	CHECK(QuantizeSnorm16(-2.0f) == -32767 && QuantizeSnorm16(2.0f) == 32767);
+	CHECK(DequantizeSnorm16(-32768) == -1.0f);
+	CHECK(DequantizeUnorm16(0) == 0.0f && DequantizeUnorm16(0xFFFF) == 1.0f);
+}
+
+DXPG_TEST(VertexQuantization, OctahedralNormalsRoundTrip)
+{
+	// Axes, the fold diagonals and the equator are the edge cases of the mapping
+	std::vector<Vector3> normals = {
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+		{ 0.70710678f, 0.70710678f, 0 }, { -0.70710678f, 0, -0.70710678f }, { 0.57735027f, -0.57735027f, -0.57735027f },
+	};
+	std::mt19937 random(9);
+	for (uint32_t i = 0; i < 20000; ++i)
+		normals.push_back(RandomUnit(random));
+
+	float maxError = 0.0f;
+	for (auto& normal : normals)
+	{
+		Vector2 encoded = OctahedralEncode(normal);
+		CHECK(std::abs(encoded.x) <= 1.0f && std::abs(encoded.y) <= 1.0f);
+		CHECK(AngleDegrees(OctahedralDecode(encoded), normal) < 1e-3f);
+		Vector2 quantized(DequantizeSnorm16(QuantizeSnorm16(encoded.x)), DequantizeSnorm16(QuantizeSnorm16(encoded.y)));
+		maxError = std::max(maxError, AngleDegrees(OctahedralDecode(quantized), normal));
+	}
+	// 16-bit octahedral normals are good to a few thousandths of a degree
+	CHECK(maxError < 0.01f);
+	CHECK(OctahedralEncode(Vector3(0, 0, 0)).x == 0.0f);
+}
+
+DXPG_TEST(VertexQuantization, VerticesRoundTripWithinBounds)
+{
+	DirectX::BoundingBox bounds(Vector3(3.0f, -1.0f, 10.0f), Vector3(50.0f, 2.0f, 0.5f));
+	std::mt19937 random(4);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> uv(-4.0f, 4.0f);
+	std::vector<MeshVertex> vertices;
+	for (uint32_t i = 0; i < 5000; ++i)
+	{
+		Vector3 position(bounds.Center.x + unit(random) * bounds.Extents.x, bounds.Center.y + unit(random) * bounds.Extents.y, bounds.Center.z + unit(random) * bounds.Extents.z);
+		vertices.push_back({ position, RandomUnit(random), Vector2(uv(random), uv(random)) });
+	}
+
+	std::vector<QuantizedMeshVertex> quantized;
+	QuantizationError error;
+	QuantizeVertices(vertices, bounds, quantized, error);
+	CHECK(quantized.size() == vertices.size());
+
+	// Half a step on every axis
+	float stepX = 2.0f * bounds.Extents.x / 65535.0f, stepY = 2.0f * bounds.Extents.y / 65535.0f, stepZ = 2.0f * bounds.Extents.z / 65535.0f;
+	float positionBound = 0.5f * std::sqrt(stepX * stepX + stepY * stepY + stepZ * stepZ) * 1.01f;
+	CHECK(error.Position <= positionBound);
+	// The import report measures with acos, which alone is off by a few hundredths of a degree
+	CHECK(error.NormalDegrees < 0.05f);
+	// Halves keep 11 significant bits, UVs up to 4 are within 2^-10 relative
+	CHECK(error.TexCoord <= 4.0f / 2048.0f);
+
+	Matrix4x4 dequantize = PositionDequantizeMatrix(bounds);
+	for (size_t i = 0; i < vertices.size(); i += 97)
+	{
+		MeshVertex decoded = DequantizeVertex(quantized[i], bounds);
+		Vector4 unit = XMVectorSet(DequantizeUnorm16(quantized[i].Position[0]), DequantizeUnorm16(quantized[i].Position[1]), DequantizeUnorm16(quantized[i].Position[2]), 1.0f);
+		Vector4 shaderPosition = XMVector3Transform(unit, dequantize);
+		CHECK(XMVectorGetX(XMVector3Length(XMVectorSubtract(shaderPosition, XMLoadFloat3(&decoded.Position)))) < 1e-4f);
+	}
+}
+
+DXPG_TEST(VertexQuantization, FlatBoundsStayInvertible)
+{
+	// A plane has no extent along y, it decodes to the plane instead of dividing by zero
+	DirectX::BoundingBox bounds(Vector3(0.0f, 2.0f, 0.0f), Vector3(1.0f, 0.0f, 1.0f));
+	MeshVertex vertex{ Vector3(0.25f, 2.0f, -0.5f), Vector3(0, 1, 0), Vector2(0.5f, 0.5f) };
+	MeshVertex decoded = DequantizeVertex(QuantizeVertex(vertex, bounds), bounds);
+	CHECK_NEAR(decoded.Position.x, 0.25f, 1e-4f);
+	CHECK(decoded.Position.y == 2.0f);
+	CHECK_NEAR(decoded.Position.z, -0.5f, 1e-4f);
+	CHECK(AngleDegrees(decoded.Normal, vertex.Normal) < 0.01f);
+	CHECK(decoded.TexCoord.x == 0.5f && decoded.TexCoord.y == 0.5f);
+}
\ No newline at end of file
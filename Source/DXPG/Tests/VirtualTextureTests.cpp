@@ -0,0 +1,171 @@
+#include "TestFramework.h"
+
+#include "VirtualTexture.h"
+
+using namespace dxpg;
+
+namespace
+{
+
+// 1024x512 RGBA8 in 128x128 tiles: 8x4, 4x2, 2x1 and 1x1 tiles, the rest packed
+VirtualTextureLayout TestLayout()
+{
+	VirtualTextureLayout layout;
+	layout.Width = 1024;
+	layout.Height = 512;
+	layout.MipCount = 11;
+	layout.StandardLevels = 4;
+	StandardTileShape(4, 1, layout.TileWidth, layout.TileHeight);
+	return layout;
+}
+
+uint32_t Page(uint32_t texture, uint32_t level, uint32_t x, uint32_t y)
+{
+	return PackTilePage({ texture, level, x, y });
+}
+
+uint32_t CountOf(std::vector<TileRequest> const& requests, uint32_t page)
+{
+	for (auto& request : requests)
+		if (request.Page == page)
+			return request.Count;
+	return 0;
+}
+
+}
+
+DXPG_TEST(VirtualTexture, TileShapesCover64KB)
+{
+	uint32_t width, height;
+	StandardTileShape(4, 1, width, height);
+	CHECK(width == 128 && height == 128);
+	StandardTileShape(1, 1, width, height);
+	CHECK(width == 256 && height == 256);
+	StandardTileShape(8, 1, width, height);
+	CHECK(width == 128 && height == 64);
+	// BC1 blocks of 8 bytes cover 4x4 texels, BC7 blocks 16 bytes
+	StandardTileShape(8, 4, width, height);
+	CHECK(width == 512 && height == 256);
+	StandardTileShape(16, 4, width, height);
+	CHECK(width == 256 && height == 256);
+}
+
+DXPG_TEST(VirtualTexture, PagesPackLikeTheShader)
+{
+	TilePage page{ MaxVirtualTextures - 1, MaxVirtualTileLevels - 1, MaxVirtualTilesPerSide - 1, 17 };
+	uint32_t packed = PackTilePage(page);
+	CHECK(packed != EmptyTilePage);
+	TilePage unpacked = UnpackTilePage(packed);
+	CHECK(unpacked.Texture == page.Texture && unpacked.Level == page.Level && unpacked.X == page.X && unpacked.Y == page.Y);
+	CHECK(Page(1, 2, 3, 4) == (1u << 20 | 2u << 16 | 4u << 8 | 3u));
+}
+
+DXPG_TEST(VirtualTexture, LayoutGridAndParents)
+{
+	auto layout = TestLayout();
+	CHECK(IsVirtualTextureLayoutValid(layout));
+	CHECK(layout.TilesWide(0) == 8 && layout.TilesHigh(0) == 4);
+	CHECK(layout.TilesWide(3) == 1 && layout.TilesHigh(3) == 1);
+	CHECK(layout.Contains({ 0, 0, 7, 3 }));
+	CHECK(!layout.Contains({ 0, 0, 8, 0 }));
+	CHECK(!layout.Contains({ 0, 4, 0, 0 }));
+	TilePage parent = layout.Parent({ 0, 0, 5, 3 });
+	CHECK(parent.Level == 1 && parent.X == 2 && parent.Y == 1);
+	// Odd sizes clamp to the last tile of the coarser level
+	parent = layout.Parent({ 0, 2, 1, 0 });
+	CHECK(parent.Level == 3 && parent.X == 0 && parent.Y == 0);
+
+	auto tooLarge = layout;
+	tooLarge.Width = tooLarge.TileWidth * (MaxVirtualTilesPerSide + 1);
+	CHECK(!IsVirtualTextureLayoutValid(tooLarge));
+	auto noTiles = layout;
+	noTiles.StandardLevels = 0;
+	CHECK(!IsVirtualTextureLayoutValid(noTiles));
+}
+
+DXPG_TEST(VirtualTexture, FeedbackAddsFallbacksCoarsestFirst)
+{
+	std::vector<VirtualTextureLayout> layouts = { TestLayout(), TestLayout() };
+	std::vector<uint32_t> feedback = {
+		Page(0, 0, 5, 3), Page(0, 0, 5, 3), Page(0, 0, 4, 2), EmptyTilePage,
+		Page(1, 2, 0, 0),
+		// Unknown texture, outside the grid and a packed level
+		Page(2, 0, 0, 0), Page(0, 0, 8, 0), Page(0, 5, 0, 0),
+	};
+	std::vector<TileRequest> requests;
+	AnalyzeTileFeedback(feedback, layouts, requests);
+
+	CHECK(CountOf(requests, Page(0, 0, 5, 3)) == 2);
+	CHECK(CountOf(requests, Page(0, 0, 4, 2)) == 1);
+	// Both share their level 1 parent and every coarser one
+	CHECK(CountOf(requests, Page(0, 1, 2, 1)) == 3);
+	CHECK(CountOf(requests, Page(0, 2, 1, 0)) == 3);
+	CHECK(CountOf(requests, Page(0, 3, 0, 0)) == 3);
+	CHECK(CountOf(requests, Page(1, 2, 0, 0)) == 1);
+	CHECK(CountOf(requests, Page(1, 3, 0, 0)) == 1);
+	CHECK(requests.size() == 7);
+	for (size_t i = 1; i < requests.size(); ++i)
+	{
+		uint32_t previous = UnpackTilePage(requests[i - 1].Page).Level;
+		uint32_t level = UnpackTilePage(requests[i].Page).Level;
+		CHECK(previous > level || (previous == level && requests[i - 1].Count >= requests[i].Count));
+	}
+}
+
+DXPG_TEST(VirtualTexture, CacheEvictsLeastRecentlyRequested)
+{
+	TileCache cache;
+	cache.Init(3);
+	std::vector<TileMapping> mappings;
+	std::vector<TileRequest> requests = { { Page(0, 0, 0, 0), 1 }, { Page(0, 0, 1, 0), 1 }, { Page(0, 0, 2, 0), 1 } };
+
+	// The mapping budget leaves the rest missing until the next frame
+	cache.Update(requests, 2, mappings);
+	CHECK(mappings.size() == 2 && mappings[0].EvictedPage == EmptyTilePage);
+	CHECK(cache.GetStats().Missing == 1 && cache.GetStats().Resident == 2);
+	cache.Update(requests, 2, mappings);
+	CHECK(mappings.size() == 1 && mappings[0].Page == Page(0, 0, 2, 0) && mappings[0].Slot == 2);
+	CHECK(cache.GetStats().Missing == 0 && cache.GetStats().Resident == 3);
+
+	// Page 0 stays in use, page 1 was requested longer ago than page 2
+	std::vector<TileRequest> keep = { { Page(0, 0, 0, 0), 1 }, { Page(0, 0, 2, 0), 1 } };
+	cache.Update(keep, 8, mappings);
+	CHECK(mappings.empty());
+	std::vector<TileRequest> next = { { Page(0, 0, 0, 0), 1 }, { Page(0, 0, 3, 0), 1 } };
+	cache.Update(next, 8, mappings);
+	CHECK(mappings.size() == 1 && mappings[0].EvictedPage == Page(0, 0, 1, 0) && mappings[0].Slot == 1);
+	CHECK(!cache.IsResident(Page(0, 0, 1, 0)) && cache.IsResident(Page(0, 0, 3, 0)));
+
+	// Pages of the same feedback never evict each other, the ones that do not fit stay missing
+	std::vector<TileRequest> tooMany = { { Page(1, 0, 0, 0), 1 }, { Page(1, 0, 1, 0), 1 }, { Page(1, 0, 2, 0), 1 }, { Page(1, 0, 3, 0), 1 } };
+	cache.Update(tooMany, 8, mappings);
+	CHECK(mappings.size() == 3);
+	CHECK(cache.GetStats().Missing == 1);
+	CHECK(cache.GetStats().Evicted == 4 && cache.GetStats().Mapped == 7);
+}
+
+DXPG_TEST(VirtualTexture, ResidencyOnlyRefinesBelowResidentParents)
+{
+	auto layout = TestLayout();
+	TileCache cache;
+	cache.Init(16);
+	std::vector<TileMapping> mappings;
+	// Level 0 tile (5, 3) is resident but its level 1 and level 2 ancestors are not
+	std::vector<TileRequest> requests = { { Page(0, 3, 0, 0), 1 }, { Page(0, 2, 0, 0), 1 }, { Page(0, 0, 5, 3), 1 }, { Page(0, 1, 0, 0), 1 }, { Page(0, 0, 0, 0), 1 } };
+	cache.Update(requests, 16, mappings);
+	std::vector<uint8_t> map;
+	BuildResidencyMap(layout, 0, cache, map);
+	CHECK(map.size() == 8 * 4);
+	CHECK(map[0] == 0);
+	CHECK(map[1] == 1);
+	CHECK(map[3 * 8 + 5] == 3);
+	CHECK(map[3 * 8 + 7] == 3);
+	CHECK(map[1 * 8 + 2] == 2);
+
+	// Nothing resident falls back to the packed levels
+	TileCache empty;
+	empty.Init(4);
+	BuildResidencyMap(layout, 0, empty, map);
+	for (uint8_t level : map)
+		CHECK(level == layout.StandardLevels);
+}
\ No newline at end of file